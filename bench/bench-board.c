@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Board definitions that expanded-gpio expects from the library that
+ * embeds it (librpiplc, for example). The benchmarks only exercise the
+ * I2C peripherals, so the direct GPIOs do nothing.
+ */
+
+#include <expanded-gpio.h>
+
+#ifndef BENCH_I2C_BUS
+#define BENCH_I2C_BUS 1
+#endif
+
+const int I2C_BUS = BENCH_I2C_BUS;
+
+// Unless the library already provides them over the GPIO character device
+#ifndef PLC_PERIPHERALS_NORMAL_GPIO_CHARDEV
+const uint8_t NORMAL_GPIO_INPUT = 0;
+const uint8_t NORMAL_GPIO_OUTPUT = 1;
+
+int normal_gpio_init(void) {
+	return 0;
+}
+
+int normal_gpio_deinit(void) {
+	return 0;
+}
+
+int normal_gpio_set_pin_mode(uint32_t pin, uint8_t mode) {
+	(void) pin;
+	(void) mode;
+	return 0;
+}
+
+int normal_gpio_write(uint32_t pin, uint8_t value) {
+	(void) pin;
+	(void) value;
+	return 0;
+}
+
+int normal_gpio_pwm_frequency(uint32_t pin, uint32_t freq) {
+	(void) pin;
+	(void) freq;
+	return 0;
+}
+
+int normal_gpio_pwm_write(uint32_t pin, uint16_t value) {
+	(void) pin;
+	(void) value;
+	return 0;
+}
+
+int normal_gpio_read(uint32_t pin, uint8_t* read) {
+	(void) pin;
+	*read = 0;
+	return 0;
+}
+
+int normal_gpio_analog_read(uint32_t pin, uint16_t* read) {
+	(void) pin;
+	*read = 0;
+	return 0;
+}
+#endif // PLC_PERIPHERALS_NORMAL_GPIO_CHARDEV
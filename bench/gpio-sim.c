@@ -0,0 +1,467 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include "gpio-sim.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <linux/gpio.h>
+
+#define MAX_FDS 1024
+#define MAX_REQUESTS 32
+
+struct sim_chip {
+	bool present;
+	uint32_t num_lines;
+	uint64_t inputs; // Physical levels that drive the inputs
+	uint64_t outputs; // Physical levels driven by the library
+	uint8_t owner[GPIO_SIM_MAX_LINES]; // Request index + 1, 0 if free
+};
+
+struct sim_request {
+	bool used;
+	uint8_t chip;
+	int read_fd; // Given to the library
+	int write_fd; // Where the edges are queued, -1 once hung up
+	size_t num_lines;
+	uint32_t offsets[GPIO_V2_LINES_MAX];
+	uint64_t flags[GPIO_V2_LINES_MAX];
+	uint32_t seqno;
+	uint32_t line_seqno[GPIO_V2_LINES_MAX];
+};
+
+static struct sim_chip chips[GPIO_SIM_MAX_CHIPS];
+static struct sim_request requests[MAX_REQUESTS];
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Chip number + 1 of every simulated chip descriptor, and request index + 1 of every line request
+static uint8_t chip_fds[MAX_FDS];
+static uint8_t request_fds[MAX_FDS];
+
+
+static inline uint64_t monotonic_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static struct sim_chip* find_chip(uint8_t chip, uint32_t offset) {
+	if (chip >= GPIO_SIM_MAX_CHIPS || !chips[chip].present) {
+		errno = ENODEV;
+		return NULL;
+	}
+	if (offset >= chips[chip].num_lines) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return &chips[chip];
+}
+
+/**
+ * @brief Gets the index of a line in its request.
+ *
+ * It must be called with the lock held.
+ */
+static struct sim_request* line_request(const struct sim_chip* c, uint32_t offset, size_t* index) {
+	if (c->owner[offset] == 0) {
+		return NULL;
+	}
+	struct sim_request* req = &requests[c->owner[offset] - 1];
+	for (size_t i = 0; i < req->num_lines; i++) {
+		if (req->offsets[i] == offset) {
+			*index = i;
+			return req;
+		}
+	}
+	return NULL;
+}
+
+static inline bool is_output(const struct sim_request* req, size_t i) {
+	return req->flags[i] & GPIO_V2_LINE_FLAG_OUTPUT;
+}
+
+static inline bool is_active_low(const struct sim_request* req, size_t i) {
+	return req->flags[i] & GPIO_V2_LINE_FLAG_ACTIVE_LOW;
+}
+
+/**
+ * @brief Applies a line configuration to a request, as GPIO_V2_LINE_SET_CONFIG_IOCTL.
+ *
+ * It must be called with the lock held.
+ *
+ * @return 0 on success, -1 on failure (errno is set to EINVAL).
+ */
+static int apply_config(struct sim_request* req, const struct gpio_v2_line_config* config) {
+	if (config->num_attrs > GPIO_V2_LINE_NUM_ATTRS_MAX) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	uint64_t flags[GPIO_V2_LINES_MAX];
+	for (size_t i = 0; i < req->num_lines; i++) {
+		flags[i] = config->flags;
+		for (size_t a = 0; a < config->num_attrs; a++) {
+			if (config->attrs[a].attr.id == GPIO_V2_LINE_ATTR_ID_FLAGS && (config->attrs[a].mask & (1ULL << i))) {
+				flags[i] = config->attrs[a].attr.flags;
+			}
+		}
+		if ((flags[i] & GPIO_V2_LINE_FLAG_INPUT) && (flags[i] & GPIO_V2_LINE_FLAG_OUTPUT)) {
+			errno = EINVAL;
+			return -1;
+		}
+		if ((flags[i] & GPIO_V2_LINE_FLAG_OUTPUT) && (flags[i] & (GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING))) {
+			errno = EINVAL;
+			return -1;
+		}
+	}
+
+	struct sim_chip* c = &chips[req->chip];
+	for (size_t i = 0; i < req->num_lines; i++) {
+		req->flags[i] = flags[i];
+		if (!is_output(req, i)) {
+			continue;
+		}
+
+		bool value = false;
+		for (size_t a = 0; a < config->num_attrs; a++) {
+			if (config->attrs[a].attr.id == GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES && (config->attrs[a].mask & (1ULL << i))) {
+				value = config->attrs[a].attr.values & (1ULL << i);
+			}
+		}
+		const uint64_t bit = 1ULL << req->offsets[i];
+		c->outputs = (value != is_active_low(req, i)) ? (c->outputs | bit) : (c->outputs & ~bit);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Requests lines of a chip, as GPIO_V2_GET_LINE_IOCTL.
+ *
+ * It must be called with the lock held.
+ */
+static int get_line(uint8_t chip, struct gpio_v2_line_request* request) {
+	struct sim_chip* c = &chips[chip];
+	if (request->num_lines == 0 || request->num_lines > GPIO_V2_LINES_MAX) {
+		errno = EINVAL;
+		return -1;
+	}
+	for (size_t i = 0; i < request->num_lines; i++) {
+		if (request->offsets[i] >= c->num_lines) {
+			errno = EINVAL;
+			return -1;
+		}
+		if (c->owner[request->offsets[i]] != 0) {
+			errno = EBUSY;
+			return -1;
+		}
+	}
+
+	size_t r = 0;
+	while (r < MAX_REQUESTS && requests[r].used) {
+		r++;
+	}
+	if (r == MAX_REQUESTS) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	struct sim_request* req = &requests[r];
+	memset(req, 0, sizeof(*req));
+	req->chip = chip;
+	req->num_lines = request->num_lines;
+	memcpy(req->offsets, request->offsets, request->num_lines * sizeof(request->offsets[0]));
+	if (apply_config(req, &request->config) != 0) {
+		return -1;
+	}
+
+	int fds[2];
+	if (pipe2(fds, O_CLOEXEC) != 0) {
+		return -1;
+	}
+	if (fds[0] >= MAX_FDS) {
+		close(fds[0]);
+		close(fds[1]);
+		errno = EMFILE;
+		return -1;
+	}
+	// A full queue drops the edges, as the kernel does
+	fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+	req->used = true;
+	req->read_fd = fds[0];
+	req->write_fd = fds[1];
+	for (size_t i = 0; i < req->num_lines; i++) {
+		c->owner[req->offsets[i]] = r + 1;
+	}
+	request_fds[fds[0]] = r + 1;
+
+	request->fd = fds[0];
+	return 0;
+}
+
+static int get_values(struct sim_request* req, struct gpio_v2_line_values* values) {
+	const struct sim_chip* c = &chips[req->chip];
+	uint64_t bits = 0;
+	for (size_t i = 0; i < req->num_lines; i++) {
+		if (!(values->mask & (1ULL << i))) {
+			continue;
+		}
+		const uint64_t levels = is_output(req, i) ? c->outputs : c->inputs;
+		const bool level = levels & (1ULL << req->offsets[i]);
+		if (level != is_active_low(req, i)) {
+			bits |= 1ULL << i;
+		}
+	}
+	values->bits = bits;
+	return 0;
+}
+
+static int set_values(struct sim_request* req, const struct gpio_v2_line_values* values) {
+	struct sim_chip* c = &chips[req->chip];
+	for (size_t i = 0; i < req->num_lines; i++) {
+		if ((values->mask & (1ULL << i)) && !is_output(req, i)) {
+			errno = EPERM;
+			return -1;
+		}
+	}
+	for (size_t i = 0; i < req->num_lines; i++) {
+		if (!(values->mask & (1ULL << i))) {
+			continue;
+		}
+		const bool value = values->bits & (1ULL << i);
+		const uint64_t bit = 1ULL << req->offsets[i];
+		c->outputs = (value != is_active_low(req, i)) ? (c->outputs | bit) : (c->outputs & ~bit);
+	}
+	return 0;
+}
+
+int gpio_sim_add_chip(uint8_t chip, uint32_t num_lines) {
+	if (chip >= GPIO_SIM_MAX_CHIPS || num_lines == 0 || num_lines > GPIO_SIM_MAX_LINES) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	int ret = 0;
+	pthread_mutex_lock(&lock);
+	if (chips[chip].present) {
+		errno = EEXIST;
+		ret = -1;
+	}
+	else {
+		memset(&chips[chip], 0, sizeof(chips[chip]));
+		chips[chip].present = true;
+		chips[chip].num_lines = num_lines;
+	}
+	pthread_mutex_unlock(&lock);
+
+	return ret;
+}
+
+int gpio_sim_set_input(uint8_t chip, uint32_t offset, bool level) {
+	pthread_mutex_lock(&lock);
+	struct sim_chip* c = find_chip(chip, offset);
+	if (c == NULL) {
+		pthread_mutex_unlock(&lock);
+		return -1;
+	}
+
+	const uint64_t bit = 1ULL << offset;
+	const bool old_level = c->inputs & bit;
+	c->inputs = level ? (c->inputs | bit) : (c->inputs & ~bit);
+
+	size_t i;
+	struct sim_request* req = line_request(c, offset, &i);
+	if (req != NULL && !is_output(req, i) && level != old_level) {
+		// The edges are seen after the active-low inversion
+		const bool rising = level != is_active_low(req, i);
+		const uint64_t edge_flag = rising ? GPIO_V2_LINE_FLAG_EDGE_RISING : GPIO_V2_LINE_FLAG_EDGE_FALLING;
+		if (req->flags[i] & edge_flag) {
+			const struct gpio_v2_line_event event = {
+				.timestamp_ns = monotonic_ns(),
+				.id = rising ? GPIO_V2_LINE_EVENT_RISING_EDGE : GPIO_V2_LINE_EVENT_FALLING_EDGE,
+				.offset = offset,
+				.seqno = ++req->seqno,
+				.line_seqno = ++req->line_seqno[i]
+			};
+			if (req->write_fd >= 0 && write(req->write_fd, &event, sizeof(event)) < 0) {
+				// Dropped, the sequence numbers tell the library
+			}
+		}
+	}
+	pthread_mutex_unlock(&lock);
+
+	return 0;
+}
+
+int gpio_sim_get_output(uint8_t chip, uint32_t offset) {
+	pthread_mutex_lock(&lock);
+	int ret = -1;
+	struct sim_chip* c = find_chip(chip, offset);
+	if (c != NULL) {
+		size_t i;
+		struct sim_request* req = line_request(c, offset, &i);
+		if (req != NULL && is_output(req, i)) {
+			ret = (c->outputs >> offset) & 1;
+		}
+		else {
+			errno = EINVAL;
+		}
+	}
+	pthread_mutex_unlock(&lock);
+
+	return ret;
+}
+
+bool gpio_sim_is_requested(uint8_t chip, uint32_t offset) {
+	pthread_mutex_lock(&lock);
+	const struct sim_chip* c = find_chip(chip, offset);
+	const bool requested = c != NULL && c->owner[offset] != 0;
+	pthread_mutex_unlock(&lock);
+
+	return requested;
+}
+
+int gpio_sim_hangup(uint8_t chip) {
+	int write_fds[MAX_REQUESTS];
+	size_t num_fds = 0;
+
+	pthread_mutex_lock(&lock);
+	if (find_chip(chip, 0) == NULL) {
+		pthread_mutex_unlock(&lock);
+		return -1;
+	}
+	for (size_t r = 0; r < MAX_REQUESTS; r++) {
+		if (requests[r].used && requests[r].chip == chip && requests[r].write_fd >= 0) {
+			write_fds[num_fds++] = requests[r].write_fd;
+			requests[r].write_fd = -1;
+		}
+	}
+	pthread_mutex_unlock(&lock);
+
+	// Closed without the lock, since "close" comes back to gpio_sim_close
+	for (size_t i = 0; i < num_fds; i++) {
+		close(write_fds[i]);
+	}
+	return 0;
+}
+
+int gpio_sim_chip_from_path(const char* path) {
+	int chip;
+	char trailing;
+	if (path == NULL || sscanf(path, "/dev/gpiochip%d%c", &chip, &trailing) != 1 ||
+	    chip < 0 || chip >= GPIO_SIM_MAX_CHIPS) {
+		return -1;
+	}
+
+	pthread_mutex_lock(&lock);
+	const bool present = chips[chip].present;
+	pthread_mutex_unlock(&lock);
+	return present ? chip : -1;
+}
+
+int gpio_sim_bind_chip(int fd, uint8_t chip) {
+	if (fd < 0 || fd >= MAX_FDS) {
+		errno = EMFILE;
+		return -1;
+	}
+
+	pthread_mutex_lock(&lock);
+	chip_fds[fd] = chip + 1;
+	pthread_mutex_unlock(&lock);
+	return 0;
+}
+
+bool gpio_sim_owns_fd(int fd) {
+	if (fd < 0 || fd >= MAX_FDS) {
+		return false;
+	}
+
+	pthread_mutex_lock(&lock);
+	const bool owned = chip_fds[fd] != 0 || request_fds[fd] != 0;
+	pthread_mutex_unlock(&lock);
+	return owned;
+}
+
+int gpio_sim_ioctl(int fd, unsigned long request, void* arg) {
+	if (fd < 0 || fd >= MAX_FDS) {
+		errno = EBADF;
+		return -1;
+	}
+	if (arg == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	int ret = -1;
+	errno = ENOTTY;
+	pthread_mutex_lock(&lock);
+	if (chip_fds[fd] != 0) {
+		if (request == GPIO_V2_GET_LINE_IOCTL) {
+			ret = get_line(chip_fds[fd] - 1, arg);
+		}
+	}
+	else if (request_fds[fd] != 0) {
+		struct sim_request* req = &requests[request_fds[fd] - 1];
+		if (request == GPIO_V2_LINE_GET_VALUES_IOCTL) {
+			ret = get_values(req, arg);
+		}
+		else if (request == GPIO_V2_LINE_SET_VALUES_IOCTL) {
+			ret = set_values(req, arg);
+		}
+		else if (request == GPIO_V2_LINE_SET_CONFIG_IOCTL) {
+			ret = apply_config(req, arg);
+		}
+	}
+	else {
+		errno = EBADF;
+	}
+	pthread_mutex_unlock(&lock);
+
+	return ret;
+}
+
+void gpio_sim_close(int fd) {
+	if (fd < 0 || fd >= MAX_FDS) {
+		return;
+	}
+
+	int write_fd = -1;
+	pthread_mutex_lock(&lock);
+	chip_fds[fd] = 0;
+	if (request_fds[fd] != 0) {
+		struct sim_request* req = &requests[request_fds[fd] - 1];
+		for (size_t i = 0; i < req->num_lines; i++) {
+			chips[req->chip].owner[req->offsets[i]] = 0;
+		}
+		write_fd = req->write_fd;
+		req->used = false;
+		request_fds[fd] = 0;
+	}
+	pthread_mutex_unlock(&lock);
+
+	if (write_fd >= 0) {
+		close(write_fd);
+	}
+}
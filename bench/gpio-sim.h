@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GPIO_SIM_H__
+#define __GPIO_SIM_H__
+
+/*
+ * gpio-sim models the GPIO character devices ("/dev/gpiochipN") used by
+ * gpio-chardev, next to the I2C buses of i2c-sim and behind the same
+ * link-time glue (i2c-sim-wrap.c). A chip is only simulated once it has
+ * been added, so the other chips reach the real system calls. Every line
+ * request gets a pipe as its descriptor, where the edges of its lines are
+ * written as the kernel would queue them, so the library can poll and
+ * read it as usual.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GPIO_SIM_MAX_CHIPS 4
+#define GPIO_SIM_MAX_LINES 64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/**
+	 * @brief Adds a simulated GPIO chip, with all its lines as low inputs.
+	 *
+	 * @param chip The chip number (as in "/dev/gpiochipN").
+	 * @param num_lines The number of lines (up to GPIO_SIM_MAX_LINES).
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EINVAL: The chip number or the number of lines are invalid.
+	 *             - EEXIST: The chip is already simulated.
+	 */
+	int gpio_sim_add_chip(uint8_t chip, uint32_t num_lines);
+
+	/**
+	 * @brief Sets the physical level that drives an input line.
+	 *
+	 * If the line is requested with edge detection, and the change is one of
+	 * the requested edges, an edge event is queued in its request.
+	 *
+	 * @param chip The chip number.
+	 * @param offset The offset of the line.
+	 * @param level The physical level.
+	 * @return 0 on success, -1 on failure (errno is set to ENODEV or EINVAL).
+	 */
+	int gpio_sim_set_input(uint8_t chip, uint32_t offset, bool level);
+
+	/**
+	 * @brief Gets the physical level driven by the library on an output line.
+	 *
+	 * @param chip The chip number.
+	 * @param offset The offset of the line.
+	 * @return The level, or -1 if the line isn't a requested output (errno is set
+	 *         to ENODEV or EINVAL).
+	 */
+	int gpio_sim_get_output(uint8_t chip, uint32_t offset);
+
+	/**
+	 * @brief Tells whether a line is requested by the library.
+	 *
+	 * @param chip The chip number.
+	 * @param offset The offset of the line.
+	 * @return True if the line is requested.
+	 */
+	bool gpio_sim_is_requested(uint8_t chip, uint32_t offset);
+
+	/**
+	 * @brief Hangs up the requests of a chip, as if it were unbound.
+	 *
+	 * Their descriptors report POLLHUP and their reads return 0 once the
+	 * queued edges are taken.
+	 *
+	 * @param chip The chip number.
+	 * @return 0 on success, -1 if the chip doesn't exist (errno is set to ENODEV).
+	 */
+	int gpio_sim_hangup(uint8_t chip);
+
+	/**
+	 * @brief Gets the simulated chip of a path given to "open".
+	 *
+	 * @param path The path.
+	 * @return The chip number, or -1 if it isn't a simulated chip.
+	 */
+	int gpio_sim_chip_from_path(const char* path);
+
+	/**
+	 * @brief Binds a descriptor opened for a simulated chip.
+	 *
+	 * @param fd The descriptor returned by "open".
+	 * @param chip The chip number.
+	 * @return 0 on success, -1 if the descriptor can't be tracked (errno is set to EMFILE).
+	 */
+	int gpio_sim_bind_chip(int fd, uint8_t chip);
+
+	/**
+	 * @brief Tells whether a descriptor is a simulated chip or line request.
+	 */
+	bool gpio_sim_owns_fd(int fd);
+
+	/**
+	 * @brief Executes an ioctl on a simulated chip or line request.
+	 *
+	 * @param fd The descriptor.
+	 * @param request The ioctl request.
+	 * @param arg The argument of the ioctl.
+	 * @return 0 on success, -1 on failure (errno is set as the kernel would).
+	 */
+	int gpio_sim_ioctl(int fd, unsigned long request, void* arg);
+
+	/**
+	 * @brief Forgets a descriptor that is being closed, releasing its lines.
+	 *
+	 * @param fd The descriptor.
+	 */
+	void gpio_sim_close(int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __GPIO_SIM_H__
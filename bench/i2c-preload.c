@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Shared object for LD_PRELOAD that answers the I2C buses instantly with the
+ * simulated devices of i2c-sim. It is built with -fvisibility=hidden, so the
+ * copy of i2c-sim inside it never mixes with the one of a benchmark: only the
+ * intercepted calls and the statistics are exported.
+ *
+ * Usage: LD_PRELOAD=libplc-i2c-preload.so program
+ */
+
+#define _GNU_SOURCE
+
+#include "i2c-preload.h"
+#include "i2c-sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <stdatomic.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+#define PRELOAD_EXPORT __attribute__((visibility("default")))
+
+#define MAX_FDS 1024
+#define DEFAULT_BUS 1
+
+// The devices of plc-bench-api
+#define DEFAULT_DEVICES "mcp23008@0x20,mcp23017@0x21,pca9685@0x40,ads1015@0x48,ltc2309@0x08"
+
+static const char* const DEVICE_TYPES[] = {
+	[I2C_SIM_MCP23008] = "mcp23008",
+	[I2C_SIM_MCP23017] = "mcp23017",
+	[I2C_SIM_PCA9685] = "pca9685",
+	[I2C_SIM_ADS1015] = "ads1015",
+	[I2C_SIM_LTC2309] = "ltc2309",
+};
+
+static int (*real_open)(const char*, int, ...);
+static int (*real_open64)(const char*, int, ...);
+static int (*real_close)(int);
+static int (*real_ioctl)(int, unsigned long, ...);
+
+// Bus number + 1 of every intercepted file descriptor, 0 for the real ones
+static uint8_t preload_fds[MAX_FDS];
+
+static atomic_uint_fast64_t stat_opens, stat_closes, stat_ioctls, stat_messages, stat_bytes, stat_sleeps;
+
+
+/**
+ * @brief Adds a device given as "[BUS:]TYPE@ADDR" to the simulated buses.
+ *
+ * @return 0 on success, -1 if the description is invalid or the device can't be added.
+ */
+static int add_device(char* description) {
+	unsigned long bus = DEFAULT_BUS;
+	char* type = description;
+
+	char* colon = strchr(description, ':');
+	if (colon != NULL) {
+		*colon = '\0';
+		bus = strtoul(description, NULL, 0);
+		type = colon + 1;
+	}
+
+	char* at = strchr(type, '@');
+	if (at == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	*at = '\0';
+	const unsigned long addr = strtoul(at + 1, NULL, 0);
+
+	for (size_t i = 0; i < sizeof(DEVICE_TYPES) / sizeof(DEVICE_TYPES[0]); i++) {
+		if (strcasecmp(type, DEVICE_TYPES[i]) == 0) {
+			if (bus >= I2C_SIM_MAX_BUSES || addr >= 128) {
+				errno = EINVAL;
+				return -1;
+			}
+			return i2c_sim_add_device(bus, i, addr);
+		}
+	}
+
+	errno = EINVAL;
+	return -1;
+}
+
+__attribute__((constructor))
+static void preload_init(void) {
+	real_open = dlsym(RTLD_NEXT, "open");
+	real_open64 = dlsym(RTLD_NEXT, "open64");
+	real_close = dlsym(RTLD_NEXT, "close");
+	real_ioctl = dlsym(RTLD_NEXT, "ioctl");
+
+	const char* env = getenv("PLC_I2C_PRELOAD_DEVICES");
+	char* devices = strdup(env != NULL ? env : DEFAULT_DEVICES);
+	if (devices == NULL) {
+		return;
+	}
+
+	char* saveptr;
+	for (char* device = strtok_r(devices, ",", &saveptr); device != NULL; device = strtok_r(NULL, ",", &saveptr)) {
+		if (add_device(device) != 0) {
+			fprintf(stderr, "i2c-preload: ignoring device \"%s\": %s\n", device, strerror(errno));
+		}
+	}
+	free(devices);
+
+	i2c_sim_set_bus_speed(0);
+}
+
+__attribute__((destructor))
+static void preload_fini(void) {
+	if (getenv("PLC_I2C_PRELOAD_STATS") == NULL) {
+		return;
+	}
+
+	struct i2c_preload_stats stats;
+	i2c_preload_get_stats(&stats);
+	fprintf(stderr, "i2c-preload: %lu opens, %lu closes, %lu ioctls, %lu messages, %lu bytes, %lu sleeps\n",
+	        (unsigned long) stats.opens, (unsigned long) stats.closes, (unsigned long) stats.ioctls,
+	        (unsigned long) stats.messages, (unsigned long) stats.bytes, (unsigned long) stats.sleeps);
+}
+
+/**
+ * @brief Returns the bus number if the path is an I2C character device.
+ *
+ * @param path The path given to "open".
+ * @return The bus number, or -1 if it isn't an I2C bus that can be intercepted.
+ */
+static int i2c_bus_from_path(const char* path) {
+	int bus;
+	char trailing;
+	if (path == NULL || sscanf(path, "/dev/i2c-%d%c", &bus, &trailing) != 1) {
+		return -1;
+	}
+	return (bus >= 0 && bus < I2C_SIM_MAX_BUSES) ? bus : -1;
+}
+
+static int open_preload(const char* path, int flags, mode_t mode, int (*next_open)(const char*, int, ...)) {
+	if (next_open == NULL) {
+		errno = ENOSYS;
+		return -1;
+	}
+
+	const int bus = i2c_bus_from_path(path);
+	if (bus < 0) {
+		return next_open(path, flags, mode);
+	}
+
+	// Back the bus with a real descriptor, so it can be closed normally
+	int fd = next_open("/dev/null", O_RDWR);
+	if (fd < 0) {
+		return fd;
+	}
+	if (fd >= MAX_FDS) {
+		real_close(fd);
+		errno = EMFILE;
+		return -1;
+	}
+
+	preload_fds[fd] = bus + 1;
+	stat_opens++;
+	return fd;
+}
+
+PRELOAD_EXPORT int open(const char* path, int flags, ...) {
+	mode_t mode = 0;
+	if (flags & (O_CREAT | O_TMPFILE)) {
+		va_list args;
+		va_start(args, flags);
+		mode = va_arg(args, mode_t);
+		va_end(args);
+	}
+	return open_preload(path, flags, mode, real_open);
+}
+
+PRELOAD_EXPORT int open64(const char* path, int flags, ...) {
+	mode_t mode = 0;
+	if (flags & (O_CREAT | O_TMPFILE)) {
+		va_list args;
+		va_start(args, flags);
+		mode = va_arg(args, mode_t);
+		va_end(args);
+	}
+	return open_preload(path, flags, mode, real_open64);
+}
+
+PRELOAD_EXPORT int close(int fd) {
+	if (fd >= 0 && fd < MAX_FDS && preload_fds[fd] != 0) {
+		preload_fds[fd] = 0;
+		stat_closes++;
+	}
+	return real_close(fd);
+}
+
+PRELOAD_EXPORT int ioctl(int fd, unsigned long request, ...) {
+	va_list args;
+	va_start(args, request);
+	void* arg = va_arg(args, void*);
+	va_end(args);
+
+	if (fd < 0 || fd >= MAX_FDS || preload_fds[fd] == 0) {
+		return real_ioctl(fd, request, arg);
+	}
+
+	if (request != I2C_RDWR) {
+		// I2C_SLAVE, I2C_FUNCS and the like: nothing to configure
+		return 0;
+	}
+
+	struct i2c_rdwr_ioctl_data* data = arg;
+	if (data == NULL || data->msgs == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	size_t bytes = 0;
+	for (size_t i = 0; i < data->nmsgs; i++) {
+		bytes += data->msgs[i].len;
+	}
+	stat_ioctls++;
+	stat_messages += data->nmsgs;
+	stat_bytes += bytes;
+
+	return i2c_sim_transfer(preload_fds[fd] - 1, data->msgs, data->nmsgs);
+}
+
+PRELOAD_EXPORT int usleep(useconds_t usec) {
+	(void) usec;
+	stat_sleeps++;
+	return 0;
+}
+
+PRELOAD_EXPORT void i2c_preload_get_stats(struct i2c_preload_stats* stats) {
+	*stats = (struct i2c_preload_stats) {
+		.opens = stat_opens,
+		.closes = stat_closes,
+		.ioctls = stat_ioctls,
+		.messages = stat_messages,
+		.bytes = stat_bytes,
+		.sleeps = stat_sleeps,
+	};
+}
+
+PRELOAD_EXPORT void i2c_preload_clear_stats(void) {
+	stat_opens = 0;
+	stat_closes = 0;
+	stat_ioctls = 0;
+	stat_messages = 0;
+	stat_bytes = 0;
+	stat_sleeps = 0;
+}
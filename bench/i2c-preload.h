@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __I2C_PRELOAD_H__
+#define __I2C_PRELOAD_H__
+
+/*
+ * libplc-i2c-preload.so is loaded with LD_PRELOAD in front of any program
+ * that uses the library. It intercepts the system calls that reach the
+ * I2C buses and answers them at once from the register models of i2c-sim,
+ * without any modelled bus time, and it returns from usleep without
+ * sleeping. What is left of the time of a call is the CPU cost of the
+ * library itself (plus the few register copies of the models). Unlike the
+ * benchmarks linked with i2c-sim, the program doesn't need to be relinked.
+ *
+ * The devices are given in PLC_I2C_PRELOAD_DEVICES as a comma-separated
+ * list of "[BUS:]TYPE@ADDR" (the bus is 1 by default), where TYPE is one
+ * of mcp23008, mcp23017, pca9685, ads1015 and ltc2309. For example:
+ *     PLC_I2C_PRELOAD_DEVICES=mcp23008@0x20,pca9685@0x40,1:ads1015@0x48
+ * Without it, there is one device of each type on bus 1, at the addresses
+ * used by plc-bench-api.
+ *
+ * If the environment variable PLC_I2C_PRELOAD_STATS is set, the counters
+ * are printed to stderr when the program exits.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/**
+	 * @brief Counters of the intercepted calls.
+	 *
+	 * - @c opens: Number of I2C buses opened.
+	 * - @c closes: Number of I2C buses closed.
+	 * - @c ioctls: Number of I2C_RDWR ioctls answered.
+	 * - @c messages: Number of I2C messages of those ioctls.
+	 * - @c bytes: Number of payload bytes of those messages.
+	 * - @c sleeps: Number of usleep calls skipped.
+	 */
+	struct i2c_preload_stats {
+		uint64_t opens;
+		uint64_t closes;
+		uint64_t ioctls;
+		uint64_t messages;
+		uint64_t bytes;
+		uint64_t sleeps;
+	};
+
+	/**
+	 * @brief Copies the counters of the intercepted calls.
+	 *
+	 * The programs that may run without the shim should look this function
+	 * up with dlsym, which returns NULL when it isn't preloaded.
+	 *
+	 * @param stats Where to copy the counters.
+	 */
+	void i2c_preload_get_stats(struct i2c_preload_stats* stats);
+
+	/**
+	 * @brief Sets all the counters to zero.
+	 */
+	void i2c_preload_clear_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_PRELOAD_H__
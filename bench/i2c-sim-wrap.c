@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Link-time glue between the library and i2c-sim (and gpio-sim). It must be
+ * linked with:
+ *     -Wl,--wrap=open,--wrap=open64,--wrap=close,--wrap=ioctl
+ * so the calls made by i2c-interface.c and gpio-chardev.c end up here.
+ */
+
+#define _GNU_SOURCE
+
+#include "i2c-sim.h"
+#include "gpio-sim.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+#define MAX_FDS 1024
+
+int __real_open(const char* path, int flags, ...);
+int __real_open64(const char* path, int flags, ...);
+int __real_close(int fd);
+int __real_ioctl(int fd, unsigned long request, ...);
+
+// Bus number + 1 of every simulated file descriptor, 0 for the real ones
+static uint8_t sim_fds[MAX_FDS];
+
+
+/**
+ * @brief Returns the bus number if the path is an I2C character device.
+ *
+ * @param path The path given to "open".
+ * @return The bus number, or -1 if it isn't a simulable I2C bus.
+ */
+static int i2c_bus_from_path(const char* path) {
+	int bus;
+	char trailing;
+	if (path == NULL || sscanf(path, "/dev/i2c-%d%c", &bus, &trailing) != 1) {
+		return -1;
+	}
+	return (bus >= 0 && bus < I2C_SIM_MAX_BUSES) ? bus : -1;
+}
+
+/**
+ * @brief Opens a simulated GPIO chip, backed by a real descriptor as the buses.
+ */
+static int open_gpio_sim(int chip, int (*real_open)(const char*, int, ...)) {
+	int fd = real_open("/dev/null", O_RDWR);
+	if (fd < 0) {
+		return fd;
+	}
+	if (gpio_sim_bind_chip(fd, chip) != 0) {
+		__real_close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static int open_sim(const char* path, int flags, mode_t mode, int (*real_open)(const char*, int, ...)) {
+	const int chip = gpio_sim_chip_from_path(path);
+	if (chip >= 0) {
+		return open_gpio_sim(chip, real_open);
+	}
+
+	const int bus = i2c_sim_is_enabled() ? i2c_bus_from_path(path) : -1;
+	if (bus < 0) {
+		return real_open(path, flags, mode);
+	}
+
+	// Back the simulated bus with a real descriptor, so it can be closed normally
+	int fd = real_open("/dev/null", O_RDWR);
+	if (fd < 0) {
+		return fd;
+	}
+	if (fd >= MAX_FDS) {
+		__real_close(fd);
+		errno = EMFILE;
+		return -1;
+	}
+
+	sim_fds[fd] = bus + 1;
+	return fd;
+}
+
+int __wrap_open(const char* path, int flags, ...) {
+	mode_t mode = 0;
+	if (flags & (O_CREAT | O_TMPFILE)) {
+		va_list args;
+		va_start(args, flags);
+		mode = va_arg(args, mode_t);
+		va_end(args);
+	}
+	return open_sim(path, flags, mode, __real_open);
+}
+
+int __wrap_open64(const char* path, int flags, ...) {
+	mode_t mode = 0;
+	if (flags & (O_CREAT | O_TMPFILE)) {
+		va_list args;
+		va_start(args, flags);
+		mode = va_arg(args, mode_t);
+		va_end(args);
+	}
+	return open_sim(path, flags, mode, __real_open64);
+}
+
+int __wrap_close(int fd) {
+	if (fd >= 0 && fd < MAX_FDS) {
+		sim_fds[fd] = 0;
+	}
+	gpio_sim_close(fd);
+	return __real_close(fd);
+}
+
+int __wrap_ioctl(int fd, unsigned long request, ...) {
+	va_list args;
+	va_start(args, request);
+	void* arg = va_arg(args, void*);
+	va_end(args);
+
+	if (gpio_sim_owns_fd(fd)) {
+		return gpio_sim_ioctl(fd, request, arg);
+	}
+
+	if (request != I2C_RDWR) {
+		return __real_ioctl(fd, request, arg);
+	}
+
+	struct i2c_rdwr_ioctl_data* data = arg;
+	if (data != NULL) {
+		i2c_sim_account(data->msgs, data->nmsgs);
+	}
+
+	if (fd >= 0 && fd < MAX_FDS && sim_fds[fd] != 0) {
+		if (data == NULL || data->msgs == NULL) {
+			errno = EFAULT;
+			return -1;
+		}
+		return i2c_sim_transfer(sim_fds[fd] - 1, data->msgs, data->nmsgs);
+	}
+
+	return __real_ioctl(fd, request, arg);
+}
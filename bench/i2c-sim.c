@@ -0,0 +1,541 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "i2c-sim.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define MAX_DEVICES 64
+
+// MCP230XX registers, as numbered in the MCP23008 (the MCP23017 in BANK=0 interleaves A and B)
+#define MCP_IODIR	0x00
+#define MCP_IPOL	0x01
+#define MCP_GPINTEN	0x02
+#define MCP_DEFVAL	0x03
+#define MCP_INTCON	0x04
+#define MCP_IOCON	0x05
+#define MCP_GPPU	0x06
+#define MCP_INTF	0x07
+#define MCP_INTCAP	0x08
+#define MCP_GPIO	0x09
+#define MCP_OLAT	0x0A
+#define MCP_IOCON_SEQOP	0x20
+
+// PCA9685 registers
+#define PCA_MODE1		0x00
+#define PCA_LAST_LED_REGISTER	0x45
+#define PCA_ALL_LED_ON_L	0xFA
+#define PCA_PRE_SCALE		0xFE
+#define PCA_MODE1_SLEEP		0x10
+#define PCA_MODE1_AI		0x20
+
+// ADS1015 registers
+#define ADS_CONVERSION	0x00
+#define ADS_CONFIG	0x01
+#define ADS_OS		0x80
+
+struct sim_device {
+	i2c_sim_device_type_t type;
+	uint8_t bus;
+	uint8_t addr;
+	uint8_t ptr;
+	uint8_t regs[256];
+	uint16_t regs16[4];
+	uint16_t inputs;
+	uint8_t channel;
+	uint16_t analog[I2C_SIM_MAX_CHANNELS];
+};
+
+static struct sim_device devices[MAX_DEVICES];
+static size_t num_devices = 0;
+static struct sim_device* device_map[I2C_SIM_MAX_BUSES][128];
+static pthread_mutex_t bus_locks[I2C_SIM_MAX_BUSES] = {
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER
+};
+
+static atomic_bool enabled = false;
+static atomic_uint_fast32_t bus_speed = 100000;
+
+static atomic_uint_fast64_t stat_ioctls, stat_messages, stat_bytes, stat_wire_bytes, stat_nacks, stat_bus_ns;
+
+
+void i2c_sim_enable(bool enable) {
+	atomic_store(&enabled, enable);
+}
+
+bool i2c_sim_is_enabled(void) {
+	return atomic_load(&enabled);
+}
+
+void i2c_sim_set_bus_speed(uint32_t hz) {
+	atomic_store(&bus_speed, hz);
+}
+
+void i2c_sim_reset(void) {
+	for (size_t bus = 0; bus < I2C_SIM_MAX_BUSES; bus++) {
+		pthread_mutex_lock(&bus_locks[bus]);
+	}
+	memset(device_map, 0, sizeof(device_map));
+	memset(devices, 0, sizeof(devices));
+	num_devices = 0;
+	for (size_t bus = 0; bus < I2C_SIM_MAX_BUSES; bus++) {
+		pthread_mutex_unlock(&bus_locks[bus]);
+	}
+
+	i2c_sim_clear_stats();
+}
+
+/**
+ * @brief Puts a simulated device in its power-on reset state.
+ *
+ * @param dev The device to reset.
+ */
+static void power_on_reset(struct sim_device* dev) {
+	memset(dev->regs, 0, sizeof(dev->regs));
+	dev->ptr = 0;
+
+	switch (dev->type) {
+	case I2C_SIM_MCP23008:
+		dev->regs[MCP_IODIR] = 0xFF;
+		break;
+	case I2C_SIM_MCP23017:
+		dev->regs[MCP_IODIR * 2] = 0xFF;
+		dev->regs[MCP_IODIR * 2 + 1] = 0xFF;
+		break;
+	case I2C_SIM_PCA9685:
+		dev->regs[PCA_MODE1] = 0x11;
+		dev->regs[0x01] = 0x04;
+		dev->regs[0x02] = 0xE2;
+		dev->regs[0x03] = 0xE4;
+		dev->regs[0x04] = 0xE8;
+		dev->regs[0x05] = 0xE0;
+		for (uint8_t i = 0; i < 16; i++) {
+			dev->regs[0x06 + i*4 + 3] = 0x10;
+		}
+		dev->regs[PCA_ALL_LED_ON_L + 1] = 0x10;
+		dev->regs[PCA_ALL_LED_ON_L + 3] = 0x10;
+		dev->regs[PCA_PRE_SCALE] = 0x1E;
+		break;
+	case I2C_SIM_ADS1015:
+		dev->regs16[0] = 0x0000;
+		dev->regs16[1] = 0x8583;
+		dev->regs16[2] = 0x8000;
+		dev->regs16[3] = 0x7FFF;
+		break;
+	case I2C_SIM_LTC2309:
+		break;
+	}
+}
+
+int i2c_sim_add_device(uint8_t bus, i2c_sim_device_type_t type, uint8_t addr) {
+	if (bus >= I2C_SIM_MAX_BUSES || addr >= 128 || type > I2C_SIM_LTC2309) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	int ret = 0;
+	pthread_mutex_lock(&bus_locks[bus]);
+	if (device_map[bus][addr] != NULL) {
+		errno = EEXIST;
+		ret = -1;
+	}
+	else if (num_devices >= MAX_DEVICES) {
+		errno = ENOMEM;
+		ret = -1;
+	}
+	else {
+		struct sim_device* dev = &devices[num_devices++];
+		memset(dev, 0, sizeof(*dev));
+		dev->type = type;
+		dev->bus = bus;
+		dev->addr = addr;
+		power_on_reset(dev);
+		device_map[bus][addr] = dev;
+	}
+	pthread_mutex_unlock(&bus_locks[bus]);
+
+	return ret;
+}
+
+static struct sim_device* find_device(uint8_t bus, uint8_t addr) {
+	if (bus >= I2C_SIM_MAX_BUSES || addr >= 128) {
+		return NULL;
+	}
+	return device_map[bus][addr];
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// MCP230XX model
+
+static inline uint8_t mcp_num_ports(const struct sim_device* dev) {
+	return dev->type == I2C_SIM_MCP23017 ? 2 : 1;
+}
+
+static inline uint8_t* mcp_reg(struct sim_device* dev, uint8_t reg, uint8_t port) {
+	return &dev->regs[reg * mcp_num_ports(dev) + port];
+}
+
+static inline uint8_t mcp_port_inputs(const struct sim_device* dev, uint8_t port) {
+	return (dev->inputs >> (8 * port)) & 0xFF;
+}
+
+static uint8_t mcp_gpio(struct sim_device* dev, uint8_t port) {
+	const uint8_t iodir = *mcp_reg(dev, MCP_IODIR, port);
+	const uint8_t ipol = *mcp_reg(dev, MCP_IPOL, port);
+	const uint8_t olat = *mcp_reg(dev, MCP_OLAT, port);
+	return ((mcp_port_inputs(dev, port) ^ ipol) & iodir) | (olat & ~iodir);
+}
+
+static void mcp_update_interrupts(struct sim_device* dev, uint16_t old_inputs) {
+	for (uint8_t port = 0; port < mcp_num_ports(dev); port++) {
+		const uint8_t enabled_pins = *mcp_reg(dev, MCP_GPINTEN, port) & *mcp_reg(dev, MCP_IODIR, port);
+		const uint8_t intcon = *mcp_reg(dev, MCP_INTCON, port);
+		const uint8_t levels = mcp_port_inputs(dev, port);
+		const uint8_t previous = (old_inputs >> (8 * port)) & 0xFF;
+
+		const uint8_t fired = enabled_pins & (((levels ^ *mcp_reg(dev, MCP_DEFVAL, port)) & intcon) |
+						      ((levels ^ previous) & ~intcon));
+		if (fired == 0) {
+			continue;
+		}
+		uint8_t* intf = mcp_reg(dev, MCP_INTF, port);
+		if (*intf == 0) {
+			*mcp_reg(dev, MCP_INTCAP, port) = mcp_gpio(dev, port);
+		}
+		*intf |= fired;
+	}
+}
+
+static uint8_t mcp_next_ptr(struct sim_device* dev, uint8_t ptr) {
+	const uint8_t last = 11 * mcp_num_ports(dev) - 1;
+
+	if (*mcp_reg(dev, MCP_IOCON, 0) & MCP_IOCON_SEQOP) {
+		// Sequential operation disabled: the MCP23017 toggles between the A/B pair
+		return dev->type == I2C_SIM_MCP23017 ? (ptr ^ 1) : ptr;
+	}
+	return ptr >= last ? 0 : ptr + 1;
+}
+
+static void mcp_write_byte(struct sim_device* dev, uint8_t ptr, uint8_t value) {
+	const uint8_t ports = mcp_num_ports(dev);
+	const uint8_t reg = ptr / ports;
+	const uint8_t port = ptr % ports;
+
+	switch (reg) {
+	case MCP_INTF:
+	case MCP_INTCAP:
+		break;
+	case MCP_GPIO:
+	case MCP_OLAT:
+		*mcp_reg(dev, MCP_OLAT, port) = value;
+		break;
+	case MCP_IOCON:
+		// IOCON is shared by both ports
+		for (uint8_t p = 0; p < ports; p++) {
+			*mcp_reg(dev, MCP_IOCON, p) = value;
+		}
+		break;
+	default:
+		if (reg < MCP_OLAT + 1) {
+			*mcp_reg(dev, reg, port) = value;
+		}
+		break;
+	}
+}
+
+static uint8_t mcp_read_byte(struct sim_device* dev, uint8_t ptr) {
+	const uint8_t ports = mcp_num_ports(dev);
+	const uint8_t reg = ptr / ports;
+	const uint8_t port = ptr % ports;
+
+	switch (reg) {
+	case MCP_GPIO: {
+		const uint8_t gpio = mcp_gpio(dev, port);
+		*mcp_reg(dev, MCP_INTF, port) = 0;
+		return gpio;
+	}
+	case MCP_INTCAP:
+		*mcp_reg(dev, MCP_INTF, port) = 0;
+		return *mcp_reg(dev, MCP_INTCAP, port);
+	default:
+		return reg < MCP_OLAT + 1 ? *mcp_reg(dev, reg, port) : 0;
+	}
+}
+
+static void mcp_transfer(struct sim_device* dev, struct i2c_msg* msg) {
+	size_t i = 0;
+	if (!(msg->flags & I2C_M_RD)) {
+		if (msg->len == 0) {
+			return;
+		}
+		dev->ptr = msg->buf[i++];
+	}
+
+	for (; i < msg->len; i++) {
+		if (msg->flags & I2C_M_RD) {
+			msg->buf[i] = mcp_read_byte(dev, dev->ptr);
+		}
+		else {
+			mcp_write_byte(dev, dev->ptr, msg->buf[i]);
+		}
+		dev->ptr = mcp_next_ptr(dev, dev->ptr);
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// PCA9685 model
+
+static uint8_t pca_next_ptr(struct sim_device* dev, uint8_t ptr) {
+	if (!(dev->regs[PCA_MODE1] & PCA_MODE1_AI)) {
+		return ptr;
+	}
+	if (ptr == PCA_LAST_LED_REGISTER) {
+		return PCA_ALL_LED_ON_L;
+	}
+	return ptr + 1;
+}
+
+static void pca_transfer(struct sim_device* dev, struct i2c_msg* msg) {
+	size_t i = 0;
+	if (!(msg->flags & I2C_M_RD)) {
+		if (msg->len == 0) {
+			return;
+		}
+		dev->ptr = msg->buf[i++];
+	}
+
+	for (; i < msg->len; i++) {
+		const uint8_t ptr = dev->ptr;
+		const bool reserved = ptr > PCA_LAST_LED_REGISTER && ptr < PCA_ALL_LED_ON_L;
+
+		if (msg->flags & I2C_M_RD) {
+			msg->buf[i] = reserved ? 0 : dev->regs[ptr];
+		}
+		else if (!reserved) {
+			// The prescaler can only be written in sleep mode
+			if (ptr != PCA_PRE_SCALE || (dev->regs[PCA_MODE1] & PCA_MODE1_SLEEP)) {
+				dev->regs[ptr] = msg->buf[i];
+			}
+		}
+		dev->ptr = pca_next_ptr(dev, ptr);
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// ADC models
+
+static void ads_transfer(struct sim_device* dev, struct i2c_msg* msg) {
+	if (msg->flags & I2C_M_RD) {
+		const uint16_t reg = dev->regs16[dev->ptr & 0x03];
+		for (size_t i = 0; i < msg->len; i++) {
+			msg->buf[i] = (i % 2 == 0) ? (reg >> 8) : (reg & 0xFF);
+		}
+		return;
+	}
+
+	if (msg->len == 0) {
+		return;
+	}
+	dev->ptr = msg->buf[0] & 0x03;
+	if (msg->len < 3 || dev->ptr == ADS_CONVERSION) {
+		return;
+	}
+
+	const uint16_t value = (msg->buf[1] << 8) | msg->buf[2];
+	// Conversions are instantaneous, so OS always reads back as "not converting"
+	dev->regs16[dev->ptr] = dev->ptr == ADS_CONFIG ? (value | (ADS_OS << 8)) : value;
+	if (dev->ptr == ADS_CONFIG && (msg->buf[1] & ADS_OS)) {
+		const uint8_t mux = (msg->buf[1] >> 4) & 0x07;
+		// Only single-ended conversions are modelled
+		const uint16_t result = mux >= 4 ? dev->analog[mux - 4] : 0;
+		dev->regs16[ADS_CONVERSION] = (result & 0x0FFF) << 4;
+	}
+}
+
+static void ltc_transfer(struct sim_device* dev, struct i2c_msg* msg) {
+	if (msg->flags & I2C_M_RD) {
+		const uint16_t result = (dev->analog[dev->channel] & 0x0FFF) << 4;
+		for (size_t i = 0; i < msg->len; i++) {
+			msg->buf[i] = (i % 2 == 0) ? (result >> 8) : (result & 0xFF);
+		}
+		return;
+	}
+
+	if (msg->len == 0) {
+		return;
+	}
+	const uint8_t din = msg->buf[0];
+	dev->channel = (((din >> 4) & 0x03) << 1) | ((din >> 6) & 0x01);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t transaction_bus_ns(const struct i2c_msg* msgs, size_t num_msgs, uint32_t hz) {
+	if (hz == 0) {
+		return 0;
+	}
+
+	// START + address + ACK per message, 9 clocks per byte, and a final STOP
+	uint64_t bits = 1;
+	for (size_t i = 0; i < num_msgs; i++) {
+		bits += 1 + 9 + 9 * (uint64_t) msgs[i].len;
+	}
+	return bits * 1000000000ULL / hz;
+}
+
+int i2c_sim_transfer(uint8_t bus, struct i2c_msg* msgs, size_t num_msgs) {
+	if (bus >= I2C_SIM_MAX_BUSES || msgs == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&bus_locks[bus]);
+
+	size_t done = 0;
+	for (; done < num_msgs; done++) {
+		struct sim_device* dev = find_device(bus, msgs[done].addr & 0x7F);
+		if (dev == NULL) {
+			break;
+		}
+
+		switch (dev->type) {
+		case I2C_SIM_MCP23008:
+		case I2C_SIM_MCP23017:
+			mcp_transfer(dev, &msgs[done]);
+			break;
+		case I2C_SIM_PCA9685:
+			pca_transfer(dev, &msgs[done]);
+			break;
+		case I2C_SIM_ADS1015:
+			ads_transfer(dev, &msgs[done]);
+			break;
+		case I2C_SIM_LTC2309:
+			ltc_transfer(dev, &msgs[done]);
+			break;
+		}
+	}
+
+	// The transaction is aborted at the first NACK, like the kernel drivers do
+	const uint64_t ns = transaction_bus_ns(msgs, done < num_msgs ? done + 1 : done, atomic_load(&bus_speed));
+	if (ns > 0) {
+		const struct timespec wait = {.tv_sec = ns / 1000000000ULL, .tv_nsec = ns % 1000000000ULL};
+		clock_nanosleep(CLOCK_MONOTONIC, 0, &wait, NULL);
+		atomic_fetch_add_explicit(&stat_bus_ns, ns, memory_order_relaxed);
+	}
+
+	pthread_mutex_unlock(&bus_locks[bus]);
+
+	if (done < num_msgs) {
+		atomic_fetch_add_explicit(&stat_nacks, 1, memory_order_relaxed);
+		errno = EREMOTEIO;
+		return -1;
+	}
+	return (int) done;
+}
+
+int i2c_sim_set_inputs(uint8_t bus, uint8_t addr, uint16_t levels) {
+	struct sim_device* dev = find_device(bus, addr);
+	if (dev == NULL || (dev->type != I2C_SIM_MCP23008 && dev->type != I2C_SIM_MCP23017)) {
+		errno = ENODEV;
+		return -1;
+	}
+
+	pthread_mutex_lock(&bus_locks[bus]);
+	const uint16_t old_inputs = dev->inputs;
+	dev->inputs = levels;
+	mcp_update_interrupts(dev, old_inputs);
+	pthread_mutex_unlock(&bus_locks[bus]);
+
+	return 0;
+}
+
+int i2c_sim_set_analog(uint8_t bus, uint8_t addr, uint8_t channel, uint16_t value) {
+	struct sim_device* dev = find_device(bus, addr);
+	if (dev == NULL || (dev->type != I2C_SIM_ADS1015 && dev->type != I2C_SIM_LTC2309)) {
+		errno = ENODEV;
+		return -1;
+	}
+	if (channel >= I2C_SIM_MAX_CHANNELS) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&bus_locks[bus]);
+	dev->analog[channel] = value & 0x0FFF;
+	pthread_mutex_unlock(&bus_locks[bus]);
+
+	return 0;
+}
+
+int i2c_sim_peek(uint8_t bus, uint8_t addr, uint8_t reg) {
+	struct sim_device* dev = find_device(bus, addr);
+	if (dev == NULL) {
+		errno = ENODEV;
+		return -1;
+	}
+
+	pthread_mutex_lock(&bus_locks[bus]);
+	int value;
+	if (dev->type == I2C_SIM_ADS1015) {
+		value = dev->regs16[reg & 0x03];
+	}
+	else {
+		value = dev->regs[reg];
+	}
+	pthread_mutex_unlock(&bus_locks[bus]);
+
+	return value;
+}
+
+void i2c_sim_account(const struct i2c_msg* msgs, size_t num_msgs) {
+	uint64_t bytes = 0;
+	for (size_t i = 0; i < num_msgs; i++) {
+		bytes += msgs[i].len;
+	}
+
+	atomic_fetch_add_explicit(&stat_ioctls, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&stat_messages, num_msgs, memory_order_relaxed);
+	atomic_fetch_add_explicit(&stat_bytes, bytes, memory_order_relaxed);
+	atomic_fetch_add_explicit(&stat_wire_bytes, bytes + num_msgs, memory_order_relaxed);
+}
+
+void i2c_sim_get_stats(struct i2c_sim_stats* stats) {
+	stats->ioctls = atomic_load_explicit(&stat_ioctls, memory_order_relaxed);
+	stats->messages = atomic_load_explicit(&stat_messages, memory_order_relaxed);
+	stats->bytes = atomic_load_explicit(&stat_bytes, memory_order_relaxed);
+	stats->wire_bytes = atomic_load_explicit(&stat_wire_bytes, memory_order_relaxed);
+	stats->nacks = atomic_load_explicit(&stat_nacks, memory_order_relaxed);
+	stats->bus_ns = atomic_load_explicit(&stat_bus_ns, memory_order_relaxed);
+}
+
+void i2c_sim_clear_stats(void) {
+	atomic_store(&stat_ioctls, 0);
+	atomic_store(&stat_messages, 0);
+	atomic_store(&stat_bytes, 0);
+	atomic_store(&stat_wire_bytes, 0);
+	atomic_store(&stat_nacks, 0);
+	atomic_store(&stat_bus_ns, 0);
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __I2C_SIM_H__
+#define __I2C_SIM_H__
+
+/*
+ * i2c-sim models the register files of the peripherals supported by
+ * plc-peripherals behind a fake "/dev/i2c-N" character device. The
+ * benchmark programs link it with "-Wl,--wrap=open,--wrap=ioctl,..."
+ * so that the unmodified library talks to the simulated devices when
+ * the simulation is enabled, and to the real bus otherwise. In both
+ * cases every I2C_RDWR transaction is accounted in the statistics.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <linux/i2c.h>
+
+#define I2C_SIM_MAX_BUSES 8
+#define I2C_SIM_MAX_CHANNELS 8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	typedef enum {
+		I2C_SIM_MCP23008 = 0,
+		I2C_SIM_MCP23017,
+		I2C_SIM_PCA9685,
+		I2C_SIM_ADS1015,
+		I2C_SIM_LTC2309
+	} i2c_sim_device_type_t;
+
+	/**
+	 * @brief Counters of the I2C traffic seen by the transport layer.
+	 *
+	 * - @c ioctls: Number of I2C_RDWR ioctls issued.
+	 * - @c messages: Number of I2C messages (a START/repeated START each).
+	 * - @c bytes: Number of payload bytes transferred.
+	 * - @c wire_bytes: Payload bytes plus one address byte per message.
+	 * - @c nacks: Number of transactions not acknowledged by a simulated device.
+	 * - @c bus_ns: Modelled time on the wire, in nanoseconds (only simulated buses).
+	 */
+	struct i2c_sim_stats {
+		uint64_t ioctls;
+		uint64_t messages;
+		uint64_t bytes;
+		uint64_t wire_bytes;
+		uint64_t nacks;
+		uint64_t bus_ns;
+	};
+
+	/**
+	 * @brief Enables or disables the simulation.
+	 *
+	 * When enabled, opening "/dev/i2c-N" returns a simulated bus. When disabled,
+	 * the calls are forwarded to the real system calls (but still accounted).
+	 * It must be called before the I2C bus is opened.
+	 *
+	 * @param enable True to simulate the buses.
+	 */
+	void i2c_sim_enable(bool enable);
+
+	/**
+	 * @brief Returns whether the simulation is enabled.
+	 */
+	bool i2c_sim_is_enabled(void);
+
+	/**
+	 * @brief Removes all the simulated devices and clears the statistics.
+	 */
+	void i2c_sim_reset(void);
+
+	/**
+	 * @brief Adds a simulated device to a bus, in its power-on reset state.
+	 *
+	 * @param bus The I2C bus number (as in "/dev/i2c-N").
+	 * @param type The type of the device.
+	 * @param addr The 7-bit I2C address of the device.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EINVAL: The bus, type or address are invalid.
+	 *             - EEXIST: There is already a device with that address on the bus.
+	 *             - ENOMEM: There is no room for more devices.
+	 */
+	int i2c_sim_add_device(uint8_t bus, i2c_sim_device_type_t type, uint8_t addr);
+
+	/**
+	 * @brief Sets the modelled SCL frequency of the simulated buses.
+	 *
+	 * Each transaction sleeps the time it would take on a real bus at this
+	 * frequency, while holding the bus. A frequency of 0 answers instantly.
+	 *
+	 * @param hz The SCL frequency in Hertz (100000 by default).
+	 */
+	void i2c_sim_set_bus_speed(uint32_t hz);
+
+	/**
+	 * @brief Sets the level of the input pins of a simulated GPIO expander.
+	 *
+	 * @param bus The I2C bus number.
+	 * @param addr The I2C address of the MCP23008 or MCP23017.
+	 * @param levels Bitmask with the level of each pin (bit 0 == GP0 / GPA0).
+	 * @return 0 on success, -1 if the device doesn't exist (errno is set to ENODEV).
+	 */
+	int i2c_sim_set_inputs(uint8_t bus, uint8_t addr, uint16_t levels);
+
+	/**
+	 * @brief Sets the value that a simulated ADC returns for a channel.
+	 *
+	 * @param bus The I2C bus number.
+	 * @param addr The I2C address of the ADS1015 or LTC2309.
+	 * @param channel The channel index.
+	 * @param value The 12-bit conversion result.
+	 * @return 0 on success, -1 on failure (errno is set to ENODEV or EINVAL).
+	 */
+	int i2c_sim_set_analog(uint8_t bus, uint8_t addr, uint8_t channel, uint16_t value);
+
+	/**
+	 * @brief Reads back a register of a simulated device, without bus traffic.
+	 *
+	 * @param bus The I2C bus number.
+	 * @param addr The I2C address of the device.
+	 * @param reg The register address.
+	 * @return The register value, or -1 if the device doesn't exist.
+	 */
+	int i2c_sim_peek(uint8_t bus, uint8_t addr, uint8_t reg);
+
+	/**
+	 * @brief Executes the messages of an I2C_RDWR ioctl against a simulated bus.
+	 *
+	 * @param bus The I2C bus number.
+	 * @param msgs The messages of the transaction.
+	 * @param num_msgs The number of messages.
+	 * @return The number of messages transferred, or -1 with errno set to EREMOTEIO
+	 *         if no device acknowledged the address.
+	 */
+	int i2c_sim_transfer(uint8_t bus, struct i2c_msg* msgs, size_t num_msgs);
+
+	/**
+	 * @brief Accounts a transaction in the statistics.
+	 *
+	 * @param msgs The messages of the transaction.
+	 * @param num_msgs The number of messages.
+	 */
+	void i2c_sim_account(const struct i2c_msg* msgs, size_t num_msgs);
+
+	/**
+	 * @brief Copies the accumulated statistics.
+	 *
+	 * @param stats Where to store the statistics.
+	 */
+	void i2c_sim_get_stats(struct i2c_sim_stats* stats);
+
+	/**
+	 * @brief Clears the accumulated statistics.
+	 */
+	void i2c_sim_clear_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_SIM_H__
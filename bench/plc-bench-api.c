@@ -0,0 +1,746 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * plc-bench-api calls every public function of the peripheral drivers and
+ * of expanded-gpio in a loop, and reports what each call costs: wall and
+ * CPU time, and the I2C traffic (ioctls, messages and bytes on the wire)
+ * seen by the transport. The bytes per operation don't depend on the
+ * machine, so they can be tracked from one release to the next. It runs
+ * against the real bus, against the simulated peripherals of i2c-sim, or
+ * with libplc-i2c-preload.so answering the bus instantly, which leaves the
+ * CPU cost of the library alone.
+ */
+
+#define _GNU_SOURCE
+
+#include <plc-peripherals.h>
+#include <peripheral-mcp23017.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <dlfcn.h>
+
+#include "i2c-sim.h"
+
+#define NSEC_PER_SEC 1000000000LL
+
+// Iterations of the cases that initialize the whole library (they wait for the devices)
+#define INIT_LOOPS 20
+
+// Devices of the benchmark (they must exist on the real bus)
+#define MCP23008_ADDR 0x20
+#define MCP23017_ADDR 0x21
+#define PCA9685_ADDR 0x40
+#define ADS1015_ADDR 0x48
+#define LTC2309_ADDR 0x08
+
+typedef enum {
+	FORMAT_TEXT,
+	FORMAT_CSV,
+	FORMAT_JSON
+} output_format_t;
+
+struct options {
+	long loops;
+	bool real_bus;
+	bool preload;
+	uint32_t sim_bus_speed;
+	output_format_t format;
+	const char* filter;
+};
+
+struct bench_case {
+	const char* name;
+	int (*run)(long iteration);
+	long max_loops; // 0 to run the number of loops of the options
+};
+
+struct bench_result {
+	long loops;
+	long errors;
+	int64_t wall_ns;
+	int64_t cpu_ns;
+	struct i2c_sim_stats stats;
+};
+
+static const uint8_t mcp23008_addrs[] = {MCP23008_ADDR};
+static const uint8_t mcp23017_addrs[] = {MCP23017_ADDR};
+static const uint8_t pca9685_addrs[] = {PCA9685_ADDR};
+static const uint8_t ads1015_addrs[] = {ADS1015_ADDR};
+static const uint8_t ltc2309_addrs[] = {LTC2309_ADDR};
+
+// Bus used to call the drivers directly, apart from the one of expanded-gpio
+static i2c_interface_t* i2c;
+
+
+static void usage(const char* name) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -l LOOPS    number of calls of every function (default 100)\n"
+		"  -t FILTER   only run the functions whose name contains FILTER\n"
+		"  -f FORMAT   output format: text, csv or json (default text)\n"
+		"  -r          use the real I2C bus instead of the simulated one\n"
+		"  -p          use the bus of libplc-i2c-preload.so, given in LD_PRELOAD\n"
+		"  -S HZ       SCL frequency of the simulated bus (default 100000, 0 = no bus time)\n"
+		"\n"
+		"On the real bus, the devices must be at MCP23008 0x%02x, MCP23017 0x%02x,\n"
+		"PCA9685 0x%02x, ADS1015 0x%02x and LTC2309 0x%02x.\n",
+		name, MCP23008_ADDR, MCP23017_ADDR, PCA9685_ADDR, ADS1015_ADDR, LTC2309_ADDR);
+}
+
+static int parse_options(int argc, char* argv[], struct options* opts) {
+	*opts = (struct options) {
+		.loops = 100,
+		.real_bus = false,
+		.preload = false,
+		.sim_bus_speed = 100000,
+		.format = FORMAT_TEXT,
+		.filter = NULL,
+	};
+
+	int opt;
+	while ((opt = getopt(argc, argv, "l:t:f:rpS:")) != -1) {
+		switch (opt) {
+		case 'l':
+			opts->loops = strtol(optarg, NULL, 0);
+			break;
+		case 't':
+			opts->filter = optarg;
+			break;
+		case 'f':
+			if (strcmp(optarg, "text") == 0) {
+				opts->format = FORMAT_TEXT;
+			}
+			else if (strcmp(optarg, "csv") == 0) {
+				opts->format = FORMAT_CSV;
+			}
+			else if (strcmp(optarg, "json") == 0) {
+				opts->format = FORMAT_JSON;
+			}
+			else {
+				return -1;
+			}
+			break;
+		case 'r':
+			opts->real_bus = true;
+			break;
+		case 'p':
+			opts->preload = true;
+			break;
+		case 'S':
+			opts->sim_bus_speed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			return -1;
+		}
+	}
+
+	return opts->loops > 0 ? 0 : -1;
+}
+
+/**
+ * @brief Fills the peripherals struct (and the simulated bus) with one device of each type.
+ */
+static int setup_devices(const struct options* opts) {
+	_peripherals_struct = (struct peripherals_t) {
+		.arrayMCP23008 = mcp23008_addrs, .numArrayMCP23008 = 1,
+		.arrayADS1015 = ads1015_addrs, .numArrayADS1015 = 1,
+		.arrayPCA9685 = pca9685_addrs, .numArrayPCA9685 = 1,
+		.arrayLTC2309 = ltc2309_addrs, .numArrayLTC2309 = 1,
+		.arrayMCP23017 = mcp23017_addrs, .numArrayMCP23017 = 1,
+	};
+
+	if (opts->real_bus || opts->preload) {
+		return 0;
+	}
+
+	i2c_sim_enable(true);
+	i2c_sim_set_bus_speed(opts->sim_bus_speed);
+
+	if (i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23008, MCP23008_ADDR) != 0 ||
+	    i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23017, MCP23017_ADDR) != 0 ||
+	    i2c_sim_add_device(I2C_BUS, I2C_SIM_PCA9685, PCA9685_ADDR) != 0 ||
+	    i2c_sim_add_device(I2C_BUS, I2C_SIM_ADS1015, ADS1015_ADDR) != 0 ||
+	    i2c_sim_add_device(I2C_BUS, I2C_SIM_LTC2309, LTC2309_ADDR) != 0) {
+		return -1;
+	}
+	return 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Driver functions. The values change on every call, so no cache can skip the transfer.
+// The init functions of the expanders and the PCA9685 return 1 (and do less) if the
+// device is already initialized, so they are measured both ways.
+static int b_mcp23008_deinit_init(long it) {
+	(void) it;
+	if (mcp23008_deinit(i2c, MCP23008_ADDR) < 0) {
+		return -1;
+	}
+	return mcp23008_init(i2c, MCP23008_ADDR);
+}
+
+static int b_mcp23008_init_again(long it) {
+	(void) it;
+	return mcp23008_init(i2c, MCP23008_ADDR) == 1 ? 0 : -1;
+}
+
+static int b_mcp23008_set_pin_mode(long it) {
+	return mcp23008_set_pin_mode(i2c, MCP23008_ADDR, it % 4, it & 1 ? MCP23008_INPUT : MCP23008_OUTPUT);
+}
+
+static int b_mcp23008_set_pin_mode_all(long it) {
+	return mcp23008_set_pin_mode_all(i2c, MCP23008_ADDR, it & 1 ? 0xF0 : 0x0F);
+}
+
+static int b_mcp23008_write(long it) {
+	return mcp23008_write(i2c, MCP23008_ADDR, it % MCP23008_NUM_IO, it & 1);
+}
+
+static int b_mcp23008_read(long it) {
+	uint8_t value;
+	return mcp23008_read(i2c, MCP23008_ADDR, it % MCP23008_NUM_IO, &value);
+}
+
+static int b_mcp23008_write_all(long it) {
+	return mcp23008_write_all(i2c, MCP23008_ADDR, it & 0xFF);
+}
+
+static int b_mcp23008_read_all(long it) {
+	(void) it;
+	uint8_t value;
+	return mcp23008_read_all(i2c, MCP23008_ADDR, &value);
+}
+
+static int b_mcp23008_read_state(long it) {
+	(void) it;
+	uint8_t state[MCP23008_STATE_SIZE];
+	return mcp23008_read_state(i2c, MCP23008_ADDR, state);
+}
+
+static int b_mcp23008_set_interrupt(long it) {
+	return mcp23008_set_interrupt(i2c, MCP23008_ADDR, it % MCP23008_NUM_IO, it & 1 ? MCP23008_INT_ON_CHANGE : MCP23008_INT_DISABLED);
+}
+
+static int b_mcp23008_set_interrupt_all(long it) {
+	return mcp23008_set_interrupt_all(i2c, MCP23008_ADDR, it & 0xFF, 0x00, 0x00);
+}
+
+static int b_mcp23008_read_interrupt(long it) {
+	(void) it;
+	uint8_t flags, captured;
+	return mcp23008_read_interrupt(i2c, MCP23008_ADDR, &flags, &captured);
+}
+
+static int b_mcp23017_deinit_init(long it) {
+	(void) it;
+	if (mcp23017_deinit(i2c, MCP23017_ADDR) < 0) {
+		return -1;
+	}
+	return mcp23017_init(i2c, MCP23017_ADDR);
+}
+
+static int b_mcp23017_init_again(long it) {
+	(void) it;
+	return mcp23017_init(i2c, MCP23017_ADDR) == 1 ? 0 : -1;
+}
+
+static int b_mcp23017_set_pin_mode(long it) {
+	return mcp23017_set_pin_mode(i2c, MCP23017_ADDR, it % 8, it & 1 ? MCP23017_INPUT : MCP23017_OUTPUT);
+}
+
+static int b_mcp23017_set_pin_mode_all(long it) {
+	return mcp23017_set_pin_mode_all(i2c, MCP23017_ADDR, it & 1 ? 0xFF00 : 0x00FF);
+}
+
+static int b_mcp23017_write(long it) {
+	return mcp23017_write(i2c, MCP23017_ADDR, it % MCP23017_NUM_IO, it & 1);
+}
+
+static int b_mcp23017_read(long it) {
+	uint8_t value;
+	return mcp23017_read(i2c, MCP23017_ADDR, it % MCP23017_NUM_IO, &value);
+}
+
+static int b_mcp23017_write_all(long it) {
+	return mcp23017_write_all(i2c, MCP23017_ADDR, it & 0xFFFF);
+}
+
+static int b_mcp23017_read_all(long it) {
+	(void) it;
+	uint16_t value;
+	return mcp23017_read_all(i2c, MCP23017_ADDR, &value);
+}
+
+static int b_mcp23017_read_state(long it) {
+	(void) it;
+	uint8_t state[MCP23017_STATE_SIZE];
+	return mcp23017_read_state(i2c, MCP23017_ADDR, state);
+}
+
+static int b_mcp23017_set_interrupt(long it) {
+	return mcp23017_set_interrupt(i2c, MCP23017_ADDR, it % MCP23017_NUM_IO, it & 1 ? MCP23017_INT_ON_CHANGE : MCP23017_INT_DISABLED);
+}
+
+static int b_mcp23017_set_interrupt_all(long it) {
+	return mcp23017_set_interrupt_all(i2c, MCP23017_ADDR, it & 0xFFFF, 0x0000, 0x0000);
+}
+
+static int b_mcp23017_read_interrupt(long it) {
+	(void) it;
+	uint16_t flags, captured;
+	return mcp23017_read_interrupt(i2c, MCP23017_ADDR, &flags, &captured);
+}
+
+static int b_pca9685_deinit_init(long it) {
+	(void) it;
+	if (pca9685_deinit(i2c, PCA9685_ADDR) < 0) {
+		return -1;
+	}
+	return pca9685_init(i2c, PCA9685_ADDR);
+}
+
+static int b_pca9685_init_again(long it) {
+	(void) it;
+	return pca9685_init(i2c, PCA9685_ADDR) == 1 ? 0 : -1;
+}
+
+static int b_pca9685_write(long it) {
+	return pca9685_write(i2c, PCA9685_ADDR, it % PCA9685_NUM_OUTPUTS, it & 1);
+}
+
+static int b_pca9685_write_all(long it) {
+	return pca9685_write_all(i2c, PCA9685_ADDR, it & 0xFFFF);
+}
+
+static int b_pca9685_pwm_frequency(long it) {
+	return pca9685_pwm_frequency(i2c, PCA9685_ADDR, it & 1 ? 0x1E : 0x79);
+}
+
+static int b_pca9685_pwm_write(long it) {
+	return pca9685_pwm_write(i2c, PCA9685_ADDR, it % PCA9685_NUM_OUTPUTS, (it * 37) & 0x0FFF);
+}
+
+static int b_pca9685_pwm_write_all(long it) {
+	uint16_t values[PCA9685_NUM_OUTPUTS];
+	for (size_t i = 0; i < PCA9685_NUM_OUTPUTS; i++) {
+		values[i] = (it * 37 + i * 256) & 0x0FFF;
+	}
+	return pca9685_pwm_write_all(i2c, PCA9685_ADDR, values);
+}
+
+static int b_pca9685_read_state(long it) {
+	(void) it;
+	uint8_t state[PCA9685_STATE_SIZE];
+	return pca9685_read_state(i2c, PCA9685_ADDR, state);
+}
+
+static int b_ads1015_init(long it) {
+	(void) it;
+	return ads1015_init(i2c, ADS1015_ADDR);
+}
+
+static int b_ads1015_read(long it) {
+	int16_t value;
+	return ads1015_read(i2c, ADS1015_ADDR, it % ADS1015_NUM_INPUTS, &value);
+}
+
+static int b_ads1015_unsigned_read(long it) {
+	uint16_t value;
+	return ads1015_unsigned_read(i2c, ADS1015_ADDR, it % ADS1015_NUM_INPUTS, &value);
+}
+
+static int b_ads1015_start_conversion(long it) {
+	return ads1015_start_conversion(i2c, ADS1015_ADDR, it % ADS1015_NUM_INPUTS);
+}
+
+static int b_ads1015_read_conversion(long it) {
+	(void) it;
+	int16_t value;
+	return ads1015_read_conversion(i2c, ADS1015_ADDR, &value);
+}
+
+static int b_ads1015_deinit(long it) {
+	(void) it;
+	return ads1015_deinit(i2c, ADS1015_ADDR);
+}
+
+static int b_ltc2309_init(long it) {
+	(void) it;
+	return ltc2309_init(i2c, LTC2309_ADDR);
+}
+
+static int b_ltc2309_read(long it) {
+	uint16_t value;
+	return ltc2309_read(i2c, LTC2309_ADDR, it % LTC2309_NUM_INPUTS, &value);
+}
+
+static int b_ltc2309_deinit(long it) {
+	(void) it;
+	return ltc2309_deinit(i2c, LTC2309_ADDR);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// expanded-gpio functions, on the devices initialized by initExpandedGPIO
+static int b_pinMode(long it) {
+	return pinMode(MAKE_PIN_MCP23008(MCP23008_ADDR, it % 4), it & 1 ? INPUT : OUTPUT);
+}
+
+static int b_digitalWrite_mcp23008(long it) {
+	// The first pins are switched between input and output by b_pinMode
+	const uint8_t index = 4 + it % 4;
+	return digitalWrite(MAKE_PIN_MCP23008(MCP23008_ADDR, index), it & 1);
+}
+
+static int b_digitalRead_mcp23008(long it) {
+	(void) digitalRead(MAKE_PIN_MCP23008(MCP23008_ADDR, it % MCP23008_NUM_IO));
+	return 0;
+}
+
+static int b_digitalWrite_mcp23017(long it) {
+	return digitalWrite(MAKE_PIN_MCP23017(MCP23017_ADDR, it % MCP23017_NUM_IO), it & 1);
+}
+
+static int b_digitalRead_mcp23017(long it) {
+	(void) digitalRead(MAKE_PIN_MCP23017(MCP23017_ADDR, it % MCP23017_NUM_IO));
+	return 0;
+}
+
+static int b_digitalWrite_pca9685(long it) {
+	return digitalWrite(MAKE_PIN_PCA9685(PCA9685_ADDR, it % PCA9685_NUM_OUTPUTS), it & 1);
+}
+
+static int b_analogWrite(long it) {
+	return analogWrite(MAKE_PIN_PCA9685(PCA9685_ADDR, it % PCA9685_NUM_OUTPUTS), (it * 37) & 0x0FFF);
+}
+
+static int b_analogWriteSetFrequency(long it) {
+	return analogWriteSetFrequency(MAKE_PIN_PCA9685(PCA9685_ADDR, 0), it & 1 ? 200 : 50);
+}
+
+static int b_analogRead_ads1015(long it) {
+	(void) analogRead(MAKE_PIN_ADS1015(ADS1015_ADDR, it % ADS1015_NUM_INPUTS));
+	return 0;
+}
+
+static int b_analogRead_ltc2309(long it) {
+	(void) analogRead(MAKE_PIN_LTC2309(LTC2309_ADDR, it % LTC2309_NUM_INPUTS));
+	return 0;
+}
+
+static int b_digitalWriteAll_mcp23008(long it) {
+	return digitalWriteAll(MCP23008_ADDR, it & 0xFF);
+}
+
+static int b_digitalReadAll_mcp23008(long it) {
+	(void) it;
+	uint8_t values;
+	return digitalReadAll(MCP23008_ADDR, &values);
+}
+
+static int b_digitalWriteAll_mcp23017(long it) {
+	return digitalWriteAll(MCP23017_ADDR, it & 0xFFFF);
+}
+
+static int b_digitalReadAll_mcp23017(long it) {
+	(void) it;
+	uint16_t values;
+	return digitalReadAll(MCP23017_ADDR, &values);
+}
+
+static int b_digitalWriteAll_pca9685(long it) {
+	return digitalWriteAll(PCA9685_ADDR, it & 0xFFFF);
+}
+
+static int b_analogWriteAll(long it) {
+	uint16_t values[PCA9685_NUM_OUTPUTS];
+	for (size_t i = 0; i < PCA9685_NUM_OUTPUTS; i++) {
+		values[i] = (it * 37 + i * 256) & 0x0FFF;
+	}
+	return analogWriteAll(PCA9685_ADDR, values);
+}
+
+static int b_digitalWriteAllBatch(long it) {
+	expanded_gpio_write_all_t ops[] = {
+		{.device = MAKE_PIN_MCP23008(MCP23008_ADDR, 0), .values = it & 0xFF},
+		{.device = MAKE_PIN_MCP23017(MCP23017_ADDR, 0), .values = it & 0xFFFF},
+	};
+	return digitalWriteAllBatch(ops, sizeof(ops) / sizeof(ops[0]));
+}
+
+static int b_digitalReadAllBatch(long it) {
+	(void) it;
+	expanded_gpio_read_all_t ops[] = {
+		{.device = MAKE_PIN_MCP23008(MCP23008_ADDR, 0)},
+		{.device = MAKE_PIN_MCP23017(MCP23017_ADDR, 0)},
+	};
+	return digitalReadAllBatch(ops, sizeof(ops) / sizeof(ops[0]));
+}
+
+static int b_initExpandedGPIO(long it) {
+	(void) it;
+	int ret = deinitExpandedGPIO();
+	return ret != 0 ? ret : initExpandedGPIO(false);
+}
+
+// It leaves the library in lazy mode, so it must be the last case
+static int b_initExpandedGPIOLazy(long it) {
+	(void) it;
+	int ret = deinitExpandedGPIO();
+	return ret != 0 ? ret : initExpandedGPIOLazy(false);
+}
+
+static const struct bench_case DRIVER_CASES[] = {
+	{"mcp23008_deinit+init", b_mcp23008_deinit_init, 0},
+	{"mcp23008_init(initialized)", b_mcp23008_init_again, 0},
+	{"mcp23008_set_pin_mode", b_mcp23008_set_pin_mode, 0},
+	{"mcp23008_set_pin_mode_all", b_mcp23008_set_pin_mode_all, 0},
+	{"mcp23008_write", b_mcp23008_write, 0},
+	{"mcp23008_read", b_mcp23008_read, 0},
+	{"mcp23008_write_all", b_mcp23008_write_all, 0},
+	{"mcp23008_read_all", b_mcp23008_read_all, 0},
+	{"mcp23008_read_state", b_mcp23008_read_state, 0},
+	{"mcp23008_set_interrupt", b_mcp23008_set_interrupt, 0},
+	{"mcp23008_set_interrupt_all", b_mcp23008_set_interrupt_all, 0},
+	{"mcp23008_read_interrupt", b_mcp23008_read_interrupt, 0},
+	{"mcp23017_deinit+init", b_mcp23017_deinit_init, 0},
+	{"mcp23017_init(initialized)", b_mcp23017_init_again, 0},
+	{"mcp23017_set_pin_mode", b_mcp23017_set_pin_mode, 0},
+	{"mcp23017_set_pin_mode_all", b_mcp23017_set_pin_mode_all, 0},
+	{"mcp23017_write", b_mcp23017_write, 0},
+	{"mcp23017_read", b_mcp23017_read, 0},
+	{"mcp23017_write_all", b_mcp23017_write_all, 0},
+	{"mcp23017_read_all", b_mcp23017_read_all, 0},
+	{"mcp23017_read_state", b_mcp23017_read_state, 0},
+	{"mcp23017_set_interrupt", b_mcp23017_set_interrupt, 0},
+	{"mcp23017_set_interrupt_all", b_mcp23017_set_interrupt_all, 0},
+	{"mcp23017_read_interrupt", b_mcp23017_read_interrupt, 0},
+	{"pca9685_deinit+init", b_pca9685_deinit_init, 0},
+	{"pca9685_init(initialized)", b_pca9685_init_again, 0},
+	{"pca9685_write", b_pca9685_write, 0},
+	{"pca9685_write_all", b_pca9685_write_all, 0},
+	{"pca9685_pwm_frequency", b_pca9685_pwm_frequency, 0},
+	{"pca9685_pwm_write", b_pca9685_pwm_write, 0},
+	{"pca9685_pwm_write_all", b_pca9685_pwm_write_all, 0},
+	{"pca9685_read_state", b_pca9685_read_state, 0},
+	{"ads1015_init", b_ads1015_init, 0},
+	{"ads1015_read", b_ads1015_read, 0},
+	{"ads1015_unsigned_read", b_ads1015_unsigned_read, 0},
+	{"ads1015_start_conversion", b_ads1015_start_conversion, 0},
+	{"ads1015_read_conversion", b_ads1015_read_conversion, 0},
+	{"ads1015_deinit", b_ads1015_deinit, 0},
+	{"ltc2309_init", b_ltc2309_init, 0},
+	{"ltc2309_read", b_ltc2309_read, 0},
+	{"ltc2309_deinit", b_ltc2309_deinit, 0},
+};
+
+static const struct bench_case EXPANDED_CASES[] = {
+	{"pinMode(MCP23008)", b_pinMode, 0},
+	{"digitalWrite(MCP23008)", b_digitalWrite_mcp23008, 0},
+	{"digitalRead(MCP23008)", b_digitalRead_mcp23008, 0},
+	{"digitalWrite(MCP23017)", b_digitalWrite_mcp23017, 0},
+	{"digitalRead(MCP23017)", b_digitalRead_mcp23017, 0},
+	{"digitalWrite(PCA9685)", b_digitalWrite_pca9685, 0},
+	{"analogWrite(PCA9685)", b_analogWrite, 0},
+	{"analogWriteSetFrequency(PCA9685)", b_analogWriteSetFrequency, 0},
+	{"analogRead(ADS1015)", b_analogRead_ads1015, 0},
+	{"analogRead(LTC2309)", b_analogRead_ltc2309, 0},
+	{"digitalWriteAll(MCP23008)", b_digitalWriteAll_mcp23008, 0},
+	{"digitalReadAll(MCP23008)", b_digitalReadAll_mcp23008, 0},
+	{"digitalWriteAll(MCP23017)", b_digitalWriteAll_mcp23017, 0},
+	{"digitalReadAll(MCP23017)", b_digitalReadAll_mcp23017, 0},
+	{"digitalWriteAll(PCA9685)", b_digitalWriteAll_pca9685, 0},
+	{"analogWriteAll(PCA9685)", b_analogWriteAll, 0},
+	{"digitalWriteAllBatch(2)", b_digitalWriteAllBatch, 0},
+	{"digitalReadAllBatch(2)", b_digitalReadAllBatch, 0},
+	{"deinitExpandedGPIO+initExpandedGPIO", b_initExpandedGPIO, INIT_LOOPS},
+	{"deinitExpandedGPIO+initExpandedGPIOLazy", b_initExpandedGPIOLazy, INIT_LOOPS},
+};
+
+
+static inline int64_t clock_ns(clockid_t clock) {
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void run_case(const struct bench_case* c, long loops, struct bench_result* result) {
+	if (c->max_loops > 0 && loops > c->max_loops) {
+		loops = c->max_loops;
+	}
+	*result = (struct bench_result) {.loops = loops};
+
+	i2c_sim_clear_stats();
+	const int64_t wall_start = clock_ns(CLOCK_MONOTONIC);
+	const int64_t cpu_start = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+
+	for (long it = 0; it < loops; it++) {
+		if (c->run(it) != 0) {
+			result->errors++;
+		}
+	}
+
+	result->cpu_ns = clock_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+	result->wall_ns = clock_ns(CLOCK_MONOTONIC) - wall_start;
+	i2c_sim_get_stats(&result->stats);
+}
+
+static void print_header(const struct options* opts) {
+	switch (opts->format) {
+	case FORMAT_TEXT:
+		printf("# plc-bench-api: ");
+		if (opts->real_bus) {
+			printf("real bus /dev/i2c-%d", I2C_BUS);
+		}
+		else if (opts->preload) {
+			printf("preloaded bus, no bus time and no sleeps");
+		}
+		else {
+			printf("simulated bus at %u Hz", opts->sim_bus_speed);
+		}
+		printf(", library %s\n", LIB_PLC_PERIPHERALS_VERSION);
+		printf("# Per call: wall and CPU time in ns, ioctls, I2C messages, payload bytes and bytes on the wire\n");
+		printf("%-40s %8s %6s %10s %10s %7s %7s %7s %7s\n",
+		       "function", "loops", "errors", "wall_ns", "cpu_ns", "ioctls", "msgs", "bytes", "wire");
+		break;
+	case FORMAT_CSV:
+		printf("function,loops,errors,wall_ns,cpu_ns,ioctls,messages,bytes,wire_bytes,bus_ns\n");
+		break;
+	case FORMAT_JSON:
+		printf("{\n");
+		printf("  \"library\": \"%s\",\n", LIB_PLC_PERIPHERALS_VERSION);
+		if (opts->real_bus) {
+			printf("  \"bus\": \"/dev/i2c-%d\",\n", I2C_BUS);
+		}
+		else if (opts->preload) {
+			printf("  \"bus\": \"preload\",\n");
+		}
+		else {
+			printf("  \"bus\": \"simulated\",\n");
+			printf("  \"bus_speed_hz\": %u,\n", opts->sim_bus_speed);
+		}
+		printf("  \"results\": [");
+		break;
+	}
+}
+
+static void print_result(const struct options* opts, const char* name, const struct bench_result* r, bool first) {
+	const double loops = r->loops;
+	const double wall_ns = r->wall_ns / loops;
+	const double cpu_ns = r->cpu_ns / loops;
+	const double ioctls = r->stats.ioctls / loops;
+	const double messages = r->stats.messages / loops;
+	const double bytes = r->stats.bytes / loops;
+	const double wire_bytes = r->stats.wire_bytes / loops;
+	const double bus_ns = r->stats.bus_ns / loops;
+
+	switch (opts->format) {
+	case FORMAT_TEXT:
+		printf("%-40s %8ld %6ld %10.0f %10.0f %7.2f %7.2f %7.2f %7.2f\n",
+		       name, r->loops, r->errors, wall_ns, cpu_ns, ioctls, messages, bytes, wire_bytes);
+		break;
+	case FORMAT_CSV:
+		printf("%s,%ld,%ld,%.0f,%.0f,%.2f,%.2f,%.2f,%.2f,%.0f\n",
+		       name, r->loops, r->errors, wall_ns, cpu_ns, ioctls, messages, bytes, wire_bytes, bus_ns);
+		break;
+	case FORMAT_JSON:
+		printf("%s\n    {\"function\": \"%s\", \"loops\": %ld, \"errors\": %ld, "
+		       "\"wall_ns\": %.0f, \"cpu_ns\": %.0f, \"ioctls\": %.2f, \"messages\": %.2f, "
+		       "\"bytes\": %.2f, \"wire_bytes\": %.2f, \"bus_ns\": %.0f}",
+		       first ? "" : ",", name, r->loops, r->errors, wall_ns, cpu_ns, ioctls, messages, bytes, wire_bytes, bus_ns);
+		break;
+	}
+}
+
+static void print_footer(const struct options* opts) {
+	if (opts->format == FORMAT_JSON) {
+		printf("\n  ]\n}\n");
+	}
+}
+
+/**
+ * @brief Runs the cases whose name matches the filter.
+ *
+ * @param num_printed Number of results already printed.
+ * @return The number of results printed, including the previous ones.
+ */
+static size_t run_cases(const struct options* opts, const struct bench_case* cases, size_t num_cases, size_t num_printed) {
+	for (size_t i = 0; i < num_cases; i++) {
+		if (opts->filter != NULL && strstr(cases[i].name, opts->filter) == NULL) {
+			continue;
+		}
+
+		struct bench_result result;
+		run_case(&cases[i], opts->loops, &result);
+		print_result(opts, cases[i].name, &result, num_printed == 0);
+		num_printed++;
+	}
+	return num_printed;
+}
+
+int main(int argc, char* argv[]) {
+	struct options opts;
+	if (parse_options(argc, argv, &opts) != 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// Without the shim, the calls would go to the real bus
+	if (opts.preload && dlsym(RTLD_DEFAULT, "i2c_preload_get_stats") == NULL) {
+		fprintf(stderr, "-p needs LD_PRELOAD=libplc-i2c-preload.so\n");
+		return EXIT_FAILURE;
+	}
+
+	if (setup_devices(&opts) != 0) {
+		fprintf(stderr, "Could not create the simulated bus: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	i2c = i2c_init(I2C_BUS);
+	if (i2c == NULL) {
+		fprintf(stderr, "Could not open /dev/i2c-%d: %s\n", I2C_BUS, strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	print_header(&opts);
+	size_t num_printed = run_cases(&opts, DRIVER_CASES, sizeof(DRIVER_CASES) / sizeof(DRIVER_CASES[0]), 0);
+
+	int ret = initExpandedGPIO(false);
+	if (ret != 0) {
+		fprintf(stderr, "initExpandedGPIO failed with %d: %s\n", ret, strerror(errno));
+		i2c_deinit(&i2c);
+		return EXIT_FAILURE;
+	}
+
+	run_cases(&opts, EXPANDED_CASES, sizeof(EXPANDED_CASES) / sizeof(EXPANDED_CASES[0]), num_printed);
+	print_footer(&opts);
+
+	ret = deinitExpandedGPIO();
+	i2c_deinit(&i2c);
+	if (ret != 0) {
+		fprintf(stderr, "deinitExpandedGPIO failed with %d: %s\n", ret, strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,624 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * plc-bench-contention starts N threads that call expanded-gpio at the
+ * same time, as the HMI, logger and control threads of an application do,
+ * and reports how the throughput and the latency change with the number of
+ * threads. Every bus slot has the same simulated devices, and thread i
+ * works on the devices of slot i % BUSES, so the runs with one bus measure
+ * the contention on a single lock and the runs with several buses measure
+ * how well the work spreads over them.
+ *
+ * Two strategies are compared:
+ * - pin: digitalWrite/digitalRead of single pins, which only lock the bus
+ *   of the pin.
+ * - batch: digitalWriteAllBatch/digitalReadAllBatch of whole ports, which
+ *   lock all the buses.
+ * Both read an ADC channel and write a PWM output with analogRead and
+ * analogWrite in between.
+ */
+
+#define _GNU_SOURCE
+
+#include <plc-peripherals.h>
+#include <peripheral-mcp23017.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "i2c-sim.h"
+
+#define NSEC_PER_SEC 1000000000LL
+
+#define MAX_THREADS 64
+#define MAX_SWEEP 16
+
+// The devices of every bus slot
+#define MCP23008_ADDR 0x20
+#define MCP23017_ADDR 0x21
+#define PCA9685_ADDR 0x40
+#define LTC2309_ADDR 0x08
+
+static const uint8_t BUS_MCP23008[] = {MCP23008_ADDR};
+static const uint8_t BUS_MCP23017[] = {MCP23017_ADDR};
+static const uint8_t BUS_PCA9685[] = {PCA9685_ADDR};
+static const uint8_t BUS_LTC2309[] = {LTC2309_ADDR};
+static const uint8_t NO_DEVICES[] = {0};
+
+static const struct peripherals_t BUS_DEVICES = {
+	.arrayMCP23008 = BUS_MCP23008,
+	.numArrayMCP23008 = 1,
+	.arrayADS1015 = NO_DEVICES,
+	.numArrayADS1015 = 0,
+	.arrayPCA9685 = BUS_PCA9685,
+	.numArrayPCA9685 = 1,
+	.arrayLTC2309 = BUS_LTC2309,
+	.numArrayLTC2309 = 1,
+	.arrayMCP23017 = BUS_MCP23017,
+	.numArrayMCP23017 = 1,
+};
+
+typedef enum {
+	FORMAT_TEXT,
+	FORMAT_CSV,
+	FORMAT_JSON
+} output_format_t;
+
+typedef enum {
+	STRATEGY_PIN,
+	STRATEGY_BATCH,
+	NUM_STRATEGIES
+} strategy_t;
+
+static const char* const STRATEGY_NAMES[NUM_STRATEGIES] = {
+	[STRATEGY_PIN] = "pin",
+	[STRATEGY_BATCH] = "batch",
+};
+
+struct options {
+	long ops; // Per thread
+	long threads[MAX_SWEEP];
+	size_t num_threads;
+	long buses[MAX_SWEEP];
+	size_t num_buses;
+	bool strategies[NUM_STRATEGIES];
+	uint32_t sim_bus_speed;
+	bool per_thread;
+	output_format_t format;
+};
+
+struct latency {
+	int64_t avg_ns;
+	int64_t p50_ns;
+	int64_t p99_ns;
+	int64_t max_ns;
+};
+
+struct worker {
+	pthread_t thread;
+	unsigned int index;
+	uint8_t slot;
+	strategy_t strategy;
+	long ops;
+	pthread_barrier_t* start;
+	int64_t* times;
+	long errors;
+	int64_t elapsed_ns;
+	struct latency latency;
+};
+
+struct run_result {
+	long buses;
+	strategy_t strategy;
+	long threads;
+	long ops;
+	long errors;
+	int64_t wall_ns;
+	double ops_per_sec;
+	double speedup; // Against the first thread count of the sweep
+	struct latency latency;
+	expanded_gpio_lock_stats_t locks; // Of all the slots
+};
+
+
+static void usage(const char* name) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -t LIST     comma-separated numbers of threads (default 1,2,4,8, at most %d)\n"
+		"  -b LIST     comma-separated numbers of buses (default 1,%d)\n"
+		"  -s LIST     comma-separated strategies: pin, batch (default pin,batch)\n"
+		"  -l OPS      operations of every thread (default 200)\n"
+		"  -f FORMAT   output format: text, csv or json (default text)\n"
+		"  -v          also report every thread\n"
+		"  -S HZ       SCL frequency of the simulated buses (default 100000, 0 = no bus time)\n",
+		name, MAX_THREADS, EXPANDED_GPIO_MAX_BUSES);
+}
+
+/**
+ * @brief Parses a comma-separated list of numbers between min and max.
+ *
+ * @return The number of values, or 0 if the list is invalid.
+ */
+static size_t parse_list(const char* arg, long* values, long min, long max) {
+	size_t num_values = 0;
+	const char* p = arg;
+	while (*p != '\0') {
+		char* end;
+		const long value = strtol(p, &end, 0);
+		if (end == p || value < min || value > max || num_values == MAX_SWEEP) {
+			return 0;
+		}
+		values[num_values++] = value;
+
+		if (*end == ',') {
+			end++;
+		}
+		else if (*end != '\0') {
+			return 0;
+		}
+		p = end;
+	}
+	return num_values;
+}
+
+static int parse_strategies(const char* arg, bool* strategies) {
+	char* list = strdup(arg);
+	if (list == NULL) {
+		return -1;
+	}
+
+	memset(strategies, 0, NUM_STRATEGIES * sizeof(bool));
+
+	int ret = 0;
+	char* saveptr;
+	for (char* name = strtok_r(list, ",", &saveptr); name != NULL && ret == 0; name = strtok_r(NULL, ",", &saveptr)) {
+		ret = -1;
+		for (size_t i = 0; i < NUM_STRATEGIES; i++) {
+			if (strcmp(name, STRATEGY_NAMES[i]) == 0) {
+				strategies[i] = true;
+				ret = 0;
+			}
+		}
+	}
+
+	free(list);
+	return ret;
+}
+
+static int parse_options(int argc, char* argv[], struct options* opts) {
+	*opts = (struct options) {
+		.ops = 200,
+		.threads = {1, 2, 4, 8},
+		.num_threads = 4,
+		.buses = {1, EXPANDED_GPIO_MAX_BUSES},
+		.num_buses = EXPANDED_GPIO_MAX_BUSES > 1 ? 2 : 1,
+		.strategies = {true, true},
+		.sim_bus_speed = 100000,
+		.per_thread = false,
+		.format = FORMAT_TEXT,
+	};
+
+	int opt;
+	while ((opt = getopt(argc, argv, "t:b:s:l:f:vS:")) != -1) {
+		switch (opt) {
+		case 't':
+			opts->num_threads = parse_list(optarg, opts->threads, 1, MAX_THREADS);
+			if (opts->num_threads == 0) {
+				return -1;
+			}
+			break;
+		case 'b':
+			opts->num_buses = parse_list(optarg, opts->buses, 1, EXPANDED_GPIO_MAX_BUSES);
+			if (opts->num_buses == 0) {
+				return -1;
+			}
+			break;
+		case 's':
+			if (parse_strategies(optarg, opts->strategies) != 0) {
+				return -1;
+			}
+			break;
+		case 'l':
+			opts->ops = strtol(optarg, NULL, 0);
+			break;
+		case 'f':
+			if (strcmp(optarg, "text") == 0) {
+				opts->format = FORMAT_TEXT;
+			}
+			else if (strcmp(optarg, "csv") == 0) {
+				opts->format = FORMAT_CSV;
+			}
+			else if (strcmp(optarg, "json") == 0) {
+				opts->format = FORMAT_JSON;
+			}
+			else {
+				return -1;
+			}
+			break;
+		case 'v':
+			opts->per_thread = true;
+			break;
+		case 'S':
+			opts->sim_bus_speed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			return -1;
+		}
+	}
+
+	return opts->ops > 0 ? 0 : -1;
+}
+
+static inline int64_t clock_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static int compare_ns(const void* a, const void* b) {
+	const int64_t x = *(const int64_t*) a;
+	const int64_t y = *(const int64_t*) b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief Sorts the times of some operations and summarizes them.
+ */
+static void summarize(int64_t* times, size_t num_times, struct latency* latency) {
+	qsort(times, num_times, sizeof(int64_t), compare_ns);
+
+	int64_t sum = 0;
+	for (size_t i = 0; i < num_times; i++) {
+		sum += times[i];
+	}
+
+	latency->avg_ns = sum / (int64_t) num_times;
+	latency->p50_ns = times[num_times / 2];
+	latency->p99_ns = times[(num_times * 99) / 100];
+	latency->max_ns = times[num_times - 1];
+}
+
+/**
+ * @brief Runs one operation of the mix on the devices of a slot.
+ *
+ * @return true if it succeeded.
+ */
+static bool run_operation(strategy_t strategy, uint8_t slot, long op) {
+	const uint8_t index = op / 4;
+
+	switch (op % 4) {
+	case 0:
+		if (strategy == STRATEGY_PIN) {
+			return digitalWrite(PIN_ON_BUS(slot, MAKE_PIN_MCP23008(MCP23008_ADDR, index % 8)), index & 1) == 0;
+		}
+		else {
+			expanded_gpio_write_all_t write = {
+				.device = PIN_ON_BUS(slot, MAKE_PIN_MCP23008(MCP23008_ADDR, 0)),
+				.values = index,
+			};
+			return digitalWriteAllBatch(&write, 1) == 0;
+		}
+	case 1:
+		if (strategy == STRATEGY_PIN) {
+			return digitalRead(PIN_ON_BUS(slot, MAKE_PIN_MCP23017(MCP23017_ADDR, index % 16))) >= 0;
+		}
+		else {
+			expanded_gpio_read_all_t read = {
+				.device = PIN_ON_BUS(slot, MAKE_PIN_MCP23017(MCP23017_ADDR, 0)),
+			};
+			return digitalReadAllBatch(&read, 1) == 0;
+		}
+	case 2: {
+		volatile uint16_t value = analogRead(PIN_ON_BUS(slot, MAKE_PIN_LTC2309(LTC2309_ADDR, index % LTC2309_NUM_INPUTS)));
+		(void) value;
+		return true;
+	}
+	default:
+		return analogWrite(PIN_ON_BUS(slot, MAKE_PIN_PCA9685(PCA9685_ADDR, index % PCA9685_NUM_OUTPUTS)), (index * 16) & 0x0FFF) == 0;
+	}
+}
+
+static void* worker_thread(void* arg) {
+	struct worker* w = arg;
+
+	pthread_barrier_wait(w->start);
+
+	const int64_t start = clock_ns();
+	for (long op = 0; op < w->ops; op++) {
+		// Every thread starts at a different point of the mix
+		const long mixed_op = op + w->index;
+
+		const int64_t op_start = clock_ns();
+		if (!run_operation(w->strategy, w->slot, mixed_op)) {
+			w->errors++;
+		}
+		w->times[op] = clock_ns() - op_start;
+	}
+	w->elapsed_ns = clock_ns() - start;
+
+	return NULL;
+}
+
+static void sum_lock_stats(expanded_gpio_lock_stats_t* total) {
+	*total = (expanded_gpio_lock_stats_t) {0};
+
+	for (uint8_t slot = 0; slot < EXPANDED_GPIO_MAX_BUSES; slot++) {
+		expanded_gpio_lock_stats_t stats;
+		if (getExpandedGPIOLockStats(slot, &stats) != 0) {
+			continue;
+		}
+		total->acquisitions += stats.acquisitions;
+		total->contended += stats.contended;
+		total->wait_ns += stats.wait_ns;
+		if (stats.max_wait_ns > total->max_wait_ns) {
+			total->max_wait_ns = stats.max_wait_ns;
+		}
+	}
+}
+
+/**
+ * @brief Runs the operations of all the threads at the same time.
+ *
+ * The workers are left with their own results, and result gets the ones
+ * of all of them together.
+ */
+static int run_threads(const struct options* opts, long buses, strategy_t strategy, long threads,
+                       struct worker* workers, struct run_result* result) {
+	const size_t num_times = threads * opts->ops;
+	int64_t* times = calloc(num_times, sizeof(int64_t));
+	if (times == NULL) {
+		return -1;
+	}
+
+	pthread_barrier_t start;
+	pthread_barrier_init(&start, NULL, threads + 1);
+
+	clearExpandedGPIOLockStats();
+
+	for (long i = 0; i < threads; i++) {
+		workers[i] = (struct worker) {
+			.index = i,
+			.slot = i % buses,
+			.strategy = strategy,
+			.ops = opts->ops,
+			.start = &start,
+			.times = &times[i * opts->ops],
+		};
+		const int err = pthread_create(&workers[i].thread, NULL, worker_thread, &workers[i]);
+		if (err != 0) {
+			// The threads already started would wait at the barrier forever
+			fprintf(stderr, "pthread_create: %s\n", strerror(err));
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	pthread_barrier_wait(&start);
+	const int64_t wall_start = clock_ns();
+	for (long i = 0; i < threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+	}
+	const int64_t wall_ns = clock_ns() - wall_start;
+	pthread_barrier_destroy(&start);
+
+	*result = (struct run_result) {
+		.buses = buses,
+		.strategy = strategy,
+		.threads = threads,
+		.ops = num_times,
+		.wall_ns = wall_ns,
+		.ops_per_sec = wall_ns > 0 ? (double) num_times * NSEC_PER_SEC / wall_ns : 0,
+	};
+	sum_lock_stats(&result->locks);
+
+	for (long i = 0; i < threads; i++) {
+		result->errors += workers[i].errors;
+		// Sorting the times of a thread in place doesn't change the ones of all of them
+		summarize(workers[i].times, opts->ops, &workers[i].latency);
+	}
+	summarize(times, num_times, &result->latency);
+
+	free(times);
+	return 0;
+}
+
+/**
+ * @brief Configures the bus slots and initializes expanded-gpio with them.
+ */
+static int setup_buses(long buses) {
+	for (uint8_t slot = 1; slot < EXPANDED_GPIO_MAX_BUSES; slot++) {
+		if (setExpandedGPIOBus(slot, I2C_BUS + slot, slot < buses ? &BUS_DEVICES : NULL) != 0) {
+			fprintf(stderr, "setExpandedGPIOBus(%u): %s\n", slot, strerror(errno));
+			return -1;
+		}
+	}
+
+	int ret = initExpandedGPIO(false);
+	if (ret != 0) {
+		fprintf(stderr, "initExpandedGPIO failed with %d: %s\n", ret, strerror(errno));
+		return -1;
+	}
+
+	// The devices are left ready and the outputs configured, as in a running application
+	for (uint8_t slot = 0; slot < buses; slot++) {
+		for (long op = 0; op < 4; op++) {
+			run_operation(STRATEGY_PIN, slot, op);
+		}
+	}
+	return 0;
+}
+
+static void print_header(const struct options* opts) {
+	switch (opts->format) {
+	case FORMAT_TEXT:
+		printf("# plc-bench-contention: simulated buses at %u Hz, %ld operations per thread, library %s\n",
+		       opts->sim_bus_speed, opts->ops, LIB_PLC_PERIPHERALS_VERSION);
+		printf("# Latency of one operation in us, throughput in operations per second, speedup against\n");
+		printf("# the first number of threads; lock waits of all the buses, per operation\n");
+		printf("%5s %-5s %7s %6s %9s %7s %8s %8s %8s %8s %9s %8s %9s\n",
+		       "buses", "strat", "threads", "errors", "ops_s", "speedup", "avg_us", "p50_us", "p99_us",
+		       "max_us", "contended", "wait_us", "maxwait_us");
+		break;
+	case FORMAT_CSV:
+		printf("buses,strategy,threads,thread,ops,errors,ops_s,avg_ns,p50_ns,p99_ns,max_ns,"
+		       "lock_acquisitions,lock_contended,lock_wait_ns,lock_max_wait_ns\n");
+		break;
+	case FORMAT_JSON:
+		printf("{\n");
+		printf("  \"library\": \"%s\",\n", LIB_PLC_PERIPHERALS_VERSION);
+		printf("  \"bus\": \"simulated\",\n");
+		printf("  \"bus_speed_hz\": %u,\n", opts->sim_bus_speed);
+		printf("  \"ops_per_thread\": %ld,\n", opts->ops);
+		printf("  \"results\": [");
+		break;
+	}
+}
+
+static void print_result(const struct options* opts, const struct run_result* r, const struct worker* workers, bool first) {
+	const double contended = r->locks.acquisitions > 0 ? 100.0 * r->locks.contended / r->locks.acquisitions : 0;
+	const double wait_ns = (double) r->locks.wait_ns / r->ops;
+	const char* strategy = STRATEGY_NAMES[r->strategy];
+
+	switch (opts->format) {
+	case FORMAT_TEXT:
+		printf("%5ld %-5s %7ld %6ld %9.1f %7.2f %8.1f %8.1f %8.1f %8.1f %8.1f%% %8.1f %9.1f\n",
+		       r->buses, strategy, r->threads, r->errors, r->ops_per_sec, r->speedup,
+		       r->latency.avg_ns / 1000.0, r->latency.p50_ns / 1000.0, r->latency.p99_ns / 1000.0,
+		       r->latency.max_ns / 1000.0, contended, wait_ns / 1000.0, r->locks.max_wait_ns / 1000.0);
+		if (opts->per_thread) {
+			for (long i = 0; i < r->threads; i++) {
+				const struct worker* w = &workers[i];
+				printf("%5s %-5s %7s %6ld %9.1f %7s %8.1f %8.1f %8.1f %8.1f   thread %ld on slot %u\n",
+				       "", "", "", w->errors, w->elapsed_ns > 0 ? (double) w->ops * NSEC_PER_SEC / w->elapsed_ns : 0, "",
+				       w->latency.avg_ns / 1000.0, w->latency.p50_ns / 1000.0, w->latency.p99_ns / 1000.0,
+				       w->latency.max_ns / 1000.0, i, w->slot);
+			}
+		}
+		break;
+	case FORMAT_CSV:
+		printf("%ld,%s,%ld,all,%ld,%ld,%.1f,%ld,%ld,%ld,%ld,%lu,%lu,%lu,%lu\n",
+		       r->buses, strategy, r->threads, r->ops, r->errors, r->ops_per_sec,
+		       (long) r->latency.avg_ns, (long) r->latency.p50_ns, (long) r->latency.p99_ns, (long) r->latency.max_ns,
+		       (unsigned long) r->locks.acquisitions, (unsigned long) r->locks.contended,
+		       (unsigned long) r->locks.wait_ns, (unsigned long) r->locks.max_wait_ns);
+		if (opts->per_thread) {
+			for (long i = 0; i < r->threads; i++) {
+				const struct worker* w = &workers[i];
+				printf("%ld,%s,%ld,%ld,%ld,%ld,%.1f,%ld,%ld,%ld,%ld,,,,\n",
+				       r->buses, strategy, r->threads, i, w->ops, w->errors,
+				       w->elapsed_ns > 0 ? (double) w->ops * NSEC_PER_SEC / w->elapsed_ns : 0,
+				       (long) w->latency.avg_ns, (long) w->latency.p50_ns, (long) w->latency.p99_ns, (long) w->latency.max_ns);
+			}
+		}
+		break;
+	case FORMAT_JSON:
+		printf("%s\n    {\"buses\": %ld, \"strategy\": \"%s\", \"threads\": %ld, \"ops\": %ld, \"errors\": %ld, "
+		       "\"ops_s\": %.1f, \"speedup\": %.2f, \"avg_ns\": %ld, \"p50_ns\": %ld, \"p99_ns\": %ld, \"max_ns\": %ld, "
+		       "\"lock_acquisitions\": %lu, \"lock_contended\": %lu, \"lock_wait_ns\": %lu, \"lock_max_wait_ns\": %lu, "
+		       "\"per_thread\": [",
+		       first ? "" : ",", r->buses, strategy, r->threads, r->ops, r->errors, r->ops_per_sec, r->speedup,
+		       (long) r->latency.avg_ns, (long) r->latency.p50_ns, (long) r->latency.p99_ns, (long) r->latency.max_ns,
+		       (unsigned long) r->locks.acquisitions, (unsigned long) r->locks.contended,
+		       (unsigned long) r->locks.wait_ns, (unsigned long) r->locks.max_wait_ns);
+		for (long i = 0; i < r->threads; i++) {
+			const struct worker* w = &workers[i];
+			printf("%s{\"slot\": %u, \"errors\": %ld, \"ops_s\": %.1f, \"avg_ns\": %ld, \"p50_ns\": %ld, "
+			       "\"p99_ns\": %ld, \"max_ns\": %ld}",
+			       i == 0 ? "" : ", ", w->slot, w->errors,
+			       w->elapsed_ns > 0 ? (double) w->ops * NSEC_PER_SEC / w->elapsed_ns : 0,
+			       (long) w->latency.avg_ns, (long) w->latency.p50_ns, (long) w->latency.p99_ns, (long) w->latency.max_ns);
+		}
+		printf("]}");
+		break;
+	}
+}
+
+static void print_footer(const struct options* opts) {
+	if (opts->format == FORMAT_JSON) {
+		printf("\n  ]\n}\n");
+	}
+}
+
+int main(int argc, char* argv[]) {
+	struct options opts;
+	if (parse_options(argc, argv, &opts) != 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	i2c_sim_enable(true);
+	i2c_sim_set_bus_speed(opts.sim_bus_speed);
+	for (uint8_t slot = 0; slot < EXPANDED_GPIO_MAX_BUSES; slot++) {
+		const uint8_t bus = I2C_BUS + slot;
+		if (i2c_sim_add_device(bus, I2C_SIM_MCP23008, MCP23008_ADDR) != 0 ||
+		    i2c_sim_add_device(bus, I2C_SIM_MCP23017, MCP23017_ADDR) != 0 ||
+		    i2c_sim_add_device(bus, I2C_SIM_PCA9685, PCA9685_ADDR) != 0 ||
+		    i2c_sim_add_device(bus, I2C_SIM_LTC2309, LTC2309_ADDR) != 0) {
+			fprintf(stderr, "i2c_sim_add_device(%u): %s\n", bus, strerror(errno));
+			return EXIT_FAILURE;
+		}
+	}
+	_peripherals_struct = BUS_DEVICES;
+
+	static struct worker workers[MAX_THREADS];
+
+	print_header(&opts);
+
+	size_t num_printed = 0;
+	for (size_t b = 0; b < opts.num_buses; b++) {
+		if (setup_buses(opts.buses[b]) != 0) {
+			return EXIT_FAILURE;
+		}
+
+		for (strategy_t strategy = 0; strategy < NUM_STRATEGIES; strategy++) {
+			if (!opts.strategies[strategy]) {
+				continue;
+			}
+
+			double baseline = 0;
+			for (size_t t = 0; t < opts.num_threads; t++) {
+				struct run_result result;
+				if (run_threads(&opts, opts.buses[b], strategy, opts.threads[t], workers, &result) != 0) {
+					fprintf(stderr, "%s\n", strerror(errno));
+					return EXIT_FAILURE;
+				}
+
+				if (t == 0) {
+					baseline = result.ops_per_sec;
+				}
+				result.speedup = baseline > 0 ? result.ops_per_sec / baseline : 0;
+
+				print_result(&opts, &result, workers, num_printed == 0);
+				num_printed++;
+			}
+		}
+
+		const int ret = deinitExpandedGPIO();
+		if (ret != 0) {
+			fprintf(stderr, "deinitExpandedGPIO failed with %d: %s\n", ret, strerror(errno));
+			return EXIT_FAILURE;
+		}
+	}
+
+	print_footer(&opts);
+	return EXIT_SUCCESS;
+}
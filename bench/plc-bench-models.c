@@ -0,0 +1,410 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * plc-bench-models runs back to back the full I/O scan of every synthetic
+ * topology of plc-models.h on a simulated bus, and reports the achievable
+ * scan rate of each one: all the expanders read and written, all the ADC
+ * channels read and all the PWM outputs written, as fast as possible.
+ * On a real board with the devices of a topology, it measures it on the
+ * real bus.
+ */
+
+#define _GNU_SOURCE
+
+#include <plc-peripherals.h>
+#include <peripheral-mcp23017.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "i2c-sim.h"
+#include "plc-models.h"
+
+#define NSEC_PER_SEC 1000000000LL
+
+#define MAX_EXPANDERS 16
+#define MAX_ADC_CHANNELS 128
+#define MAX_PWMS 16
+
+typedef enum {
+	FORMAT_TEXT,
+	FORMAT_CSV,
+	FORMAT_JSON
+} output_format_t;
+
+struct options {
+	long loops;
+	const char* filter;
+	bool real_bus;
+	uint32_t sim_bus_speed;
+	output_format_t format;
+};
+
+// What one scan of a model touches
+struct scan_plan {
+	expanded_gpio_read_all_t reads[MAX_EXPANDERS];
+	expanded_gpio_write_all_t writes[MAX_EXPANDERS];
+	size_t num_expanders;
+	uint32_t adc_pins[MAX_ADC_CHANNELS];
+	size_t num_adc_channels;
+	uint8_t pwms[MAX_PWMS];
+	size_t num_pwms;
+};
+
+struct model_result {
+	long loops;
+	long errors;
+	int64_t avg_ns;
+	int64_t p99_ns;
+	int64_t max_ns;
+	struct i2c_sim_stats stats;
+};
+
+
+static void usage(const char* name) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -m NAME     only run the topologies whose name contains NAME\n"
+		"  -L          list the topologies and exit\n"
+		"  -l LOOPS    number of scans of every topology (default 50)\n"
+		"  -f FORMAT   output format: text, csv or json (default text)\n"
+		"  -r          use the real I2C bus (the filter must select a single topology)\n"
+		"  -S HZ       SCL frequency of the simulated bus (default 100000, 0 = no bus time)\n",
+		name);
+}
+
+static void list_models(void) {
+	for (size_t i = 0; i < PLC_NUM_MODELS; i++) {
+		const struct peripherals_t* p = &PLC_MODELS[i].peripherals;
+		printf("%-18s %-26s MCP23008 %zu, MCP23017 %zu, ADS1015 %zu, LTC2309 %zu, PCA9685 %zu\n",
+		       PLC_MODELS[i].name, PLC_MODELS[i].description, p->numArrayMCP23008, p->numArrayMCP23017,
+		       p->numArrayADS1015, p->numArrayLTC2309, p->numArrayPCA9685);
+	}
+}
+
+static int parse_options(int argc, char* argv[], struct options* opts) {
+	*opts = (struct options) {
+		.loops = 50,
+		.filter = NULL,
+		.real_bus = false,
+		.sim_bus_speed = 100000,
+		.format = FORMAT_TEXT,
+	};
+
+	int opt;
+	while ((opt = getopt(argc, argv, "m:Ll:f:rS:")) != -1) {
+		switch (opt) {
+		case 'm':
+			opts->filter = optarg;
+			break;
+		case 'L':
+			list_models();
+			exit(EXIT_SUCCESS);
+		case 'l':
+			opts->loops = strtol(optarg, NULL, 0);
+			break;
+		case 'f':
+			if (strcmp(optarg, "text") == 0) {
+				opts->format = FORMAT_TEXT;
+			}
+			else if (strcmp(optarg, "csv") == 0) {
+				opts->format = FORMAT_CSV;
+			}
+			else if (strcmp(optarg, "json") == 0) {
+				opts->format = FORMAT_JSON;
+			}
+			else {
+				return -1;
+			}
+			break;
+		case 'r':
+			opts->real_bus = true;
+			break;
+		case 'S':
+			opts->sim_bus_speed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			return -1;
+		}
+	}
+
+	return opts->loops > 0 ? 0 : -1;
+}
+
+static bool model_selected(const struct options* opts, const struct plc_model* model) {
+	return opts->filter == NULL || strstr(model->name, opts->filter) != NULL;
+}
+
+/**
+ * @brief Lists the operations of a full scan of the devices of a model.
+ */
+static int plan_scan(const struct peripherals_t* p, struct scan_plan* plan) {
+	if (p->numArrayMCP23008 + p->numArrayMCP23017 > MAX_EXPANDERS ||
+	    p->numArrayADS1015 * ADS1015_NUM_INPUTS + p->numArrayLTC2309 * LTC2309_NUM_INPUTS > MAX_ADC_CHANNELS ||
+	    p->numArrayPCA9685 > MAX_PWMS) {
+		errno = E2BIG;
+		return -1;
+	}
+
+	*plan = (struct scan_plan) {0};
+
+	for (size_t i = 0; i < p->numArrayMCP23008; i++) {
+		plan->reads[plan->num_expanders].device = MAKE_PIN_MCP23008(p->arrayMCP23008[i], 0);
+		plan->writes[plan->num_expanders].device = MAKE_PIN_MCP23008(p->arrayMCP23008[i], 0);
+		plan->num_expanders++;
+	}
+	for (size_t i = 0; i < p->numArrayMCP23017; i++) {
+		plan->reads[plan->num_expanders].device = MAKE_PIN_MCP23017(p->arrayMCP23017[i], 0);
+		plan->writes[plan->num_expanders].device = MAKE_PIN_MCP23017(p->arrayMCP23017[i], 0);
+		plan->num_expanders++;
+	}
+
+	for (size_t i = 0; i < p->numArrayADS1015; i++) {
+		for (uint8_t channel = 0; channel < ADS1015_NUM_INPUTS; channel++) {
+			plan->adc_pins[plan->num_adc_channels++] = MAKE_PIN_ADS1015(p->arrayADS1015[i], channel);
+		}
+	}
+	for (size_t i = 0; i < p->numArrayLTC2309; i++) {
+		for (uint8_t channel = 0; channel < LTC2309_NUM_INPUTS; channel++) {
+			plan->adc_pins[plan->num_adc_channels++] = MAKE_PIN_LTC2309(p->arrayLTC2309[i], channel);
+		}
+	}
+
+	for (size_t i = 0; i < p->numArrayPCA9685; i++) {
+		plan->pwms[plan->num_pwms++] = p->arrayPCA9685[i];
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Runs one full scan: inputs first, then outputs, as a PLC cycle does.
+ *
+ * @return The number of operations that failed.
+ */
+static unsigned int scan(struct scan_plan* plan, long cycle) {
+	unsigned int errors = 0;
+
+	if (digitalReadAllBatch(plan->reads, plan->num_expanders) != 0) {
+		errors++;
+	}
+
+	for (size_t i = 0; i < plan->num_adc_channels; i++) {
+		volatile uint16_t value = analogRead(plan->adc_pins[i]);
+		(void) value;
+	}
+
+	for (size_t i = 0; i < plan->num_expanders; i++) {
+		plan->writes[i].values = (cycle + i) & 0xFFFF;
+	}
+	if (digitalWriteAllBatch(plan->writes, plan->num_expanders) != 0) {
+		errors++;
+	}
+
+	for (size_t i = 0; i < plan->num_pwms; i++) {
+		uint16_t values[PCA9685_NUM_OUTPUTS];
+		for (size_t j = 0; j < PCA9685_NUM_OUTPUTS; j++) {
+			values[j] = (cycle * 16 + j * 256) & 0x0FFF;
+		}
+		if (analogWriteAll(plan->pwms[i], values) != 0) {
+			errors++;
+		}
+	}
+
+	return errors;
+}
+
+static inline int64_t clock_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static int compare_ns(const void* a, const void* b) {
+	const int64_t x = *(const int64_t*) a;
+	const int64_t y = *(const int64_t*) b;
+	return (x > y) - (x < y);
+}
+
+static int run_model(const struct options* opts, const struct plc_model* model, struct model_result* result) {
+	struct scan_plan plan;
+	if (plan_scan(&model->peripherals, &plan) != 0) {
+		return -1;
+	}
+
+	if (!opts->real_bus) {
+		i2c_sim_reset();
+		if (plc_model_add_to_sim(model, I2C_BUS) != 0) {
+			return -1;
+		}
+	}
+	_peripherals_struct = model->peripherals;
+
+	int64_t* times = calloc(opts->loops, sizeof(int64_t));
+	if (times == NULL) {
+		return -1;
+	}
+
+	int ret = initExpandedGPIO(false);
+	if (ret != 0) {
+		fprintf(stderr, "%s: initExpandedGPIO failed with %d: %s\n", model->name, ret, strerror(errno));
+		free(times);
+		return -1;
+	}
+
+	*result = (struct model_result) {.loops = opts->loops};
+
+	// The first scan finds the devices ready, as in a running PLC
+	scan(&plan, 0);
+	i2c_sim_clear_stats();
+
+	int64_t sum = 0;
+	for (long loop = 0; loop < opts->loops; loop++) {
+		const int64_t start = clock_ns();
+		result->errors += scan(&plan, loop);
+		times[loop] = clock_ns() - start;
+		sum += times[loop];
+	}
+	i2c_sim_get_stats(&result->stats);
+
+	qsort(times, opts->loops, sizeof(int64_t), compare_ns);
+	result->avg_ns = sum / opts->loops;
+	result->p99_ns = times[(opts->loops * 99) / 100];
+	result->max_ns = times[opts->loops - 1];
+	free(times);
+
+	ret = deinitExpandedGPIO();
+	if (ret != 0) {
+		fprintf(stderr, "%s: deinitExpandedGPIO failed with %d: %s\n", model->name, ret, strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+static void print_header(const struct options* opts) {
+	switch (opts->format) {
+	case FORMAT_TEXT:
+		printf("# plc-bench-models: ");
+		if (opts->real_bus) {
+			printf("real bus /dev/i2c-%d", I2C_BUS);
+		}
+		else {
+			printf("simulated bus at %u Hz", opts->sim_bus_speed);
+		}
+		printf(", %ld scans, library %s\n", opts->loops, LIB_PLC_PERIPHERALS_VERSION);
+		printf("# Per scan: time in us, ioctls and bytes on the wire; rate in scans per second\n");
+		printf("%-18s %6s %9s %9s %9s %9s %7s %7s\n",
+		       "model", "errors", "avg_us", "p99_us", "max_us", "rate_hz", "ioctls", "wire");
+		break;
+	case FORMAT_CSV:
+		printf("model,loops,errors,avg_ns,p99_ns,max_ns,rate_hz,ioctls,wire_bytes,bus_ns\n");
+		break;
+	case FORMAT_JSON:
+		printf("{\n");
+		printf("  \"library\": \"%s\",\n", LIB_PLC_PERIPHERALS_VERSION);
+		if (opts->real_bus) {
+			printf("  \"bus\": \"/dev/i2c-%d\",\n", I2C_BUS);
+		}
+		else {
+			printf("  \"bus\": \"simulated\",\n");
+			printf("  \"bus_speed_hz\": %u,\n", opts->sim_bus_speed);
+		}
+		printf("  \"results\": [");
+		break;
+	}
+}
+
+static void print_result(const struct options* opts, const struct plc_model* model, const struct model_result* r, bool first) {
+	const double loops = r->loops;
+	const double rate_hz = r->avg_ns > 0 ? (double) NSEC_PER_SEC / r->avg_ns : 0;
+	const double ioctls = r->stats.ioctls / loops;
+	const double wire_bytes = r->stats.wire_bytes / loops;
+	const double bus_ns = r->stats.bus_ns / loops;
+
+	switch (opts->format) {
+	case FORMAT_TEXT:
+		printf("%-18s %6ld %9.1f %9.1f %9.1f %9.1f %7.1f %7.1f\n",
+		       model->name, r->errors, r->avg_ns / 1000.0, r->p99_ns / 1000.0, r->max_ns / 1000.0,
+		       rate_hz, ioctls, wire_bytes);
+		break;
+	case FORMAT_CSV:
+		printf("%s,%ld,%ld,%ld,%ld,%ld,%.1f,%.1f,%.1f,%.0f\n",
+		       model->name, r->loops, r->errors, (long) r->avg_ns, (long) r->p99_ns, (long) r->max_ns,
+		       rate_hz, ioctls, wire_bytes, bus_ns);
+		break;
+	case FORMAT_JSON:
+		printf("%s\n    {\"model\": \"%s\", \"loops\": %ld, \"errors\": %ld, \"avg_ns\": %ld, "
+		       "\"p99_ns\": %ld, \"max_ns\": %ld, \"rate_hz\": %.1f, \"ioctls\": %.1f, "
+		       "\"wire_bytes\": %.1f, \"bus_ns\": %.0f}",
+		       first ? "" : ",", model->name, r->loops, r->errors, (long) r->avg_ns, (long) r->p99_ns,
+		       (long) r->max_ns, rate_hz, ioctls, wire_bytes, bus_ns);
+		break;
+	}
+}
+
+static void print_footer(const struct options* opts) {
+	if (opts->format == FORMAT_JSON) {
+		printf("\n  ]\n}\n");
+	}
+}
+
+int main(int argc, char* argv[]) {
+	struct options opts;
+	if (parse_options(argc, argv, &opts) != 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	size_t num_selected = 0;
+	for (size_t i = 0; i < PLC_NUM_MODELS; i++) {
+		num_selected += model_selected(&opts, &PLC_MODELS[i]);
+	}
+	if (num_selected == 0 || (opts.real_bus && num_selected != 1)) {
+		fprintf(stderr, "The filter must select %s topology (see -L)\n", opts.real_bus ? "a single" : "at least one");
+		return EXIT_FAILURE;
+	}
+
+	if (!opts.real_bus) {
+		i2c_sim_enable(true);
+		i2c_sim_set_bus_speed(opts.sim_bus_speed);
+	}
+
+	print_header(&opts);
+
+	size_t num_printed = 0;
+	for (size_t i = 0; i < PLC_NUM_MODELS; i++) {
+		if (!model_selected(&opts, &PLC_MODELS[i])) {
+			continue;
+		}
+
+		struct model_result result;
+		if (run_model(&opts, &PLC_MODELS[i], &result) != 0) {
+			fprintf(stderr, "%s: %s\n", PLC_MODELS[i].name, strerror(errno));
+			return EXIT_FAILURE;
+		}
+		print_result(&opts, &PLC_MODELS[i], &result, num_printed == 0);
+		num_printed++;
+	}
+
+	print_footer(&opts);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,475 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * plc-cyclictest runs a periodic I/O scan (like the main loop of a PLC
+ * program) and measures, in the same way as rt-tests' cyclictest, how
+ * late every cycle wakes up and how long the scan takes. It can run
+ * against the real bus or against the simulated peripherals of i2c-sim.
+ */
+
+#define _GNU_SOURCE
+
+#include <plc-peripherals.h>
+#include <peripheral-mcp23017.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include "i2c-sim.h"
+
+#define NSEC_PER_SEC 1000000000LL
+#define DEFAULT_HISTOGRAM_US 10000
+
+static const uint8_t LTC2309_ADDRESSES[] = {0x08, 0x09, 0x0A, 0x0B, 0x18, 0x19, 0x1A, 0x1B, 0x14};
+
+struct options {
+	size_t num_expanders;
+	peripheral_type_t expander_type;
+	size_t num_adc_channels;
+	peripheral_type_t adc_type;
+	size_t num_pwm_outputs;
+	long interval_us;
+	long loops;
+	int priority;
+	int cpu;
+	bool real_bus;
+	uint32_t sim_bus_speed;
+	long histogram_us;
+	bool quiet;
+};
+
+struct measure {
+	int64_t min;
+	int64_t max;
+	int64_t sum;
+	uint64_t count;
+	uint64_t* histogram;
+	uint64_t overflows;
+	long histogram_us;
+};
+
+static uint8_t mcp23008_addrs[8], mcp23017_addrs[8], ads1015_addrs[4], ltc2309_addrs[9], pca9685_addrs[8];
+static uint32_t adc_pins[sizeof(ltc2309_addrs) * LTC2309_NUM_INPUTS];
+static uint32_t pwm_pins[sizeof(pca9685_addrs) * PCA9685_NUM_OUTPUTS];
+
+
+static void usage(const char* name) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -n NUM      number of GPIO expanders to read every cycle (default 2, max 8)\n"
+		"  -x TYPE     expander type: mcp23008 or mcp23017 (default mcp23008)\n"
+		"  -m NUM      number of ADC channels to read every cycle (default 4)\n"
+		"  -a TYPE     ADC type: ads1015 or ltc2309 (default ads1015)\n"
+		"  -k NUM      number of PWM outputs to write every cycle (default 8, max 128)\n"
+		"  -i US       cycle interval in microseconds (default 10000)\n"
+		"  -l LOOPS    number of cycles (default 1000)\n"
+		"  -p PRIO     run with SCHED_FIFO at this priority (default SCHED_OTHER)\n"
+		"  -c CPU      pin the measuring thread to this CPU\n"
+		"  -r          use the real I2C bus instead of the simulated one\n"
+		"  -S HZ       SCL frequency of the simulated bus (default 100000, 0 = no bus time)\n"
+		"  -h US       print histograms of up to US microseconds\n"
+		"  -q          only print the summary\n",
+		name);
+}
+
+static int parse_options(int argc, char* argv[], struct options* opts) {
+	*opts = (struct options) {
+		.num_expanders = 2,
+		.expander_type = PLC_MCP23008,
+		.num_adc_channels = 4,
+		.adc_type = PLC_ADS1015,
+		.num_pwm_outputs = 8,
+		.interval_us = 10000,
+		.loops = 1000,
+		.priority = 0,
+		.cpu = -1,
+		.real_bus = false,
+		.sim_bus_speed = 100000,
+		.histogram_us = 0,
+		.quiet = false,
+	};
+
+	int opt;
+	while ((opt = getopt(argc, argv, "n:x:m:a:k:i:l:p:c:rS:h:q")) != -1) {
+		switch (opt) {
+		case 'n':
+			opts->num_expanders = strtoul(optarg, NULL, 0);
+			break;
+		case 'x':
+			if (strcmp(optarg, "mcp23008") == 0) {
+				opts->expander_type = PLC_MCP23008;
+			}
+			else if (strcmp(optarg, "mcp23017") == 0) {
+				opts->expander_type = PLC_MCP23017;
+			}
+			else {
+				return -1;
+			}
+			break;
+		case 'm':
+			opts->num_adc_channels = strtoul(optarg, NULL, 0);
+			break;
+		case 'a':
+			if (strcmp(optarg, "ads1015") == 0) {
+				opts->adc_type = PLC_ADS1015;
+			}
+			else if (strcmp(optarg, "ltc2309") == 0) {
+				opts->adc_type = PLC_LTC2309;
+			}
+			else {
+				return -1;
+			}
+			break;
+		case 'k':
+			opts->num_pwm_outputs = strtoul(optarg, NULL, 0);
+			break;
+		case 'i':
+			opts->interval_us = strtol(optarg, NULL, 0);
+			break;
+		case 'l':
+			opts->loops = strtol(optarg, NULL, 0);
+			break;
+		case 'p':
+			opts->priority = atoi(optarg);
+			break;
+		case 'c':
+			opts->cpu = atoi(optarg);
+			break;
+		case 'r':
+			opts->real_bus = true;
+			break;
+		case 'S':
+			opts->sim_bus_speed = strtoul(optarg, NULL, 0);
+			break;
+		case 'h':
+			opts->histogram_us = strtol(optarg, NULL, 0);
+			break;
+		case 'q':
+			opts->quiet = true;
+			break;
+		default:
+			return -1;
+		}
+	}
+
+	const size_t max_adc_channels = opts->adc_type == PLC_ADS1015 ?
+		sizeof(ads1015_addrs) * ADS1015_NUM_INPUTS : sizeof(ltc2309_addrs) * LTC2309_NUM_INPUTS;
+	if (opts->num_expanders > 8 || opts->num_adc_channels > max_adc_channels ||
+	    opts->num_pwm_outputs > sizeof(pwm_pins) / sizeof(pwm_pins[0]) ||
+	    opts->interval_us <= 0 || opts->loops <= 0 || opts->histogram_us < 0) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Fills the peripherals struct (and the simulated bus) with the requested workload.
+ */
+static int setup_workload(const struct options* opts) {
+	size_t num_mcp23008 = 0, num_mcp23017 = 0, num_ads1015 = 0, num_ltc2309 = 0, num_pca9685 = 0;
+
+	for (size_t i = 0; i < opts->num_expanders; i++) {
+		if (opts->expander_type == PLC_MCP23008) {
+			mcp23008_addrs[num_mcp23008++] = 0x20 + i;
+		}
+		else {
+			mcp23017_addrs[num_mcp23017++] = 0x20 + i;
+		}
+	}
+
+	for (size_t i = 0; i < opts->num_adc_channels; i++) {
+		if (opts->adc_type == PLC_ADS1015) {
+			if (i % ADS1015_NUM_INPUTS == 0) {
+				ads1015_addrs[num_ads1015++] = 0x48 + i / ADS1015_NUM_INPUTS;
+			}
+			adc_pins[i] = MAKE_PIN_ADS1015(ads1015_addrs[num_ads1015 - 1], i % ADS1015_NUM_INPUTS);
+		}
+		else {
+			if (i % LTC2309_NUM_INPUTS == 0) {
+				ltc2309_addrs[num_ltc2309] = LTC2309_ADDRESSES[num_ltc2309];
+				num_ltc2309++;
+			}
+			adc_pins[i] = MAKE_PIN_LTC2309(ltc2309_addrs[num_ltc2309 - 1], i % LTC2309_NUM_INPUTS);
+		}
+	}
+
+	for (size_t i = 0; i < opts->num_pwm_outputs; i++) {
+		if (i % PCA9685_NUM_OUTPUTS == 0) {
+			pca9685_addrs[num_pca9685++] = 0x40 + i / PCA9685_NUM_OUTPUTS;
+		}
+		pwm_pins[i] = MAKE_PIN_PCA9685(pca9685_addrs[num_pca9685 - 1], i % PCA9685_NUM_OUTPUTS);
+	}
+
+	_peripherals_struct = (struct peripherals_t) {
+		.arrayMCP23008 = mcp23008_addrs, .numArrayMCP23008 = num_mcp23008,
+		.arrayADS1015 = ads1015_addrs, .numArrayADS1015 = num_ads1015,
+		.arrayPCA9685 = pca9685_addrs, .numArrayPCA9685 = num_pca9685,
+		.arrayLTC2309 = ltc2309_addrs, .numArrayLTC2309 = num_ltc2309,
+		.arrayMCP23017 = mcp23017_addrs, .numArrayMCP23017 = num_mcp23017,
+	};
+
+	if (opts->real_bus) {
+		return 0;
+	}
+
+	i2c_sim_enable(true);
+	i2c_sim_set_bus_speed(opts->sim_bus_speed);
+
+	int ret = 0;
+	for (size_t i = 0; i < num_mcp23008 && ret == 0; i++) {
+		ret = i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23008, mcp23008_addrs[i]);
+	}
+	for (size_t i = 0; i < num_mcp23017 && ret == 0; i++) {
+		ret = i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23017, mcp23017_addrs[i]);
+	}
+	for (size_t i = 0; i < num_ads1015 && ret == 0; i++) {
+		ret = i2c_sim_add_device(I2C_BUS, I2C_SIM_ADS1015, ads1015_addrs[i]);
+	}
+	for (size_t i = 0; i < num_ltc2309 && ret == 0; i++) {
+		ret = i2c_sim_add_device(I2C_BUS, I2C_SIM_LTC2309, ltc2309_addrs[i]);
+	}
+	for (size_t i = 0; i < num_pca9685 && ret == 0; i++) {
+		ret = i2c_sim_add_device(I2C_BUS, I2C_SIM_PCA9685, pca9685_addrs[i]);
+	}
+
+	return ret;
+}
+
+/**
+ * @brief Runs one I/O scan: read all the expanders and ADC channels, and update the PWMs.
+ *
+ * @return The number of operations that failed.
+ */
+static unsigned int scan(const struct options* opts, long cycle) {
+	unsigned int errors = 0;
+
+	for (size_t i = 0; i < opts->num_expanders; i++) {
+		uint16_t values = 0;
+		const uint8_t addr = opts->expander_type == PLC_MCP23008 ? mcp23008_addrs[i] : mcp23017_addrs[i];
+		if (digitalReadAll(addr, &values) != 0) {
+			errors++;
+		}
+	}
+
+	for (size_t i = 0; i < opts->num_adc_channels; i++) {
+		volatile uint16_t value = analogRead(adc_pins[i]);
+		(void) value;
+	}
+
+	for (size_t i = 0; i < opts->num_pwm_outputs; i++) {
+		if (analogWrite(pwm_pins[i], (cycle * 16 + i * 256) & 0x0FFF) != 0) {
+			errors++;
+		}
+	}
+
+	return errors;
+}
+
+
+static inline int64_t timespec_to_ns(const struct timespec* ts) {
+	return ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+static inline void timespec_add_ns(struct timespec* ts, int64_t ns) {
+	ns += ts->tv_nsec;
+	ts->tv_sec += ns / NSEC_PER_SEC;
+	ts->tv_nsec = ns % NSEC_PER_SEC;
+}
+
+static int measure_init(struct measure* m, long histogram_us) {
+	*m = (struct measure) {.min = INT64_MAX, .max = INT64_MIN, .histogram_us = histogram_us};
+	m->histogram = calloc(histogram_us, sizeof(uint64_t));
+	return m->histogram == NULL ? -1 : 0;
+}
+
+static void measure_add(struct measure* m, int64_t ns) {
+	if (ns < m->min) {
+		m->min = ns;
+	}
+	if (ns > m->max) {
+		m->max = ns;
+	}
+	m->sum += ns;
+	m->count++;
+
+	const int64_t us = ns > 0 ? ns / 1000 : 0;
+	if (us < m->histogram_us) {
+		m->histogram[us]++;
+	}
+	else {
+		m->overflows++;
+	}
+}
+
+/**
+ * @brief Returns the percentile (in microseconds) from the histogram, or -1 if it overflows.
+ */
+static long measure_percentile(const struct measure* m, double percentile) {
+	const uint64_t target = (uint64_t) (m->count * percentile / 100.0 + 0.5);
+	uint64_t accumulated = 0;
+	for (long us = 0; us < m->histogram_us; us++) {
+		accumulated += m->histogram[us];
+		if (accumulated >= target) {
+			return us;
+		}
+	}
+	return -1;
+}
+
+static void print_measure(const char* name, const struct measure* m) {
+	const long p99 = measure_percentile(m, 99.0);
+	char p99_str[32];
+	if (p99 < 0) {
+		snprintf(p99_str, sizeof(p99_str), ">%ld", m->histogram_us);
+	}
+	else {
+		snprintf(p99_str, sizeof(p99_str), "%ld", p99);
+	}
+
+	printf("%-10s %10ld %10ld %10s %10ld\n", name,
+	       (long) (m->min / 1000), (long) (m->sum / (int64_t) m->count / 1000), p99_str, (long) (m->max / 1000));
+}
+
+static void print_histograms(const struct measure* latency, const struct measure* cycle, long histogram_us) {
+	printf("# Histogram (us, wake-up latency, cycle time)\n");
+	for (long us = 0; us < histogram_us; us++) {
+		printf("%06ld %06lu %06lu\n", us,
+		       (unsigned long) latency->histogram[us], (unsigned long) cycle->histogram[us]);
+	}
+	printf("# Histogram Overflows: %05lu %05lu\n",
+	       (unsigned long) latency->overflows, (unsigned long) cycle->overflows);
+}
+
+static void setup_realtime(const struct options* opts) {
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+		fprintf(stderr, "Warning: mlockall failed: %s\n", strerror(errno));
+	}
+
+	if (opts->cpu >= 0) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(opts->cpu, &set);
+		if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+			fprintf(stderr, "Warning: could not pin to CPU %d: %s\n", opts->cpu, strerror(errno));
+		}
+	}
+
+	if (opts->priority > 0) {
+		const struct sched_param param = {.sched_priority = opts->priority};
+		if (sched_setscheduler(0, SCHED_FIFO, &param) != 0) {
+			fprintf(stderr, "Warning: could not set SCHED_FIFO %d: %s\n", opts->priority, strerror(errno));
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	struct options opts;
+	if (parse_options(argc, argv, &opts) != 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (setup_workload(&opts) != 0) {
+		fprintf(stderr, "Could not create the simulated bus: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	int ret = initExpandedGPIO(false);
+	if (ret != 0) {
+		fprintf(stderr, "initExpandedGPIO failed with %d: %s\n", ret, strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	const long histogram_us = opts.histogram_us > 0 ? opts.histogram_us : DEFAULT_HISTOGRAM_US;
+	struct measure latency, cycle;
+	if (measure_init(&latency, histogram_us) != 0 || measure_init(&cycle, histogram_us) != 0) {
+		perror("calloc");
+		return EXIT_FAILURE;
+	}
+
+	setup_realtime(&opts);
+
+	const int64_t interval_ns = opts.interval_us * 1000LL;
+	unsigned long errors = 0, overruns = 0;
+	struct timespec next, now;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	timespec_add_ns(&next, interval_ns);
+
+	for (long loop = 0; loop < opts.loops; loop++) {
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		const int64_t wake_ns = timespec_to_ns(&now);
+		measure_add(&latency, wake_ns - timespec_to_ns(&next));
+
+		errors += scan(&opts, loop);
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		const int64_t end_ns = timespec_to_ns(&now);
+		measure_add(&cycle, end_ns - wake_ns);
+
+		timespec_add_ns(&next, interval_ns);
+		if (end_ns > timespec_to_ns(&next)) {
+			// The scan didn't fit in the period: skip the missed cycles
+			overruns++;
+			const int64_t missed = (end_ns - timespec_to_ns(&next)) / interval_ns + 1;
+			timespec_add_ns(&next, missed * interval_ns);
+		}
+	}
+
+	if (!opts.quiet) {
+		printf("# plc-cyclictest: %zu x %s, %zu x %s channels, %zu x PCA9685 outputs, ",
+		       opts.num_expanders, opts.expander_type == PLC_MCP23008 ? "MCP23008" : "MCP23017",
+		       opts.num_adc_channels, opts.adc_type == PLC_ADS1015 ? "ADS1015" : "LTC2309",
+		       opts.num_pwm_outputs);
+		if (opts.real_bus) {
+			printf("real bus /dev/i2c-%d\n", I2C_BUS);
+		}
+		else {
+			printf("simulated bus at %u Hz\n", opts.sim_bus_speed);
+		}
+		printf("# Interval %ld us, %ld loops, %s %d, library %s\n", opts.interval_us, opts.loops,
+		       opts.priority > 0 ? "SCHED_FIFO" : "SCHED_OTHER", opts.priority, LIB_PLC_PERIPHERALS_VERSION);
+	}
+	printf("%-10s %10s %10s %10s %10s\n", "(us)", "min", "avg", "p99", "max");
+	print_measure("latency", &latency);
+	print_measure("cycle", &cycle);
+	printf("overruns: %lu errors: %lu\n", overruns, errors);
+
+	if (opts.histogram_us > 0 && !opts.quiet) {
+		print_histograms(&latency, &cycle, histogram_us);
+	}
+
+	free(latency.histogram);
+	free(cycle.histogram);
+
+	ret = deinitExpandedGPIO();
+	if (ret != 0) {
+		fprintf(stderr, "deinitExpandedGPIO failed with %d: %s\n", ret, strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
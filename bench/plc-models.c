@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The topologies are synthetic: they are not the board definitions of any
+ * PLC, whose addresses live in librpiplc. They span the device mixes the
+ * library is used with, from 4 to 13 devices, sampling with ADS1015 or with
+ * LTC2309. A change to a topology makes its scan rates incomparable with
+ * the previous ones, so new mixes get new names instead.
+ */
+
+#include "plc-models.h"
+#include "i2c-sim.h"
+
+#include <string.h>
+
+// expanded-gpio needs an array for every type, even if it has no devices
+static const uint8_t NO_DEVICES[] = {0};
+
+#define ADDRESSES(array) (array), sizeof(array)
+#define NO_ADDRESSES NO_DEVICES, 0
+
+// Sampling with ADS1015
+static const uint8_t ADS_SMALL_MCP23008[] = {0x20, 0x21};
+static const uint8_t ADS_SMALL_ADS1015[] = {0x48};
+static const uint8_t ADS_SMALL_PCA9685[] = {0x40};
+
+static const uint8_t ADS_MEDIUM_MCP23008[] = {0x20, 0x21, 0x22, 0x23};
+static const uint8_t ADS_MEDIUM_ADS1015[] = {0x48, 0x49, 0x4A};
+static const uint8_t ADS_MEDIUM_PCA9685[] = {0x40, 0x41};
+
+static const uint8_t ADS_LARGE_MCP23008[] = {0x20, 0x21, 0x22, 0x23, 0x24, 0x25};
+static const uint8_t ADS_LARGE_ADS1015[] = {0x48, 0x49, 0x4A, 0x4B};
+static const uint8_t ADS_LARGE_PCA9685[] = {0x40, 0x41, 0x42};
+
+// Sampling with LTC2309
+static const uint8_t LTC_SMALL_MCP23008[] = {0x20, 0x21};
+static const uint8_t LTC_SMALL_LTC2309[] = {0x08};
+static const uint8_t LTC_SMALL_PCA9685[] = {0x40};
+
+static const uint8_t LTC_MEDIUM_MCP23008[] = {0x20, 0x21, 0x22, 0x23};
+static const uint8_t LTC_MEDIUM_LTC2309[] = {0x08, 0x0A, 0x18};
+static const uint8_t LTC_MEDIUM_PCA9685[] = {0x40, 0x41};
+
+static const uint8_t LTC_LARGE_MCP23008[] = {0x20, 0x21, 0x22, 0x23, 0x24, 0x25};
+static const uint8_t LTC_LARGE_LTC2309[] = {0x08, 0x0A, 0x18, 0x1A};
+static const uint8_t LTC_LARGE_PCA9685[] = {0x40, 0x41, 0x42};
+
+// In the order of struct peripherals_t: MCP23008, ADS1015, PCA9685, LTC2309 and MCP23017
+const struct plc_model PLC_MODELS[] = {
+	{"ads1015-small", "Synthetic, 4 devices",
+	 {ADDRESSES(ADS_SMALL_MCP23008), ADDRESSES(ADS_SMALL_ADS1015), ADDRESSES(ADS_SMALL_PCA9685), NO_ADDRESSES, NO_ADDRESSES}},
+	{"ads1015-medium", "Synthetic, 9 devices",
+	 {ADDRESSES(ADS_MEDIUM_MCP23008), ADDRESSES(ADS_MEDIUM_ADS1015), ADDRESSES(ADS_MEDIUM_PCA9685), NO_ADDRESSES, NO_ADDRESSES}},
+	{"ads1015-large", "Synthetic, 13 devices",
+	 {ADDRESSES(ADS_LARGE_MCP23008), ADDRESSES(ADS_LARGE_ADS1015), ADDRESSES(ADS_LARGE_PCA9685), NO_ADDRESSES, NO_ADDRESSES}},
+	{"ltc2309-small", "Synthetic, 4 devices",
+	 {ADDRESSES(LTC_SMALL_MCP23008), NO_ADDRESSES, ADDRESSES(LTC_SMALL_PCA9685), ADDRESSES(LTC_SMALL_LTC2309), NO_ADDRESSES}},
+	{"ltc2309-medium", "Synthetic, 9 devices",
+	 {ADDRESSES(LTC_MEDIUM_MCP23008), NO_ADDRESSES, ADDRESSES(LTC_MEDIUM_PCA9685), ADDRESSES(LTC_MEDIUM_LTC2309), NO_ADDRESSES}},
+	{"ltc2309-large", "Synthetic, 13 devices",
+	 {ADDRESSES(LTC_LARGE_MCP23008), NO_ADDRESSES, ADDRESSES(LTC_LARGE_PCA9685), ADDRESSES(LTC_LARGE_LTC2309), NO_ADDRESSES}},
+};
+
+const size_t PLC_NUM_MODELS = sizeof(PLC_MODELS) / sizeof(PLC_MODELS[0]);
+
+
+const struct plc_model* plc_model_find(const char* name) {
+	for (size_t i = 0; i < PLC_NUM_MODELS; i++) {
+		if (strcmp(PLC_MODELS[i].name, name) == 0) {
+			return &PLC_MODELS[i];
+		}
+	}
+	return NULL;
+}
+
+int plc_model_add_to_sim(const struct plc_model* model, uint8_t bus) {
+	const struct peripherals_t* p = &model->peripherals;
+
+	int ret = 0;
+	for (size_t i = 0; i < p->numArrayMCP23008 && ret == 0; i++) {
+		ret = i2c_sim_add_device(bus, I2C_SIM_MCP23008, p->arrayMCP23008[i]);
+	}
+	for (size_t i = 0; i < p->numArrayMCP23017 && ret == 0; i++) {
+		ret = i2c_sim_add_device(bus, I2C_SIM_MCP23017, p->arrayMCP23017[i]);
+	}
+	for (size_t i = 0; i < p->numArrayADS1015 && ret == 0; i++) {
+		ret = i2c_sim_add_device(bus, I2C_SIM_ADS1015, p->arrayADS1015[i]);
+	}
+	for (size_t i = 0; i < p->numArrayLTC2309 && ret == 0; i++) {
+		ret = i2c_sim_add_device(bus, I2C_SIM_LTC2309, p->arrayLTC2309[i]);
+	}
+	for (size_t i = 0; i < p->numArrayPCA9685 && ret == 0; i++) {
+		ret = i2c_sim_add_device(bus, I2C_SIM_PCA9685, p->arrayPCA9685[i]);
+	}
+	return ret;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PLC_MODELS_H__
+#define __PLC_MODELS_H__
+
+/*
+ * Named synthetic I2C topologies, each one a _peripherals_struct with a
+ * typical mix of devices. The benchmarks use them to measure the library
+ * against a whole board instead of a single device. They are not the board
+ * definitions of any PLC model.
+ */
+
+#include <expanded-gpio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	struct plc_model {
+		const char* name; // As given on the command line, like "ltc2309-small"
+		const char* description;
+		struct peripherals_t peripherals;
+	};
+
+	extern const struct plc_model PLC_MODELS[];
+	extern const size_t PLC_NUM_MODELS;
+
+	/**
+	 * @brief Finds a model by its name.
+	 *
+	 * @param name The name of the model.
+	 * @return The model, or NULL if there is none with that name.
+	 */
+	const struct plc_model* plc_model_find(const char* name);
+
+	/**
+	 * @brief Adds the devices of a model to a simulated bus.
+	 *
+	 * @param model The model.
+	 * @param bus The I2C bus number.
+	 * @return 0 on success, -1 on failure (errno is set as in i2c_sim_add_device).
+	 */
+	int plc_model_add_to_sim(const struct plc_model* model, uint8_t bus);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __PLC_MODELS_H__
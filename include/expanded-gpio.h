@@ -38,6 +38,14 @@
 
 #define PERIPHERALS_NO_I2C_BUS -1
 
+#ifndef EXPANDED_GPIO_MAX_BUSES
+#define EXPANDED_GPIO_MAX_BUSES 4
+#endif
+
+#define DEBOUNCE_NONE 0
+#define DEBOUNCE_INTEGRATOR 1
+#define DEBOUNCE_TIME_WINDOW 2
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -86,13 +94,16 @@ extern "C" {
 	/*
 	 * The adapted peripherals until now use the 2th byte as I2C address,
 	 * and the 0th byte as the GPIO's index of the peripheral. The 1th
-	 * byte is left as 0x00
+	 * byte is the slot of the I2C bus (see setExpandedGPIOBus), 0x00 for
+	 * the devices of _peripherals_struct on I2C_BUS
 	 */
 #define MAKE_PIN_PCA9685(addr, index) _MAKE_PIN_PLC(PLC_PCA9685, addr, 0x00, index)
 #define MAKE_PIN_MCP23008(addr, index) _MAKE_PIN_PLC(PLC_MCP23008, addr, 0x00, index)
 #define MAKE_PIN_MCP23017(addr, index) _MAKE_PIN_PLC(PLC_MCP23017, addr, 0x00, index)
 #define MAKE_PIN_LTC2309(addr, index) _MAKE_PIN_PLC(PLC_LTC2309, addr, 0x00, index)
 #define MAKE_PIN_ADS1015(addr, index) _MAKE_PIN_PLC(PLC_ADS1015, addr, 0x00, index)
+	// Moves a peripheral pin (or a device, for the batches) to another bus slot
+#define PIN_ON_BUS(slot, pin) (((pin) & 0xFFFF00FF) | ((uint32_t)((slot) & 0xFF) << 8))
 
 	extern struct peripherals_t _peripherals_struct;
 #define ARRAY_MCP23008 _peripherals_struct.arrayMCP23008
@@ -136,6 +147,16 @@ extern "C" {
 
 	extern int normal_gpio_analog_read(uint32_t pin, uint16_t* read);
 
+	/*
+	 * Optional: write or read several direct pins in one operation (bit
+	 * "i" of the masks is the direct pin "i"). If they are not provided,
+	 * digitalWriteAllDirect and digitalReadAllDirect fall back to a loop
+	 * of normal_gpio_write or normal_gpio_read.
+	 */
+	extern int normal_gpio_write_all(uint64_t mask, uint64_t values) __attribute__((weak));
+
+	extern int normal_gpio_read_all(uint64_t mask, uint64_t* values) __attribute__((weak));
+
 
 	#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
 	void delay(uint32_t milliseconds);
@@ -186,10 +207,12 @@ extern "C" {
 		ARRAY_PCA9685_WRITE_ALL_FAIL          = 26,
 		ARRAY_MCP23008_WRITE_ALL_FAIL         = 27,
 		ARRAY_MCP23017_WRITE_ALL_FAIL         = 28,
+		NORMAL_GPIO_WRITE_ALL_FAIL            = 34,
 
 		// digitalReadAll Errors
 		ARRAY_MCP23008_READ_ALL_FAIL          = 29,
 		ARRAY_MCP23017_READ_ALL_FAIL          = 30,
+		NORMAL_GPIO_READ_ALL_FAIL             = 35,
 
 		// analogWriteAll Errors
 		ARRAY_PCA9685_PWM_WRITE_ALL_FAIL      = 31,
@@ -204,7 +227,9 @@ extern "C" {
 	/**
 	 * @brief Initializes the expanded GPIO devices.
 	 *
-	 * This function initializes all the GPIOs defined in the passed array.
+	 * This function initializes all the GPIOs defined in the passed array. The
+	 * devices saved by deinitExpandedGPIONoReset whose registers still match the
+	 * saved state are not initialized (nor restarted) again.
 	 *
 	 * @param peripherals Struct that indicates which peripherals should be initialized.
 	 * @param restart Flag indicating whether to restart the peripherals on initialization failure.
@@ -212,6 +237,33 @@ extern "C" {
 	 */
 	int initExpandedGPIO(bool restart);
 
+	/**
+	 * @brief Initializes the expanded GPIO devices on demand.
+	 *
+	 * This function opens the I2C bus but doesn't touch the peripherals. Each device
+	 * is initialized the first time one of its pins is accessed, so programs that
+	 * only use a few of them don't pay for the rest. If a device fails to initialize,
+	 * the following accesses to it fail at once, until prewarmExpandedGPIO or a new
+	 * initialization tries it again.
+	 *
+	 * @param restart Flag indicating whether to restart each peripheral when it is initialized.
+	 * @return 0 if successful, appropriate error code otherwise.
+	 */
+	int initExpandedGPIOLazy(bool restart);
+
+	/**
+	 * @brief Initializes in advance the devices of the given pins.
+	 *
+	 * In lazy mode, it avoids paying the initialization of a device on the first
+	 * access to a latency-sensitive pin. The devices that failed to initialize are
+	 * tried again. Otherwise it does nothing.
+	 *
+	 * @param pins Array of pin numbers.
+	 * @param num_pins Number of pins in the array.
+	 * @return 0 if successful, appropriate error code otherwise.
+	 */
+	int prewarmExpandedGPIO(const uint32_t* pins, size_t num_pins);
+
 	/**
 	 * @brief De-initializes the expanded GPIO devices.
 	 *
@@ -225,7 +277,10 @@ extern "C" {
 	 * @brief De-initializes the expanded GPIO devices.
 	 *
 	 * This function de-initializes all the GPIOs defined in the library without
-	 * resetting the peripherals associated.
+	 * resetting the peripherals associated. In Linux, the state of the devices is
+	 * saved to a snapshot under /run (or the directory given by the environment
+	 * variable PLC_PERIPHERALS_SNAPSHOT_DIR), so the next initialization can keep
+	 * them running as they are.
 	 *
 	 * @return 0 if successful, appropriate error code otherwise.
 	 */
@@ -313,6 +368,325 @@ extern "C" {
 	 */
 	int analogWriteAll(uint8_t addr, const void* values);
 
+	/**
+	 * @brief Writes digital values to several direct pins at once.
+	 *
+	 * It is a single operation if the normal_gpio layer provides
+	 * normal_gpio_write_all, and a loop of normal_gpio_write otherwise.
+	 *
+	 * @param mask A bitmask of the direct pins to write (bit "i" is MAKE_PIN_DIRECT(i)).
+	 * @param values A bitmask with the values to write (only the bits in "mask" are used).
+	 * @return 0 if successful, appropriate error code otherwise.
+	 */
+	int digitalWriteAllDirect(uint64_t mask, uint64_t values);
+
+	/**
+	 * @brief Reads the digital values of several direct pins at once.
+	 *
+	 * If the normal_gpio layer provides normal_gpio_read_all, all the pins
+	 * are read in a single operation, so the values are a consistent
+	 * snapshot. Otherwise they are read one by one with normal_gpio_read.
+	 *
+	 * @param mask A bitmask of the direct pins to read (bit "i" is MAKE_PIN_DIRECT(i)).
+	 * @param values Pointer where the values will be stored (only the bits in "mask" are valid).
+	 * @return 0 if successful, appropriate error code otherwise.
+	 */
+	int digitalReadAllDirect(uint64_t mask, uint64_t* values);
+
+	/**
+	 * @brief Configures the software debounce of a MCP23008 or MCP23017 input.
+	 *
+	 * The debounce runs on samples of the whole port, so a single read feeds
+	 * all the debounced pins of the expander. The samples are taken by
+	 * digitalRead (at most one every EXPANDED_GPIO_DEBOUNCE_SAMPLE_US, 1 ms
+	 * by default), digitalReadAll, scanDebouncedInputs and the input events
+	 * monitor. digitalRead and digitalReadAll return the debounced level.
+	 *
+	 * - DEBOUNCE_INTEGRATOR: the new level must be read in "param"
+	 *   consecutive samples.
+	 * - DEBOUNCE_TIME_WINDOW: the new level must be held for "param"
+	 *   milliseconds, and is accepted on the next sample.
+	 * - DEBOUNCE_NONE: disables the debounce of the pin.
+	 *
+	 * @param pin The pin number.
+	 * @param mode The debounce mode.
+	 * @param param Number of samples or milliseconds, depending on the mode.
+	 * @return 0 if successful, -1 on failure (errno is set).
+	 */
+	int setInputDebounce(uint32_t pin, uint8_t mode, uint16_t param);
+
+	/**
+	 * @brief Samples every expander with debounced inputs.
+	 *
+	 * Meant to be called once per scan cycle, so the debounce advances at
+	 * a known rate whatever the pins read by the application.
+	 *
+	 * @return 0 if successful, appropriate error code otherwise.
+	 */
+	int scanDebouncedInputs(void);
+
+	/*
+	 * Several I2C buses. Slot 0 is always I2C_BUS with the devices of
+	 * _peripherals_struct, and up to EXPANDED_GPIO_MAX_BUSES - 1 more
+	 * buses can be added, each with its own devices. Their pins are
+	 * made with PIN_ON_BUS, for example
+	 *     PIN_ON_BUS(1, MAKE_PIN_MCP23008(0x20, 3))
+	 * In Linux, every bus but the first one gets a worker thread, so the
+	 * initialization, scanDebouncedInputs and the batches run on all
+	 * the buses at the same time. The *All functions above, and the
+	 * interrupt lines of the input events, only use slot 0.
+	 */
+
+	/**
+	 * @brief Configures the I2C bus and the devices of a bus slot.
+	 *
+	 * It must be called before the initialization (or after the
+	 * de-initialization) of the expanded GPIOs. The peripherals struct
+	 * must stay valid while it is used.
+	 *
+	 * @param slot The slot of the bus, from 1 to EXPANDED_GPIO_MAX_BUSES - 1.
+	 * @param bus The number of the I2C bus (/dev/i2c-N in Linux).
+	 * @param peripherals The devices of the bus, or NULL to remove the slot.
+	 * @return 0 if successful, -1 on failure (errno is set).
+	 */
+	int setExpandedGPIOBus(uint8_t slot, int bus, const struct peripherals_t* peripherals);
+
+	typedef struct {
+		uint32_t device; // PIN_ON_BUS(slot, MAKE_PIN_XXX(addr, 0))
+		uint32_t values; // As in digitalWriteAll
+		int result; // Filled by digitalWriteAllBatch
+	} expanded_gpio_write_all_t;
+
+	typedef struct {
+		uint32_t device; // PIN_ON_BUS(slot, MAKE_PIN_XXX(addr, 0))
+		uint16_t values; // Filled as in digitalReadAll (the low byte for a MCP23008)
+		int result; // Filled by digitalReadAllBatch
+	} expanded_gpio_read_all_t;
+
+	/**
+	 * @brief Writes all the pins of several devices, on all the buses at the same time.
+	 *
+	 * The operations of the same bus run in the order of the array.
+	 *
+	 * @param ops The operations, whose "result" is set to what digitalWriteAll would return.
+	 * @param num_ops Number of operations.
+	 * @return 0 if all of them succeeded, the result of the first failed operation otherwise.
+	 */
+	int digitalWriteAllBatch(expanded_gpio_write_all_t* ops, size_t num_ops);
+
+	/**
+	 * @brief Reads all the pins of several devices, on all the buses at the same time.
+	 *
+	 * The operations of the same bus run in the order of the array.
+	 *
+	 * @param ops The operations, whose "values" and "result" are set as digitalReadAll would.
+	 * @param num_ops Number of operations.
+	 * @return 0 if all of them succeeded, the result of the first failed operation otherwise.
+	 */
+	int digitalReadAllBatch(expanded_gpio_read_all_t* ops, size_t num_ops);
+
+	/*
+	 * Lock statistics. Each bus slot counts how many times its lock was
+	 * taken, how many of them it was held by another thread, and the time
+	 * waited in those cases, so the applications that use the library from
+	 * several threads can see how much they block each other. The waits are
+	 * only timed when there is contention. Only counted in Linux.
+	 */
+
+	typedef struct {
+		uint64_t acquisitions; // Times the lock of the bus was taken
+		uint64_t contended; // Times it had to wait for another thread
+		uint64_t wait_ns; // Total time waited, CLOCK_MONOTONIC
+		uint64_t max_wait_ns; // Longest wait
+	} expanded_gpio_lock_stats_t;
+
+	/**
+	 * @brief Gets the lock statistics of a bus slot.
+	 *
+	 * The direct pins and the pins of the slots without bus are serialized
+	 * by a lock of their own, which isn't reported here.
+	 *
+	 * @param slot The slot of the bus, from 0 to EXPANDED_GPIO_MAX_BUSES - 1.
+	 * @param stats Where to copy the statistics (all zeros outside Linux).
+	 * @return 0 if successful, -1 on failure (errno is set).
+	 */
+	int getExpandedGPIOLockStats(uint8_t slot, expanded_gpio_lock_stats_t* stats);
+
+	/**
+	 * @brief Sets the lock statistics of all the bus slots to zero.
+	 */
+	void clearExpandedGPIOLockStats(void);
+
+	/*
+	 * Input change events. The subscribed inputs are sampled by a
+	 * background thread, and every change is queued with its timestamp.
+	 * The descriptor returned by inputEventFd() is readable while there
+	 * are queued events, so it can be added to the poll/epoll loop of the
+	 * application instead of reading the inputs on every scan. Only
+	 * available in Linux.
+	 */
+
+	typedef struct {
+		uint64_t timestamp_ns; // CLOCK_MONOTONIC, or the edge time of the INT line
+		uint32_t pin;
+		uint16_t value; // New level (LOW or HIGH)
+		uint16_t analog; // ADC reading that crossed the threshold, 0 for digital pins
+	} input_event_t;
+
+	/**
+	 * @brief Gets the file descriptor that signals the queued input events.
+	 *
+	 * It is an eventfd: it becomes readable when an event is queued, and
+	 * readInputEvents() clears it once the queue is empty. It stays readable
+	 * if the monitor thread stops on an error (see inputEventsError). It must
+	 * not be closed by the application.
+	 *
+	 * @return The file descriptor, -1 on failure (errno is set).
+	 */
+	int inputEventFd(void);
+
+	/**
+	 * @brief Subscribes to the changes of an input.
+	 *
+	 * MCP23008 and MCP23017 pins report every change of level. ADS1015 and
+	 * LTC2309 pins report when the reading crosses the threshold: HIGH at or
+	 * above "threshold", LOW below "threshold - hysteresis". Subscribing an
+	 * already subscribed pin updates its threshold.
+	 *
+	 * @param pin The pin number.
+	 * @param threshold Threshold of the analog pins, ignored for digital pins.
+	 * @param hysteresis Hysteresis of the analog pins, ignored for digital pins.
+	 * @return 0 if successful, -1 on failure (errno is set) or I2C_PIN_WITHOUT_I2C_BUS.
+	 */
+	int subscribeInput(uint32_t pin, uint16_t threshold, uint16_t hysteresis);
+
+	/**
+	 * @brief Removes the subscription of an input.
+	 *
+	 * @param pin The pin number.
+	 * @return 0 if successful, -1 on failure (errno is set).
+	 */
+	int unsubscribeInput(uint32_t pin);
+
+	/**
+	 * @brief Uses the INT line of an MCP230xx instead of polling it.
+	 *
+	 * The expander is then only read when its INT line fires. The line is
+	 * requested from the GPIO character device as an active-low input. The
+	 * two INT lines of a MCP23017 are attached with two calls.
+	 *
+	 * @param addr The I2C address of the expander.
+	 * @param chip Path of the GPIO chip (e.g. "/dev/gpiochip0").
+	 * @param line Offset of the line in the chip.
+	 * @return 0 if successful, -1 on failure (errno is set).
+	 */
+	int attachInputInterruptLine(uint8_t addr, const char* chip, uint32_t line);
+
+	/**
+	 * @brief Sets how often the inputs without INT line are sampled.
+	 *
+	 * @param period_ms The sampling period in milliseconds (10 ms by default).
+	 * @return 0 if successful, -1 on failure (errno is set).
+	 */
+	int setInputEventPeriod(uint32_t period_ms);
+
+	/**
+	 * @brief Takes the queued input events, without blocking.
+	 *
+	 * If the application doesn't drain the queue, the oldest events are
+	 * discarded once it holds 256 events.
+	 *
+	 * @param events Pointer to an array where the events will be stored.
+	 * @param max_events The size of the array.
+	 * @return The number of events stored, 0 if there are none. Once the
+	 *         queue is drained after the monitor thread stopped on an error,
+	 *         0 with errno set to EPIPE.
+	 */
+	size_t readInputEvents(input_event_t* events, size_t max_events);
+
+	/**
+	 * @brief Gets the error that stopped the monitor thread of the input events.
+	 *
+	 * The subscriptions are kept, but no more changes are queued until a call
+	 * to subscribeInput (of any pin, even one already subscribed) starts the
+	 * thread again.
+	 *
+	 * @return The errno of the failure, 0 if the thread is running or was never started.
+	 */
+	int inputEventsError(void);
+
+	/*
+	 * Contexts. All the functions above work on the default context,
+	 * whose slot 0 is I2C_BUS with the devices of _peripherals_struct.
+	 * plcContextCreate makes an independent set of buses and devices,
+	 * with their own locks, workers and lazy mode, so several of them can
+	 * be driven from different threads without interfering. Each context
+	 * must use its own I2C buses.
+	 *
+	 * The plc* functions are the ones above with the context as the
+	 * first argument. The direct pins, the digital*AllDirect functions
+	 * and the input events are shared by the whole process, and belong
+	 * to the default context: the other contexts don't initialize the
+	 * normal_gpio layer, but their direct pins are forwarded to it.
+	 */
+	typedef struct plc_context_t plc_context_t;
+
+	typedef struct {
+		int bus; // I2C bus of slot 0 (/dev/i2c-N in Linux)
+		const struct peripherals_t* peripherals; // Devices of slot 0, must stay valid while used
+	} plc_context_config_t;
+
+	/**
+	 * @brief Gets the default context, used by the functions without context.
+	 */
+	plc_context_t* plcDefaultContext(void);
+
+	/**
+	 * @brief Creates a context.
+	 *
+	 * More buses can be added with plcSetExpandedGPIOBus before the initialization.
+	 *
+	 * @param config The I2C bus and devices of slot 0.
+	 * @return The new context, or NULL on failure (errno is set).
+	 */
+	plc_context_t* plcContextCreate(const plc_context_config_t* config);
+
+	/**
+	 * @brief Destroys a context created with plcContextCreate.
+	 *
+	 * It must be de-initialized first.
+	 *
+	 * @param ctx Pointer to the context, which is set to NULL.
+	 * @return 0 if successful, -1 on failure (errno is set).
+	 */
+	int plcContextDestroy(plc_context_t** ctx);
+
+	int plcInitExpandedGPIO(plc_context_t* ctx, bool restart);
+	int plcInitExpandedGPIOLazy(plc_context_t* ctx, bool restart);
+	int plcPrewarmExpandedGPIO(plc_context_t* ctx, const uint32_t* pins, size_t num_pins);
+	int plcDeinitExpandedGPIO(plc_context_t* ctx);
+	int plcDeinitExpandedGPIONoReset(plc_context_t* ctx);
+	int plcSetExpandedGPIOBus(plc_context_t* ctx, uint8_t slot, int bus, const struct peripherals_t* peripherals);
+
+	int plcPinMode(plc_context_t* ctx, uint32_t pin, uint8_t mode);
+	int plcDigitalWrite(plc_context_t* ctx, uint32_t pin, uint8_t value);
+	int plcDigitalRead(plc_context_t* ctx, uint32_t pin);
+	int plcAnalogWrite(plc_context_t* ctx, uint32_t pin, uint16_t value);
+	int plcAnalogWriteSetFrequency(plc_context_t* ctx, uint32_t pin, uint32_t desired_freq);
+	uint16_t plcAnalogRead(plc_context_t* ctx, uint32_t pin);
+
+	int plcDigitalWriteAll(plc_context_t* ctx, uint8_t addr, uint32_t values);
+	int plcDigitalReadAll(plc_context_t* ctx, uint8_t addr, void* values);
+	int plcAnalogWriteAll(plc_context_t* ctx, uint8_t addr, const void* values);
+	int plcDigitalWriteAllBatch(plc_context_t* ctx, expanded_gpio_write_all_t* ops, size_t num_ops);
+	int plcDigitalReadAllBatch(plc_context_t* ctx, expanded_gpio_read_all_t* ops, size_t num_ops);
+
+	int plcSetInputDebounce(plc_context_t* ctx, uint32_t pin, uint8_t mode, uint16_t param);
+	int plcScanDebouncedInputs(plc_context_t* ctx);
+
+	int plcGetExpandedGPIOLockStats(plc_context_t* ctx, uint8_t slot, expanded_gpio_lock_stats_t* stats);
+	void plcClearExpandedGPIOLockStats(plc_context_t* ctx);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GPIO_CHARDEV_H__
+#define __GPIO_CHARDEV_H__
+
+/*
+ * gpio-chardev is a thin layer over the Linux GPIO character device (uAPI v2).
+ * A request groups several lines of a chip behind a single file descriptor, so
+ * they can be read or written with one ioctl and their edges waited with poll.
+ * Within a request, bit "i" of a mask refers to the i-th requested line.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "detect-platform.h"
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#define GPIO_CHARDEV_MAX_LINES 64
+
+// Edge events that the kernel keeps for a request with edge detection (its maximum)
+#define GPIO_CHARDEV_EVENT_BUFFER_SIZE 1024
+
+// Flags of a line request
+#define GPIO_CHARDEV_EDGE_RISING	0x01
+#define GPIO_CHARDEV_EDGE_FALLING	0x02
+#define GPIO_CHARDEV_EDGE_BOTH		(GPIO_CHARDEV_EDGE_RISING | GPIO_CHARDEV_EDGE_FALLING)
+#define GPIO_CHARDEV_BIAS_PULL_UP	0x04
+#define GPIO_CHARDEV_BIAS_PULL_DOWN	0x08
+#define GPIO_CHARDEV_ACTIVE_LOW		0x10
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/**
+	 * @brief Structure representing an edge event of a requested line.
+	 *
+	 * - @c timestamp_ns: Time of the event, from CLOCK_MONOTONIC, in nanoseconds.
+	 * - @c offset: Offset of the line in the chip.
+	 * - @c seqno: Sequence number of the event on its line (a gap means events were lost).
+	 * - @c rising: 1 for a rising edge, 0 for a falling one (after ACTIVE_LOW is applied).
+	 */
+	typedef struct {
+		uint64_t timestamp_ns;
+		uint32_t offset;
+		uint32_t seqno;
+		uint8_t rising;
+	} gpio_chardev_edge_t;
+
+	/**
+	 * @brief Requests several lines of a GPIO chip as inputs.
+	 *
+	 * If any of the GPIO_CHARDEV_EDGE_* flags is given, the edges of the lines are
+	 * reported as events that can be waited with gpio_chardev_read_edge (or
+	 * poll/epoll on the returned file descriptor).
+	 *
+	 * @param chip The path of the GPIO chip (for example, "/dev/gpiochip0").
+	 * @param offsets Array with the offsets of the lines in the chip.
+	 * @param num_lines Number of lines (up to GPIO_CHARDEV_MAX_LINES).
+	 * @param flags Bitmask of GPIO_CHARDEV_* flags.
+	 * @param consumer Label of the consumer shown by the kernel, can be NULL.
+	 * @return The file descriptor of the request on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: One of the pointers given is invalid.
+	 *             - EINVAL: The number of lines or the flags are invalid.
+	 *             - Other errors that "open" or "ioctl" may return.
+	 */
+	int gpio_chardev_request_inputs(const char* chip, const uint32_t* offsets, size_t num_lines, uint8_t flags, const char* consumer);
+
+	/**
+	 * @brief Requests several lines of a GPIO chip as outputs.
+	 *
+	 * @param chip The path of the GPIO chip (for example, "/dev/gpiochip0").
+	 * @param offsets Array with the offsets of the lines in the chip.
+	 * @param num_lines Number of lines (up to GPIO_CHARDEV_MAX_LINES).
+	 * @param values Initial values of the lines (bit "i" is the i-th line).
+	 * @param flags Bitmask of GPIO_CHARDEV_* flags, except the edge ones.
+	 * @param consumer Label of the consumer shown by the kernel, can be NULL.
+	 * @return The file descriptor of the request on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: One of the pointers given is invalid.
+	 *             - EINVAL: The number of lines or the flags are invalid.
+	 *             - Other errors that "open" or "ioctl" may return.
+	 */
+	int gpio_chardev_request_outputs(const char* chip, const uint32_t* offsets, size_t num_lines, uint64_t values, uint8_t flags, const char* consumer);
+
+	/**
+	 * @brief Changes the direction of the lines of a request with a single ioctl.
+	 *
+	 * The lines in "output_mask" become outputs, driven with "values", and the
+	 * rest become inputs.
+	 *
+	 * @param fd The file descriptor of the request.
+	 * @param output_mask Bitmask of the lines that are outputs.
+	 * @param values Values of the output lines.
+	 * @param flags Bitmask of GPIO_CHARDEV_* flags. The edge ones are only valid
+	 *              if all the lines are inputs.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EINVAL: The flags are invalid.
+	 *             - Other errors that "ioctl" may return.
+	 */
+	int gpio_chardev_set_directions(int fd, uint64_t output_mask, uint64_t values, uint8_t flags);
+
+	/**
+	 * @brief Writes the values of several output lines of a request with a single ioctl.
+	 *
+	 * @param fd The file descriptor of the request.
+	 * @param mask Bitmask of the lines to write.
+	 * @param values The values to write (only the bits in "mask" are used).
+	 * @return 0 on success, -1 on failure (errno is set by "ioctl").
+	 */
+	int gpio_chardev_set_values(int fd, uint64_t mask, uint64_t values);
+
+	/**
+	 * @brief Reads the values of several lines of a request with a single ioctl.
+	 *
+	 * @param fd The file descriptor of the request.
+	 * @param mask Bitmask of the lines to read.
+	 * @param values Pointer where the values will be stored (only the bits in "mask" are valid).
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: The pointer given is invalid.
+	 *             - Other errors that "ioctl" may return.
+	 */
+	int gpio_chardev_get_values(int fd, uint64_t mask, uint64_t* values);
+
+	/**
+	 * @brief Waits for the next edge event of a request.
+	 *
+	 * @param fd The file descriptor of the request.
+	 * @param timeout_ms Maximum time to wait in milliseconds, negative to wait forever
+	 *                   and 0 to return immediately.
+	 * @param edge Pointer where the event will be stored.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: The pointer given is invalid.
+	 *             - ETIMEDOUT: No event arrived before the timeout.
+	 *             - EBADE: The kernel returned an incomplete event.
+	 *             - Other errors that "poll" or "read" may return.
+	 */
+	int gpio_chardev_read_edge(int fd, int timeout_ms, gpio_chardev_edge_t* edge);
+
+	/**
+	 * @brief Waits for edge events of a request and takes all the pending ones.
+	 *
+	 * Unlike gpio_chardev_read_edge, the events already buffered by the kernel
+	 * are taken with a single "read", up to "max_edges".
+	 *
+	 * @param fd The file descriptor of the request.
+	 * @param timeout_ms Maximum time to wait in milliseconds, negative to wait forever
+	 *                   and 0 to return immediately.
+	 * @param edges Array where the events will be stored, oldest first.
+	 * @param max_edges Size of the array.
+	 * @return The number of events stored on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: The pointer given is invalid.
+	 *             - EINVAL: The size of the array is 0.
+	 *             - ETIMEDOUT: No event arrived before the timeout.
+	 *             - EBADE: The kernel returned an incomplete event.
+	 *             - Other errors that "poll" or "read" may return.
+	 */
+	int gpio_chardev_read_edges(int fd, int timeout_ms, gpio_chardev_edge_t* edges, size_t max_edges);
+
+	/**
+	 * @brief Releases the lines of a request.
+	 *
+	 * @param fd The file descriptor of the request.
+	 * @return 0 on success, -1 on failure (errno is set by "close").
+	 */
+	int gpio_chardev_release(int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PLC_ENVIRONMENT == Linux
+
+#endif // __GPIO_CHARDEV_H__
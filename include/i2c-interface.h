@@ -46,6 +46,11 @@ extern "C" {
         #define FAST_CREATE_I2C_WRITE(name, ...) \
 	const i2c_write_t name = {.buff = (const uint8_t[]) {__VA_ARGS__}, sizeof((const uint8_t[]) {__VA_ARGS__})}
 
+	/**
+	 * @brief Maximum number of reads that i2c_write_then_read_multiple can combine.
+	 */
+        #define I2C_MAX_COMBINED_READS 16
+
 
 	/**
 	 * @brief Structure representing an I2C interface.
@@ -186,6 +191,33 @@ extern "C" {
 	 */
         int i2c_write_then_read(i2c_interface_t* i2c, const uint8_t addr, const i2c_write_t* read_order, const i2c_read_t* to_read);
 
+	/**
+	 * @brief It performs several write-then-read operations on the same I2C device as a
+	 *        single combined transaction. It is normally used to read several
+	 *        non-contiguous registers at once.
+	 *
+	 * In Linux all the messages are sent in one I2C_RDWR ioctl, separated by repeated
+	 * STARTs. In Arduino ESP32 the reads are performed one after the other.
+	 *
+	 * @param i2c Pointer to the I2C interface structure.
+	 * @param addr The address of the I2C device.
+	 * @param read_orders Array of "num" read orders.
+	 * @param to_reads Array of "num" buffers where the data will be read.
+	 * @param num The number of reads to perform (up to I2C_MAX_COMBINED_READS).
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: One of the pointers given is invalid.
+	 *             - EINVAL: The I2C address, "num" or the length of one of the buffers is invalid.
+	 *             - EBADFD: The I2C interface contains incorrect data.
+	 *             - EAGAIN: The operation is temporarily unavailable.
+	 *             - EIO: The slave didn't ACK the request, or there is a more general error on the bus.
+	 *             - EBADE: Unexpected result from the write function. If this errno is set, the
+	 *                      return value will be the same as the platform's write function.
+	 *             - For Linux:
+	 *                 - Other errors that "ioctl" may return.
+	 */
+	int i2c_write_then_read_multiple(i2c_interface_t* i2c, const uint8_t addr, const i2c_write_t* read_orders, const i2c_read_t* to_reads, size_t num);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __IIO_BUFFER_H__
+#define __IIO_BUFFER_H__
+
+/*
+ * iio-buffer captures the channels of a Linux IIO device (an ADC of the SoC,
+ * for example) in buffered mode: the device samples them on every trigger,
+ * and a thread reads the samples from /dev/iio:deviceN in blocks, keeping
+ * them in a ring. The latest value of a channel, or the samples taken since
+ * the last call, can then be read without any system call.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "detect-platform.h"
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#define IIO_BUFFER_MAX_CHANNELS 16
+#define IIO_BUFFER_DEFAULT_SYSFS_ROOT "/sys/bus/iio/devices"
+#define IIO_BUFFER_DEFAULT_DEV_ROOT "/dev"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/**
+	 * @brief Structure representing an IIO device in buffered mode.
+	 */
+	struct _iio_buffer_t;
+	typedef struct _iio_buffer_t iio_buffer_t;
+
+	/**
+	 * @brief Structure representing the configuration of the capture.
+	 *
+	 * - @c sysfs_root: The sysfs IIO directory, NULL for IIO_BUFFER_DEFAULT_SYSFS_ROOT.
+	 * - @c dev_root: The directory of the character device, NULL for IIO_BUFFER_DEFAULT_DEV_ROOT.
+	 * - @c device: The number of the device (N in "iio:deviceN").
+	 * - @c channels: The names of the scan elements to capture (e.g. "in_voltage0").
+	 * - @c num_channels: Number of channels (up to IIO_BUFFER_MAX_CHANNELS).
+	 * - @c trigger: The name of the trigger, NULL to keep the current one.
+	 * - @c kernel_length: Samples held by the kernel buffer, 0 to keep the current length.
+	 * - @c ring_length: Samples held by the ring of the library.
+	 */
+	typedef struct {
+		const char* sysfs_root;
+		const char* dev_root;
+		uint32_t device;
+		const char* const* channels;
+		size_t num_channels;
+		const char* trigger;
+		uint32_t kernel_length;
+		size_t ring_length;
+	} iio_buffer_config_t;
+
+	/**
+	 * @brief Structure representing a sample of all the captured channels.
+	 *
+	 * - @c timestamp_ns: Time of the sample, 0 if the device has no timestamp channel.
+	 * - @c values: Raw value of every channel, in the order of the configuration.
+	 *              Negative values of signed channels are stored as 0.
+	 */
+	typedef struct {
+		uint64_t timestamp_ns;
+		uint16_t values[IIO_BUFFER_MAX_CHANNELS];
+	} iio_buffer_sample_t;
+
+	/**
+	 * @brief Configures an IIO device in buffered mode and starts the capture.
+	 *
+	 * Only the given channels (and the timestamp, if the device has it) are
+	 * enabled.
+	 *
+	 * @param config Pointer to the configuration.
+	 * @return Pointer to the capture on success, NULL on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: One of the pointers given is invalid.
+	 *             - EINVAL: The number of channels, the ring length or the type of a channel is invalid.
+	 *             - ENAMETOOLONG: A path is too long.
+	 *             - Other errors that "open", "read", "write", "malloc" or "pthread_create" may return.
+	 */
+	iio_buffer_t* iio_buffer_open(const iio_buffer_config_t* config);
+
+	/**
+	 * @brief Stops the capture and disables the buffer of the device.
+	 *
+	 * @param pointer_to_buffer Pointer to the pointer of the capture. It is set to NULL.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: The pointer given is invalid.
+	 *             - Other errors that "write" or "close" may return.
+	 */
+	int iio_buffer_close(iio_buffer_t** pointer_to_buffer);
+
+	/**
+	 * @brief Gets the latest value of a channel.
+	 *
+	 * @param buffer Pointer to the capture.
+	 * @param channel Index of the channel in the configuration.
+	 * @param value Pointer where the value will be stored.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: One of the pointers given is invalid.
+	 *             - EINVAL: The channel doesn't exist.
+	 *             - EAGAIN: No sample has been captured yet.
+	 *             - EPIPE: The capture stopped on an error of the device (see iio_buffer_error).
+	 *                      The samples already captured can still be taken with iio_buffer_read_block.
+	 */
+	int iio_buffer_latest(iio_buffer_t* buffer, size_t channel, uint16_t* value);
+
+	/**
+	 * @brief Takes the samples captured since the last call, without blocking.
+	 *
+	 * If they are not taken in time, the oldest samples are overwritten (see
+	 * iio_buffer_dropped).
+	 *
+	 * @param buffer Pointer to the capture.
+	 * @param samples Pointer to an array where the samples will be stored, oldest first.
+	 * @param max_samples The size of the array.
+	 * @return The number of samples stored, 0 if there are none or the pointers are invalid.
+	 */
+	size_t iio_buffer_read_block(iio_buffer_t* buffer, iio_buffer_sample_t* samples, size_t max_samples);
+
+	/**
+	 * @brief Gets the number of samples overwritten before being taken.
+	 *
+	 * @param buffer Pointer to the capture.
+	 * @return The number of samples, 0 if the pointer is invalid.
+	 */
+	uint64_t iio_buffer_dropped(iio_buffer_t* buffer);
+
+	/**
+	 * @brief Gets the error that stopped the capture.
+	 *
+	 * A hang-up or the end of the character device is reported as EPIPE. The capture
+	 * isn't restarted: the device must be closed and opened again.
+	 *
+	 * @param buffer Pointer to the capture.
+	 * @return The errno that stopped the capture, 0 while it runs or if the pointer is invalid.
+	 */
+	int iio_buffer_error(iio_buffer_t* buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PLC_ENVIRONMENT == Linux
+
+#endif // __IIO_BUFFER_H__
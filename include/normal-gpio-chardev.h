@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __NORMAL_GPIO_CHARDEV_H__
+#define __NORMAL_GPIO_CHARDEV_H__
+
+/*
+ * normal-gpio-chardev is an implementation of the normal_gpio_* functions
+ * that expanded-gpio expects (see expanded-gpio.h), on top of the Linux GPIO
+ * character device. It is only built when PLC_PERIPHERALS_NORMAL_GPIO_CHARDEV
+ * is defined, so it doesn't clash with the implementation of the library that
+ * embeds plc-peripherals.
+ *
+ * The PWM outputs of the direct pins (analogWrite) are driven through sysfs
+ * with pwm-sysfs, keeping the attribute files open. The analog inputs
+ * (analogRead) can be captured by an IIO device in buffered mode with
+ * iio-buffer, and are then served from the latest sample. The direct inputs
+ * connected to flow meters or encoders can count their pulses with
+ * pulse-counter, from the edge events timestamped by the kernel.
+ *
+ * The direct pins are numbered by their position in the table given to
+ * normal_gpio_chardev_set_lines. All the lines of the same chip are requested
+ * together, so reading or writing many of them (with the optional
+ * normal_gpio_write_all and normal_gpio_read_all) is one ioctl per chip.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "detect-platform.h"
+#include "iio-buffer.h"
+#include "pulse-counter.h"
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#define NORMAL_GPIO_CHARDEV_MAX_PINS 64
+#define NORMAL_GPIO_CHARDEV_MAX_CHIPS 8
+#define NORMAL_GPIO_CHARDEV_MAX_PWMS 16
+#define NORMAL_GPIO_CHARDEV_PWM_DEFAULT_FREQ 1000
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/**
+	 * @brief Structure representing a direct pin.
+	 *
+	 * - @c chip: The path of the GPIO chip (for example, "/dev/gpiochip0").
+	 * - @c offset: Offset of the line in the chip.
+	 */
+	typedef struct {
+		const char* chip;
+		uint32_t offset;
+	} normal_gpio_chardev_line_t;
+
+	/**
+	 * @brief Sets the lines of the direct pins.
+	 *
+	 * It must be called before initExpandedGPIO. The lines are requested as
+	 * inputs by normal_gpio_init, and pinMode changes their direction.
+	 *
+	 * @param lines Array with the line of every direct pin (pin "i" is lines[i]).
+	 * @param num_pins Number of pins (up to NORMAL_GPIO_CHARDEV_MAX_PINS).
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: One of the pointers given is invalid.
+	 *             - EINVAL: The number of pins is invalid.
+	 *             - ENOSPC: The lines belong to more than NORMAL_GPIO_CHARDEV_MAX_CHIPS chips.
+	 *             - ENAMETOOLONG: The path of a chip is too long.
+	 *             - EBUSY: The lines are already requested.
+	 */
+	int normal_gpio_chardev_set_lines(const normal_gpio_chardev_line_t* lines, size_t num_pins);
+
+	/**
+	 * @brief Sets the direct pins that count pulses.
+	 *
+	 * It must be called after normal_gpio_chardev_set_lines and before
+	 * initExpandedGPIO. The counter pins are requested apart, with edge
+	 * detection, by normal_gpio_init. They can still be read (digitalRead),
+	 * but pinMode and digitalWrite return EBUSY for them.
+	 *
+	 * @param counters Array with the direct pins that count pulses.
+	 * @param num_counters Number of pins, 0 to disable the counters.
+	 * @param flags Bitmask of GPIO_CHARDEV_* flags, with the edges to count.
+	 * @param gate_ms Minimum time over which the frequency is averaged, 0 for
+	 *                PULSE_COUNTER_DEFAULT_GATE_MS.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: The pointer given is invalid.
+	 *             - EINVAL: A pin doesn't exist or no edge is given.
+	 *             - EBUSY: The lines are already requested.
+	 */
+	int normal_gpio_chardev_set_counters(const uint32_t* counters, size_t num_counters, uint8_t flags, uint32_t gate_ms);
+
+	/**
+	 * @brief Gets the count, period and frequency of a counter pin, without blocking.
+	 *
+	 * @param pin The direct pin.
+	 * @param reading Pointer where the state of the counter will be stored.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: The pointer given is invalid.
+	 *             - EINVAL: The pin doesn't count pulses.
+	 *             - EBADFD: The counters aren't started.
+	 *             - EPIPE: The counting stopped on an error of the chip (see pulse_counter_error).
+	 */
+	int normal_gpio_chardev_read_counter(uint32_t pin, pulse_counter_reading_t* reading);
+
+	/**
+	 * @brief Sets the count of a counter pin to 0.
+	 *
+	 * @param pin The direct pin.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EINVAL: The pin doesn't count pulses.
+	 *             - EBADFD: The counters aren't started.
+	 */
+	int normal_gpio_chardev_reset_counter(uint32_t pin);
+
+	/**
+	 * @brief Gets the number of pulses whose events were discarded by the kernel (see pulse_counter_missed).
+	 *
+	 * @return The number of pulses of all the counter pins.
+	 */
+	uint64_t normal_gpio_chardev_missed_pulses(void);
+
+	/**
+	 * @brief Structure representing the PWM channel of a direct pin.
+	 *
+	 * - @c pin: The direct pin (the index given to MAKE_PIN_DIRECT).
+	 * - @c chip: The number of the PWM chip (N in "pwmchipN").
+	 * - @c channel: The number of the channel in the chip.
+	 */
+	typedef struct {
+		uint32_t pin;
+		uint32_t chip;
+		uint32_t channel;
+	} normal_gpio_chardev_pwm_t;
+
+	/**
+	 * @brief Sets the PWM channels of the direct pins.
+	 *
+	 * It must be called before initExpandedGPIO. The channels are exported
+	 * and opened by normal_gpio_init, and the ones without a period get
+	 * NORMAL_GPIO_CHARDEV_PWM_DEFAULT_FREQ. The pins without a channel
+	 * return ENOTSUP from the PWM functions.
+	 *
+	 * @param root The sysfs PWM directory, NULL for PWM_SYSFS_DEFAULT_ROOT.
+	 * @param channels Array with the channels.
+	 * @param num_channels Number of channels (up to NORMAL_GPIO_CHARDEV_MAX_PWMS).
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: The pointer given is invalid.
+	 *             - EINVAL: The number of channels is invalid.
+	 *             - ENAMETOOLONG: The root path is too long.
+	 *             - EBUSY: The channels are already opened.
+	 */
+	int normal_gpio_chardev_set_pwms(const char* root, const normal_gpio_chardev_pwm_t* channels, size_t num_channels);
+
+	/**
+	 * @brief Sets the IIO device that captures the analog inputs of the direct pins.
+	 *
+	 * It must be called before initExpandedGPIO, and the configuration (with
+	 * the strings it points to) must remain valid until normal_gpio_deinit.
+	 * The capture is started by normal_gpio_init. The pins without a channel
+	 * return ENOTSUP from normal_gpio_analog_read.
+	 *
+	 * @param config Pointer to the configuration of the capture, NULL to disable it.
+	 * @param pins Array with the direct pin of every channel (pins[i] is config->channels[i]).
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: The pointer to the pins is invalid.
+	 *             - EINVAL: The number of channels is invalid.
+	 *             - EBUSY: The capture is already started.
+	 */
+	int normal_gpio_chardev_set_analog(const iio_buffer_config_t* config, const uint32_t* pins);
+
+	/**
+	 * @brief Gets the capture of the analog inputs, to read blocks of samples.
+	 *
+	 * @return Pointer to the capture, NULL if it isn't started.
+	 */
+	iio_buffer_t* normal_gpio_chardev_analog_buffer(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PLC_ENVIRONMENT == Linux
+
+#endif // __NORMAL_GPIO_CHARDEV_H__
@@ -24,6 +24,7 @@
 #include <i2c-interface.h>
 
 #define ADS1015_NUM_INPUTS 4
+#define ADS1015_CONVERSION_US 650 // Wait between the start of a conversion and its result
 
 #ifdef __cplusplus
 extern "C" {
@@ -116,6 +117,54 @@ extern "C" {
 	 */
 	int ads1015_unsigned_read(i2c_interface_t* i2c, uint8_t addr, uint8_t index, uint16_t* read_value);
 
+	/**
+	 * @brief Starts a single-ended conversion of the ADS1015 ADC.
+	 *
+	 * ads1015_read is this function, a wait of ADS1015_CONVERSION_US and
+	 * ads1015_read_conversion. Split, the bus can be used for something else
+	 * while the ADC converts.
+	 *
+	 * @param i2c Pointer to the I2C interface structure.
+	 * @param addr The I2C address of the ADS1015.
+	 * @param index The channel index (0-3).
+	 * @return 0 on success, -1 on failure.
+	 *	   On failure, errno is set as follows:
+	 *	       - EFAULT: The specified pointer to the I2C interface structure is invalid.
+	 *	       - EINVAL: The I2C address or the channel index is invalid.
+	 *	       - EBADFD: The I2C interface contains incorrect data.
+	 *	       - EAGAIN: The operation is temporarily unavailable.
+	 *	       - EIO: The slave didn't ACK the request, or there is a more general error on the bus.
+	 *	       - EBADE: Unexpected result from the write function. If this errno is set, the
+	 *			return value will be the same as the platform's write function.
+	 *	       - For Linux:
+	 *		   - Other errors that "ioctl" may return.
+	 */
+	int ads1015_start_conversion(i2c_interface_t* i2c, uint8_t addr, uint8_t index);
+
+	/**
+	 * @brief Reads the result of the conversion started with ads1015_start_conversion.
+	 *
+	 * It must be called at least ADS1015_CONVERSION_US after the start.
+	 *
+	 * @param i2c Pointer to the I2C interface structure.
+	 * @param addr The I2C address of the ADS1015.
+	 * @param read_value Pointer to store the read value.
+	 * @return 0 on success, -1 on failure.
+	 *	   On failure, errno is set as in ads1015_read.
+	 */
+	int ads1015_read_conversion(i2c_interface_t* i2c, uint8_t addr, int16_t* read_value);
+
+	/**
+	 * @brief Same as ads1015_read_conversion, as an unsigned value (see ads1015_unsigned_read).
+	 *
+	 * @param i2c Pointer to the I2C interface structure.
+	 * @param addr The I2C address of the ADS1015.
+	 * @param read_value Pointer to store the read value.
+	 * @return 0 on success, -1 on failure.
+	 *	   On failure, errno is set as in ads1015_unsigned_read.
+	 */
+	int ads1015_unsigned_read_conversion(i2c_interface_t* i2c, uint8_t addr, uint16_t* read_value);
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,12 +22,20 @@
 
 #include <stdint.h>
 #include <i2c-interface.h>
+#include <detect-platform.h>
 
 #define MCP23008_NUM_IO 8
+#define MCP23008_STATE_SIZE 8
 
 #define MCP23008_OUTPUT 0
 #define MCP23008_INPUT 1
 
+// Interrupt modes of a pin
+#define MCP23008_INT_DISABLED 0
+#define MCP23008_INT_ON_CHANGE 1 // Fires when the pin changes
+#define MCP23008_INT_ON_LOW 2 // Fires while the pin is low
+#define MCP23008_INT_ON_HIGH 3 // Fires while the pin is high
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -45,7 +53,8 @@ extern "C" {
 	 *	       - EINVAL: The I2C address is invalid.
 	 *	       - EBADFD: The I2C interface contains incorrect data.
 	 *	       - EAGAIN: The operation is temporarily unavailable.
-	 *	       - EIO: The slave didn't ACK the request, or there is a more general error on the bus.
+	 *	       - EIO: The slave didn't ACK the request, there is a more general error on the bus,
+	 *		      or the configuration read back doesn't match the one written.
 	 *	       - EBADE: Unexpected result from the write function. If this errno is set, the
 	 *			return value will be the same as the platform's write function.
 	 *	       - For Linux:
@@ -212,6 +221,127 @@ extern "C" {
 	 */
 	int mcp23008_write_all(i2c_interface_t* i2c, uint8_t addr, uint8_t value);
 
+	/**
+	 * @brief Reads the configuration and output latch registers of the MCP23008.
+	 *
+	 * The registers IODIR, IPOL, GPINTEN, DEFVAL, INTCON, IOCON, GPPU and OLAT are
+	 * read, in this order, with a single combined transaction. It is meant to
+	 * compare the state of the device with a previously saved one.
+	 *
+	 * @param i2c Pointer to the I2C interface structure.
+	 * @param addr The I2C address of the MCP23008.
+	 * @param state Buffer where the registers will be stored.
+	 * @return 0 on success, -1 on failure.
+	 *	   On failure, errno is set as follows:
+	 *	       - EFAULT: One of the pointers given is invalid.
+	 *	       - EINVAL: The I2C address is invalid.
+	 *	       - EBADFD: The I2C interface contains incorrect data.
+	 *	       - EAGAIN: The operation is temporarily unavailable.
+	 *	       - EIO: The slave didn't ACK the request, or there is a more general error on the bus.
+	 *	       - EBADE: Unexpected result from the write function. If this errno is set, the
+	 *			return value will be the same as the platform's write function.
+	 *	       - For Linux:
+	 *		   - Other errors that "ioctl" may return.
+	 */
+	int mcp23008_read_state(i2c_interface_t* i2c, uint8_t addr, uint8_t state[MCP23008_STATE_SIZE]);
+
+	/**
+	 * @brief Sets the interrupt-on-change mode of a pin of the MCP23008.
+	 *
+	 * The INT output of the device is open-drain and active-low (as configured
+	 * by mcp23008_init).
+	 *
+	 * @param i2c Pointer to the I2C interface structure.
+	 * @param addr The I2C address of the MCP23008.
+	 * @param index The index of the pin (0-7).
+	 * @param mode One of the MCP23008_INT_* modes.
+	 * @return 0 on success, -1 on failure.
+	 *	   On failure, errno is set as follows:
+	 *	       - EFAULT: One of the pointers given is invalid.
+	 *	       - EINVAL: The I2C address or one of the parameters is invalid.
+	 *	       - EBADFD: The I2C interface contains incorrect data.
+	 *	       - EAGAIN: The operation is temporarily unavailable.
+	 *	       - EIO: The slave didn't ACK the request, or there is a more general error on the bus.
+	 *	       - EBADE: Unexpected result from the write function. If this errno is set, the
+	 *			return value will be the same as the platform's write function.
+	 *	       - For Linux:
+	 *		   - Other errors that "ioctl" may return.
+	 */
+	int mcp23008_set_interrupt(i2c_interface_t* i2c, uint8_t addr, uint8_t index, uint8_t mode);
+
+	/**
+	 * @brief Sets the interrupt configuration of all the pins of the MCP23008.
+	 *
+	 * Each bit represents the pin with the same index. A pin with its "compare" bit
+	 * cleared fires on any change, otherwise it fires while its level differs from
+	 * its "defval" bit.
+	 *
+	 * @param i2c Pointer to the I2C interface structure.
+	 * @param addr The I2C address of the MCP23008.
+	 * @param enable Bitmask of the pins with the interrupt enabled (GPINTEN).
+	 * @param compare Bitmask of the pins compared with "defval" (INTCON).
+	 * @param defval Bitmask of the default values to compare with (DEFVAL).
+	 * @return 0 on success, -1 on failure.
+	 *	   On failure, errno is set as follows:
+	 *	       - EFAULT: One of the pointers given is invalid.
+	 *	       - EINVAL: The I2C address or one of the parameters is invalid.
+	 *	       - EBADFD: The I2C interface contains incorrect data.
+	 *	       - EAGAIN: The operation is temporarily unavailable.
+	 *	       - EIO: The slave didn't ACK the request, or there is a more general error on the bus.
+	 *	       - EBADE: Unexpected result from the write function. If this errno is set, the
+	 *			return value will be the same as the platform's write function.
+	 *	       - For Linux:
+	 *		   - Other errors that "ioctl" may return.
+	 */
+	int mcp23008_set_interrupt_all(i2c_interface_t* i2c, uint8_t addr, uint8_t enable, uint8_t compare, uint8_t defval);
+
+	/**
+	 * @brief Reads which pins caused an interrupt, and their captured values.
+	 *
+	 * The INTF and INTCAP registers are read in a single combined transaction.
+	 * Reading INTCAP clears the interrupt.
+	 *
+	 * @param i2c Pointer to the I2C interface structure.
+	 * @param addr The I2C address of the MCP23008.
+	 * @param flags Pointer where the bitmask of the pins that caused the interrupt will be stored.
+	 * @param captured Pointer where the values of the pins at the time of the interrupt will be stored.
+	 * @return 0 on success, -1 on failure.
+	 *	   On failure, errno is set as follows:
+	 *	       - EFAULT: One of the pointers given is invalid.
+	 *	       - EINVAL: The I2C address or one of the parameters is invalid.
+	 *	       - EBADFD: The I2C interface contains incorrect data.
+	 *	       - EAGAIN: The operation is temporarily unavailable.
+	 *	       - EIO: The slave didn't ACK the request, or there is a more general error on the bus.
+	 *	       - EBADE: Unexpected result from the write function. If this errno is set, the
+	 *			return value will be the same as the platform's write function.
+	 *	       - For Linux:
+	 *		   - Other errors that "ioctl" may return.
+	 */
+	int mcp23008_read_interrupt(i2c_interface_t* i2c, uint8_t addr, uint8_t* flags, uint8_t* captured);
+
+	#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+	/**
+	 * @brief Waits for an interrupt of the MCP23008 on its INT line.
+	 *
+	 * It blocks on the edge events of the GPIO connected to the INT output, and
+	 * then reads which pins changed with mcp23008_read_interrupt. An interrupt
+	 * already pending when it is called is returned immediately.
+	 *
+	 * @param i2c Pointer to the I2C interface structure.
+	 * @param addr The I2C address of the MCP23008.
+	 * @param line_fd A gpio-chardev request of only the INT line, with the flags
+	 *                GPIO_CHARDEV_ACTIVE_LOW and GPIO_CHARDEV_EDGE_RISING (at least).
+	 * @param timeout_ms Maximum time to wait in milliseconds, negative to wait forever.
+	 * @param flags Pointer where the bitmask of the pins that caused the interrupt will be stored.
+	 * @param captured Pointer where the values of the pins at the time of the interrupt will be stored.
+	 * @return 0 on success, -1 on failure.
+	 *	   On failure, errno is set as in mcp23008_read_interrupt, or as follows:
+	 *	       - ETIMEDOUT: No interrupt arrived before the timeout.
+	 *	       - Other errors that gpio_chardev_get_values or gpio_chardev_read_edge may set.
+	 */
+	int mcp23008_wait_interrupt(i2c_interface_t* i2c, uint8_t addr, int line_fd, int timeout_ms, uint8_t* flags, uint8_t* captured);
+	#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -25,6 +25,7 @@
 
 #define PCA9685_NUM_OUTPUTS 16
 #define PCA9685_INTERNAL_CLOCK 25000000UL // 25 MHz
+#define PCA9685_STATE_SIZE 71
 
 #ifdef __cplusplus
 extern "C" {
@@ -189,6 +190,30 @@ extern "C" {
 	 */
 	int pca9685_pwm_write_all(i2c_interface_t* i2c, uint8_t addr, const uint16_t values[PCA9685_NUM_OUTPUTS]);
 
+	/**
+	 * @brief Reads the configuration and output registers of the PCA9685.
+	 *
+	 * The registers from MODE1 to LED15_OFF_H, followed by PRE_SCALE, are read with
+	 * a single combined transaction. It is meant to compare the state of the device
+	 * with a previously saved one.
+	 *
+	 * @param i2c Pointer to the I2C interface structure.
+	 * @param addr The I2C address of the PCA9685 device.
+	 * @param state Buffer where the registers will be stored.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: One of the pointers given is invalid.
+	 *             - EINVAL: The I2C address is invalid.
+	 *             - EBADFD: The I2C interface contains incorrect data.
+	 *             - EAGAIN: The operation is temporarily unavailable.
+	 *             - EIO: The slave didn't ACK the request, or there is a more general error on the bus.
+	 *             - EBADE: Unexpected result from the write function. If this errno is set, the
+	 *                      return value will be the same as the platform's write function.
+	 *             - For Linux:
+	 *                 - Other errors that "ioctl" may return.
+	 */
+	int pca9685_read_state(i2c_interface_t* i2c, uint8_t addr, uint8_t state[PCA9685_STATE_SIZE]);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,832 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PLC_ASYNC_HPP__
+#define __PLC_ASYNC_HPP__
+
+/*
+ * Awaitable operations over the device classes of plc-peripherals.hpp, for
+ * applications written with C++20 coroutines.
+ *
+ * plc::AsyncBus opens a bus and runs its transactions on a worker thread.
+ * The async devices (plc::AsyncMcp23008, plc::AsyncMcp23017,
+ * plc::AsyncPca9685, plc::AsyncAds1015 and plc::AsyncLtc2309) give
+ * operations that are queued to the worker when awaited, and resume the
+ * coroutine when they are done:
+ *
+ *     plc::Task<> scan(plc::AsyncMcp23017& inputs, plc::AsyncAds1015& ads) {
+ *         auto [levels, analog] = co_await plc::when_all(inputs.read_all(), ads.read(0));
+ *         ...
+ *     }
+ *
+ * An ADS1015 read doesn't hold the bus while the ADC converts: the worker
+ * starts the conversion, runs the other transactions of the bus, and reads
+ * the result ADS1015_CONVERSION_US later. The reads of the same ADS1015 are
+ * done one after another. Several buses work at the same time, each on its
+ * own worker.
+ *
+ * The coroutines awaiting inside plc::AsyncLoop::run are resumed on the
+ * thread of the loop, so the computation never runs on a worker. Outside a
+ * loop they are resumed on the worker, and must not destroy its bus there.
+ *
+ * The operations return a plc::Result (a plc::Status for those that don't
+ * read anything), and nothing throws, but the exceptions of a plc::Task are
+ * passed on to its awaiter. The bus must only be used through its worker,
+ * and it must outlive its devices and their operations.
+ *
+ * GCC 12 skips the body of a coroutine that has a co_await in the condition
+ * of an if: the result must be awaited into a variable first.
+ */
+
+#if __cplusplus < 202002L || !defined(__cpp_impl_coroutine)
+#error "plc-async.hpp needs C++20 coroutines"
+#endif
+
+#include "plc-peripherals.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <tuple>
+
+namespace plc {
+
+	/**
+	 * @brief Result of an operation that reads a value, valid if status is ok.
+	 */
+	template <typename T>
+	struct Result {
+		Status status;
+		T value{};
+
+		bool ok() const noexcept { return status.ok(); }
+		explicit operator bool() const noexcept { return ok(); }
+	};
+
+
+	template <typename T = void>
+	class Task;
+
+	namespace detail {
+		class TaskPromiseBase {
+		public:
+			struct FinalAwaiter {
+				bool await_ready() const noexcept { return false; }
+
+				template <typename Promise>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+					const std::coroutine_handle<> continuation = handle.promise().continuation_;
+					return continuation ? continuation : std::noop_coroutine();
+				}
+
+				void await_resume() const noexcept {}
+			};
+
+			std::suspend_always initial_suspend() const noexcept { return {}; }
+			FinalAwaiter final_suspend() const noexcept { return {}; }
+			void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+			std::coroutine_handle<> continuation_;
+			std::exception_ptr exception_;
+		};
+
+		template <typename T>
+		class TaskPromise : public TaskPromiseBase {
+		public:
+			Task<T> get_return_object() noexcept;
+
+			template <typename U>
+			void return_value(U&& value) { value_.emplace(std::forward<U>(value)); }
+
+			T take() {
+				if (exception_) {
+					std::rethrow_exception(exception_);
+				}
+				return std::move(*value_);
+			}
+
+		private:
+			std::optional<T> value_;
+		};
+
+		template <>
+		class TaskPromise<void> : public TaskPromiseBase {
+		public:
+			Task<void> get_return_object() noexcept;
+
+			void return_void() noexcept {}
+
+			void take() {
+				if (exception_) {
+					std::rethrow_exception(exception_);
+				}
+			}
+		};
+	}
+
+	/**
+	 * @brief A coroutine that starts when awaited, and returns its value (or throws its exception) to the awaiter.
+	 */
+	template <typename T>
+	class [[nodiscard]] Task {
+	public:
+		using promise_type = detail::TaskPromise<T>;
+
+		Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+		Task& operator=(Task&& other) noexcept {
+			if (this != &other) {
+				if (handle_) {
+					handle_.destroy();
+				}
+				handle_ = std::exchange(other.handle_, {});
+			}
+			return *this;
+		}
+
+		~Task() {
+			if (handle_) {
+				handle_.destroy();
+			}
+		}
+
+		bool await_ready() const noexcept { return false; }
+
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+			handle_.promise().continuation_ = continuation;
+			return handle_;
+		}
+
+		T await_resume() { return handle_.promise().take(); }
+
+	private:
+		friend promise_type;
+
+		explicit Task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+		std::coroutine_handle<promise_type> handle_;
+	};
+
+	namespace detail {
+		template <typename T>
+		inline Task<T> TaskPromise<T>::get_return_object() noexcept {
+			return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+		}
+
+		inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+			return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+		}
+
+		/**
+		 * @brief A coroutine that nobody awaits, which frees itself when it ends.
+		 */
+		struct Detached {
+			struct promise_type {
+				Detached get_return_object() noexcept {
+					return {std::coroutine_handle<promise_type>::from_promise(*this)};
+				}
+
+				std::suspend_always initial_suspend() const noexcept { return {}; }
+				std::suspend_never final_suspend() const noexcept { return {}; }
+				void return_void() noexcept {}
+				void unhandled_exception() noexcept { std::terminate(); }
+			};
+
+			std::coroutine_handle<promise_type> handle;
+		};
+	}
+
+
+	class AsyncLoop;
+
+	namespace detail {
+		inline thread_local AsyncLoop* current_loop = nullptr;
+	}
+
+	/**
+	 * @brief Runs coroutines on the calling thread, and resumes them there when their operations are done.
+	 */
+	class AsyncLoop {
+	public:
+		AsyncLoop() = default;
+		AsyncLoop(const AsyncLoop&) = delete;
+		AsyncLoop& operator=(const AsyncLoop&) = delete;
+
+		/**
+		 * @brief The loop running on this thread, or nullptr.
+		 */
+		static AsyncLoop* current() noexcept { return detail::current_loop; }
+
+		/**
+		 * @brief Adds a task, started by run. An exception that leaves it terminates the program.
+		 */
+		void spawn(Task<> task) {
+			const detail::Detached detached = launch(*this, std::move(task));
+			std::lock_guard<std::mutex> guard(lock_);
+			tasks_++;
+			queue_.push_back(detached.handle);
+		}
+
+		/**
+		 * @brief Runs the tasks until all of them have finished.
+		 */
+		void run() {
+			AsyncLoop* const previous = std::exchange(detail::current_loop, this);
+
+			std::unique_lock<std::mutex> guard(lock_);
+			for (;;) {
+				cond_.wait(guard, [this] { return !queue_.empty() || tasks_ == 0; });
+				if (queue_.empty()) {
+					break;
+				}
+				const std::coroutine_handle<> handle = queue_.front();
+				queue_.pop_front();
+
+				guard.unlock();
+				handle.resume();
+				guard.lock();
+			}
+
+			detail::current_loop = previous;
+		}
+
+		/**
+		 * @brief Resumes a coroutine on the loop. It can be called from any thread.
+		 */
+		void post(std::coroutine_handle<> handle) {
+			// Notified with the lock held: once it is released, run may end and the loop be destroyed
+			std::lock_guard<std::mutex> guard(lock_);
+			queue_.push_back(handle);
+			cond_.notify_one();
+		}
+
+	private:
+		static detail::Detached launch(AsyncLoop& loop, Task<> task) {
+			co_await task;
+
+			std::lock_guard<std::mutex> guard(loop.lock_);
+			loop.tasks_--;
+		}
+
+		std::mutex lock_;
+		std::condition_variable cond_;
+		std::deque<std::coroutine_handle<>> queue_;
+		size_t tasks_ = 0; // Spawned and not finished
+	};
+
+
+	class AsyncBus;
+
+	namespace detail {
+		/**
+		 * @brief Who to resume when an operation is done.
+		 */
+		struct Continuation {
+			std::coroutine_handle<> handle;
+			AsyncLoop* loop; // nullptr to resume on the worker
+			std::atomic<size_t>* pending; // Of when_all, which resumes after the last one
+
+			void resume() noexcept {
+				if (pending != nullptr && pending->fetch_sub(1, std::memory_order_acq_rel) != 1) {
+					return;
+				}
+				if (loop != nullptr) {
+					loop->post(handle);
+				}
+				else {
+					handle.resume();
+				}
+			}
+		};
+
+		/**
+		 * @brief An operation queued to the worker of a bus.
+		 *
+		 * It lives in the frame of the suspended coroutine, so queueing it
+		 * doesn't allocate anything.
+		 */
+		struct Job {
+			enum class Step {
+				DONE,
+				WAIT, // Run it again at "due"
+				PARK, // Someone else will queue it again
+			};
+
+			explicit Job(Step (*step)(Job*) noexcept) noexcept : step(step) {}
+
+			Step (*step)(Job*) noexcept; // Runs on the worker
+			Job* next = nullptr;
+			std::chrono::steady_clock::time_point due;
+			Continuation* continuation = nullptr;
+		};
+
+		template <typename T>
+		struct Storage {
+			T value{};
+		};
+
+		template <>
+		struct Storage<void> {};
+
+		/**
+		 * @brief Awaitable base of the operations, returning a Result<T>, or a Status if T is void.
+		 */
+		template <typename T>
+		class Operation : public Job {
+		public:
+			bool await_ready() const noexcept { return false; }
+
+			void await_suspend(std::coroutine_handle<> handle) noexcept {
+				own_ = Continuation{handle, AsyncLoop::current(), nullptr};
+				start(&own_);
+			}
+
+			auto await_resume() noexcept {
+				if constexpr (std::is_void_v<T>) {
+					return status_;
+				}
+				else {
+					return Result<T>{status_, std::move(storage_.value)};
+				}
+			}
+
+			/**
+			 * @brief Queues the operation, to resume continuation when it is done.
+			 */
+			void start(Continuation* continuation) noexcept;
+
+		protected:
+			Operation(AsyncBus& bus, Step (*step)(Job*) noexcept) noexcept : Job(step), bus_(&bus) {}
+
+			AsyncBus* bus_;
+			Status status_;
+			Storage<T> storage_;
+
+		private:
+			Continuation own_{};
+		};
+
+		/**
+		 * @brief An operation that calls a function on the worker: Status(T&), or Status() if T is void.
+		 */
+		template <typename T, typename F>
+		class CallOperation : public Operation<T> {
+		public:
+			CallOperation(AsyncBus& bus, F function) noexcept : Operation<T>(bus, &CallOperation::run), function_(std::move(function)) {}
+
+		private:
+			static Job::Step run(Job* job) noexcept {
+				CallOperation* const self = static_cast<CallOperation*>(job);
+				if constexpr (std::is_void_v<T>) {
+					self->status_ = self->function_();
+				}
+				else {
+					self->status_ = self->function_(self->storage_.value);
+				}
+				return Job::Step::DONE;
+			}
+
+			F function_;
+		};
+	}
+
+	/**
+	 * @brief An I2C bus whose transactions run on a worker thread.
+	 *
+	 * The destructor waits for the operations already queued. If the worker
+	 * can't be started, the operations run on the thread that awaits them.
+	 */
+	class AsyncBus {
+	public:
+		explicit AsyncBus(uint8_t bus) : bus_(bus) {
+			if (bus_.is_open()) {
+				try {
+					worker_ = std::thread(&AsyncBus::work, this);
+				}
+				catch (const std::system_error&) {
+				}
+			}
+		}
+
+		AsyncBus(const AsyncBus&) = delete;
+		AsyncBus& operator=(const AsyncBus&) = delete;
+
+		~AsyncBus() {
+			if (worker_.joinable()) {
+				{
+					std::lock_guard<std::mutex> guard(lock_);
+					stop_ = true;
+				}
+				cond_.notify_one();
+				worker_.join();
+			}
+		}
+
+		/**
+		 * @brief The result of opening the bus.
+		 */
+		Status status() const noexcept { return bus_.status(); }
+
+		/**
+		 * @brief The bus, for the device objects used inside run.
+		 */
+		I2cBus& bus() noexcept { return bus_; }
+
+		/**
+		 * @brief Calls a function on the worker.
+		 *
+		 * With T void, the function is Status() and the operation returns
+		 * its Status. Otherwise, it is Status(T&) and the operation returns
+		 * a Result<T>. It is the way to do anything that the async devices
+		 * don't, with the synchronous objects of plc-peripherals.hpp:
+		 *
+		 *     co_await bus.run([&] { return pca.set_prescaler(0x79); });
+		 */
+		template <typename T = void, typename F>
+		detail::CallOperation<T, F> run(F function) noexcept {
+			return detail::CallOperation<T, F>(*this, std::move(function));
+		}
+
+		/**
+		 * @brief Queues a job to the worker. It can be called from any thread.
+		 */
+		void submit(detail::Job* job) noexcept {
+			if (!worker_.joinable()) {
+				run_inline(job);
+				return;
+			}
+
+			job->next = nullptr;
+			std::lock_guard<std::mutex> guard(lock_);
+			if (ready_tail_ != nullptr) {
+				ready_tail_->next = job;
+			}
+			else {
+				ready_ = job;
+			}
+			ready_tail_ = job;
+			cond_.notify_one();
+		}
+
+	private:
+		using Step = detail::Job::Step;
+
+		void work() noexcept {
+			std::unique_lock<std::mutex> guard(lock_);
+			for (;;) {
+				// The jobs whose wait is over go first, they are already late
+				const auto now = std::chrono::steady_clock::now();
+				while (timers_ != nullptr && timers_->due <= now) {
+					detail::Job* const job = timers_;
+					timers_ = job->next;
+					job->next = ready_;
+					ready_ = job;
+					if (ready_tail_ == nullptr) {
+						ready_tail_ = job;
+					}
+				}
+
+				if (ready_ != nullptr) {
+					detail::Job* const job = ready_;
+					ready_ = job->next;
+					if (ready_ == nullptr) {
+						ready_tail_ = nullptr;
+					}
+
+					guard.unlock();
+					const Step step = job->step(job);
+					if (step == Step::DONE) {
+						// The job may be gone after this
+						job->continuation->resume();
+					}
+					guard.lock();
+
+					if (step == Step::WAIT) {
+						add_timer(job);
+					}
+					continue;
+				}
+
+				// A parked job always waits for one in timers_
+				if (stop_ && timers_ == nullptr) {
+					break;
+				}
+
+				if (timers_ != nullptr) {
+					cond_.wait_until(guard, timers_->due);
+				}
+				else {
+					cond_.wait(guard);
+				}
+			}
+		}
+
+		void add_timer(detail::Job* job) noexcept {
+			detail::Job** link = &timers_;
+			while (*link != nullptr && (*link)->due <= job->due) {
+				link = &(*link)->next;
+			}
+			job->next = *link;
+			*link = job;
+		}
+
+		void run_inline(detail::Job* job) noexcept {
+			{
+				// One job at a time, so none of them is parked
+				std::lock_guard<std::mutex> guard(inline_lock_);
+				while (job->step(job) == Step::WAIT) {
+					std::this_thread::sleep_until(job->due);
+				}
+			}
+			job->continuation->resume();
+		}
+
+		I2cBus bus_;
+		std::mutex lock_;
+		std::condition_variable cond_;
+		detail::Job* ready_ = nullptr;
+		detail::Job* ready_tail_ = nullptr;
+		detail::Job* timers_ = nullptr; // Sorted by due
+		bool stop_ = false;
+		std::mutex inline_lock_;
+		std::thread worker_;
+	};
+
+	namespace detail {
+		template <typename T>
+		inline void Operation<T>::start(Continuation* continuation) noexcept {
+			this->continuation = continuation;
+			bus_->submit(this);
+		}
+	}
+
+
+	/**
+	 * @brief Awaits several operations at once, and returns the tuple of their results.
+	 *
+	 * All the operations are queued before waiting, so those of different
+	 * buses run at the same time, and those of the same bus one after
+	 * another, without going back to the coroutine in between.
+	 */
+	template <typename... Operations>
+	class WhenAll {
+	public:
+		template <typename... Args>
+		explicit WhenAll(Args&&... operations) noexcept : operations_(std::forward<Args>(operations)...) {}
+
+		WhenAll(const WhenAll&) = delete;
+		WhenAll& operator=(const WhenAll&) = delete;
+
+		bool await_ready() const noexcept { return false; }
+
+		void await_suspend(std::coroutine_handle<> handle) noexcept {
+			pending_.store(sizeof...(Operations), std::memory_order_relaxed);
+			continuation_ = detail::Continuation{handle, AsyncLoop::current(), &pending_};
+			std::apply([this](Operations&... operations) { (operations.start(&continuation_), ...); }, operations_);
+		}
+
+		auto await_resume() noexcept {
+			return std::apply([](Operations&... operations) { return std::make_tuple(operations.await_resume()...); }, operations_);
+		}
+
+	private:
+		std::tuple<Operations...> operations_;
+		std::atomic<size_t> pending_{0};
+		detail::Continuation continuation_{};
+	};
+
+	template <typename... Operations>
+	inline WhenAll<std::decay_t<Operations>...> when_all(Operations&&... operations) noexcept {
+		return WhenAll<std::decay_t<Operations>...>(std::forward<Operations>(operations)...);
+	}
+
+
+	/**
+	 * @brief Async MCP23008 or MCP23017, over the objects of plc-peripherals.hpp and their cache.
+	 */
+	template <typename Device, typename Mask>
+	class AsyncExpander {
+	public:
+		AsyncExpander(AsyncBus& bus, uint8_t addr) noexcept : bus_(&bus), device_(bus.bus(), addr) {}
+
+		uint8_t address() const noexcept { return device_.address(); }
+
+		auto init() noexcept { return bus_->run([this] { return device_.init(); }); }
+		auto deinit() noexcept { return bus_->run([this] { return device_.deinit(); }); }
+
+		auto pin_mode(uint8_t index, uint8_t mode) noexcept {
+			return bus_->run([this, index, mode] { return device_.pin_mode(index, mode); });
+		}
+
+		auto pin_mode_all(Mask modes) noexcept {
+			return bus_->run([this, modes] { return device_.pin_mode_all(modes); });
+		}
+
+		auto write(uint8_t index, bool value) noexcept {
+			return bus_->run([this, index, value] { return device_.write(index, value); });
+		}
+
+		auto write_all(Mask values) noexcept {
+			return bus_->run([this, values] { return device_.write_all(values); });
+		}
+
+		auto write_masked(Mask mask, Mask values) noexcept {
+			return bus_->run([this, mask, values] { return device_.write_masked(mask, values); });
+		}
+
+		auto read(uint8_t index) noexcept {
+			return bus_->template run<bool>([this, index](bool& value) { return device_.read(index, value); });
+		}
+
+		auto read_all() noexcept {
+			return bus_->template run<Mask>([this](Mask& values) { return device_.read_all(values); });
+		}
+
+	private:
+		AsyncBus* bus_;
+		Device device_; // Only used on the worker
+	};
+
+	using AsyncMcp23008 = AsyncExpander<Mcp23008, uint8_t>;
+	using AsyncMcp23017 = AsyncExpander<Mcp23017, uint16_t>;
+
+
+	/**
+	 * @brief Async PCA9685, over plc::Pca9685 and its cache.
+	 */
+	class AsyncPca9685 {
+	public:
+		AsyncPca9685(AsyncBus& bus, uint8_t addr) noexcept : bus_(&bus), device_(bus.bus(), addr) {}
+
+		uint8_t address() const noexcept { return device_.address(); }
+
+		auto init() noexcept { return bus_->run([this] { return device_.init(); }); }
+		auto deinit() noexcept { return bus_->run([this] { return device_.deinit(); }); }
+
+		auto pwm_write(uint8_t index, uint16_t value) noexcept {
+			return bus_->run([this, index, value] { return device_.pwm_write(index, value); });
+		}
+
+		auto write(uint8_t index, bool value) noexcept {
+			return bus_->run([this, index, value] { return device_.write(index, value); });
+		}
+
+		auto write_all(uint16_t values) noexcept {
+			return bus_->run([this, values] { return device_.write_all(values); });
+		}
+
+	private:
+		AsyncBus* bus_;
+		Pca9685 device_; // Only used on the worker
+	};
+
+
+	/**
+	 * @brief Async ADS1015, which leaves the bus to the other operations while it converts.
+	 */
+	class AsyncAds1015 {
+		template <typename T>
+		class ReadOperation;
+
+	public:
+		AsyncAds1015(AsyncBus& bus, uint8_t addr) noexcept : bus_(&bus), device_(bus.bus(), addr) {}
+
+		uint8_t address() const noexcept { return device_.address(); }
+
+		auto init() noexcept { return bus_->run([this] { return device_.init(); }); }
+		auto deinit() noexcept { return bus_->run([this] { return device_.deinit(); }); }
+
+		ReadOperation<int16_t> read(uint8_t index) noexcept { return ReadOperation<int16_t>(*this, index); }
+		ReadOperation<uint16_t> unsigned_read(uint8_t index) noexcept { return ReadOperation<uint16_t>(*this, index); }
+
+	private:
+		using Job = detail::Job;
+
+		template <typename T>
+		class ReadOperation : public detail::Operation<T> {
+		public:
+			ReadOperation(AsyncAds1015& ads, uint8_t index) noexcept : detail::Operation<T>(*ads.bus_, &ReadOperation::run), ads_(&ads), index_(index) {}
+
+		private:
+			static Job::Step run(Job* job) noexcept {
+				ReadOperation* const self = static_cast<ReadOperation*>(job);
+				return self->converting_ ? self->finish() : self->start_conversion();
+			}
+
+			Job::Step start_conversion() noexcept {
+				if (ads_->converting_ != nullptr) {
+					ads_->park(this);
+					return Job::Step::PARK;
+				}
+
+				i2c_interface_t* const i2c = ads_->bus_->bus().get();
+				this->status_ = detail::status_of(ads1015_start_conversion(i2c, ads_->address(), index_));
+				if (!this->status_) {
+					return Job::Step::DONE;
+				}
+
+				ads_->converting_ = this;
+				converting_ = true;
+				this->due = std::chrono::steady_clock::now() + std::chrono::microseconds(ADS1015_CONVERSION_US);
+				return Job::Step::WAIT;
+			}
+
+			Job::Step finish() noexcept {
+				i2c_interface_t* const i2c = ads_->bus_->bus().get();
+				if constexpr (std::is_signed_v<T>) {
+					this->status_ = detail::status_of(ads1015_read_conversion(i2c, ads_->address(), &this->storage_.value));
+				}
+				else {
+					this->status_ = detail::status_of(ads1015_unsigned_read_conversion(i2c, ads_->address(), &this->storage_.value));
+				}
+
+				ads_->converting_ = nullptr;
+				if (Job* const next = ads_->unpark()) {
+					ads_->bus_->submit(next);
+				}
+				return Job::Step::DONE;
+			}
+
+			AsyncAds1015* ads_;
+			uint8_t index_;
+			bool converting_ = false;
+		};
+
+		// Only used on the worker
+		void park(Job* job) noexcept {
+			job->next = nullptr;
+			if (parked_tail_ != nullptr) {
+				parked_tail_->next = job;
+			}
+			else {
+				parked_ = job;
+			}
+			parked_tail_ = job;
+		}
+
+		Job* unpark() noexcept {
+			Job* const job = parked_;
+			if (job != nullptr) {
+				parked_ = job->next;
+				if (parked_ == nullptr) {
+					parked_tail_ = nullptr;
+				}
+			}
+			return job;
+		}
+
+		AsyncBus* bus_;
+		Ads1015 device_; // Only used on the worker
+		Job* converting_ = nullptr;
+		Job* parked_ = nullptr; // Waiting for the conversion of another one
+		Job* parked_tail_ = nullptr;
+	};
+
+
+	/**
+	 * @brief Async LTC2309. Its conversions take a few microseconds, so they hold the bus.
+	 */
+	class AsyncLtc2309 {
+	public:
+		AsyncLtc2309(AsyncBus& bus, uint8_t addr) noexcept : bus_(&bus), device_(bus.bus(), addr) {}
+
+		uint8_t address() const noexcept { return device_.address(); }
+
+		auto init() noexcept { return bus_->run([this] { return device_.init(); }); }
+		auto deinit() noexcept { return bus_->run([this] { return device_.deinit(); }); }
+
+		auto read(uint8_t index) noexcept {
+			return bus_->run<uint16_t>([this, index](uint16_t& value) { return device_.read(index, value); });
+		}
+
+	private:
+		AsyncBus* bus_;
+		Ltc2309 device_; // Only used on the worker
+	};
+
+}
+
+#endif // __PLC_ASYNC_HPP__
@@ -29,6 +29,11 @@
 #include "peripheral-ltc2309.h"
 #include "peripheral-mcp23008.h"
 #include "peripheral-pca9685.h"
+#include "gpio-chardev.h"
+#include "pwm-sysfs.h"
+#include "iio-buffer.h"
+#include "pulse-counter.h"
+#include "plc-stats.h"
 
 #include "expanded-gpio.h"
 
@@ -0,0 +1,833 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PLC_PERIPHERALS_HPP__
+#define __PLC_PERIPHERALS_HPP__
+
+/*
+ * Header-only C++ layer over the drivers (C++11 or later).
+ *
+ * plc::I2cBus owns an I2C interface and closes it when destroyed, and the
+ * device classes (plc::Mcp23008, plc::Mcp23017, plc::Pca9685, plc::Ads1015
+ * and plc::Ltc2309) call the C functions of their driver on it. Every call
+ * returns a plc::Status with the errno of the failure, so nothing has to be
+ * read from errno afterwards, and nothing throws.
+ *
+ * The expanders and the PCA9685 keep a copy of the registers they write
+ * (the direction and the outputs, the duty cycles), so a single pin is
+ * written without reading the port first, and a write that wouldn't change
+ * anything isn't sent at all. The copy assumes that the object is the only
+ * writer of the device: if something else writes it (expanded-gpio, another
+ * process), load_state() reads it again. The bus must outlive its devices.
+ */
+
+#include "i2c-interface.h"
+#include "peripheral-ads1015.h"
+#include "peripheral-ltc2309.h"
+#include "peripheral-mcp23008.h"
+#include "peripheral-mcp23017.h"
+#include "peripheral-pca9685.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace plc {
+
+	/**
+	 * @brief Result of an operation: 0 on success, or the errno of the failure.
+	 */
+	class Status {
+	public:
+		constexpr Status() noexcept : error_(0) {}
+		constexpr explicit Status(int error) noexcept : error_(error) {}
+
+		constexpr bool ok() const noexcept { return error_ == 0; }
+		constexpr explicit operator bool() const noexcept { return ok(); }
+		constexpr int error() const noexcept { return error_; }
+		const char* message() const noexcept { return std::strerror(error_); }
+
+	private:
+		int error_;
+	};
+
+	namespace detail {
+		/**
+		 * @brief Converts the return value of a driver function to a Status.
+		 *
+		 * The drivers return 0 on success, and something else with errno set on failure.
+		 */
+		inline Status status_of(int ret) noexcept {
+			return ret == 0 ? Status() : Status(errno != 0 ? errno : EIO);
+		}
+
+		/**
+		 * @brief Same as status_of, for the init and deinit functions, which return 1
+		 * (and EALREADY) when there is nothing to do.
+		 */
+		inline Status status_of_init(int ret) noexcept {
+			return ret == 1 ? Status() : status_of(ret);
+		}
+	}
+
+	/**
+	 * @brief View of a contiguous sequence of elements, like std::span in C++20.
+	 *
+	 * It can be made from a pointer and a size, an array, or any container with
+	 * data() and size() (std::array, std::vector).
+	 */
+	template <typename T>
+	class Span {
+	public:
+		using value_type = typename std::remove_const<T>::type;
+
+		constexpr Span() noexcept : data_(nullptr), size_(0) {}
+		constexpr Span(T* data, size_t size) noexcept : data_(data), size_(size) {}
+
+		template <size_t N>
+		constexpr Span(T (&array)[N]) noexcept : data_(array), size_(N) {}
+
+		template <typename Container, typename = decltype(std::declval<Container&>().data())>
+		constexpr Span(Container& container) noexcept : data_(container.data()), size_(container.size()) {}
+
+		constexpr T* data() const noexcept { return data_; }
+		constexpr size_t size() const noexcept { return size_; }
+		constexpr bool empty() const noexcept { return size_ == 0; }
+		constexpr T& operator[](size_t i) const noexcept { return data_[i]; }
+		constexpr T* begin() const noexcept { return data_; }
+		constexpr T* end() const noexcept { return data_ + size_; }
+
+	private:
+		T* data_;
+		size_t size_;
+	};
+
+	/**
+	 * @brief A pin of an expander and the value to write to it.
+	 */
+	struct PinValue {
+		uint8_t index;
+		bool value;
+	};
+
+	/**
+	 * @brief An output of the PCA9685 and its duty cycle (0-4095).
+	 */
+	struct ChannelValue {
+		uint8_t index;
+		uint16_t value;
+	};
+
+
+	/**
+	 * @brief Owner of an I2C interface, closed when it is destroyed. It can be moved, not copied.
+	 */
+	class I2cBus {
+	public:
+		/**
+		 * @brief Opens an I2C bus. If it fails, is_open() is false and status() tells why.
+		 */
+		explicit I2cBus(uint8_t bus) noexcept : i2c_(i2c_init(bus)), error_(i2c_ != nullptr ? 0 : (errno != 0 ? errno : EIO)) {}
+
+		~I2cBus() { close(); }
+
+		I2cBus(const I2cBus&) = delete;
+		I2cBus& operator=(const I2cBus&) = delete;
+
+		I2cBus(I2cBus&& other) noexcept : i2c_(other.i2c_), error_(other.error_) {
+			other.i2c_ = nullptr;
+		}
+
+		I2cBus& operator=(I2cBus&& other) noexcept {
+			if (this != &other) {
+				close();
+				i2c_ = other.i2c_;
+				error_ = other.error_;
+				other.i2c_ = nullptr;
+			}
+			return *this;
+		}
+
+		bool is_open() const noexcept { return i2c_ != nullptr; }
+		explicit operator bool() const noexcept { return is_open(); }
+
+		/**
+		 * @brief The result of opening the bus.
+		 */
+		Status status() const noexcept { return Status(error_); }
+
+		/**
+		 * @brief The interface, to call the C functions directly.
+		 */
+		i2c_interface_t* get() const noexcept { return i2c_; }
+
+		/**
+		 * @brief Closes the bus before the destructor. Closing it twice does nothing.
+		 */
+		Status close() noexcept {
+			if (i2c_ == nullptr) {
+				return Status();
+			}
+			return detail::status_of(i2c_deinit(&i2c_));
+		}
+
+		Status write(uint8_t addr, Span<const uint8_t> data) noexcept {
+			const i2c_write_t to_write = {data.data(), data.size()};
+			return detail::status_of(i2c_write(i2c_, addr, &to_write));
+		}
+
+		Status read(uint8_t addr, Span<uint8_t> data) noexcept {
+			const i2c_read_t to_read = {data.data(), data.size()};
+			return detail::status_of(i2c_read(i2c_, addr, &to_read));
+		}
+
+		Status write_then_read(uint8_t addr, Span<const uint8_t> order, Span<uint8_t> data) noexcept {
+			const i2c_write_t read_order = {order.data(), order.size()};
+			const i2c_read_t to_read = {data.data(), data.size()};
+			return detail::status_of(i2c_write_then_read(i2c_, addr, &read_order, &to_read));
+		}
+
+	private:
+		i2c_interface_t* i2c_;
+		int error_;
+	};
+
+
+	/**
+	 * @brief MCP23008 expander. Bit "i" of the masks is the pin "i".
+	 */
+	class Mcp23008 {
+	public:
+		Mcp23008(const I2cBus& bus, uint8_t addr) noexcept : i2c_(bus.get()), addr_(addr), modes_(0xFF), outputs_(0x00) {}
+
+		uint8_t address() const noexcept { return addr_; }
+
+		/**
+		 * @brief Initializes the device. If it was already initialized, the cache is read from it.
+		 */
+		Status init() noexcept {
+			const int ret = mcp23008_init(i2c_, addr_);
+			if (ret == 1) {
+				return load_state();
+			}
+			if (ret == 0) {
+				modes_ = 0xFF;
+				outputs_ = 0x00;
+			}
+			return detail::status_of(ret);
+		}
+
+		Status deinit() noexcept {
+			const int ret = mcp23008_deinit(i2c_, addr_);
+			if (ret == 0) {
+				modes_ = 0xFF;
+				outputs_ = 0x00;
+			}
+			return detail::status_of_init(ret);
+		}
+
+		/**
+		 * @brief Reads the direction and the outputs from the device into the cache.
+		 */
+		Status load_state() noexcept {
+			uint8_t state[MCP23008_STATE_SIZE];
+			const int ret = mcp23008_read_state(i2c_, addr_, state);
+			if (ret == 0) {
+				modes_ = state[0]; // IODIR
+				outputs_ = state[7]; // OLAT
+			}
+			return detail::status_of(ret);
+		}
+
+		/**
+		 * @brief Sets the mode of a pin (MCP23008_INPUT or MCP23008_OUTPUT).
+		 */
+		Status pin_mode(uint8_t index, uint8_t mode) noexcept {
+			if (index >= MCP23008_NUM_IO || mode > MCP23008_INPUT) {
+				return Status(EINVAL);
+			}
+			const uint8_t bit = 1 << index;
+			return pin_mode_all(mode == MCP23008_INPUT ? modes_ | bit : modes_ & ~bit);
+		}
+
+		/**
+		 * @brief Sets the mode of all the pins, 1 for input and 0 for output.
+		 */
+		Status pin_mode_all(uint8_t modes) noexcept {
+			if (modes == modes_) {
+				return Status();
+			}
+			const int ret = mcp23008_set_pin_mode_all(i2c_, addr_, modes);
+			if (ret == 0) {
+				modes_ = modes;
+			}
+			return detail::status_of(ret);
+		}
+
+		/**
+		 * @brief Sets the mode of the pins of a mask, leaving the others as they are.
+		 */
+		Status pin_mode_masked(uint8_t mask, uint8_t modes) noexcept {
+			return pin_mode_all((modes_ & ~mask) | (modes & mask));
+		}
+
+		/**
+		 * @brief Writes a pin with a single transaction, or none if it already has the value.
+		 */
+		Status write(uint8_t index, bool value) noexcept {
+			if (index >= MCP23008_NUM_IO) {
+				return Status(EINVAL);
+			}
+			const uint8_t bit = 1 << index;
+			return write_all(value ? outputs_ | bit : outputs_ & ~bit);
+		}
+
+		/**
+		 * @brief Writes several pins with a single transaction.
+		 */
+		Status write(Span<const PinValue> pins) noexcept {
+			uint8_t outputs = outputs_;
+			for (const PinValue& pin : pins) {
+				if (pin.index >= MCP23008_NUM_IO) {
+					return Status(EINVAL);
+				}
+				const uint8_t bit = 1 << pin.index;
+				outputs = pin.value ? outputs | bit : outputs & ~bit;
+			}
+			return write_all(outputs);
+		}
+
+		Status write_all(uint8_t values) noexcept {
+			if (values == outputs_) {
+				return Status();
+			}
+			const int ret = mcp23008_write_all(i2c_, addr_, values);
+			if (ret == 0) {
+				outputs_ = values;
+			}
+			return detail::status_of(ret);
+		}
+
+		/**
+		 * @brief Writes the pins of a mask, leaving the others as they are.
+		 */
+		Status write_masked(uint8_t mask, uint8_t values) noexcept {
+			return write_all((outputs_ & ~mask) | (values & mask));
+		}
+
+		Status read(uint8_t index, bool& value) noexcept {
+			if (index >= MCP23008_NUM_IO) {
+				return Status(EINVAL);
+			}
+			uint8_t values;
+			const Status status = read_all(values);
+			value = (values >> index) & 1;
+			return status;
+		}
+
+		/**
+		 * @brief Reads several pins with a single transaction. indexes and values must have the same size.
+		 */
+		Status read(Span<const uint8_t> indexes, Span<bool> values) noexcept {
+			if (indexes.size() != values.size()) {
+				return Status(EINVAL);
+			}
+			for (uint8_t index : indexes) {
+				if (index >= MCP23008_NUM_IO) {
+					return Status(EINVAL);
+				}
+			}
+			uint8_t all;
+			const Status status = read_all(all);
+			for (size_t i = 0; status && i < indexes.size(); i++) {
+				values[i] = (all >> indexes[i]) & 1;
+			}
+			return status;
+		}
+
+		Status read_all(uint8_t& values) noexcept {
+			values = 0;
+			return detail::status_of(mcp23008_read_all(i2c_, addr_, &values));
+		}
+
+		/**
+		 * @brief The cached modes, 1 for input.
+		 */
+		uint8_t modes() const noexcept { return modes_; }
+
+		/**
+		 * @brief The cached output latches.
+		 */
+		uint8_t outputs() const noexcept { return outputs_; }
+
+	private:
+		i2c_interface_t* i2c_;
+		uint8_t addr_;
+		uint8_t modes_;
+		uint8_t outputs_;
+	};
+
+
+	/**
+	 * @brief MCP23017 expander. Bit "i" of the masks is the pin "i": port A is the low byte.
+	 */
+	class Mcp23017 {
+	public:
+		Mcp23017(const I2cBus& bus, uint8_t addr) noexcept : i2c_(bus.get()), addr_(addr), modes_(0xFFFF), outputs_(0x0000) {}
+
+		uint8_t address() const noexcept { return addr_; }
+
+		/**
+		 * @brief Initializes the device. If it was already initialized, the cache is read from it.
+		 */
+		Status init() noexcept {
+			const int ret = mcp23017_init(i2c_, addr_);
+			if (ret == 1) {
+				return load_state();
+			}
+			if (ret == 0) {
+				modes_ = 0xFFFF;
+				outputs_ = 0x0000;
+			}
+			return detail::status_of(ret);
+		}
+
+		Status deinit() noexcept {
+			const int ret = mcp23017_deinit(i2c_, addr_);
+			if (ret == 0) {
+				modes_ = 0xFFFF;
+				outputs_ = 0x0000;
+			}
+			return detail::status_of_init(ret);
+		}
+
+		/**
+		 * @brief Reads the direction and the outputs from the device into the cache.
+		 */
+		Status load_state() noexcept {
+			uint8_t state[MCP23017_STATE_SIZE];
+			const int ret = mcp23017_read_state(i2c_, addr_, state);
+			if (ret == 0) {
+				modes_ = state[0] | state[1] << 8; // IODIR A and B
+				outputs_ = state[14] | state[15] << 8; // OLAT A and B
+			}
+			return detail::status_of(ret);
+		}
+
+		/**
+		 * @brief Sets the mode of a pin (MCP23017_INPUT or MCP23017_OUTPUT).
+		 */
+		Status pin_mode(uint8_t index, uint8_t mode) noexcept {
+			if (index >= MCP23017_NUM_IO || mode > MCP23017_INPUT) {
+				return Status(EINVAL);
+			}
+			const uint16_t bit = 1 << index;
+			return pin_mode_all(mode == MCP23017_INPUT ? modes_ | bit : modes_ & ~bit);
+		}
+
+		/**
+		 * @brief Sets the mode of all the pins, 1 for input and 0 for output.
+		 */
+		Status pin_mode_all(uint16_t modes) noexcept {
+			if (modes == modes_) {
+				return Status();
+			}
+			// mcp23017_set_pin_mode_all takes port A in the high byte
+			const int ret = mcp23017_set_pin_mode_all(i2c_, addr_, (modes << 8 | modes >> 8) & 0xFFFF);
+			if (ret == 0) {
+				modes_ = modes;
+			}
+			return detail::status_of(ret);
+		}
+
+		/**
+		 * @brief Sets the mode of the pins of a mask, leaving the others as they are.
+		 */
+		Status pin_mode_masked(uint16_t mask, uint16_t modes) noexcept {
+			return pin_mode_all((modes_ & ~mask) | (modes & mask));
+		}
+
+		/**
+		 * @brief Writes a pin with the transactions of write_all, or none if it already has the value.
+		 */
+		Status write(uint8_t index, bool value) noexcept {
+			if (index >= MCP23017_NUM_IO) {
+				return Status(EINVAL);
+			}
+			const uint16_t bit = 1 << index;
+			return write_all(value ? outputs_ | bit : outputs_ & ~bit);
+		}
+
+		/**
+		 * @brief Writes several pins, with the transactions of write_all if any of them changes.
+		 */
+		Status write(Span<const PinValue> pins) noexcept {
+			uint16_t outputs = outputs_;
+			for (const PinValue& pin : pins) {
+				if (pin.index >= MCP23017_NUM_IO) {
+					return Status(EINVAL);
+				}
+				const uint16_t bit = 1 << pin.index;
+				outputs = pin.value ? outputs | bit : outputs & ~bit;
+			}
+			return write_all(outputs);
+		}
+
+		/**
+		 * @brief Writes all the pins, with a transaction for each port, or none if nothing changes.
+		 */
+		Status write_all(uint16_t values) noexcept {
+			if (values == outputs_) {
+				return Status();
+			}
+			const int ret = mcp23017_write_all(i2c_, addr_, values);
+			if (ret == 0) {
+				outputs_ = values;
+			}
+			return detail::status_of(ret);
+		}
+
+		/**
+		 * @brief Writes the pins of a mask, leaving the others as they are.
+		 */
+		Status write_masked(uint16_t mask, uint16_t values) noexcept {
+			return write_all((outputs_ & ~mask) | (values & mask));
+		}
+
+		Status read(uint8_t index, bool& value) noexcept {
+			if (index >= MCP23017_NUM_IO) {
+				return Status(EINVAL);
+			}
+			uint16_t values;
+			const Status status = read_all(values);
+			value = (values >> index) & 1;
+			return status;
+		}
+
+		/**
+		 * @brief Reads several pins with the transactions of read_all. indexes and values must have the same size.
+		 */
+		Status read(Span<const uint8_t> indexes, Span<bool> values) noexcept {
+			if (indexes.size() != values.size()) {
+				return Status(EINVAL);
+			}
+			for (uint8_t index : indexes) {
+				if (index >= MCP23017_NUM_IO) {
+					return Status(EINVAL);
+				}
+			}
+			uint16_t all;
+			const Status status = read_all(all);
+			for (size_t i = 0; status && i < indexes.size(); i++) {
+				values[i] = (all >> indexes[i]) & 1;
+			}
+			return status;
+		}
+
+		Status read_all(uint16_t& values) noexcept {
+			// mcp23017_read_all stores port A in the first byte of the value
+			uint8_t ports[2] = {0, 0};
+			uint16_t raw;
+			const int ret = mcp23017_read_all(i2c_, addr_, &raw);
+			if (ret == 0) {
+				std::memcpy(ports, &raw, sizeof(ports));
+			}
+			values = ports[0] | ports[1] << 8;
+			return detail::status_of(ret);
+		}
+
+		/**
+		 * @brief The cached modes, 1 for input.
+		 */
+		uint16_t modes() const noexcept { return modes_; }
+
+		/**
+		 * @brief The cached output latches.
+		 */
+		uint16_t outputs() const noexcept { return outputs_; }
+
+	private:
+		i2c_interface_t* i2c_;
+		uint8_t addr_;
+		uint16_t modes_;
+		uint16_t outputs_;
+	};
+
+
+	/**
+	 * @brief PCA9685 PWM controller.
+	 *
+	 * The cache knows the duty cycle of an output once it has been written
+	 * with pwm_write (or reset by init); the digital writes make it unknown.
+	 */
+	class Pca9685 {
+	public:
+		Pca9685(const I2cBus& bus, uint8_t addr) noexcept : i2c_(bus.get()), addr_(addr), prescaler_(0), known_(0), duty_() {}
+
+		uint8_t address() const noexcept { return addr_; }
+
+		/**
+		 * @brief Initializes the device. If it was already initialized, the duty cycles are unknown.
+		 */
+		Status init() noexcept {
+			const int ret = pca9685_init(i2c_, addr_);
+			if (ret == 1) {
+				forget();
+				return Status();
+			}
+			if (ret == 0) {
+				// The reset turns all the outputs off
+				std::memset(duty_, 0, sizeof(duty_));
+				known_ = 0xFFFF;
+				prescaler_ = 0;
+			}
+			return detail::status_of(ret);
+		}
+
+		Status deinit() noexcept {
+			forget();
+			return detail::status_of_init(pca9685_deinit(i2c_, addr_));
+		}
+
+		/**
+		 * @brief Makes all the cached values unknown, if something else has written the device.
+		 */
+		void forget() noexcept {
+			known_ = 0;
+			prescaler_ = 0;
+		}
+
+		/**
+		 * @brief Sets the prescaler of the PWM frequency (3-255), unless it is the current one.
+		 */
+		Status set_prescaler(uint8_t prescaler) noexcept {
+			if (prescaler == prescaler_) {
+				return Status();
+			}
+			const int ret = pca9685_pwm_frequency(i2c_, addr_, prescaler);
+			prescaler_ = ret == 0 ? prescaler : 0;
+			return detail::status_of(ret);
+		}
+
+		/**
+		 * @brief Writes the duty cycle of an output (0-4095), unless it already has it.
+		 */
+		Status pwm_write(uint8_t index, uint16_t value) noexcept {
+			if (index >= PCA9685_NUM_OUTPUTS) {
+				return Status(EINVAL);
+			}
+			if (is_known(index) && duty_[index] == value) {
+				return Status();
+			}
+			const int ret = pca9685_pwm_write(i2c_, addr_, index, value);
+			set_known(index, ret == 0, value);
+			return detail::status_of(ret);
+		}
+
+		/**
+		 * @brief Writes the duty cycles of several outputs.
+		 *
+		 * The ones that change are written one by one, or all the outputs with a
+		 * single transaction if more than one changes and all of them are known.
+		 */
+		Status pwm_write(Span<const ChannelValue> channels) noexcept {
+			uint16_t duty[PCA9685_NUM_OUTPUTS];
+			std::memcpy(duty, duty_, sizeof(duty));
+			uint16_t changed = 0;
+			for (const ChannelValue& channel : channels) {
+				if (channel.index >= PCA9685_NUM_OUTPUTS) {
+					return Status(EINVAL);
+				}
+				if (!is_known(channel.index) || duty_[channel.index] != channel.value) {
+					changed |= 1 << channel.index;
+				}
+				duty[channel.index] = channel.value;
+			}
+
+			if (known_ == 0xFFFF && (changed & (changed - 1)) != 0) {
+				return pwm_write_all(duty);
+			}
+			for (uint8_t i = 0; i < PCA9685_NUM_OUTPUTS; i++) {
+				if (changed & (1 << i)) {
+					const int ret = pca9685_pwm_write(i2c_, addr_, i, duty[i]);
+					set_known(i, ret == 0, duty[i]);
+					if (ret != 0) {
+						return detail::status_of(ret);
+					}
+				}
+			}
+			return Status();
+		}
+
+		/**
+		 * @brief Writes the duty cycles of all the outputs with a single transaction.
+		 */
+		Status pwm_write_all(const uint16_t (&values)[PCA9685_NUM_OUTPUTS]) noexcept {
+			const int ret = pca9685_pwm_write_all(i2c_, addr_, values);
+			if (ret == 0) {
+				std::memcpy(duty_, values, sizeof(duty_));
+				known_ = 0xFFFF;
+			}
+			else {
+				known_ = 0;
+			}
+			return detail::status_of(ret);
+		}
+
+		/**
+		 * @brief Turns an output fully on or off.
+		 */
+		Status write(uint8_t index, bool value) noexcept {
+			if (index >= PCA9685_NUM_OUTPUTS) {
+				return Status(EINVAL);
+			}
+			set_known(index, false, 0);
+			return detail::status_of(pca9685_write(i2c_, addr_, index, value));
+		}
+
+		/**
+		 * @brief Turns all the outputs fully on or off, bit "i" being the output "i".
+		 */
+		Status write_all(uint16_t values) noexcept {
+			known_ = 0;
+			return detail::status_of(pca9685_write_all(i2c_, addr_, values));
+		}
+
+		/**
+		 * @brief The cached duty cycle of an output, if it is known.
+		 */
+		bool duty(uint8_t index, uint16_t& value) const noexcept {
+			if (index >= PCA9685_NUM_OUTPUTS || !is_known(index)) {
+				return false;
+			}
+			value = duty_[index];
+			return true;
+		}
+
+	private:
+		bool is_known(uint8_t index) const noexcept { return (known_ >> index) & 1; }
+
+		void set_known(uint8_t index, bool known, uint16_t value) noexcept {
+			duty_[index] = value;
+			known_ = known ? known_ | (1 << index) : known_ & ~(1 << index);
+		}
+
+		i2c_interface_t* i2c_;
+		uint8_t addr_;
+		uint8_t prescaler_; // 0 if unknown
+		uint16_t known_; // Bit "i" set if duty_[i] is the one of the device
+		uint16_t duty_[PCA9685_NUM_OUTPUTS];
+	};
+
+
+	/**
+	 * @brief ADS1015 ADC. Each read starts a conversion and waits for it.
+	 */
+	class Ads1015 {
+	public:
+		Ads1015(const I2cBus& bus, uint8_t addr) noexcept : i2c_(bus.get()), addr_(addr) {}
+
+		uint8_t address() const noexcept { return addr_; }
+
+		Status init() noexcept {
+			return detail::status_of(ads1015_init(i2c_, addr_));
+		}
+
+		Status deinit() noexcept {
+			return detail::status_of(ads1015_deinit(i2c_, addr_));
+		}
+
+		Status read(uint8_t index, int16_t& value) noexcept {
+			return detail::status_of(ads1015_read(i2c_, addr_, index, &value));
+		}
+
+		Status unsigned_read(uint8_t index, uint16_t& value) noexcept {
+			return detail::status_of(ads1015_unsigned_read(i2c_, addr_, index, &value));
+		}
+
+		/**
+		 * @brief Reads several channels, in order. channels and values must have the same size.
+		 */
+		Status read(Span<const uint8_t> channels, Span<int16_t> values) noexcept {
+			if (channels.size() != values.size()) {
+				return Status(EINVAL);
+			}
+			for (size_t i = 0; i < channels.size(); i++) {
+				const Status status = read(channels[i], values[i]);
+				if (!status) {
+					return status;
+				}
+			}
+			return Status();
+		}
+
+	private:
+		i2c_interface_t* i2c_;
+		uint8_t addr_;
+	};
+
+
+	/**
+	 * @brief LTC2309 ADC.
+	 */
+	class Ltc2309 {
+	public:
+		Ltc2309(const I2cBus& bus, uint8_t addr) noexcept : i2c_(bus.get()), addr_(addr) {}
+
+		uint8_t address() const noexcept { return addr_; }
+
+		Status init() noexcept {
+			return detail::status_of(ltc2309_init(i2c_, addr_));
+		}
+
+		Status deinit() noexcept {
+			return detail::status_of(ltc2309_deinit(i2c_, addr_));
+		}
+
+		Status read(uint8_t index, uint16_t& value) noexcept {
+			return detail::status_of(ltc2309_read(i2c_, addr_, index, &value));
+		}
+
+		/**
+		 * @brief Reads several channels, in order. channels and values must have the same size.
+		 */
+		Status read(Span<const uint8_t> channels, Span<uint16_t> values) noexcept {
+			if (channels.size() != values.size()) {
+				return Status(EINVAL);
+			}
+			for (size_t i = 0; i < channels.size(); i++) {
+				const Status status = read(channels[i], values[i]);
+				if (!status) {
+					return status;
+				}
+			}
+			return Status();
+		}
+
+	private:
+		i2c_interface_t* i2c_;
+		uint8_t addr_;
+	};
+
+}
+
+#endif // __PLC_PERIPHERALS_HPP__
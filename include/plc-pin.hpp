@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PLC_PIN_HPP__
+#define __PLC_PIN_HPP__
+
+/*
+ * Compile-time pins for C++ (C++11 or later), over the device classes of
+ * plc-peripherals.hpp.
+ *
+ * The device type, the address and the index of a plc::Pin are template
+ * arguments, and the pin is bound to the object of its device:
+ *
+ *     plc::Mcp23017 q0(bus, 0x21);
+ *     const plc::Pin<PLC_MCP23017, 0x21, 5> q0_5(q0);
+ *     plc::digitalWrite(q0_5, true);
+ *
+ * digitalWrite is resolved when compiling to the write of that device with a
+ * constant mask, without decoding a packed pin nor a switch on its type as in
+ * expanded-gpio. An index out of the device, or an operation that the device
+ * can't do (digitalWrite on an ADC), doesn't compile.
+ *
+ * plc::PinGroup writes or reads several pins of the same device with a single
+ * transaction (one for each port of a MCP23017), their mask and
+ * the bits of the values being folded when compiling.
+ *
+ * The pins don't go through expanded-gpio: there are no bus locks, no lazy
+ * initialization and no debounce. The devices must be initialized, and used
+ * by one thread at a time.
+ */
+
+#include "expanded-gpio.h"
+#include "plc-peripherals.hpp"
+
+#include <cassert>
+#include <type_traits>
+
+namespace plc {
+
+	namespace detail {
+		/**
+		 * @brief Class and number of pins of every type of device.
+		 */
+		template <peripheral_type_t Type>
+		struct PinTraits;
+
+		template <>
+		struct PinTraits<PLC_MCP23008> {
+			using device_type = Mcp23008;
+			using mask_type = uint8_t;
+			static constexpr uint8_t num_pins = MCP23008_NUM_IO;
+		};
+
+		template <>
+		struct PinTraits<PLC_MCP23017> {
+			using device_type = Mcp23017;
+			using mask_type = uint16_t;
+			static constexpr uint8_t num_pins = MCP23017_NUM_IO;
+		};
+
+		template <>
+		struct PinTraits<PLC_PCA9685> {
+			using device_type = Pca9685;
+			using mask_type = uint16_t;
+			static constexpr uint8_t num_pins = PCA9685_NUM_OUTPUTS;
+		};
+
+		template <>
+		struct PinTraits<PLC_ADS1015> {
+			using device_type = Ads1015;
+			using mask_type = uint8_t;
+			static constexpr uint8_t num_pins = ADS1015_NUM_INPUTS;
+		};
+
+		template <>
+		struct PinTraits<PLC_LTC2309> {
+			using device_type = Ltc2309;
+			using mask_type = uint8_t;
+			static constexpr uint8_t num_pins = LTC2309_NUM_INPUTS;
+		};
+	}
+
+	/**
+	 * @brief A pin of an I2C device, known when compiling.
+	 *
+	 * @tparam Type The type of the device (PLC_MCP23008, PLC_MCP23017, PLC_PCA9685, PLC_ADS1015 or PLC_LTC2309).
+	 * @tparam Addr The I2C address of the device.
+	 * @tparam Index The index of the pin in the device.
+	 * @tparam Slot The bus slot of expanded-gpio, only for id.
+	 */
+	template <peripheral_type_t Type, uint8_t Addr, uint8_t Index, uint8_t Slot = 0>
+	class Pin {
+		static_assert(Type != PLC_DIRECT, "The direct pins are only available through expanded-gpio");
+		static_assert(Addr < 128, "Invalid I2C address");
+		static_assert(Index < detail::PinTraits<Type>::num_pins, "The device doesn't have this pin");
+
+	public:
+		using device_type = typename detail::PinTraits<Type>::device_type;
+		using mask_type = typename detail::PinTraits<Type>::mask_type;
+
+		static constexpr peripheral_type_t type = Type;
+		static constexpr uint8_t address = Addr;
+		static constexpr uint8_t index = Index;
+		static constexpr uint8_t slot = Slot;
+		static constexpr mask_type mask = (mask_type) (1u << Index);
+
+		/**
+		 * @brief The same pin for the functions of expanded-gpio.
+		 */
+		static constexpr uint32_t id = PIN_ON_BUS(Slot, _MAKE_PIN_PLC(Type, Addr, 0, Index));
+
+		explicit Pin(device_type& device) noexcept : device_(&device) {
+			assert(device.address() == Addr);
+		}
+
+		device_type& device() const noexcept { return *device_; }
+
+	private:
+		device_type* device_;
+	};
+
+	// Definitions of the constants, needed when they are bound to a reference before C++17
+	template <peripheral_type_t Type, uint8_t Addr, uint8_t Index, uint8_t Slot>
+	constexpr peripheral_type_t Pin<Type, Addr, Index, Slot>::type;
+	template <peripheral_type_t Type, uint8_t Addr, uint8_t Index, uint8_t Slot>
+	constexpr uint8_t Pin<Type, Addr, Index, Slot>::address;
+	template <peripheral_type_t Type, uint8_t Addr, uint8_t Index, uint8_t Slot>
+	constexpr uint8_t Pin<Type, Addr, Index, Slot>::index;
+	template <peripheral_type_t Type, uint8_t Addr, uint8_t Index, uint8_t Slot>
+	constexpr uint8_t Pin<Type, Addr, Index, Slot>::slot;
+	template <peripheral_type_t Type, uint8_t Addr, uint8_t Index, uint8_t Slot>
+	constexpr typename Pin<Type, Addr, Index, Slot>::mask_type Pin<Type, Addr, Index, Slot>::mask;
+	template <peripheral_type_t Type, uint8_t Addr, uint8_t Index, uint8_t Slot>
+	constexpr uint32_t Pin<Type, Addr, Index, Slot>::id;
+
+
+	namespace detail {
+		// The operations of each device, chosen by overload resolution
+		inline Status pin_mode(Mcp23008& device, uint8_t mask, uint8_t, uint8_t mode) noexcept {
+			return device.pin_mode_masked(mask, mode == INPUT ? mask : 0);
+		}
+
+		inline Status pin_mode(Mcp23017& device, uint16_t mask, uint8_t, uint8_t mode) noexcept {
+			return device.pin_mode_masked(mask, mode == INPUT ? mask : 0);
+		}
+
+		inline Status digital_write(Mcp23008& device, uint8_t mask, uint8_t, bool value) noexcept {
+			return device.write_masked(mask, value ? mask : 0);
+		}
+
+		inline Status digital_write(Mcp23017& device, uint16_t mask, uint8_t, bool value) noexcept {
+			return device.write_masked(mask, value ? mask : 0);
+		}
+
+		inline Status digital_write(Pca9685& device, uint16_t, uint8_t index, bool value) noexcept {
+			return device.write(index, value);
+		}
+
+		inline Status analog_write(Pca9685& device, uint8_t index, uint16_t value) noexcept {
+			return device.pwm_write(index, value);
+		}
+
+		inline Status analog_read(Ads1015& device, uint8_t index, uint16_t& value) noexcept {
+			return device.unsigned_read(index, value);
+		}
+
+		inline Status analog_read(Ltc2309& device, uint8_t index, uint16_t& value) noexcept {
+			return device.read(index, value);
+		}
+	}
+
+	/**
+	 * @brief Sets the mode of a pin of a MCP230XX (INPUT or OUTPUT, as in expanded-gpio).
+	 */
+	template <peripheral_type_t Type, uint8_t Addr, uint8_t Index, uint8_t Slot>
+	inline Status pinMode(const Pin<Type, Addr, Index, Slot>& pin, uint8_t mode) noexcept {
+		return detail::pin_mode(pin.device(), pin.mask, Index, mode);
+	}
+
+	/**
+	 * @brief Writes a pin of a MCP230XX, or turns an output of the PCA9685 fully on or off.
+	 */
+	template <peripheral_type_t Type, uint8_t Addr, uint8_t Index, uint8_t Slot>
+	inline Status digitalWrite(const Pin<Type, Addr, Index, Slot>& pin, bool value) noexcept {
+		return detail::digital_write(pin.device(), pin.mask, Index, value);
+	}
+
+	/**
+	 * @brief Reads a pin of a MCP230XX.
+	 */
+	template <peripheral_type_t Type, uint8_t Addr, uint8_t Index, uint8_t Slot>
+	inline Status digitalRead(const Pin<Type, Addr, Index, Slot>& pin, bool& value) noexcept {
+		typename Pin<Type, Addr, Index, Slot>::mask_type all;
+		const Status status = pin.device().read_all(all);
+		value = (all & pin.mask) != 0;
+		return status;
+	}
+
+	/**
+	 * @brief Writes the duty cycle (0-4095) of an output of the PCA9685.
+	 */
+	template <peripheral_type_t Type, uint8_t Addr, uint8_t Index, uint8_t Slot>
+	inline Status analogWrite(const Pin<Type, Addr, Index, Slot>& pin, uint16_t value) noexcept {
+		return detail::analog_write(pin.device(), Index, value);
+	}
+
+	/**
+	 * @brief Reads a channel of an ADC, unsigned as in expanded-gpio.
+	 */
+	template <peripheral_type_t Type, uint8_t Addr, uint8_t Index, uint8_t Slot>
+	inline Status analogRead(const Pin<Type, Addr, Index, Slot>& pin, uint16_t& value) noexcept {
+		return detail::analog_read(pin.device(), Index, value);
+	}
+
+
+	namespace detail {
+		/**
+		 * @brief Folds the masks of several pins, and the bits of their values.
+		 */
+		template <typename... Pins>
+		struct Fold;
+
+		template <>
+		struct Fold<> {
+			static constexpr unsigned mask() noexcept { return 0; }
+			static constexpr unsigned bits() noexcept { return 0; }
+			static void unpack(unsigned) noexcept {}
+		};
+
+		template <typename P, typename... Rest>
+		struct Fold<P, Rest...> {
+			static constexpr unsigned mask() noexcept { return P::mask | Fold<Rest...>::mask(); }
+
+			template <typename... Values>
+			static constexpr unsigned bits(bool value, Values... values) noexcept {
+				return (value ? P::mask : 0u) | Fold<Rest...>::bits(values...);
+			}
+
+			template <typename... Values>
+			static void unpack(unsigned all, bool& value, Values&... values) noexcept {
+				value = (all & P::mask) != 0;
+				Fold<Rest...>::unpack(all, values...);
+			}
+		};
+
+		template <typename First, typename... Rest>
+		struct SameDevice;
+
+		template <typename First>
+		struct SameDevice<First> : std::true_type {};
+
+		template <typename First, typename Second, typename... Rest>
+		struct SameDevice<First, Second, Rest...> : std::integral_constant<bool,
+			First::type == Second::type && First::address == Second::address &&
+			First::slot == Second::slot && SameDevice<Second, Rest...>::value> {};
+
+		constexpr unsigned popcount(unsigned x) noexcept {
+			return x == 0 ? 0 : (x & 1) + popcount(x >> 1);
+		}
+	}
+
+	/**
+	 * @brief Several pins of the same MCP230XX, written or read with a single transaction.
+	 *
+	 * The values are given in the order of the pins:
+	 *
+	 *     const auto valves = plc::group(q0_1, q0_5, q0_7);
+	 *     valves.write(true, false, true);
+	 */
+	template <typename First, typename... Rest>
+	class PinGroup {
+		static_assert(detail::SameDevice<First, Rest...>::value, "The pins of a group must be of the same device");
+		static_assert(detail::popcount(detail::Fold<First, Rest...>::mask()) == 1 + sizeof...(Rest), "A pin is repeated in the group");
+
+	public:
+		using device_type = typename First::device_type;
+		using mask_type = typename First::mask_type;
+
+		static constexpr mask_type mask = (mask_type) detail::Fold<First, Rest...>::mask();
+
+		explicit PinGroup(device_type& device) noexcept : device_(&device) {
+			assert(device.address() == First::address);
+		}
+
+		device_type& device() const noexcept { return *device_; }
+
+		/**
+		 * @brief Sets the mode of all the pins (INPUT or OUTPUT, as in expanded-gpio).
+		 */
+		Status pinMode(uint8_t mode) const noexcept {
+			return detail::pin_mode(*device_, mask, 0, mode);
+		}
+
+		/**
+		 * @brief Writes the pins, one value for each of them.
+		 */
+		template <typename... Values>
+		Status write(bool value, Values... values) const noexcept {
+			static_assert(sizeof...(Values) == sizeof...(Rest), "One value is needed for each pin");
+			return device_->write_masked(mask, (mask_type) detail::Fold<First, Rest...>::bits(value, values...));
+		}
+
+		/**
+		 * @brief Reads the pins, one value for each of them.
+		 */
+		template <typename... Values>
+		Status read(bool& value, Values&... values) const noexcept {
+			static_assert(sizeof...(Values) == sizeof...(Rest), "One value is needed for each pin");
+			mask_type all;
+			const Status status = device_->read_all(all);
+			detail::Fold<First, Rest...>::unpack(all, value, values...);
+			return status;
+		}
+
+	private:
+		device_type* device_;
+	};
+
+	template <typename First, typename... Rest>
+	constexpr typename PinGroup<First, Rest...>::mask_type PinGroup<First, Rest...>::mask;
+
+	/**
+	 * @brief Makes the group of some pins of the same device.
+	 */
+	template <typename First, typename... Rest>
+	inline PinGroup<First, Rest...> group(const First& first, const Rest&...) noexcept {
+		return PinGroup<First, Rest...>(first.device());
+	}
+
+}
+
+#endif // __PLC_PIN_HPP__
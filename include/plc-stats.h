@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PLC_STATS_H__
+#define __PLC_STATS_H__
+
+/*
+ * plc-stats keeps the counters of the library: the I2C transactions, errors
+ * and latencies of every device, the duration of the scans of expanded-gpio
+ * and the hits of its caches. They are updated with relaxed atomic
+ * operations, so any thread can read them while the others work.
+ *
+ * The counters are private to the process, unless the environment variable
+ * PLC_PERIPHERALS_STATS_SHM publishes them. Then, in Linux, they live in a
+ * POSIX shared-memory segment, created the first time they are used (with
+ * mode 0644 filtered by the umask) and removed when the program exits
+ * normally. A value starting with '/' is the name of the segment, and any
+ * other non-empty value gives PLC_STATS_SHM_PREFIX followed by the PID
+ * ("/plc-peripherals-1234"). Other processes, like plc-top, attach to it
+ * read-only with plc_stats_attach, without disturbing the program that owns it.
+ *
+ * The library built with PLC_PERIPHERALS_NO_STATS doesn't count anything.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define PLC_STATS_SHM_PREFIX "/plc-peripherals-"
+#define PLC_STATS_MAGIC 0x53434c50 // "PLCS"
+#define PLC_STATS_VERSION 1
+
+#define PLC_STATS_MAX_DEVICES 64
+#define PLC_STATS_LATENCY_BUCKETS 24
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/**
+	 * @brief Distribution of some durations.
+	 *
+	 * Bucket 0 counts the durations under 1 us, and bucket i (i > 0) the
+	 * ones from 2^(i-1) us up to 2^i us. The last bucket also counts all
+	 * the longer ones.
+	 */
+	typedef struct {
+		uint64_t count;
+		uint64_t total_ns;
+		uint64_t max_ns;
+		uint64_t buckets[PLC_STATS_LATENCY_BUCKETS];
+	} plc_stats_latency_t;
+
+	/**
+	 * @brief Counters of an I2C device. Each transaction is one ioctl in Linux.
+	 */
+	typedef struct {
+		uint32_t key; // (bus << 8 | address) + 1, 0 if the entry is free
+		int32_t last_errno; // Of the last failed transaction, 0 if none failed
+		uint64_t transactions;
+		uint64_t errors;
+		uint64_t bytes; // Written and read
+		plc_stats_latency_t latency;
+	} plc_stats_device_t;
+
+	typedef enum {
+		PLC_STATS_CACHE_DEBOUNCE, // Debounced expander pins served from the last sample
+		PLC_STATS_CACHE_PWM_SYSFS, // sysfs PWM values not written again
+		PLC_STATS_NUM_CACHES
+	} plc_stats_cache_id_t;
+
+	typedef struct {
+		uint64_t hits;
+		uint64_t misses;
+	} plc_stats_cache_t;
+
+	/**
+	 * @brief Layout of the shared-memory segment.
+	 *
+	 * A reader must check magic, version and size before using the rest.
+	 */
+	typedef struct {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t size; // sizeof(plc_stats_t)
+		int32_t pid;
+		uint64_t start_ns; // CLOCK_MONOTONIC when the counters were created
+		uint64_t num_devices;
+		uint64_t dropped_transactions; // Of the devices that didn't fit in the table
+		plc_stats_latency_t scans; // scanDebouncedInputs and the *AllBatch functions
+		uint64_t scan_errors;
+		plc_stats_cache_t caches[PLC_STATS_NUM_CACHES];
+		plc_stats_device_t devices[PLC_STATS_MAX_DEVICES];
+	} plc_stats_t;
+
+	/**
+	 * @brief Gets the counters of this process.
+	 *
+	 * @return Pointer to the counters, which stays valid until the program exits.
+	 */
+	const plc_stats_t* plc_stats_self(void);
+
+	/**
+	 * @brief Gets the name of the shared-memory segment of this process.
+	 *
+	 * @return The name, or NULL if the counters are private.
+	 */
+	const char* plc_stats_shm_name(void);
+
+	/**
+	 * @brief Maps read-only the counters published by another process.
+	 *
+	 * @param name The name of the segment, like "/plc-peripherals-1234".
+	 * @return Pointer to the counters on success, NULL on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EPROTO: The segment isn't from a compatible version of the library.
+	 *             - ENOTSUP: Not available outside Linux.
+	 *             - Other errors that "shm_open", "fstat" or "mmap" may return.
+	 */
+	const plc_stats_t* plc_stats_attach(const char* name);
+
+	/**
+	 * @brief Unmaps counters mapped with plc_stats_attach.
+	 *
+	 * @param pointer_to_stats Pointer to the pointer of the counters. It is set to NULL.
+	 * @return 0 on success, -1 on failure (errno is set).
+	 */
+	int plc_stats_detach(const plc_stats_t** pointer_to_stats);
+
+	/**
+	 * @brief Copies the counters, reading each one atomically.
+	 *
+	 * The copy isn't a consistent snapshot of all of them at once, but no
+	 * counter is torn, even in 32-bit machines.
+	 *
+	 * @param stats The counters.
+	 * @param copy Where to copy them.
+	 */
+	void plc_stats_snapshot(const plc_stats_t* stats, plc_stats_t* copy);
+
+	/**
+	 * @brief Estimates a percentile of a distribution.
+	 *
+	 * @param latency The distribution.
+	 * @param fraction The percentile, from 0 to 1 (0.99 for the p99).
+	 * @return The duration in nanoseconds, interpolated within its bucket, or 0 if it is empty.
+	 */
+	uint64_t plc_stats_percentile(const plc_stats_latency_t* latency, double fraction);
+
+	/*
+	 * Recording, used by the modules of the library.
+	 */
+
+	/**
+	 * @brief Gets the start time of an operation to record, CLOCK_MONOTONIC in nanoseconds.
+	 */
+	uint64_t plc_stats_now(void);
+
+	/**
+	 * @brief Records an I2C transaction.
+	 *
+	 * errno is preserved.
+	 *
+	 * @param bus The I2C bus number.
+	 * @param addr The address of the device.
+	 * @param bytes The bytes written and read.
+	 * @param start_ns The value of plc_stats_now before the transaction.
+	 * @param ok true if it succeeded.
+	 */
+	void plc_stats_transaction(uint8_t bus, uint8_t addr, size_t bytes, uint64_t start_ns, bool ok);
+
+	/**
+	 * @brief Records a scan over the buses of expanded-gpio.
+	 *
+	 * @param start_ns The value of plc_stats_now before the scan.
+	 * @param ok true if it succeeded.
+	 */
+	void plc_stats_scan(uint64_t start_ns, bool ok);
+
+	/**
+	 * @brief Records an access to a cache.
+	 *
+	 * @param cache The cache.
+	 * @param hit true if the access was served from the cache.
+	 */
+	void plc_stats_cache(plc_stats_cache_id_t cache, bool hit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __PLC_STATS_H__
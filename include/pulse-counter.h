@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PULSE_COUNTER_H__
+#define __PULSE_COUNTER_H__
+
+/*
+ * pulse-counter counts the edges of several lines of a GPIO chip (flow meters,
+ * encoders...) from the edge events of the GPIO character device. The kernel
+ * timestamps and buffers every edge, and a thread takes them in blocks, so no
+ * pulse is missed because of the scheduling of a polling loop. The count, the
+ * period and the frequency of every line can be read at any time without
+ * blocking.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "detect-platform.h"
+#include "gpio-chardev.h"
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#define PULSE_COUNTER_DEFAULT_GATE_MS 100
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/**
+	 * @brief Structure representing the counters of several lines of a chip.
+	 */
+	struct _pulse_counter_t;
+	typedef struct _pulse_counter_t pulse_counter_t;
+
+	/**
+	 * @brief Structure representing the state of the counter of a line.
+	 *
+	 * - @c count: Edges counted since the counter was opened or reset, including
+	 *             the ones whose events the kernel had to discard.
+	 * - @c last_edge_ns: Time of the last edge, from CLOCK_MONOTONIC, 0 if there wasn't any.
+	 * - @c period_ns: Time between the last two edges, 0 if unknown.
+	 * - @c frequency_hz: Edges per second, averaged over the gate time. It decays
+	 *                    to 0 when the edges stop.
+	 */
+	typedef struct {
+		uint64_t count;
+		uint64_t last_edge_ns;
+		uint64_t period_ns;
+		double frequency_hz;
+	} pulse_counter_reading_t;
+
+	/**
+	 * @brief Requests several lines of a GPIO chip with edge detection and starts counting.
+	 *
+	 * Only the edges given in "flags" are counted: with GPIO_CHARDEV_EDGE_BOTH,
+	 * every pulse counts twice.
+	 *
+	 * @param chip The path of the GPIO chip (for example, "/dev/gpiochip0").
+	 * @param offsets Array with the offsets of the lines in the chip.
+	 * @param num_lines Number of lines (up to GPIO_CHARDEV_MAX_LINES).
+	 * @param flags Bitmask of GPIO_CHARDEV_* flags, with at least one of the edge ones.
+	 * @param gate_ms Minimum time over which the frequency is averaged, 0 for
+	 *                PULSE_COUNTER_DEFAULT_GATE_MS. Slower signals are measured
+	 *                from edge to edge.
+	 * @return Pointer to the counter on success, NULL on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: One of the pointers given is invalid.
+	 *             - EINVAL: The number of lines or the flags are invalid.
+	 *             - Other errors that gpio_chardev_request_inputs, "malloc" or "pthread_create" may return.
+	 */
+	pulse_counter_t* pulse_counter_open(const char* chip, const uint32_t* offsets, size_t num_lines, uint8_t flags, uint32_t gate_ms);
+
+	/**
+	 * @brief Stops counting and releases the lines.
+	 *
+	 * @param pointer_to_counter Pointer to the pointer of the counter. It is set to NULL.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: The pointer given is invalid.
+	 *             - Other errors that "close" may return.
+	 */
+	int pulse_counter_close(pulse_counter_t** pointer_to_counter);
+
+	/**
+	 * @brief Gets the state of the counter of a line, without blocking.
+	 *
+	 * @param counter Pointer to the counter.
+	 * @param line Index of the line in the array given to pulse_counter_open.
+	 * @param reading Pointer where the state will be stored.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: One of the pointers given is invalid.
+	 *             - EINVAL: The line doesn't exist.
+	 *             - EPIPE: The counting stopped on an error of the chip (see pulse_counter_error).
+	 *                      The state when it stopped is still stored in "reading".
+	 */
+	int pulse_counter_read(pulse_counter_t* counter, size_t line, pulse_counter_reading_t* reading);
+
+	/**
+	 * @brief Reads the current level of all the lines with a single ioctl.
+	 *
+	 * @param counter Pointer to the counter.
+	 * @param levels Pointer where the levels will be stored (bit "i" is the i-th line).
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: One of the pointers given is invalid.
+	 *             - Other errors that "ioctl" may return.
+	 */
+	int pulse_counter_levels(pulse_counter_t* counter, uint64_t* levels);
+
+	/**
+	 * @brief Sets the count of a line to 0, keeping the frequency measurement.
+	 *
+	 * @param counter Pointer to the counter.
+	 * @param line Index of the line in the array given to pulse_counter_open.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: The pointer given is invalid.
+	 *             - EINVAL: The line doesn't exist.
+	 */
+	int pulse_counter_reset(pulse_counter_t* counter, size_t line);
+
+	/**
+	 * @brief Gets the number of edges whose events were discarded by the kernel.
+	 *
+	 * They are still counted (from the sequence numbers of the next events), but
+	 * their timestamps are lost. A growing number means that the thread can't
+	 * keep up with the signals.
+	 *
+	 * @param counter Pointer to the counter.
+	 * @return The number of edges, 0 if the pointer is invalid.
+	 */
+	uint64_t pulse_counter_missed(pulse_counter_t* counter);
+
+	/**
+	 * @brief Gets the error that stopped the counting.
+	 *
+	 * A hang-up of the chip is reported as EPIPE. The counting isn't restarted:
+	 * the counter must be closed and opened again.
+	 *
+	 * @param counter Pointer to the counter.
+	 * @return The errno that stopped the counting, 0 while it runs or if the pointer is invalid.
+	 */
+	int pulse_counter_error(pulse_counter_t* counter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PLC_ENVIRONMENT == Linux
+
+#endif // __PULSE_COUNTER_H__
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PWM_SYSFS_H__
+#define __PWM_SYSFS_H__
+
+/*
+ * pwm-sysfs drives a hardware PWM channel through the Linux sysfs interface
+ * (/sys/class/pwm). The channel is exported once, and its attribute files are
+ * kept open, so every change is a single pwrite. Values equal to the last one
+ * written are not written again.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "detect-platform.h"
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#define PWM_SYSFS_DEFAULT_ROOT "/sys/class/pwm"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/**
+	 * @brief Structure representing an opened PWM channel.
+	 */
+	struct _pwm_sysfs_t;
+	typedef struct _pwm_sysfs_t pwm_sysfs_t;
+
+	/**
+	 * @brief Opens a PWM channel, exporting it if needed.
+	 *
+	 * The channel is not unexported by pwm_sysfs_close, so it keeps its
+	 * output when the program ends.
+	 *
+	 * @param root The sysfs PWM directory, NULL for PWM_SYSFS_DEFAULT_ROOT. A
+	 *             fake directory tree can be given for testing.
+	 * @param chip The number of the PWM chip (N in "pwmchipN").
+	 * @param channel The number of the channel in the chip.
+	 * @return Pointer to the channel on success, NULL on failure.
+	 *         On failure, errno is set as follows:
+	 *             - ENAMETOOLONG: The root path is too long.
+	 *             - ETIMEDOUT: The exported channel didn't appear.
+	 *             - Other errors that "open", "read", "write" or "malloc" may return.
+	 */
+	pwm_sysfs_t* pwm_sysfs_open(const char* root, uint32_t chip, uint32_t channel);
+
+	/**
+	 * @brief Closes a PWM channel.
+	 *
+	 * @param pointer_to_pwm Pointer to the pointer of the channel. It is set to NULL.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: The pointer given is invalid.
+	 *             - Other errors that "close" may return.
+	 */
+	int pwm_sysfs_close(pwm_sysfs_t** pointer_to_pwm);
+
+	/**
+	 * @brief Sets the period of a PWM channel.
+	 *
+	 * If the current duty cycle is longer than the new period, it is
+	 * shortened first, as the kernel requires.
+	 *
+	 * @param pwm Pointer to the channel.
+	 * @param period_ns The period in nanoseconds.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: The pointer given is invalid.
+	 *             - Other errors that "pwrite" may return.
+	 */
+	int pwm_sysfs_set_period(pwm_sysfs_t* pwm, uint64_t period_ns);
+
+	/**
+	 * @brief Sets the duty cycle of a PWM channel.
+	 *
+	 * @param pwm Pointer to the channel.
+	 * @param duty_ns The active time in nanoseconds.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: The pointer given is invalid.
+	 *             - EINVAL: The duty cycle is longer than the period.
+	 *             - Other errors that "pwrite" may return.
+	 */
+	int pwm_sysfs_set_duty_cycle(pwm_sysfs_t* pwm, uint64_t duty_ns);
+
+	/**
+	 * @brief Enables or disables the output of a PWM channel.
+	 *
+	 * @param pwm Pointer to the channel.
+	 * @param enable True to enable the output.
+	 * @return 0 on success, -1 on failure.
+	 *         On failure, errno is set as follows:
+	 *             - EFAULT: The pointer given is invalid.
+	 *             - Other errors that "pwrite" may return.
+	 */
+	int pwm_sysfs_enable(pwm_sysfs_t* pwm, bool enable);
+
+	/**
+	 * @brief Gets the period of a PWM channel.
+	 *
+	 * @param pwm Pointer to the channel.
+	 * @return The period in nanoseconds, 0 if the pointer is invalid.
+	 */
+	uint64_t pwm_sysfs_get_period(const pwm_sysfs_t* pwm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PLC_ENVIRONMENT == Linux
+
+#endif // __PWM_SYSFS_H__
@@ -18,12 +18,29 @@
  */
 
 #include <expanded-gpio.h>
+#include <detect-platform.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <unistd.h>
+#include <time.h>
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <gpio-chardev.h>
+#endif
 
 #include <i2c-interface.h>
+#include <plc-stats.h>
+#include "plc-trace.h"
 #include <peripheral-ads1015.h>
 #include <peripheral-mcp23008.h>
 #include <peripheral-pca9685.h>
@@ -51,12 +68,288 @@
 #define pinToPlcTypeEnum(pin) (((pin) >> 24) & 0xFF)
 #define pinToI2CAddress(pin) (((pin) >> 16) & 0xFF)
 #define pinToDeviceIndex(pin) ((pin) & 0xFF)
+#define pinToBusSlot(pin) (((pin) >> 8) & 0xFF)
+
+/*
+ * After a power-on reset, a device may not respond to I2C commands for a
+ * while. The peripherals are polled until all of them ACK, but never for
+ * longer than this (which was the fixed delay used before).
+ */
+#define PERIPHERALS_READY_TIMEOUT_US (210 * 1000)
+#define PERIPHERALS_READY_POLL_US (2 * 1000)
+
+/*
+ * deinitExpandedGPIONoReset saves the state of the peripherals to this file
+ * (formatted with the I2C bus number), so the next initialization can verify
+ * them instead of initializing them again. /run is a tmpfs, so the snapshot
+ * doesn't survive a power cycle, when the devices lose their state too.
+ * The environment variable EXPANDED_GPIO_SNAPSHOT_DIR_ENV, read on every save
+ * and restore, puts the file (EXPANDED_GPIO_SNAPSHOT_FILE) in another directory.
+ */
+#ifndef EXPANDED_GPIO_SNAPSHOT_PATH
+#define EXPANDED_GPIO_SNAPSHOT_PATH "/run/plc-peripherals-i2c-%d.snapshot"
+#endif
+#define EXPANDED_GPIO_SNAPSHOT_FILE "plc-peripherals-i2c-%d.snapshot"
+#define EXPANDED_GPIO_SNAPSHOT_DIR_ENV "PLC_PERIPHERALS_SNAPSHOT_DIR"
+
+
+
+#define DEBOUNCE_MAX_DEVICES 16
+#define DEBOUNCE_MAX_PINS 16
+
+/*
+ * Every read of the whole port is a sample, and the filter of all the pins is
+ * updated at once with bitmasks. Only the pins whose level differs from the
+ * debounced one (pending) need their own counter or timestamp.
+ */
+struct debounce_t {
+	uint8_t addr;
+	uint16_t enabled; // Debounced pins
+	uint16_t stable; // Debounced level
+	uint16_t pending; // Pins with a level different from the debounced one
+	uint16_t fresh; // Pins without debounced level yet, they take the next sample
+	uint64_t last_sample_ns;
+	uint8_t mode[DEBOUNCE_MAX_PINS];
+	uint16_t param[DEBOUNCE_MAX_PINS];
+	uint16_t count[DEBOUNCE_MAX_PINS];
+	uint64_t since_ns[DEBOUNCE_MAX_PINS];
+};
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+/*
+ * When several buses are used, each one has a worker thread, so the
+ * operations that involve all of them (initialization, scans, batches) run
+ * on every bus at the same time.
+ */
+struct expanded_bus_t;
+typedef int (*bus_job_t)(struct expanded_bus_t* b, void* arg);
+
+struct bus_worker_t {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	bool running;
+	bool stop;
+	bool pending; // A job is posted and not finished yet
+	bus_job_t job;
+	void* arg;
+	int ret;
+	int err; // errno of the job
+};
+#endif
+
+/*
+ * State of an I2C bus with peripherals. Slot 0 is the bus given to
+ * plcContextCreate (I2C_BUS with the devices of _peripherals_struct for the
+ * default context), and the other slots are configured with
+ * plcSetExpandedGPIOBus. The slot of a pin is its 1st byte.
+ *
+ * device_ready marks, by I2C address, the devices known to be initialized
+ * in lazy mode (including the ones verified against a warm restart snapshot).
+ * device_failed marks the ones whose lazy initialization failed, so an absent
+ * device fails fast instead of being waited for on every access. Only a new
+ * initialization of the bus or prewarmExpandedGPIO retry them.
+ *
+ * Every public function holds the lock of the bus while it uses it, so the
+ * input monitor thread can share it with the application (a read of the
+ * ADS1015, for example, is more than one transaction). When more than one
+ * lock is needed, they are taken in slot order.
+ */
+struct expanded_bus_t {
+	struct plc_context_t* ctx;
+	int bus; // Unused for slot 0 of the default context, which is always I2C_BUS
+	const struct peripherals_t* peripherals; // NULL if the slot is not used
+	i2c_interface_t* i2c;
+	bool device_ready[128];
+	bool device_failed[128];
+	struct debounce_t debounce[DEBOUNCE_MAX_DEVICES];
+	size_t num_debounce;
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+	pthread_mutex_t lock;
+	expanded_gpio_lock_stats_t lock_stats; // Protected by the lock itself
+	struct bus_worker_t worker;
+#endif
+};
+
+/*
+ * A set of buses and their devices, independent from the others. The
+ * exported functions without context use the default one.
+ *
+ * In lazy mode (initExpandedGPIOLazy) every device is initialized the first
+ * time one of its pins is accessed, instead of all of them up front.
+ */
+struct plc_context_t {
+	struct expanded_bus_t buses[EXPANDED_GPIO_MAX_BUSES];
+	bool lazy_init;
+	bool lazy_restart;
+};
+
+/**
+ * @brief Gets the current time of CLOCK_MONOTONIC in nanoseconds.
+ */
+static inline uint64_t monotonic_ns(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+static plc_context_t default_context = {
+	.buses = {
+		[0 ... EXPANDED_GPIO_MAX_BUSES - 1] = {
+			.ctx = &default_context,
+			.bus = PERIPHERALS_NO_I2C_BUS,
+			.lock = PTHREAD_MUTEX_INITIALIZER,
+			.worker = {
+				.lock = PTHREAD_MUTEX_INITIALIZER,
+				.cond = PTHREAD_COND_INITIALIZER
+			}
+		},
+		[0].peripherals = &_peripherals_struct
+	}
+};
+
+/**
+ * @brief Takes the lock of a bus, and times the wait if another thread holds it.
+ *
+ * The uncontended case costs the same as pthread_mutex_lock: the clock is
+ * only read when the lock is busy.
+ */
+static inline void lock_bus(struct expanded_bus_t* b) {
+	if (pthread_mutex_trylock(&b->lock) == 0) {
+		b->lock_stats.acquisitions++;
+		return;
+	}
+
+	const uint64_t start_ns = monotonic_ns();
+	pthread_mutex_lock(&b->lock);
+	const uint64_t wait_ns = monotonic_ns() - start_ns;
+
+	b->lock_stats.acquisitions++;
+	b->lock_stats.contended++;
+	b->lock_stats.wait_ns += wait_ns;
+	if (wait_ns > b->lock_stats.max_wait_ns) {
+		b->lock_stats.max_wait_ns = wait_ns;
+	}
+}
+
+#define LOCK_BUS(b) lock_bus(b)
+#define UNLOCK_BUS(b) pthread_mutex_unlock(&(b)->lock)
+#else
+static plc_context_t default_context = {
+	.buses = {
+		[0 ... EXPANDED_GPIO_MAX_BUSES - 1] = {
+			.ctx = &default_context,
+			.bus = PERIPHERALS_NO_I2C_BUS
+		},
+		[0].peripherals = &_peripherals_struct
+	}
+};
+#define LOCK_BUS(b) ((void) (b))
+#define UNLOCK_BUS(b) ((void) (b))
+#endif
+
+
+/**
+ * @brief Gets the number of the I2C bus of a slot.
+ */
+static inline int bus_number(const struct expanded_bus_t* b) {
+	return b == &default_context.buses[0] ? I2C_BUS : b->bus;
+}
+
+/**
+ * @brief Gets the bus of a slot.
+ *
+ * @param ctx Pointer to the context.
+ * @param slot The slot of the bus.
+ * @return Pointer to the bus, or NULL if the slot has no I2C bus.
+ */
+static inline struct expanded_bus_t* slot_bus(plc_context_t* ctx, uint8_t slot) {
+	if (slot >= EXPANDED_GPIO_MAX_BUSES || ctx->buses[slot].peripherals == NULL || bus_number(&ctx->buses[slot]) == PERIPHERALS_NO_I2C_BUS) {
+		return NULL;
+	}
+	return &ctx->buses[slot];
+}
+
+/**
+ * @brief Gets the bus of a peripheral pin.
+ *
+ * @return Pointer to the bus, or NULL if the slot of the pin has no I2C bus.
+ */
+static inline struct expanded_bus_t* pin_bus(plc_context_t* ctx, uint32_t pin) {
+	return slot_bus(ctx, pinToBusSlot(pin));
+}
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+/*
+ * The direct pins are shared by all the contexts and don't use any I2C bus,
+ * so they have a lock of their own: a direct pin never waits for the I2C
+ * transactions of a bus. It serializes the normal_gpio_* functions, and the
+ * pins of the slots without bus, which fail without touching any bus.
+ */
+static pthread_mutex_t direct_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define LOCK_DIRECT() pthread_mutex_lock(&direct_lock)
+#define UNLOCK_DIRECT() pthread_mutex_unlock(&direct_lock)
+#else
+#define LOCK_DIRECT() ((void) 0)
+#define UNLOCK_DIRECT() ((void) 0)
+#endif
 
+/**
+ * @brief Gets the bus whose lock serializes the accesses to a pin.
+ *
+ * @return Pointer to the bus, or NULL for a direct pin or a pin of a slot
+ *         without bus, which use the direct lock.
+ */
+static inline struct expanded_bus_t* pin_lock_bus(plc_context_t* ctx, uint32_t pin) {
+	if (pinToPlcTypeEnum(pin) == PLC_DIRECT) {
+		return NULL;
+	}
+	return pin_bus(ctx, pin);
+}
 
+/**
+ * @brief Takes the lock of a pin, given by pin_lock_bus.
+ */
+static inline void lock_pin(struct expanded_bus_t* b) {
+	if (b != NULL) {
+		LOCK_BUS(b);
+	}
+	else {
+		LOCK_DIRECT();
+	}
+}
 
-static i2c_interface_t* i2c = NULL;
+/**
+ * @brief Releases the lock of a pin, given by pin_lock_bus.
+ */
+static inline void unlock_pin(struct expanded_bus_t* b) {
+	if (b != NULL) {
+		UNLOCK_BUS(b);
+	}
+	else {
+		UNLOCK_DIRECT();
+	}
+}
 
+/**
+ * @brief Takes the locks of all the buses of a context, in slot order.
+ */
+static inline void lock_all_buses(plc_context_t* ctx) {
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		LOCK_BUS(&ctx->buses[i]);
+	}
+}
 
+/**
+ * @brief Releases the locks of all the buses of a context.
+ */
+static inline void unlock_all_buses(plc_context_t* ctx) {
+	for (size_t i = EXPANDED_GPIO_MAX_BUSES; i-- > 0;) {
+		UNLOCK_BUS(&ctx->buses[i]);
+	}
+}
 
 
 /**
@@ -84,11 +377,42 @@ typedef enum {
 	RESTART_DEINIT,
 	RESTART_INIT
 } init_fail_type_t;
+/**
+ * @brief Initializes a single device with optional restart capability.
+ *
+ * @param b Pointer to the bus of the device.
+ * @param init_fun Pointer to the initialization function of the device.
+ * @param deinit_fun Pointer to the deinitialization function of the device.
+ * @param addr The I2C address of the device.
+ * @param restart Flag indicating whether to restart the device after initializing it.
+ * @return INIT_SUCCESS if successful, appropriate error code otherwise.
+ */
+static init_fail_type_t init_one_device(struct expanded_bus_t* b, int (*init_fun)(i2c_interface_t*, uint8_t), int (*deinit_fun)(i2c_interface_t*, uint8_t), uint8_t addr, bool restart) {
+	int ret = init_fun(b->i2c, addr);
+	if (ret < 0) {
+		return FIRST_INIT;
+	}
+
+	else if (restart) {
+		ret = deinit_fun(b->i2c, addr);
+		if (ret != 0) {
+			return RESTART_DEINIT;
+		}
+		ret = init_fun(b->i2c, addr);
+		if (ret != 0) {
+			return RESTART_INIT;
+		}
+	}
+
+	return INIT_SUCCESS;
+}
+
 /**
  * @brief Initializes a device with error handling and optional restart capability.
  *
  * This function initializes a device with error handling and optional restart capability.
  *
+ * @param b Pointer to the bus of the devices.
  * @param init_fun Pointer to the initialization function of the device.
  * @param deinit_fun Pointer to the deinitialization function of the device.
  * @param devices Array of device addresses.
@@ -96,479 +420,2989 @@ typedef enum {
  * @param restart Flag indicating whether to restart the device on initialization failure.
  * @return INIT_SUCCESS if successful, appropriate error code otherwise.
  */
-static init_fail_type_t init_device(int (*init_fun)(i2c_interface_t*, uint8_t), int (*deinit_fun)(i2c_interface_t*, uint8_t), const uint8_t* devices, size_t num_devices, bool restart) {
+static init_fail_type_t init_device(struct expanded_bus_t* b, int (*init_fun)(i2c_interface_t*, uint8_t), int (*deinit_fun)(i2c_interface_t*, uint8_t), const uint8_t* devices, size_t num_devices, bool restart) {
 	for (size_t i = 0; i < num_devices; i++) {
-		int ret = init_fun(i2c, devices[i]);;
-		if (ret < 0) {
-			return FIRST_INIT;
+		if (b->device_ready[devices[i] & 0x7F]) {
+			// Restored from the warm restart snapshot
+			continue;
 		}
 
-		else if (restart) {
-			ret = deinit_fun(i2c, devices[i]);
-			if (ret != 0) {
-				return RESTART_DEINIT;
-			}
-			ret = init_fun(i2c, devices[i]);
-			if (ret != 0) {
-				return RESTART_INIT;
-			}
+		init_fail_type_t ret = init_one_device(b, init_fun, deinit_fun, devices[i], restart);
+		if (ret != INIT_SUCCESS) {
+			return ret;
 		}
+		b->device_ready[devices[i] & 0x7F] = true;
 	}
 
 	return INIT_SUCCESS;
 }
 
-struct peripherals_t _peripherals_struct = {};
+/**
+ * @brief Waits until the given devices acknowledge their address.
+ *
+ * Every pending device is probed with a one byte read, which is harmless for all the
+ * supported peripherals, until it ACKs or PERIPHERALS_READY_TIMEOUT_US expires.
+ *
+ * @param b Pointer to the bus of the devices.
+ * @param pending Array with the addresses of the devices. It is overwritten.
+ * @param num_pending Number of devices in the array.
+ * @return 0 if all the devices answered, -1 if the timeout expired (errno is set as
+ *         in the i2c_read function).
+ */
+static int wait_devices_ready(struct expanded_bus_t* b, uint8_t* pending, size_t num_pending) {
+	struct timespec start, now;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (true) {
+		size_t still_pending = 0;
+		for (size_t i = 0; i < num_pending; i++) {
+			uint8_t dummy;
+			const i2c_read_t probe = {.buff=&dummy, .len=1};
+			if (i2c_read(b->i2c, pending[i], &probe) != 0) {
+				pending[still_pending++] = pending[i];
+			}
+		}
+		num_pending = still_pending;
 
+		if (num_pending == 0) {
+			errno = 0;
+			return 0;
+		}
 
-int initExpandedGPIO(bool restart_peripherals) {
-	if (!ARRAY_MCP23008 ||
-	    !ARRAY_ADS1015 ||
-	    !ARRAY_PCA9685 ||
-	    !ARRAY_LTC2309 ||
-	    !ARRAY_MCP23017
-	    ) {
-		return PLC_PERIHPERALS_STRUCT_INVALID;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		const int64_t elapsed_us = (now.tv_sec - start.tv_sec) * 1000000LL + (now.tv_nsec - start.tv_nsec) / 1000;
+		if (elapsed_us >= PERIPHERALS_READY_TIMEOUT_US) {
+			return -1;
+		}
+		usleep(PERIPHERALS_READY_POLL_US);
 	}
+}
 
-	int ret = -1;
-
-	ret = normal_gpio_init();
-	if (ret < 0) {
-		return NORMAL_GPIO_INIT_FAIL;
+/**
+ * @brief Waits until all the configured peripherals of a bus acknowledge their address.
+ *
+ * @param b Pointer to the bus.
+ * @return 0 if all the devices answered, -1 if the timeout expired.
+ */
+static int wait_peripherals_ready(struct expanded_bus_t* b) {
+	const struct peripherals_t* p = b->peripherals;
+	const uint8_t* arrays[] = {p->arrayPCA9685, p->arrayADS1015, p->arrayMCP23008, p->arrayLTC2309, p->arrayMCP23017};
+	const size_t lengths[] = {p->numArrayPCA9685, p->numArrayADS1015, p->numArrayMCP23008, p->numArrayLTC2309, p->numArrayMCP23017};
+
+	uint8_t pending[128];
+	size_t num_pending = 0;
+	for (size_t a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++) {
+		for (size_t i = 0; i < lengths[a] && num_pending < sizeof(pending); i++) {
+			if (!b->device_ready[arrays[a][i] & 0x7F]) {
+				pending[num_pending++] = arrays[a][i];
+			}
+		}
 	}
 
+	return wait_devices_ready(b, pending, num_pending);
+}
 
-	if (I2C_BUS != PERIPHERALS_NO_I2C_BUS) {
-		/**
-		 * Introduce a delay to allow some devices to stabilize after power-up and reset.
-		 * After a power-on reset, a device may not respond to I2C commands. Without this
-		 * delay, attempting to communicate with the devices immediately after a reset
-		 * may result in a NACK, causing the program to immediately fail.
-		 */
-		usleep(210 * 1000);
+/**
+ * @brief Initializes the device of a pin on its first access, when in lazy mode.
+ *
+ * The initialization function of the drivers first checks the configuration
+ * fingerprint of the device, so a device already configured (by a previous
+ * process, for example) costs a single transaction. If the device doesn't answer,
+ * it may still be starting up: it is waited for and the initialization retried.
+ * A failure is remembered, and the next accesses fail without touching the bus
+ * until the device is re-armed by reset_device_ready or prewarm_expanded_gpio.
+ *
+ * @param b Pointer to the bus of the device.
+ * @param peri The type of the peripheral.
+ * @param addr The I2C address of the device.
+ * @return 0 if the device is ready (or it is not in the peripherals struct), the
+ *         ARRAY_XXX_INIT_FAIL error code of the peripheral otherwise.
+ */
+static int ensure_device_ready(struct expanded_bus_t* b, uint8_t peri, uint8_t addr) {
+	if (!b->ctx->lazy_init || b->device_ready[addr & 0x7F]) {
+		return 0;
+	}
 
-		if (i2c != NULL) {
-			return I2C_ALREADY_INITIALIZED;
-		}
+	int (*init_fun)(i2c_interface_t*, uint8_t);
+	int (*deinit_fun)(i2c_interface_t*, uint8_t);
+	const uint8_t* devices;
+	size_t num_devices;
+	int init_fail;
 
-		i2c = i2c_init(I2C_BUS);
-		if (i2c == NULL) {
-			return -1;
-		}
+	switch (peri) {
+		case PLC_PCA9685:
+			init_fun = pca9685_init;
+			deinit_fun = pca9685_deinit;
+			devices = b->peripherals->arrayPCA9685;
+			num_devices = b->peripherals->numArrayPCA9685;
+			init_fail = ARRAY_PCA9685_INIT_FAIL;
+			break;
+		case PLC_ADS1015:
+			init_fun = ads1015_init;
+			deinit_fun = ads1015_deinit;
+			devices = b->peripherals->arrayADS1015;
+			num_devices = b->peripherals->numArrayADS1015;
+			init_fail = ARRAY_ADS1015_INIT_FAIL;
+			break;
+		case PLC_MCP23008:
+			init_fun = mcp23008_init;
+			deinit_fun = mcp23008_deinit;
+			devices = b->peripherals->arrayMCP23008;
+			num_devices = b->peripherals->numArrayMCP23008;
+			init_fail = ARRAY_MCP23008_INIT_FAIL;
+			break;
+		case PLC_LTC2309:
+			init_fun = ltc2309_init;
+			deinit_fun = ltc2309_deinit;
+			devices = b->peripherals->arrayLTC2309;
+			num_devices = b->peripherals->numArrayLTC2309;
+			init_fail = ARRAY_LTC2309_INIT_FAIL;
+			break;
+		case PLC_MCP23017:
+			init_fun = mcp23017_init;
+			deinit_fun = mcp23017_deinit;
+			devices = b->peripherals->arrayMCP23017;
+			num_devices = b->peripherals->numArrayMCP23017;
+			init_fail = ARRAY_MCP23017_INIT_FAIL;
+			break;
+		default:
+			return 0;
+	}
 
-		ret = init_device(pca9685_init, pca9685_deinit, ARRAY_PCA9685, NUM_ARRAY_PCA9685, restart_peripherals);
-		assert(ret != FIRST_INIT);
-		assert(ret != RESTART_DEINIT);
-		assert(ret != RESTART_INIT);
-		if (ret != INIT_SUCCESS) {
-			return ARRAY_PCA9685_INIT_FAIL;
-		}
+	if (isAddressIntoArray(addr, devices, num_devices) != 0) {
+		// Not managed by the library, as with initExpandedGPIO
+		return 0;
+	}
 
-		ret = init_device(ads1015_init, ads1015_deinit, ARRAY_ADS1015, NUM_ARRAY_ADS1015, restart_peripherals);
-		assert(ret != FIRST_INIT);
-		assert(ret != RESTART_DEINIT);
-		assert(ret != RESTART_INIT);
-		if (ret != INIT_SUCCESS) {
-			return ARRAY_ADS1015_INIT_FAIL;
-		}
+	if (b->device_failed[addr & 0x7F]) {
+		return init_fail;
+	}
 
-		ret = init_device(mcp23008_init, mcp23008_deinit, ARRAY_MCP23008, NUM_ARRAY_MCP23008, restart_peripherals);
-		assert(ret != FIRST_INIT);
-		assert(ret != RESTART_DEINIT);
-		assert(ret != RESTART_INIT);
-		if (ret != INIT_SUCCESS) {
-			return ARRAY_MCP23008_INIT_FAIL;
+	init_fail_type_t ret = init_one_device(b, init_fun, deinit_fun, addr, b->ctx->lazy_restart);
+	if (ret == FIRST_INIT) {
+		uint8_t pending[1] = {addr};
+		if (wait_devices_ready(b, pending, 1) == 0) {
+			ret = init_one_device(b, init_fun, deinit_fun, addr, b->ctx->lazy_restart);
 		}
+	}
+	if (ret != INIT_SUCCESS) {
+		b->device_failed[addr & 0x7F] = true;
+		return init_fail;
+	}
 
-		ret = init_device(ltc2309_init, ltc2309_deinit, ARRAY_LTC2309, NUM_ARRAY_LTC2309, restart_peripherals);
-		assert(ret != FIRST_INIT);
-		assert(ret != RESTART_DEINIT);
-		assert(ret != RESTART_INIT);
-		if (ret != INIT_SUCCESS) {
-			return ARRAY_LTC2309_INIT_FAIL;
-		}
+	b->device_ready[addr & 0x7F] = true;
+	return 0;
+}
 
-		ret = init_device(mcp23017_init, mcp23017_deinit, ARRAY_MCP23017, NUM_ARRAY_MCP23017, restart_peripherals);
-		assert(ret != FIRST_INIT);
-		assert(ret != RESTART_DEINIT);
-		assert(ret != RESTART_INIT);
-		if (ret != INIT_SUCCESS) {
-			return ARRAY_MCP23017_INIT_FAIL;
-		}
+/**
+ * @brief Tells whether a device has to be de-initialized.
+ *
+ * In lazy mode, only the devices that have been initialized are de-initialized.
+ *
+ * @param b Pointer to the bus of the device.
+ * @param addr The I2C address of the device.
+ * @return True if the device has to be de-initialized.
+ */
+static inline bool must_deinit_device(const struct expanded_bus_t* b, uint8_t addr) {
+	return !b->ctx->lazy_init || b->device_ready[addr & 0x7F];
+}
+
+/**
+ * @brief Forgets the devices of a bus initialized (or failed) in lazy mode.
+ *
+ * @param b Pointer to the bus.
+ */
+static void reset_device_ready(struct expanded_bus_t* b) {
+	for (size_t i = 0; i < sizeof(b->device_ready) / sizeof(b->device_ready[0]); i++) {
+		b->device_ready[i] = false;
+		b->device_failed[i] = false;
 	}
+}
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+#define SNAPSHOT_MAGIC 0x53434c50 // "PLCS"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_MAX_DEVICES 32
+#define SNAPSHOT_STATE_SIZE PCA9685_STATE_SIZE
+
+struct snapshot_device_t {
+	uint8_t type;
+	uint8_t addr;
+	uint8_t state[SNAPSHOT_STATE_SIZE];
+};
+
+struct snapshot_t {
+	uint32_t magic;
+	uint32_t checksum; // Of everything after this field
+	uint32_t version;
+	int32_t bus;
+	uint32_t num_devices;
+	struct snapshot_device_t devices[SNAPSHOT_MAX_DEVICES];
+};
 
+/**
+ * @brief Gets the path of the snapshot file of an I2C bus.
+ *
+ * @param b Pointer to the bus.
+ * @param path Buffer where the path will be stored.
+ * @param len Length of the buffer.
+ * @return 0 on success, -1 if the path doesn't fit (errno is set to ENAMETOOLONG).
+ */
+static int snapshot_path(const struct expanded_bus_t* b, char* path, size_t len) {
+	const char* dir = getenv(EXPANDED_GPIO_SNAPSHOT_DIR_ENV);
+	const int written = dir != NULL && dir[0] != '\0' ?
+		snprintf(path, len, "%s/" EXPANDED_GPIO_SNAPSHOT_FILE, dir, bus_number(b)) :
+		snprintf(path, len, EXPANDED_GPIO_SNAPSHOT_PATH, bus_number(b));
+	if (written < 0 || (size_t) written >= len) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
 	return 0;
 }
 
-int deinitExpandedGPIO(void) {
-	int ret = -1;
+/**
+ * @brief Computes the FNV-1a hash of the contents of a snapshot.
+ *
+ * @param snapshot Pointer to the snapshot.
+ * @return The checksum of the snapshot.
+ */
+static uint32_t snapshot_checksum(const struct snapshot_t* snapshot) {
+	const uint8_t* data = (const uint8_t*) &snapshot->version;
+	const uint8_t* end = (const uint8_t*) (snapshot + 1);
 
-	ret = normal_gpio_deinit();
-	if (ret < 0) {
-		return NORMAL_GPIO_DEINIT_FAIL;
+	uint32_t hash = 2166136261u;
+	while (data < end) {
+		hash = (hash ^ *data++) * 16777619u;
 	}
+	return hash;
+}
 
+/**
+ * @brief Reads the registers that define the state of a device.
+ *
+ * @param b Pointer to the bus of the device.
+ * @param type The type of the peripheral.
+ * @param addr The I2C address of the device.
+ * @param state Buffer of SNAPSHOT_STATE_SIZE bytes where the state will be stored.
+ * @param len Pointer where the length of the state will be stored.
+ * @return 0 on success, -1 on failure or if the peripheral has no state to save.
+ */
+static int read_device_state(struct expanded_bus_t* b, uint8_t type, uint8_t addr, uint8_t* state, size_t* len) {
+	switch (type) {
+		case PLC_PCA9685:
+			*len = PCA9685_STATE_SIZE;
+			return pca9685_read_state(b->i2c, addr, state);
+		case PLC_MCP23008:
+			*len = MCP23008_STATE_SIZE;
+			return mcp23008_read_state(b->i2c, addr, state);
+		case PLC_MCP23017:
+			*len = MCP23017_STATE_SIZE;
+			return mcp23017_read_state(b->i2c, addr, state);
+		default:
+			// The ADCs have nothing to restore, their initialization is just a read
+			errno = ENOTSUP;
+			return -1;
+	}
+}
 
-	if (I2C_BUS != PERIPHERALS_NO_I2C_BUS) {
-		if (i2c == NULL) {
-			return I2C_ALREADY_DEINITIALIZED;
+/**
+ * @brief Adds the initialized devices of an array to a snapshot.
+ *
+ * @param b Pointer to the bus of the devices.
+ * @param snapshot Pointer to the snapshot.
+ * @param type The type of the peripherals of the array.
+ * @param devices Array of device addresses.
+ * @param num_devices Number of devices in the array.
+ */
+static void snapshot_add_devices(struct expanded_bus_t* b, struct snapshot_t* snapshot, uint8_t type, const uint8_t* devices, size_t num_devices) {
+	for (size_t i = 0; i < num_devices && snapshot->num_devices < SNAPSHOT_MAX_DEVICES; i++) {
+		if (!must_deinit_device(b, devices[i])) {
+			// Never initialized in lazy mode, it will be on first use
+			continue;
 		}
 
-		for (size_t i = 0; i < NUM_ARRAY_PCA9685; ++i) {
-			ret = pca9685_deinit(i2c, ARRAY_PCA9685[i]);
-			if (ret != 0) {
-				return ARRAY_PCA9685_DEINIT_FAIL;
-			}
+		struct snapshot_device_t* device = &snapshot->devices[snapshot->num_devices];
+		size_t len;
+		if (read_device_state(b, type, devices[i], device->state, &len) != 0) {
+			// It will be initialized normally
+			continue;
 		}
+		device->type = type;
+		device->addr = devices[i];
+		snapshot->num_devices++;
+	}
+}
 
-		for (size_t i = 0; i < NUM_ARRAY_ADS1015; ++i) {
-			ret = ads1015_deinit(i2c, ARRAY_ADS1015[i]);
-			if (ret != 0) {
-				return ARRAY_ADS1015_DEINIT_FAIL;
-			}
-		}
+/**
+ * @brief Saves the state of the initialized devices of a bus to its snapshot file.
+ *
+ * The state is read back from the devices (a single transaction each), so the
+ * snapshot contains the actual output latches.
+ *
+ * @param b Pointer to the bus.
+ * @return 0 on success, -1 on failure (errno is set by the failing system call).
+ */
+static int save_snapshot(struct expanded_bus_t* b) {
+	char path[PATH_MAX];
+	if (snapshot_path(b, path, sizeof(path)) != 0) {
+		return -1;
+	}
 
-		for (size_t i = 0; i < NUM_ARRAY_MCP23008; ++i) {
-			ret = mcp23008_deinit(i2c, ARRAY_MCP23008[i]);
-			if (ret != 0) {
-				return ARRAY_MCP23008_DEINIT_FAIL;
-			}
-		}
+	int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if (fd < 0) {
+		return -1;
+	}
+	if (ftruncate(fd, sizeof(struct snapshot_t)) != 0) {
+		close(fd);
+		return -1;
+	}
+	struct snapshot_t* snapshot = mmap(NULL, sizeof(struct snapshot_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (snapshot == MAP_FAILED) {
+		return -1;
+	}
 
-		for (size_t i = 0; i < NUM_ARRAY_LTC2309; ++i) {
-			ret = ltc2309_deinit(i2c, ARRAY_LTC2309[i]);
-			if (ret != 0) {
-				return ARRAY_LTC2309_DEINIT_FAIL;
-			}
-		}
+	// Invalid until completely written
+	snapshot->magic = 0;
+	memset(&snapshot->version, 0, sizeof(struct snapshot_t) - offsetof(struct snapshot_t, version));
+	snapshot->version = SNAPSHOT_VERSION;
+	snapshot->bus = bus_number(b);
 
-		for (size_t i = 0; i < NUM_ARRAY_MCP23017; ++i) {
-			ret = mcp23017_deinit(i2c, ARRAY_MCP23017[i]);
-			if (ret != 0) {
-				return ARRAY_MCP23017_DEINIT_FAIL;
-			}
-		}
+	const struct peripherals_t* p = b->peripherals;
+	snapshot_add_devices(b, snapshot, PLC_PCA9685, p->arrayPCA9685, p->numArrayPCA9685);
+	snapshot_add_devices(b, snapshot, PLC_MCP23008, p->arrayMCP23008, p->numArrayMCP23008);
+	snapshot_add_devices(b, snapshot, PLC_MCP23017, p->arrayMCP23017, p->numArrayMCP23017);
 
-		return i2c_deinit(&i2c);
-	}
+	snapshot->checksum = snapshot_checksum(snapshot);
+	snapshot->magic = SNAPSHOT_MAGIC;
 
+	munmap(snapshot, sizeof(struct snapshot_t));
+	errno = 0;
 	return 0;
 }
 
-int deinitExpandedGPIONoReset(void) {
-	return i2c_deinit(&i2c);
-}
+/**
+ * @brief Verifies the devices against the snapshot file, if there is one.
+ *
+ * Every device of the snapshot that is still in the peripherals struct is read
+ * with a single transaction and, if its registers match, marked as ready so it
+ * is not initialized (nor restarted) again. The snapshot is consumed: it is
+ * removed even if it is invalid.
+ *
+ * @param b Pointer to the bus.
+ * @return The number of devices restored.
+ */
+static size_t restore_snapshot(struct expanded_bus_t* b) {
+	char path[PATH_MAX];
+	if (snapshot_path(b, path, sizeof(path)) != 0) {
+		return 0;
+	}
 
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return 0;
+	}
+	unlink(path);
 
-int pinMode(uint32_t pin, uint8_t mode) {
-	int ret = -1;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size != sizeof(struct snapshot_t)) {
+		close(fd);
+		return 0;
+	}
+	const struct snapshot_t* snapshot = mmap(NULL, sizeof(struct snapshot_t), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (snapshot == MAP_FAILED) {
+		return 0;
+	}
 
-	uint8_t peri = pinToPlcTypeEnum(pin);
-	uint8_t addr = pinToI2CAddress(pin);
-	uint8_t index = pinToDeviceIndex(pin);
+	size_t restored = 0;
+	const struct peripherals_t* p = b->peripherals;
+	if (snapshot->magic == SNAPSHOT_MAGIC &&
+	    snapshot->version == SNAPSHOT_VERSION &&
+	    snapshot->bus == bus_number(b) &&
+	    snapshot->num_devices <= SNAPSHOT_MAX_DEVICES &&
+	    snapshot->checksum == snapshot_checksum(snapshot)) {
+		for (size_t i = 0; i < snapshot->num_devices; i++) {
+			const struct snapshot_device_t* device = &snapshot->devices[i];
+
+			int configured;
+			switch (device->type) {
+				case PLC_PCA9685:
+					configured = isAddressIntoArray(device->addr, p->arrayPCA9685, p->numArrayPCA9685);
+					break;
+				case PLC_MCP23008:
+					configured = isAddressIntoArray(device->addr, p->arrayMCP23008, p->numArrayMCP23008);
+					break;
+				case PLC_MCP23017:
+					configured = isAddressIntoArray(device->addr, p->arrayMCP23017, p->numArrayMCP23017);
+					break;
+				default:
+					configured = -1;
+					break;
+			}
+			if (configured != 0) {
+				continue;
+			}
 
-	if (peri == PLC_DIRECT) {
-		ret = normal_gpio_set_pin_mode(index, mode == OUTPUT ? NORMAL_GPIO_OUTPUT : NORMAL_GPIO_INPUT);
-		return ret == 0 ? 0 : NORMAL_GPIO_SET_PIN_MODE_FAIL;
+			uint8_t state[SNAPSHOT_STATE_SIZE];
+			size_t len;
+			if (read_device_state(b, device->type, device->addr, state, &len) == 0 &&
+			    memcmp(state, device->state, len) == 0) {
+				b->device_ready[device->addr & 0x7F] = true;
+				restored++;
+			}
+		}
 	}
 
-	else if (I2C_BUS == PERIPHERALS_NO_I2C_BUS) {
-		return I2C_PIN_WITHOUT_I2C_BUS;
-	}
+	munmap((void*) snapshot, sizeof(struct snapshot_t));
+	return restored;
+}
 
+/**
+ * @brief Removes the snapshot file of a bus, once its devices have been reset.
+ *
+ * @param b Pointer to the bus.
+ */
+static void discard_snapshot(const struct expanded_bus_t* b) {
+	char path[PATH_MAX];
+	if (snapshot_path(b, path, sizeof(path)) == 0) {
+		unlink(path);
+	}
+}
+#else
+static inline int save_snapshot(struct expanded_bus_t* b) {
+	(void) b;
+	errno = ENOTSUP;
+	return -1;
+}
+
+static inline size_t restore_snapshot(struct expanded_bus_t* b) {
+	(void) b;
+	return 0;
+}
+
+static inline void discard_snapshot(const struct expanded_bus_t* b) {
+	(void) b;
+}
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Debounce of the MCP230xx inputs
+
+/*
+ * Minimum time between two port reads made by digitalRead for the debounced
+ * pins. Reading the other pins of the port within this time doesn't use the
+ * bus, they are served from the last sample.
+ */
+#ifndef EXPANDED_GPIO_DEBOUNCE_SAMPLE_US
+#define EXPANDED_GPIO_DEBOUNCE_SAMPLE_US 1000
+#endif
+
+/**
+ * @brief Gets the debounce state of a device.
+ *
+ * @param b Pointer to the bus of the device.
+ * @param addr The I2C address of the device.
+ * @return Pointer to the state, or NULL if none of its pins is debounced.
+ */
+static struct debounce_t* find_debounce(struct expanded_bus_t* b, uint8_t addr) {
+	for (size_t i = 0; i < b->num_debounce; i++) {
+		if (b->debounce[i].addr == addr) {
+			return &b->debounce[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Gets the debounced pins of a device.
+ *
+ * @param b Pointer to the bus of the device.
+ * @param addr The I2C address of the device.
+ * @return Bitmask of the debounced pins (bit 0 == pin 0).
+ */
+static inline uint16_t debounced_pins(struct expanded_bus_t* b, uint8_t addr) {
+	const struct debounce_t* state = find_debounce(b, addr);
+	return state != NULL ? state->enabled : 0;
+}
+
+/**
+ * @brief Makes the debounced pins of a bus take their level from the next sample.
+ *
+ * Used when the devices are initialized, since the previous levels are no
+ * longer meaningful.
+ *
+ * @param b Pointer to the bus.
+ */
+static void reset_debounce_state(struct expanded_bus_t* b) {
+	for (size_t i = 0; i < b->num_debounce; i++) {
+		b->debounce[i].fresh = b->debounce[i].enabled;
+		b->debounce[i].pending = 0;
+	}
+}
+
+/**
+ * @brief Feeds a sample of a port to its debounce filter.
+ *
+ * @param b Pointer to the bus of the device.
+ * @param addr The I2C address of the device.
+ * @param raw The levels read from the port (bit 0 == pin 0).
+ * @return The levels with the debounced pins replaced by their debounced level.
+ */
+static uint16_t debounce_sample(struct expanded_bus_t* b, uint8_t addr, uint16_t raw) {
+	struct debounce_t* state = find_debounce(b, addr);
+	if (state == NULL) {
+		return raw;
+	}
+
+	const uint64_t now_ns = monotonic_ns();
+	state->last_sample_ns = now_ns;
+
+	state->stable = (state->stable & ~state->fresh) | (raw & state->fresh);
+	state->fresh = 0;
+
+	// A pin that goes back to the debounced level was a bounce, start over
+	const uint16_t diff = (raw ^ state->stable) & state->enabled;
+	const uint16_t starting = diff & ~state->pending;
+	state->pending = diff;
+
+	uint16_t qualified = 0;
+	uint16_t bits = state->pending;
+	while (bits) {
+		const int i = __builtin_ctz(bits);
+		bits &= bits - 1;
+
+		if (starting & (1 << i)) {
+			state->count[i] = 0;
+			state->since_ns[i] = now_ns;
+		}
+		state->count[i]++;
+
+		if (state->mode[i] == DEBOUNCE_INTEGRATOR) {
+			if (state->count[i] >= state->param[i]) {
+				qualified |= 1 << i;
+			}
+		}
+		else if (now_ns - state->since_ns[i] >= (uint64_t) state->param[i] * 1000000ULL) {
+			qualified |= 1 << i;
+		}
+	}
+
+	state->stable ^= qualified;
+	state->pending &= ~qualified;
+
+	return (raw & ~state->enabled) | state->stable;
+}
+
+/**
+ * @brief Reads all the inputs of a GPIO expander through the debounce filter.
+ *
+ * @param b Pointer to the bus of the device.
+ * @param peri The type of the peripheral.
+ * @param addr The I2C address of the device.
+ * @param levels Pointer where the level of the pins will be stored (bit 0 == pin 0).
+ * @return 0 on success, -1 on failure (errno is set as in the read_all functions).
+ */
+static int read_expander_inputs(struct expanded_bus_t* b, uint8_t peri, uint8_t addr, uint16_t* levels) {
+	uint16_t raw;
+
+	if (peri == PLC_MCP23008) {
+		uint8_t value;
+		if (mcp23008_read_all(b->i2c, addr, &value) != 0) {
+			return -1;
+		}
+		raw = value;
+	}
+	else if (peri == PLC_MCP23017) {
+		if (mcp23017_read_all(b->i2c, addr, &raw) != 0) {
+			return -1;
+		}
+	}
+	else {
+		errno = EINVAL;
+		return -1;
+	}
+
+	*levels = debounce_sample(b, addr, raw);
+	return 0;
+}
+
+/**
+ * @brief Reads a debounced pin.
+ *
+ * The port is only read if the last sample is older than
+ * EXPANDED_GPIO_DEBOUNCE_SAMPLE_US, so reading all the pins of a port in a
+ * row costs a single transaction.
+ *
+ * @param b Pointer to the bus of the device.
+ * @param peri The type of the peripheral.
+ * @param addr The I2C address of the device.
+ * @param index The index of the pin.
+ * @param value Pointer where the debounced level will be stored.
+ * @return 0 on success, -1 on failure (errno is set as in the read_all functions).
+ */
+static int read_debounced_pin(struct expanded_bus_t* b, uint8_t peri, uint8_t addr, uint8_t index, uint16_t* value) {
+	const struct debounce_t* state = find_debounce(b, addr);
+	if (state == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	const uint16_t bit = 1 << index;
+
+	const bool sample = state->fresh & bit || monotonic_ns() - state->last_sample_ns >= EXPANDED_GPIO_DEBOUNCE_SAMPLE_US * 1000ULL;
+	plc_stats_cache(PLC_STATS_CACHE_DEBOUNCE, !sample);
+	if (sample) {
+		uint16_t levels;
+		if (read_expander_inputs(b, peri, addr, &levels) != 0) {
+			return -1;
+		}
+	}
+
+	*value = (state->stable & bit) ? 1 : 0;
+	return 0;
+}
+
+/**
+ * @brief Configures the debounce of an expander pin.
+ *
+ * @param ctx Pointer to the context.
+ * @param pin The pin number.
+ * @param mode DEBOUNCE_NONE, DEBOUNCE_INTEGRATOR or DEBOUNCE_TIME_WINDOW.
+ * @param param Number of samples, or milliseconds, depending on the mode.
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+static int set_input_debounce(plc_context_t* ctx, uint32_t pin, uint8_t mode, uint16_t param) {
+	const uint8_t peri = pinToPlcTypeEnum(pin);
+	const uint8_t addr = pinToI2CAddress(pin);
+	const uint8_t index = pinToDeviceIndex(pin);
+	struct expanded_bus_t* b = pin_bus(ctx, pin);
+
+	if (((peri != PLC_MCP23008 || index >= MCP23008_NUM_IO) &&
+	     (peri != PLC_MCP23017 || index >= MCP23017_NUM_IO)) ||
+	    b == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	if ((mode != DEBOUNCE_NONE && mode != DEBOUNCE_INTEGRATOR && mode != DEBOUNCE_TIME_WINDOW) ||
+	    (mode != DEBOUNCE_NONE && param == 0)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	const uint16_t bit = 1 << index;
+	struct debounce_t* state = find_debounce(b, addr);
+
+	if (mode == DEBOUNCE_NONE) {
+		if (state != NULL) {
+			state->enabled &= ~bit;
+			state->pending &= ~bit;
+			state->fresh &= ~bit;
+			if (state->enabled == 0) {
+				*state = b->debounce[--b->num_debounce];
+			}
+		}
+		return 0;
+	}
+
+	if (state == NULL) {
+		if (b->num_debounce == DEBOUNCE_MAX_DEVICES) {
+			errno = ENOSPC;
+			return -1;
+		}
+		state = &b->debounce[b->num_debounce++];
+		*state = (struct debounce_t) {.addr = addr};
+	}
+
+	if (!(state->enabled & bit)) {
+		state->enabled |= bit;
+		state->fresh |= bit;
+	}
+	state->mode[index] = mode;
+	state->param[index] = param;
+
+	return 0;
+}
+
+/**
+ * @brief Samples every port of a bus with debounced pins.
+ *
+ * @param b Pointer to the bus.
+ * @param arg Unused.
+ * @return 0 on success, the READ_ALL_FAIL error code otherwise.
+ */
+static int scan_debounced_bus(struct expanded_bus_t* b, void* arg) {
+	(void) arg;
+
+	for (size_t i = 0; i < b->num_debounce; i++) {
+		const uint8_t addr = b->debounce[i].addr;
+		const uint8_t peri = isAddressIntoArray(addr, b->peripherals->arrayMCP23017, b->peripherals->numArrayMCP23017) == 0 ? PLC_MCP23017 : PLC_MCP23008;
+
+		int ret = ensure_device_ready(b, peri, addr);
+		if (ret != 0) {
+			return ret;
+		}
+
+		uint16_t levels;
+		if (read_expander_inputs(b, peri, addr, &levels) != 0) {
+			return peri == PLC_MCP23017 ? ARRAY_MCP23017_READ_ALL_FAIL : ARRAY_MCP23008_READ_ALL_FAIL;
+		}
+	}
+
+	return 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Workers of the buses
+
+/**
+ * @brief Gets the number of slots of a context with an I2C bus.
+ */
+static size_t num_buses(plc_context_t* ctx) {
+	size_t num = 0;
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		if (slot_bus(ctx, i) != NULL) {
+			num++;
+		}
+	}
+	return num;
+}
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+/**
+ * @brief Body of the worker thread of a bus.
+ *
+ * The jobs run on behalf of a caller that holds the locks of all the buses
+ * and waits for them, so they don't take any lock.
+ */
+static void* bus_worker(void* arg) {
+	struct expanded_bus_t* b = arg;
+	struct bus_worker_t* w = &b->worker;
+
+	pthread_mutex_lock(&w->lock);
+	while (true) {
+		while (!w->pending && !w->stop) {
+			pthread_cond_wait(&w->cond, &w->lock);
+		}
+		if (w->stop) {
+			break;
+		}
+
+		const bus_job_t job = w->job;
+		void* job_arg = w->arg;
+		pthread_mutex_unlock(&w->lock);
+
+		errno = 0;
+		const int ret = job(b, job_arg);
+		const int job_errno = errno;
+
+		pthread_mutex_lock(&w->lock);
+		w->ret = ret;
+		w->err = job_errno;
+		w->pending = false;
+		pthread_cond_broadcast(&w->cond);
+	}
+	pthread_mutex_unlock(&w->lock);
+
+	return NULL;
+}
+
+/**
+ * @brief Starts a worker for every bus but the first one, which runs in the caller.
+ *
+ * With a single bus there is nothing to run in parallel, so no worker is
+ * started. If a worker can't be started, the jobs of its bus run in the
+ * caller, one bus after the other.
+ */
+static void start_bus_workers(plc_context_t* ctx) {
+	if (num_buses(ctx) < 2) {
+		return;
+	}
+
+	bool first = true;
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		struct expanded_bus_t* b = slot_bus(ctx, i);
+		if (b == NULL || b->worker.running) {
+			continue;
+		}
+		if (first) {
+			first = false;
+			continue;
+		}
+
+		b->worker.stop = false;
+		b->worker.pending = false;
+		b->worker.running = pthread_create(&b->worker.thread, NULL, bus_worker, b) == 0;
+	}
+}
+
+/**
+ * @brief Stops the workers of all the buses.
+ */
+static void stop_bus_workers(plc_context_t* ctx) {
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		struct bus_worker_t* w = &ctx->buses[i].worker;
+		if (!w->running) {
+			continue;
+		}
+
+		pthread_mutex_lock(&w->lock);
+		w->stop = true;
+		pthread_cond_broadcast(&w->cond);
+		pthread_mutex_unlock(&w->lock);
+
+		pthread_join(w->thread, NULL);
+		w->running = false;
+	}
+}
+
+/**
+ * @brief Runs a job on every bus, all of them at the same time.
+ *
+ * The caller must hold the locks of all the buses.
+ *
+ * @param ctx Pointer to the context.
+ * @param job The function to run, with the bus as its first argument.
+ * @param arg The second argument of the function.
+ * @return 0 if the job succeeded on all the buses, or the result of the first
+ *         bus (in slot order) where it failed, whose errno is restored.
+ */
+static int run_on_buses(plc_context_t* ctx, bus_job_t job, void* arg) {
+	int rets[EXPANDED_GPIO_MAX_BUSES] = {0};
+	int errs[EXPANDED_GPIO_MAX_BUSES] = {0};
+
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		struct expanded_bus_t* b = slot_bus(ctx, i);
+		if (b == NULL || !b->worker.running) {
+			continue;
+		}
+		pthread_mutex_lock(&b->worker.lock);
+		b->worker.job = job;
+		b->worker.arg = arg;
+		b->worker.pending = true;
+		pthread_cond_broadcast(&b->worker.cond);
+		pthread_mutex_unlock(&b->worker.lock);
+	}
+
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		struct expanded_bus_t* b = slot_bus(ctx, i);
+		if (b == NULL || b->worker.running) {
+			continue;
+		}
+		errno = 0;
+		rets[i] = job(b, arg);
+		errs[i] = errno;
+	}
+
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		struct expanded_bus_t* b = slot_bus(ctx, i);
+		if (b == NULL || !b->worker.running) {
+			continue;
+		}
+		pthread_mutex_lock(&b->worker.lock);
+		while (b->worker.pending) {
+			pthread_cond_wait(&b->worker.cond, &b->worker.lock);
+		}
+		rets[i] = b->worker.ret;
+		errs[i] = b->worker.err;
+		pthread_mutex_unlock(&b->worker.lock);
+	}
+
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		if (rets[i] != 0) {
+			errno = errs[i];
+			return rets[i];
+		}
+	}
+	return 0;
+}
+#else
+static inline void start_bus_workers(plc_context_t* ctx) {
+	(void) ctx;
+}
+
+static inline void stop_bus_workers(plc_context_t* ctx) {
+	(void) ctx;
+}
+
+static int run_on_buses(plc_context_t* ctx, int (*job)(struct expanded_bus_t* b, void* arg), void* arg) {
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		struct expanded_bus_t* b = slot_bus(ctx, i);
+		if (b == NULL) {
+			continue;
+		}
+		int ret = job(b, arg);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+	return 0;
+}
+#endif
+
+/**
+ * @brief Samples every port with debounced pins, on all the buses at the same time.
+ *
+ * @param ctx Pointer to the context.
+ * @return 0 on success, the READ_ALL_FAIL error code otherwise.
+ */
+static int scan_debounced_inputs(plc_context_t* ctx) {
+	if (num_buses(ctx) == 0) {
+		return I2C_PIN_WITHOUT_I2C_BUS;
+	}
+	return run_on_buses(ctx, scan_debounced_bus, NULL);
+}
+
+
+struct peripherals_t _peripherals_struct = {};
+
+
+/**
+ * @brief Checks that all the arrays of a peripherals struct are set.
+ */
+static inline bool valid_peripherals(const struct peripherals_t* p) {
+	return p->arrayMCP23008 &&
+	       p->arrayADS1015 &&
+	       p->arrayPCA9685 &&
+	       p->arrayLTC2309 &&
+	       p->arrayMCP23017;
+}
+
+/**
+ * @brief Initializes the I2C interface and the peripherals of a bus.
+ *
+ * @param b Pointer to the bus.
+ * @param arg Pointer to a bool, true to restart the peripherals.
+ * @return 0 on success, the ARRAY_XXX_INIT_FAIL error code (or -1 if the bus
+ *         can't be opened) otherwise.
+ */
+static int init_bus(struct expanded_bus_t* b, void* arg) {
+	const bool restart_peripherals = *(const bool*) arg;
+	const struct peripherals_t* p = b->peripherals;
+
+	b->i2c = i2c_init(bus_number(b));
+	if (b->i2c == NULL) {
+		return -1;
+	}
+
+	reset_device_ready(b);
+	reset_debounce_state(b);
+	restore_snapshot(b);
+
+	/**
+	 * Allow some devices to stabilize after power-up and reset. Without this wait,
+	 * attempting to communicate with the devices immediately after a reset may
+	 * result in a NACK, causing the program to immediately fail. If a device is
+	 * still not answering after the timeout, its initialization will report it.
+	 */
+	wait_peripherals_ready(b);
+
+	int ret = init_device(b, pca9685_init, pca9685_deinit, p->arrayPCA9685, p->numArrayPCA9685, restart_peripherals);
+	assert(ret != FIRST_INIT);
+	assert(ret != RESTART_DEINIT);
+	assert(ret != RESTART_INIT);
+	if (ret != INIT_SUCCESS) {
+		return ARRAY_PCA9685_INIT_FAIL;
+	}
+
+	ret = init_device(b, ads1015_init, ads1015_deinit, p->arrayADS1015, p->numArrayADS1015, restart_peripherals);
+	assert(ret != FIRST_INIT);
+	assert(ret != RESTART_DEINIT);
+	assert(ret != RESTART_INIT);
+	if (ret != INIT_SUCCESS) {
+		return ARRAY_ADS1015_INIT_FAIL;
+	}
+
+	ret = init_device(b, mcp23008_init, mcp23008_deinit, p->arrayMCP23008, p->numArrayMCP23008, restart_peripherals);
+	assert(ret != FIRST_INIT);
+	assert(ret != RESTART_DEINIT);
+	assert(ret != RESTART_INIT);
+	if (ret != INIT_SUCCESS) {
+		return ARRAY_MCP23008_INIT_FAIL;
+	}
+
+	ret = init_device(b, ltc2309_init, ltc2309_deinit, p->arrayLTC2309, p->numArrayLTC2309, restart_peripherals);
+	assert(ret != FIRST_INIT);
+	assert(ret != RESTART_DEINIT);
+	assert(ret != RESTART_INIT);
+	if (ret != INIT_SUCCESS) {
+		return ARRAY_LTC2309_INIT_FAIL;
+	}
+
+	ret = init_device(b, mcp23017_init, mcp23017_deinit, p->arrayMCP23017, p->numArrayMCP23017, restart_peripherals);
+	assert(ret != FIRST_INIT);
+	assert(ret != RESTART_DEINIT);
+	assert(ret != RESTART_INIT);
+	if (ret != INIT_SUCCESS) {
+		return ARRAY_MCP23017_INIT_FAIL;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Initializes only the I2C interface of a bus, for lazy mode.
+ *
+ * @param b Pointer to the bus.
+ * @param arg Unused.
+ * @return 0 on success, -1 if the bus can't be opened.
+ */
+static int init_bus_lazy(struct expanded_bus_t* b, void* arg) {
+	(void) arg;
+
+	b->i2c = i2c_init(bus_number(b));
+	if (b->i2c == NULL) {
+		return -1;
+	}
+
+	reset_device_ready(b);
+	reset_debounce_state(b);
+	restore_snapshot(b);
+	return 0;
+}
+
+/**
+ * @brief Checks the peripherals structs and that no bus of a context is initialized yet.
+ *
+ * @param ctx Pointer to the context.
+ * @return 0 if the buses can be initialized, the error code otherwise.
+ */
+static int check_buses_deinitialized(plc_context_t* ctx) {
+	if (!valid_peripherals(ctx->buses[0].peripherals)) {
+		return PLC_PERIHPERALS_STRUCT_INVALID;
+	}
+
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		const struct expanded_bus_t* b = slot_bus(ctx, i);
+		if (b != NULL && b->i2c != NULL) {
+			return I2C_ALREADY_INITIALIZED;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Initializes the direct pins, under the direct lock.
+ *
+ * The accesses to the direct pins of other contexts or threads must not see
+ * the backend half initialized, like the line requests of the chardev one.
+ *
+ * @return 0 on success, a negative value on failure.
+ */
+static int init_direct_gpio(void) {
+	LOCK_DIRECT();
+	int ret = normal_gpio_init();
+	UNLOCK_DIRECT();
+	return ret;
+}
+
+/**
+ * @brief De-initializes the direct pins, under the direct lock.
+ *
+ * @return 0 on success, a negative value on failure.
+ */
+static int deinit_direct_gpio(void) {
+	LOCK_DIRECT();
+	int ret = normal_gpio_deinit();
+	UNLOCK_DIRECT();
+	return ret;
+}
+
+static int init_expanded_gpio(plc_context_t* ctx, bool restart_peripherals) {
+	int ret = check_buses_deinitialized(ctx);
+	if (ret != 0) {
+		return ret;
+	}
+
+	// The direct pins belong to the default context
+	if (ctx == &default_context && init_direct_gpio() < 0) {
+		return NORMAL_GPIO_INIT_FAIL;
+	}
+
+	ctx->lazy_init = false;
+	ctx->lazy_restart = false;
+
+	// All the buses wait for their devices and initialize them at the same time
+	start_bus_workers(ctx);
+	return run_on_buses(ctx, init_bus, &restart_peripherals);
+}
+
+static int init_expanded_gpio_lazy(plc_context_t* ctx, bool restart_peripherals) {
+	int ret = check_buses_deinitialized(ctx);
+	if (ret != 0) {
+		return ret;
+	}
+
+	// The direct pins belong to the default context
+	if (ctx == &default_context && init_direct_gpio() < 0) {
+		return NORMAL_GPIO_INIT_FAIL;
+	}
+
+	ctx->lazy_init = true;
+	ctx->lazy_restart = restart_peripherals;
+
+	start_bus_workers(ctx);
+	return run_on_buses(ctx, init_bus_lazy, NULL);
+}
+
+static int prewarm_expanded_gpio(plc_context_t* ctx, const uint32_t* pins, size_t num_pins) {
+	if (pins == NULL && num_pins > 0) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	for (size_t i = 0; i < num_pins; i++) {
+		uint8_t peri = pinToPlcTypeEnum(pins[i]);
+		if (peri == PLC_DIRECT) {
+			continue;
+		}
+
+		struct expanded_bus_t* b = pin_bus(ctx, pins[i]);
+		if (b == NULL) {
+			return I2C_PIN_WITHOUT_I2C_BUS;
+		}
+
+		// A device that failed before is tried again
+		b->device_failed[pinToI2CAddress(pins[i]) & 0x7F] = false;
+		int ret = ensure_device_ready(b, peri, pinToI2CAddress(pins[i]));
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Resets the peripherals of a bus and closes its I2C interface.
+ *
+ * @param b Pointer to the bus.
+ * @param arg Unused.
+ * @return 0 on success, the ARRAY_XXX_DEINIT_FAIL error code otherwise.
+ */
+static int deinit_bus(struct expanded_bus_t* b, void* arg) {
+	(void) arg;
+	const struct peripherals_t* p = b->peripherals;
+
+	if (b->i2c == NULL) {
+		return I2C_ALREADY_DEINITIALIZED;
+	}
+
+	for (size_t i = 0; i < p->numArrayPCA9685; ++i) {
+		if (!must_deinit_device(b, p->arrayPCA9685[i])) {
+			continue;
+		}
+		if (pca9685_deinit(b->i2c, p->arrayPCA9685[i]) != 0) {
+			return ARRAY_PCA9685_DEINIT_FAIL;
+		}
+	}
+
+	for (size_t i = 0; i < p->numArrayADS1015; ++i) {
+		if (!must_deinit_device(b, p->arrayADS1015[i])) {
+			continue;
+		}
+		if (ads1015_deinit(b->i2c, p->arrayADS1015[i]) != 0) {
+			return ARRAY_ADS1015_DEINIT_FAIL;
+		}
+	}
+
+	for (size_t i = 0; i < p->numArrayMCP23008; ++i) {
+		if (!must_deinit_device(b, p->arrayMCP23008[i])) {
+			continue;
+		}
+		if (mcp23008_deinit(b->i2c, p->arrayMCP23008[i]) != 0) {
+			return ARRAY_MCP23008_DEINIT_FAIL;
+		}
+	}
+
+	for (size_t i = 0; i < p->numArrayLTC2309; ++i) {
+		if (!must_deinit_device(b, p->arrayLTC2309[i])) {
+			continue;
+		}
+		if (ltc2309_deinit(b->i2c, p->arrayLTC2309[i]) != 0) {
+			return ARRAY_LTC2309_DEINIT_FAIL;
+		}
+	}
+
+	for (size_t i = 0; i < p->numArrayMCP23017; ++i) {
+		if (!must_deinit_device(b, p->arrayMCP23017[i])) {
+			continue;
+		}
+		if (mcp23017_deinit(b->i2c, p->arrayMCP23017[i]) != 0) {
+			return ARRAY_MCP23017_DEINIT_FAIL;
+		}
+	}
+
+	discard_snapshot(b);
+	reset_device_ready(b);
+	return i2c_deinit(&b->i2c);
+}
+
+/**
+ * @brief Saves the snapshot of a bus and closes its I2C interface.
+ *
+ * @param b Pointer to the bus.
+ * @param arg Unused.
+ * @return 0 on success, -1 on failure (errno is set by i2c_deinit).
+ */
+static int deinit_bus_no_reset(struct expanded_bus_t* b, void* arg) {
+	(void) arg;
+
+	if (b->i2c != NULL) {
+		// Best effort: without a snapshot, the next initialization is a normal one
+		save_snapshot(b);
+	}
+	reset_device_ready(b);
+	return i2c_deinit(&b->i2c);
+}
+
+static int deinit_expanded_gpio(plc_context_t* ctx) {
+	if (ctx == &default_context && deinit_direct_gpio() < 0) {
+		return NORMAL_GPIO_DEINIT_FAIL;
+	}
+
+	int ret = run_on_buses(ctx, deinit_bus, NULL);
+	if (ret == 0) {
+		stop_bus_workers(ctx);
+		ctx->lazy_init = false;
+		ctx->lazy_restart = false;
+	}
+	return ret;
+}
+
+static int deinit_expanded_gpio_no_reset(plc_context_t* ctx) {
+	int ret = run_on_buses(ctx, deinit_bus_no_reset, NULL);
+	stop_bus_workers(ctx);
+	ctx->lazy_init = false;
+	ctx->lazy_restart = false;
+	return ret;
+}
+
+
+static int pin_mode(plc_context_t* ctx, uint32_t pin, uint8_t mode) {
+	int ret = -1;
+
+	uint8_t peri = pinToPlcTypeEnum(pin);
+	uint8_t addr = pinToI2CAddress(pin);
+	uint8_t index = pinToDeviceIndex(pin);
+
+	if (peri == PLC_DIRECT) {
+		ret = normal_gpio_set_pin_mode(index, mode == OUTPUT ? NORMAL_GPIO_OUTPUT : NORMAL_GPIO_INPUT);
+		return ret == 0 ? 0 : NORMAL_GPIO_SET_PIN_MODE_FAIL;
+	}
+
+	struct expanded_bus_t* b = pin_bus(ctx, pin);
+	if (b == NULL) {
+		return I2C_PIN_WITHOUT_I2C_BUS;
+	}
+
+	ret = ensure_device_ready(b, peri, addr);
+	if (ret != 0) {
+		return ret;
+	}
+
+	switch (peri) {
+		case PLC_MCP23008:
+			ret = mcp23008_set_pin_mode(b->i2c, addr, index, mode == OUTPUT ? MCP23008_OUTPUT : MCP23008_INPUT);
+			if (ret != 0)
+				return ARRAY_MCP23008_SET_PIN_MODE_FAIL;
+			break;
+		case PLC_MCP23017:
+			ret = mcp23017_set_pin_mode(b->i2c, addr, index, mode == OUTPUT ? MCP23017_OUTPUT : MCP23017_INPUT);
+			if (ret != 0)
+				return ARRAY_MCP23017_SET_PIN_MODE_FAIL;
+			break;
+		case PLC_ADS1015:
+		case PLC_PCA9685:
+		case PLC_LTC2309:
+			break;
+		default:
+			return -1;
+	}
+	return 0;
+}
+
+static int digital_write(plc_context_t* ctx, uint32_t pin, uint8_t value) {
+	int ret = -1;
+	uint8_t peri = pinToPlcTypeEnum(pin);
+	uint8_t addr = pinToI2CAddress(pin);
+	uint8_t index = pinToDeviceIndex(pin);
+
+	if (peri == PLC_DIRECT) {
+		ret = normal_gpio_write(index, value);
+		return ret == 0 ? 0 : NORMAL_GPIO_WRITE_FAIL;
+	}
+
+	struct expanded_bus_t* b = pin_bus(ctx, pin);
+	if (b == NULL) {
+		return I2C_PIN_WITHOUT_I2C_BUS;
+	}
+
+	ret = ensure_device_ready(b, peri, addr);
+	if (ret != 0) {
+		return ret;
+	}
+
+	switch (peri) {
+		case PLC_PCA9685:
+			ret = pca9685_write(b->i2c, addr, index, value);
+			if (ret != 0)
+				return ARRAY_PCA9685_WRITE_FAIL;
+			break;
+		case PLC_MCP23008:
+			ret = mcp23008_write(b->i2c, addr, index, value);
+			if (ret != 0)
+				return ARRAY_MCP23008_WRITE_FAIL;
+			break;
+		case PLC_MCP23017:
+			ret = mcp23017_write(b->i2c, addr, index, value);
+			if (ret != 0)
+				return ARRAY_MCP23017_WRITE_FAIL;
+			break;
+		default:
+			return -1;
+	}
+	return 0;
+}
+
+static int digital_read(plc_context_t* ctx, uint32_t pin) {
+	uint16_t value = 0;
+	int ret = -1;
+
+	uint8_t peri = pinToPlcTypeEnum(pin);
+	uint8_t addr = pinToI2CAddress(pin);
+	uint8_t index = pinToDeviceIndex(pin);
+
+	if (peri == PLC_DIRECT) {
+		ret = normal_gpio_read(index, (uint8_t*) &value);
+		assert(ret == 0);
+		return ret == 0 ? (int) value : 0;
+	}
+
+	struct expanded_bus_t* b = pin_bus(ctx, pin);
+	if (b == NULL) {
+		return I2C_PIN_WITHOUT_I2C_BUS;
+	}
+
+	if (ensure_device_ready(b, peri, addr) != 0) {
+		return 0;
+	}
+
+	assert(b->i2c);
 	switch (peri) {
 		case PLC_MCP23008:
-			ret = mcp23008_set_pin_mode(i2c, addr, index, mode == OUTPUT ? MCP23008_OUTPUT : MCP23008_INPUT);
+			if (debounced_pins(b, addr) & (1 << index)) {
+				ret = read_debounced_pin(b, peri, addr, index, &value);
+			}
+			else {
+				ret = mcp23008_read(b->i2c, addr, index, (uint8_t*) &value);
+			}
+			assert(ret == 0);
+			if (ret != 0)
+				return 0;
+			break;
+		case PLC_LTC2309:
+			ret = ltc2309_read(b->i2c, addr, index, &value);
+			assert(ret == 0);
+			if (ret != 0)
+				return 0;
+			value = value > 1636 ? 1 : 0;
+			break;
+		case PLC_ADS1015:
+			ret = ads1015_unsigned_read(b->i2c, addr, index, &value);
+			assert(ret == 0);
+			if (ret != 0)
+				return 0;
+			value = value > 818 ? 1 : 0;
+			break;
+		case PLC_MCP23017:
+			if (debounced_pins(b, addr) & (1 << index)) {
+				ret = read_debounced_pin(b, peri, addr, index, &value);
+			}
+			else {
+				ret = mcp23017_read(b->i2c, addr, index, (uint8_t*) &value);
+			}
+			assert(ret == 0);
+			if (ret != 0)
+				return 0;
+			break;
+		default:
+			return value;
+	}
+	return value;
+}
+
+static int analog_write(plc_context_t* ctx, uint32_t pin, uint16_t value) {
+	int ret = -1;
+
+	uint8_t peri = pinToPlcTypeEnum(pin);
+	uint8_t addr = pinToI2CAddress(pin);
+	uint8_t index = pinToDeviceIndex(pin);
+
+	if (peri == PLC_DIRECT) {
+	        ret = normal_gpio_pwm_write(index, value);
+	        return ret == 0 ? 0 : NORMAL_GPIO_PWM_WRITE_FAIL;
+        }
+
+	struct expanded_bus_t* b = pin_bus(ctx, pin);
+	if (b == NULL) {
+		return I2C_PIN_WITHOUT_I2C_BUS;
+	}
+
+	int init_ret = ensure_device_ready(b, peri, addr);
+	if (init_ret != 0) {
+		return init_ret;
+	}
+
+
+	if (peri == PLC_PCA9685) {
+		ret = pca9685_pwm_write(b->i2c, addr, index, value);
 			if (ret != 0)
-				return ARRAY_MCP23008_SET_PIN_MODE_FAIL;
+				return ARRAY_PCA9685_PWM_WRITE_FAIL;
+	}
+
+	return ret;
+}
+
+static int analog_write_set_frequency(plc_context_t* ctx, uint32_t pin, uint32_t desired_freq) {
+	int ret = -1;
+
+	uint8_t peri = pinToPlcTypeEnum(pin);
+	uint8_t addr = pinToI2CAddress(pin);
+	uint8_t index = pinToDeviceIndex(pin);
+
+	if (peri == PLC_DIRECT) {
+	        ret = normal_gpio_pwm_frequency(index, desired_freq);
+	        return ret == 0 ? 0 : NORMAL_GPIO_PWM_CHANGE_FREQ_FAIL;
+        }
+
+	struct expanded_bus_t* b = pin_bus(ctx, pin);
+	if (b == NULL) {
+		return I2C_PIN_WITHOUT_I2C_BUS;
+	}
+
+	int init_ret = ensure_device_ready(b, peri, addr);
+	if (init_ret != 0) {
+		return init_ret;
+	}
+
+
+	if (peri == PLC_PCA9685) {
+		assert(desired_freq >= 24 && desired_freq <= 1526);
+		if (desired_freq < 24 || desired_freq > 1526) {
+			errno = ERANGE;
+			return -1;
+		}
+
+		uint64_t prescaler_value = ((((PCA9685_INTERNAL_CLOCK << 4) / (4096 * desired_freq))) >> 4) - 1;
+		if (prescaler_value > 255) {
+			errno = EOVERFLOW;
+			return -1;
+		}
+
+		ret = pca9685_pwm_frequency(b->i2c, addr, prescaler_value);
+		assert(ret == 0);
+		if (ret != 0) {
+			return NORMAL_GPIO_PWM_CHANGE_FREQ_FAIL;
+		}
+	}
+
+	return ret;
+}
+
+static uint16_t analog_read(plc_context_t* ctx, uint32_t pin) {
+	uint16_t value = 0;
+	int ret = -1;
+
+	uint8_t peri = pinToPlcTypeEnum(pin);
+	uint8_t addr = pinToI2CAddress(pin);
+	uint8_t index = pinToDeviceIndex(pin);
+
+	if (peri == PLC_DIRECT) {
+		ret = normal_gpio_analog_read(index, &value);
+		assert(ret == 0);
+		return ret == 0 ? value : 0;
+	}
+
+	struct expanded_bus_t* b = pin_bus(ctx, pin);
+	if (b == NULL) {
+		return I2C_PIN_WITHOUT_I2C_BUS;
+	}
+
+	if (ensure_device_ready(b, peri, addr) != 0) {
+		return 0;
+	}
+
+
+	assert(b->i2c);
+	switch (peri){
+		case PLC_ADS1015:
+			ret = ads1015_unsigned_read(b->i2c, addr, index, &value);
+			assert(ret == 0);
+			if (ret != 0)
+				return 0;
 			break;
-		case PLC_MCP23017:
-			ret = mcp23017_set_pin_mode(i2c, addr, index, mode == OUTPUT ? MCP23017_OUTPUT : MCP23017_INPUT);
+		case PLC_LTC2309:
+			ret = ltc2309_read(b->i2c, addr, index, &value);
+			assert(ret == 0);
 			if (ret != 0)
-				return ARRAY_MCP23017_SET_PIN_MODE_FAIL;
+				return 0;
+			break;
+		default:
+			return value;
+	}
+	return value;
+}
+
+static int digital_write_all(struct expanded_bus_t* b, uint8_t addr, uint32_t values) {
+	int ret = -1;
+
+
+	if (b == NULL) {
+		errno = ENOTSUP;
+		return ret;
+	}
+
+
+	if (isAddressIntoArray(addr, b->peripherals->arrayMCP23008, b->peripherals->numArrayMCP23008) == 0) {
+		ret = ensure_device_ready(b, PLC_MCP23008, addr);
+		if (ret != 0) {
+			return ret;
+		}
+		ret = mcp23008_write_all(b->i2c, addr, values);
+		if (ret != 0) {
+			return ARRAY_MCP23008_WRITE_ALL_FAIL;
+		}
+	}
+
+	else if (isAddressIntoArray(addr, b->peripherals->arrayPCA9685, b->peripherals->numArrayPCA9685) == 0) {
+		ret = ensure_device_ready(b, PLC_PCA9685, addr);
+		if (ret != 0) {
+			return ret;
+		}
+		ret = pca9685_write_all(b->i2c, addr, values);
+		if (ret != 0) {
+			return ARRAY_PCA9685_WRITE_ALL_FAIL;
+		}
+	}
+
+	else if (isAddressIntoArray(addr, b->peripherals->arrayMCP23017, b->peripherals->numArrayMCP23017) == 0) {
+		ret = ensure_device_ready(b, PLC_MCP23017, addr);
+		if (ret != 0) {
+			return ret;
+		}
+		ret = mcp23017_write_all(b->i2c, addr, values);
+		if (ret != 0) {
+			return ARRAY_MCP23017_WRITE_ALL_FAIL;
+		}
+	}
+
+	return ret;
+}
+
+static int digital_read_all(struct expanded_bus_t* b, uint8_t addr, void* values) {
+	int ret = -1;
+
+
+	if (b == NULL) {
+		errno = ENOTSUP;
+		return ret;
+	}
+
+
+	if (isAddressIntoArray(addr, b->peripherals->arrayMCP23008, b->peripherals->numArrayMCP23008) == 0) {
+		ret = ensure_device_ready(b, PLC_MCP23008, addr);
+		if (ret != 0) {
+			return ret;
+		}
+		uint16_t levels;
+		ret = read_expander_inputs(b, PLC_MCP23008, addr, &levels);
+		if (ret != 0) {
+			return ARRAY_MCP23008_READ_ALL_FAIL;
+		}
+		*(uint8_t*) values = levels;
+	}
+
+	else if (isAddressIntoArray(addr, b->peripherals->arrayMCP23017, b->peripherals->numArrayMCP23017) == 0) {
+		ret = ensure_device_ready(b, PLC_MCP23017, addr);
+		if (ret != 0) {
+			return ret;
+		}
+		ret = read_expander_inputs(b, PLC_MCP23017, addr, (uint16_t*) values);
+		if (ret != 0) {
+			return ARRAY_MCP23017_READ_ALL_FAIL;
+		}
+	}
+
+	return ret;
+}
+
+static int analog_write_all(struct expanded_bus_t* b, uint8_t addr, const void* values) {
+	int ret = -1;
+
+
+	if (b == NULL) {
+		errno = ENOTSUP;
+		return ret;
+	}
+
+
+	if (isAddressIntoArray(addr, b->peripherals->arrayPCA9685, b->peripherals->numArrayPCA9685) == 0) {
+		ret = ensure_device_ready(b, PLC_PCA9685, addr);
+		if (ret != 0) {
+			return ret;
+		}
+		ret = pca9685_pwm_write_all(b->i2c, addr, (uint16_t*) values);
+		if (ret != 0) {
+			return ARRAY_PCA9685_PWM_WRITE_ALL_FAIL;
+		}
+	}
+
+	return ret;
+}
+
+static int digital_write_all_direct(uint64_t mask, uint64_t values) {
+	if (normal_gpio_write_all) {
+		return normal_gpio_write_all(mask, values) == 0 ? 0 : NORMAL_GPIO_WRITE_ALL_FAIL;
+	}
+
+	while (mask) {
+		const int index = __builtin_ctzll(mask);
+		mask &= mask - 1;
+
+		if (normal_gpio_write(index, (values >> index) & 1) != 0) {
+			return NORMAL_GPIO_WRITE_ALL_FAIL;
+		}
+	}
+	return 0;
+}
+
+static int digital_read_all_direct(uint64_t mask, uint64_t* values) {
+	if (values == NULL) {
+		errno = EFAULT;
+		return NORMAL_GPIO_READ_ALL_FAIL;
+	}
+
+	if (normal_gpio_read_all) {
+		if (normal_gpio_read_all(mask, values) != 0) {
+			return NORMAL_GPIO_READ_ALL_FAIL;
+		}
+		*values &= mask;
+		return 0;
+	}
+
+	uint64_t result = 0;
+	while (mask) {
+		const int index = __builtin_ctzll(mask);
+		mask &= mask - 1;
+
+		uint8_t value;
+		if (normal_gpio_read(index, &value) != 0) {
+			return NORMAL_GPIO_READ_ALL_FAIL;
+		}
+		if (value) {
+			result |= 1ULL << index;
+		}
+	}
+
+	*values = result;
+	return 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Input change events
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+#define INPUT_EVENTS_MAX_SUBSCRIPTIONS 64
+#define INPUT_EVENTS_MAX_INTERRUPT_LINES 16
+#define INPUT_EVENTS_QUEUE_SIZE 256
+#define INPUT_EVENTS_DEFAULT_PERIOD_MS 10
+
+struct input_subscription_t {
+	uint32_t pin;
+	uint16_t threshold; // Only for analog pins
+	uint16_t hysteresis; // Only for analog pins
+	uint8_t level; // Last level reported
+};
+
+struct interrupt_line_t {
+	uint8_t addr;
+	int fd;
+};
+
+/*
+ * Lock order: subs_lock, then the bus locks, then queue_lock. The monitor
+ * holds subs_lock while it samples the inputs, but never while it sleeps.
+ * The interrupt lines are only supported for the expanders of slot 0.
+ */
+static struct {
+	pthread_mutex_t subs_lock;
+	pthread_mutex_t queue_lock;
+	pthread_t thread;
+	bool running;
+	bool stop;
+	int error; // Error that stopped the monitor, under both locks. 0 while it runs
+	int event_fd; // Readable while there are queued events, or once the monitor has stopped on an error
+	int wake_fd; // Wakes the monitor up when the subscriptions change
+	uint32_t period_ms;
+
+	struct input_subscription_t subs[INPUT_EVENTS_MAX_SUBSCRIPTIONS];
+	size_t num_subs;
+	struct interrupt_line_t lines[INPUT_EVENTS_MAX_INTERRUPT_LINES];
+	size_t num_lines;
+
+	input_event_t queue[INPUT_EVENTS_QUEUE_SIZE];
+	size_t queue_head;
+	size_t queue_count;
+} input_events = {
+	.subs_lock = PTHREAD_MUTEX_INITIALIZER,
+	.queue_lock = PTHREAD_MUTEX_INITIALIZER,
+	.event_fd = -1,
+	.wake_fd = -1,
+	.period_ms = INPUT_EVENTS_DEFAULT_PERIOD_MS
+};
+
+/**
+ * @brief Tells whether a pin is read through an ADC.
+ */
+static inline bool is_analog_pin(uint32_t pin) {
+	const uint8_t peri = pinToPlcTypeEnum(pin);
+	return peri == PLC_ADS1015 || peri == PLC_LTC2309;
+}
+
+/**
+ * @brief Tells whether an expander has an interrupt line attached.
+ */
+static bool has_interrupt_line(const struct expanded_bus_t* b, uint8_t addr) {
+	if (b != &default_context.buses[0]) {
+		return false;
+	}
+	for (size_t i = 0; i < input_events.num_lines; i++) {
+		if (input_events.lines[i].addr == addr) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Reads the interrupt registers of a GPIO expander, clearing the interrupt.
+ *
+ * @param b Pointer to the bus of the device.
+ * @param peri The type of the peripheral.
+ * @param addr The I2C address of the device.
+ * @param flags Pointer where the pins that fired will be stored.
+ * @param captured Pointer where the captured level of the pins will be stored.
+ * @return 0 on success, -1 on failure.
+ */
+static int read_expander_interrupt(struct expanded_bus_t* b, uint8_t peri, uint8_t addr, uint16_t* flags, uint16_t* captured) {
+	if (peri == PLC_MCP23008) {
+		uint8_t flags8, captured8;
+		if (mcp23008_read_interrupt(b->i2c, addr, &flags8, &captured8) != 0) {
+			return -1;
+		}
+		*flags = flags8;
+		*captured = captured8;
+		return 0;
+	}
+	else if (peri == PLC_MCP23017) {
+		return mcp23017_read_interrupt(b->i2c, addr, flags, captured);
+	}
+
+	errno = EINVAL;
+	return -1;
+}
+
+/**
+ * @brief Enables or disables the interrupt-on-change of an expander pin.
+ *
+ * @param pin The pin number.
+ * @param enable True to enable the interrupt.
+ * @return 0 on success, -1 on failure.
+ */
+static int set_expander_interrupt(uint32_t pin, bool enable) {
+	const uint8_t peri = pinToPlcTypeEnum(pin);
+	const uint8_t addr = pinToI2CAddress(pin);
+	const uint8_t index = pinToDeviceIndex(pin);
+	struct expanded_bus_t* b = pin_bus(&default_context, pin);
+
+	if (b == NULL) {
+		errno = ENODEV;
+		return -1;
+	}
+	if (ensure_device_ready(b, peri, addr) != 0) {
+		return -1;
+	}
+	if (peri == PLC_MCP23008) {
+		return mcp23008_set_interrupt(b->i2c, addr, index, enable ? MCP23008_INT_ON_CHANGE : MCP23008_INT_DISABLED);
+	}
+	else if (peri == PLC_MCP23017) {
+		return mcp23017_set_interrupt(b->i2c, addr, index, enable ? MCP23017_INT_ON_CHANGE : MCP23017_INT_DISABLED);
+	}
+
+	errno = EINVAL;
+	return -1;
+}
+
+/**
+ * @brief Reads the level of an analog subscription, applying its threshold and hysteresis.
+ *
+ * @param sub Pointer to the subscription.
+ * @param level Pointer where the new level will be stored.
+ * @param analog Pointer where the ADC reading will be stored.
+ * @return 0 on success, -1 on failure.
+ */
+static int read_analog_level(const struct input_subscription_t* sub, uint8_t* level, uint16_t* analog) {
+	const uint8_t peri = pinToPlcTypeEnum(sub->pin);
+	const uint8_t addr = pinToI2CAddress(sub->pin);
+	const uint8_t index = pinToDeviceIndex(sub->pin);
+	struct expanded_bus_t* b = pin_bus(&default_context, sub->pin);
+
+	if (b == NULL) {
+		errno = ENODEV;
+		return -1;
+	}
+	if (ensure_device_ready(b, peri, addr) != 0) {
+		return -1;
+	}
+
+	int ret = peri == PLC_ADS1015 ? ads1015_unsigned_read(b->i2c, addr, index, analog) : ltc2309_read(b->i2c, addr, index, analog);
+	if (ret != 0) {
+		return -1;
+	}
+
+	// High at or above the threshold, low again below threshold - hysteresis
+	if (*analog >= sub->threshold) {
+		*level = 1;
+	}
+	else if (*analog + sub->hysteresis < sub->threshold) {
+		*level = 0;
+	}
+	else {
+		*level = sub->level;
+	}
+	return 0;
+}
+
+/**
+ * @brief Adds an event to the queue, discarding the oldest one if it is full.
+ *
+ * @param event Pointer to the event.
+ */
+static void queue_event(const input_event_t* event) {
+	pthread_mutex_lock(&input_events.queue_lock);
+	if (input_events.queue_count == INPUT_EVENTS_QUEUE_SIZE) {
+		input_events.queue_head = (input_events.queue_head + 1) % INPUT_EVENTS_QUEUE_SIZE;
+		input_events.queue_count--;
+	}
+	const size_t tail = (input_events.queue_head + input_events.queue_count) % INPUT_EVENTS_QUEUE_SIZE;
+	input_events.queue[tail] = *event;
+	input_events.queue_count++;
+	pthread_mutex_unlock(&input_events.queue_lock);
+
+	const uint64_t one = 1;
+	if (write(input_events.event_fd, &one, sizeof(one)) < 0) {
+		// The counter can't overflow in practice, and the event is queued anyway
+	}
+}
+
+/**
+ * @brief Reports the change of a subscription, if its level is different.
+ */
+static void report_level(struct input_subscription_t* sub, uint8_t level, uint16_t analog, uint64_t timestamp_ns) {
+	if (level == sub->level) {
+		return;
+	}
+	sub->level = level;
+
+	const input_event_t event = {
+		.timestamp_ns = timestamp_ns,
+		.pin = sub->pin,
+		.value = level,
+		.analog = analog
+	};
+	queue_event(&event);
+}
+
+/**
+ * @brief Samples the subscribed inputs and queues their changes.
+ *
+ * Each expander is read once, however many of its pins are subscribed. The
+ * expanders with an interrupt line are only read when it fired: first the
+ * captured values (so a short pulse is not lost), and then the current ones.
+ *
+ * @param fired Addresses of the expanders whose interrupt line fired.
+ * @param fired_ns Timestamps of the interrupts.
+ * @param num_fired Number of expanders in "fired".
+ * @param poll_due True if the polled inputs must be sampled.
+ */
+static void sample_inputs(const uint8_t* fired, const uint64_t* fired_ns, size_t num_fired, bool poll_due) {
+	bool done[INPUT_EVENTS_MAX_SUBSCRIPTIONS] = {false};
+
+	lock_all_buses(&default_context);
+	for (size_t i = 0; i < input_events.num_subs; i++) {
+		struct input_subscription_t* sub = &input_events.subs[i];
+		if (done[i]) {
+			continue;
+		}
+
+		if (is_analog_pin(sub->pin)) {
+			uint8_t level;
+			uint16_t analog;
+			if (poll_due && read_analog_level(sub, &level, &analog) == 0) {
+				report_level(sub, level, analog, monotonic_ns());
+			}
+			done[i] = true;
+			continue;
+		}
+
+		const uint8_t peri = pinToPlcTypeEnum(sub->pin);
+		const uint8_t addr = pinToI2CAddress(sub->pin);
+		struct expanded_bus_t* b = pin_bus(&default_context, sub->pin);
+		if (b == NULL) {
+			done[i] = true;
+			continue;
+		}
+
+		uint64_t timestamp_ns = 0;
+		bool sample = false;
+		uint16_t flags = 0, captured = 0;
+		if (has_interrupt_line(b, addr)) {
+			for (size_t f = 0; f < num_fired; f++) {
+				if (fired[f] == addr) {
+					sample = true;
+					timestamp_ns = fired_ns[f];
+					break;
+				}
+			}
+			if (sample && read_expander_interrupt(b, peri, addr, &flags, &captured) != 0) {
+				flags = 0;
+			}
+
+			// The debounce filter needs samples after the last edge too
+			sample = sample || (poll_due && debounced_pins(b, addr) != 0);
+		}
+		else {
+			sample = poll_due;
+		}
+
+		uint16_t levels;
+		if (!sample || ensure_device_ready(b, peri, addr) != 0 || read_expander_inputs(b, peri, addr, &levels) != 0) {
+			continue;
+		}
+		if (timestamp_ns == 0) {
+			timestamp_ns = monotonic_ns();
+		}
+
+		// All the subscriptions of the same expander are served by this read
+		for (size_t j = i; j < input_events.num_subs; j++) {
+			struct input_subscription_t* other = &input_events.subs[j];
+			if (done[j] || is_analog_pin(other->pin) || pinToI2CAddress(other->pin) != addr || pin_bus(&default_context, other->pin) != b) {
+				continue;
+			}
+
+			const uint8_t index = pinToDeviceIndex(other->pin);
+			if (flags & ~debounced_pins(b, addr) & (1 << index)) {
+				report_level(other, (captured >> index) & 1, 0, timestamp_ns);
+			}
+			report_level(other, (levels >> index) & 1, 0, timestamp_ns);
+			done[j] = true;
+		}
+	}
+	unlock_all_buses(&default_context);
+}
+
+/**
+ * @brief Records the error that stops the monitor thread.
+ *
+ * The thread is no longer running, so the next subscription starts it again.
+ * The event descriptor is left readable, so the application wakes up and
+ * readInputEvents reports the error once the queue is drained.
+ *
+ * @param error The errno of the failure.
+ */
+static void stop_monitor_on_error(int error) {
+	pthread_mutex_lock(&input_events.subs_lock);
+	pthread_mutex_lock(&input_events.queue_lock);
+	input_events.error = error;
+	input_events.running = false;
+	const uint64_t one = 1;
+	if (write(input_events.event_fd, &one, sizeof(one)) < 0) {
+		// The counter can't overflow in practice
+	}
+	pthread_mutex_unlock(&input_events.queue_lock);
+	pthread_mutex_unlock(&input_events.subs_lock);
+}
+
+/**
+ * @brief Waits for a monitor thread that stopped on an error and clears the error.
+ *
+ * It must be called with subs_lock held.
+ */
+static void reap_failed_monitor(void) {
+	if (input_events.running || input_events.error == 0) {
+		return;
+	}
+
+	// The thread only had to return after recording the error
+	pthread_join(input_events.thread, NULL);
+	pthread_mutex_lock(&input_events.queue_lock);
+	input_events.error = 0;
+	pthread_mutex_unlock(&input_events.queue_lock);
+}
+
+/**
+ * @brief Body of the input monitor thread.
+ */
+static void* input_monitor(void* arg) {
+	(void) arg;
+
+	uint64_t next_poll_ns = monotonic_ns();
+	while (true) {
+		struct pollfd fds[1 + INPUT_EVENTS_MAX_INTERRUPT_LINES];
+		uint8_t line_addrs[INPUT_EVENTS_MAX_INTERRUPT_LINES];
+		bool must_poll = false;
+
+		pthread_mutex_lock(&input_events.subs_lock);
+		if (input_events.stop) {
+			pthread_mutex_unlock(&input_events.subs_lock);
 			break;
-		case PLC_ADS1015:
-		case PLC_PCA9685:
-		case PLC_LTC2309:
+		}
+		fds[0] = (struct pollfd) {.fd = input_events.wake_fd, .events = POLLIN};
+		const size_t num_lines = input_events.num_lines;
+		for (size_t i = 0; i < num_lines; i++) {
+			fds[1 + i] = (struct pollfd) {.fd = input_events.lines[i].fd, .events = POLLIN};
+			line_addrs[i] = input_events.lines[i].addr;
+		}
+		lock_all_buses(&default_context);
+		for (size_t i = 0; i < input_events.num_subs && !must_poll; i++) {
+			const uint32_t pin = input_events.subs[i].pin;
+			const uint8_t addr = pinToI2CAddress(pin);
+			struct expanded_bus_t* b = pin_bus(&default_context, pin);
+			must_poll = b != NULL && (is_analog_pin(pin) || !has_interrupt_line(b, addr) || debounced_pins(b, addr) != 0);
+		}
+		unlock_all_buses(&default_context);
+		const uint32_t period_ms = input_events.period_ms;
+		pthread_mutex_unlock(&input_events.subs_lock);
+
+		int timeout_ms = -1;
+		if (must_poll) {
+			const uint64_t now_ns = monotonic_ns();
+			timeout_ms = next_poll_ns > now_ns ? (int) ((next_poll_ns - now_ns + 999999) / 1000000) : 0;
+		}
+
+		int ret = poll(fds, 1 + num_lines, timeout_ms);
+		if (ret < 0 && errno != EINTR) {
+			stop_monitor_on_error(errno);
 			break;
-		default:
+		}
+
+		uint64_t counter;
+		if ((fds[0].revents & POLLIN) && read(input_events.wake_fd, &counter, sizeof(counter)) < 0) {
+			// Nothing to do, it only wakes the thread up
+		}
+
+		uint8_t fired[INPUT_EVENTS_MAX_INTERRUPT_LINES];
+		uint64_t fired_ns[INPUT_EVENTS_MAX_INTERRUPT_LINES];
+		size_t num_fired = 0;
+		for (size_t i = 0; i < num_lines; i++) {
+			if (!(fds[1 + i].revents & POLLIN)) {
+				continue;
+			}
+			gpio_chardev_edge_t edge;
+			fired_ns[num_fired] = 0;
+			while (gpio_chardev_read_edge(fds[1 + i].fd, 0, &edge) == 0) {
+				if (fired_ns[num_fired] == 0) {
+					fired_ns[num_fired] = edge.timestamp_ns;
+				}
+			}
+			fired[num_fired++] = line_addrs[i];
+		}
+
+		const uint64_t now_ns = monotonic_ns();
+		const bool poll_due = must_poll && now_ns >= next_poll_ns;
+		if (poll_due) {
+			next_poll_ns += (uint64_t) period_ms * 1000000ULL;
+			if (next_poll_ns < now_ns) {
+				// Overrun, don't try to catch up
+				next_poll_ns = now_ns + (uint64_t) period_ms * 1000000ULL;
+			}
+		}
+
+		if (num_fired > 0 || poll_due) {
+			pthread_mutex_lock(&input_events.subs_lock);
+			sample_inputs(fired, fired_ns, num_fired, poll_due);
+			pthread_mutex_unlock(&input_events.subs_lock);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Creates the event file descriptors, if they don't exist yet.
+ *
+ * @return 0 on success, -1 on failure (errno is set by "eventfd").
+ */
+static int create_event_fds(void) {
+	if (input_events.event_fd < 0) {
+		input_events.event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (input_events.event_fd < 0) {
+			return -1;
+		}
+	}
+	if (input_events.wake_fd < 0) {
+		input_events.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (input_events.wake_fd < 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Wakes the monitor thread up, so it picks the new subscriptions.
+ */
+static void wake_monitor(void) {
+	const uint64_t one = 1;
+	if (input_events.wake_fd >= 0 && write(input_events.wake_fd, &one, sizeof(one)) < 0) {
+		// The counter can't overflow in practice
+	}
+}
+
+/**
+ * @brief Stops the monitor thread and forgets all the subscriptions.
+ *
+ * The event file descriptor is kept, so the application can keep polling it.
+ */
+static void stop_input_monitor(void) {
+	pthread_mutex_lock(&input_events.subs_lock);
+	const bool running = input_events.running;
+	input_events.stop = true;
+	pthread_mutex_unlock(&input_events.subs_lock);
+
+	if (running) {
+		wake_monitor();
+		pthread_join(input_events.thread, NULL);
+	}
+
+	pthread_mutex_lock(&input_events.subs_lock);
+	for (size_t i = 0; i < input_events.num_lines; i++) {
+		gpio_chardev_release(input_events.lines[i].fd);
+	}
+	input_events.num_lines = 0;
+	input_events.num_subs = 0;
+	input_events.running = false;
+	input_events.stop = false;
+	reap_failed_monitor();
+	pthread_mutex_unlock(&input_events.subs_lock);
+}
+
+/**
+ * @brief Starts the monitor thread, if it isn't running.
+ *
+ * It must be called with subs_lock held. A thread that stopped on an error
+ * is reaped first, so its error is cleared.
+ *
+ * @return 0 on success, -1 on failure (errno is set by "pthread_create").
+ */
+static int start_input_monitor(void) {
+	if (input_events.running) {
+		return 0;
+	}
+
+	reap_failed_monitor();
+	int ret = pthread_create(&input_events.thread, NULL, input_monitor, NULL);
+	if (ret != 0) {
+		errno = ret;
+		return -1;
+	}
+	input_events.running = true;
+	return 0;
+}
+
+int inputEventFd(void) {
+	pthread_mutex_lock(&input_events.subs_lock);
+	int ret = create_event_fds();
+	if (ret == 0) {
+		ret = input_events.event_fd;
+	}
+	pthread_mutex_unlock(&input_events.subs_lock);
+	return ret;
+}
+
+int subscribeInput(uint32_t pin, uint16_t threshold, uint16_t hysteresis) {
+	const uint8_t peri = pinToPlcTypeEnum(pin);
+	if (peri != PLC_MCP23008 && peri != PLC_MCP23017 && !is_analog_pin(pin)) {
+		errno = ENOTSUP;
+		return -1;
+	}
+	struct expanded_bus_t* b = pin_bus(&default_context, pin);
+	if (b == NULL) {
+		return I2C_PIN_WITHOUT_I2C_BUS;
+	}
+
+	int ret = -1;
+	pthread_mutex_lock(&input_events.subs_lock);
+
+	for (size_t i = 0; i < input_events.num_subs; i++) {
+		if (input_events.subs[i].pin == pin) {
+			// Only the threshold can be updated
+			input_events.subs[i].threshold = threshold;
+			input_events.subs[i].hysteresis = hysteresis;
+			ret = start_input_monitor();
+			goto out;
+		}
+	}
+	if (input_events.num_subs == INPUT_EVENTS_MAX_SUBSCRIPTIONS) {
+		errno = ENOSPC;
+		goto out;
+	}
+	if (create_event_fds() != 0) {
+		goto out;
+	}
+
+	struct input_subscription_t sub = {
+		.pin = pin,
+		.threshold = threshold,
+		.hysteresis = hysteresis,
+		.level = 0
+	};
+
+	// The current level is the reference for the first event
+	LOCK_BUS(b);
+	if (b->i2c == NULL) {
+		errno = ENODEV;
+	}
+	else if (is_analog_pin(pin)) {
+		uint16_t analog;
+		ret = read_analog_level(&sub, &sub.level, &analog);
+	}
+	else {
+		uint16_t levels = 0;
+		ret = ensure_device_ready(b, peri, pinToI2CAddress(pin)) == 0 ? read_expander_inputs(b, peri, pinToI2CAddress(pin), &levels) : -1;
+		if (ret == 0) {
+			sub.level = (levels >> pinToDeviceIndex(pin)) & 1;
+			if (has_interrupt_line(b, pinToI2CAddress(pin))) {
+				ret = set_expander_interrupt(pin, true);
+			}
+		}
+	}
+	UNLOCK_BUS(b);
+	if (ret != 0) {
+		goto out;
+	}
+
+	input_events.subs[input_events.num_subs++] = sub;
+
+	ret = start_input_monitor();
+	if (ret != 0) {
+		input_events.num_subs--;
+		if (!is_analog_pin(pin) && has_interrupt_line(b, pinToI2CAddress(pin))) {
+			// Best effort: leave the interrupt of the expander as it was
+			LOCK_BUS(b);
+			set_expander_interrupt(pin, false);
+			UNLOCK_BUS(b);
+		}
+		goto out;
+	}
+	wake_monitor();
+
+out:
+	pthread_mutex_unlock(&input_events.subs_lock);
+	return ret;
+}
+
+int unsubscribeInput(uint32_t pin) {
+	int ret = -1;
+	errno = ENOENT;
+
+	pthread_mutex_lock(&input_events.subs_lock);
+	for (size_t i = 0; i < input_events.num_subs; i++) {
+		if (input_events.subs[i].pin != pin) {
+			continue;
+		}
+
+		input_events.subs[i] = input_events.subs[--input_events.num_subs];
+		ret = 0;
+		struct expanded_bus_t* b = pin_bus(&default_context, pin);
+		if (!is_analog_pin(pin) && b != NULL && has_interrupt_line(b, pinToI2CAddress(pin))) {
+			LOCK_BUS(b);
+			ret = set_expander_interrupt(pin, false);
+			UNLOCK_BUS(b);
+		}
+		wake_monitor();
+		break;
+	}
+	pthread_mutex_unlock(&input_events.subs_lock);
+
+	return ret;
+}
+
+int attachInputInterruptLine(uint8_t addr, const char* chip, uint32_t line) {
+	struct expanded_bus_t* b = slot_bus(&default_context, 0);
+	if (b == NULL ||
+	    (isAddressIntoArray(addr, ARRAY_MCP23008, NUM_ARRAY_MCP23008) != 0 &&
+	     isAddressIntoArray(addr, ARRAY_MCP23017, NUM_ARRAY_MCP23017) != 0)) {
+		errno = ENODEV;
+		return -1;
+	}
+
+	int ret = -1;
+	pthread_mutex_lock(&input_events.subs_lock);
+
+	if (input_events.num_lines == INPUT_EVENTS_MAX_INTERRUPT_LINES) {
+		errno = ENOSPC;
+		goto out;
+	}
+
+	// INT is open-drain and active-low
+	int fd = gpio_chardev_request_inputs(chip, &line, 1, GPIO_CHARDEV_ACTIVE_LOW | GPIO_CHARDEV_EDGE_RISING, NULL);
+	if (fd < 0) {
+		goto out;
+	}
+
+	// The subscribed pins of the expander must fire the interrupt
+	ret = 0;
+	LOCK_BUS(b);
+	for (size_t i = 0; i < input_events.num_subs && ret == 0; i++) {
+		const uint32_t pin = input_events.subs[i].pin;
+		if (!is_analog_pin(pin) && pinToI2CAddress(pin) == addr && pin_bus(&default_context, pin) == b) {
+			ret = set_expander_interrupt(pin, true);
+		}
+	}
+	UNLOCK_BUS(b);
+	if (ret != 0) {
+		gpio_chardev_release(fd);
+		goto out;
+	}
+
+	input_events.lines[input_events.num_lines++] = (struct interrupt_line_t) {
+		.addr = addr,
+		.fd = fd
+	};
+	wake_monitor();
+
+out:
+	pthread_mutex_unlock(&input_events.subs_lock);
+	return ret;
+}
+
+int setInputEventPeriod(uint32_t period_ms) {
+	if (period_ms == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&input_events.subs_lock);
+	input_events.period_ms = period_ms;
+	wake_monitor();
+	pthread_mutex_unlock(&input_events.subs_lock);
+
+	return 0;
+}
+
+size_t readInputEvents(input_event_t* events, size_t max_events) {
+	if (events == NULL) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&input_events.queue_lock);
+	size_t num = 0;
+	while (num < max_events && input_events.queue_count > 0) {
+		events[num++] = input_events.queue[input_events.queue_head];
+		input_events.queue_head = (input_events.queue_head + 1) % INPUT_EVENTS_QUEUE_SIZE;
+		input_events.queue_count--;
+	}
+
+	// The descriptor stays readable while events remain queued, or the monitor is stopped
+	uint64_t counter;
+	if (input_events.queue_count == 0 && input_events.error != 0) {
+		errno = EPIPE;
+	}
+	else if (input_events.queue_count == 0 && input_events.event_fd >= 0 &&
+	         read(input_events.event_fd, &counter, sizeof(counter)) < 0) {
+		// Already drained
+	}
+	pthread_mutex_unlock(&input_events.queue_lock);
+
+	return num;
+}
+
+int inputEventsError(void) {
+	pthread_mutex_lock(&input_events.queue_lock);
+	const int error = input_events.error;
+	pthread_mutex_unlock(&input_events.queue_lock);
+	return error;
+}
+#else
+static inline void stop_input_monitor(void) {
+}
+
+int inputEventFd(void) {
+	errno = ENOTSUP;
+	return -1;
+}
+
+int subscribeInput(uint32_t pin, uint16_t threshold, uint16_t hysteresis) {
+	(void) pin;
+	(void) threshold;
+	(void) hysteresis;
+	errno = ENOTSUP;
+	return -1;
+}
+
+int unsubscribeInput(uint32_t pin) {
+	(void) pin;
+	errno = ENOTSUP;
+	return -1;
+}
+
+int attachInputInterruptLine(uint8_t addr, const char* chip, uint32_t line) {
+	(void) addr;
+	(void) chip;
+	(void) line;
+	errno = ENOTSUP;
+	return -1;
+}
+
+int setInputEventPeriod(uint32_t period_ms) {
+	(void) period_ms;
+	errno = ENOTSUP;
+	return -1;
+}
+
+size_t readInputEvents(input_event_t* events, size_t max_events) {
+	(void) events;
+	(void) max_events;
+	return 0;
+}
+
+int inputEventsError(void) {
+	return 0;
+}
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Batches of operations on several buses
+struct batch_t {
+	void* ops;
+	size_t num_ops;
+};
+
+/**
+ * @brief Runs the write operations of a batch whose devices are on a bus.
+ *
+ * @param b Pointer to the bus.
+ * @param arg Pointer to the struct batch_t of the batch.
+ * @return 0 if all of them succeeded, the result of the first failure otherwise.
+ */
+static int write_all_batch_bus(struct expanded_bus_t* b, void* arg) {
+	const struct batch_t* batch = arg;
+	expanded_gpio_write_all_t* ops = batch->ops;
+	const uint8_t slot = b - b->ctx->buses;
+
+	int ret = 0;
+	for (size_t i = 0; i < batch->num_ops; i++) {
+		if (pinToBusSlot(ops[i].device) != slot) {
+			continue;
+		}
+		ops[i].result = digital_write_all(b, pinToI2CAddress(ops[i].device), ops[i].values);
+		if (ret == 0) {
+			ret = ops[i].result;
+		}
+	}
+	return ret;
+}
+
+/**
+ * @brief Runs the read operations of a batch whose devices are on a bus.
+ *
+ * @param b Pointer to the bus.
+ * @param arg Pointer to the struct batch_t of the batch.
+ * @return 0 if all of them succeeded, the result of the first failure otherwise.
+ */
+static int read_all_batch_bus(struct expanded_bus_t* b, void* arg) {
+	const struct batch_t* batch = arg;
+	expanded_gpio_read_all_t* ops = batch->ops;
+	const uint8_t slot = b - b->ctx->buses;
+
+	int ret = 0;
+	for (size_t i = 0; i < batch->num_ops; i++) {
+		if (pinToBusSlot(ops[i].device) != slot) {
+			continue;
+		}
+
+		// An MCP23008 only fills the low byte
+		ops[i].values = 0;
+		ops[i].result = digital_read_all(b, pinToI2CAddress(ops[i].device), &ops[i].values);
+		if (ret == 0) {
+			ret = ops[i].result;
+		}
+	}
+	return ret;
+}
+
+static int digital_write_all_batch(plc_context_t* ctx, expanded_gpio_write_all_t* ops, size_t num_ops) {
+	if (ops == NULL && num_ops > 0) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	// The operations on a slot without bus are not run by any job
+	for (size_t i = 0; i < num_ops; i++) {
+		ops[i].result = pin_bus(ctx, ops[i].device) == NULL ? I2C_PIN_WITHOUT_I2C_BUS : 0;
+	}
+
+	struct batch_t batch = {ops, num_ops};
+	run_on_buses(ctx, write_all_batch_bus, &batch);
+
+	for (size_t i = 0; i < num_ops; i++) {
+		if (ops[i].result != 0) {
+			return ops[i].result;
+		}
+	}
+	return 0;
+}
+
+static int digital_read_all_batch(plc_context_t* ctx, expanded_gpio_read_all_t* ops, size_t num_ops) {
+	if (ops == NULL && num_ops > 0) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	// The operations on a slot without bus are not run by any job
+	for (size_t i = 0; i < num_ops; i++) {
+		ops[i].result = pin_bus(ctx, ops[i].device) == NULL ? I2C_PIN_WITHOUT_I2C_BUS : 0;
+	}
+
+	struct batch_t batch = {ops, num_ops};
+	run_on_buses(ctx, read_all_batch_bus, &batch);
+
+	for (size_t i = 0; i < num_ops; i++) {
+		if (ops[i].result != 0) {
+			return ops[i].result;
+		}
+	}
+	return 0;
+}
+
+static int set_expanded_gpio_bus(plc_context_t* ctx, uint8_t slot, int bus, const struct peripherals_t* peripherals) {
+	if (slot == 0 || slot >= EXPANDED_GPIO_MAX_BUSES) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (peripherals != NULL && (bus < 0 || !valid_peripherals(peripherals))) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		if (ctx->buses[i].i2c != NULL) {
+			errno = EBUSY;
+			return -1;
+		}
+		// Two slots on the same bus would not be serialized with each other
+		if (peripherals != NULL && i != slot && slot_bus(ctx, i) != NULL && bus_number(&ctx->buses[i]) == bus) {
+			errno = EINVAL;
 			return -1;
+		}
 	}
+
+	ctx->buses[slot].bus = peripherals != NULL ? bus : PERIPHERALS_NO_I2C_BUS;
+	ctx->buses[slot].peripherals = peripherals;
 	return 0;
 }
 
-int digitalWrite(uint32_t pin, uint8_t value) {
-	int ret = -1;
-	uint8_t peri = pinToPlcTypeEnum(pin);
-	uint8_t addr = pinToI2CAddress(pin);
-	uint8_t index = pinToDeviceIndex(pin);
 
-	if (peri == PLC_DIRECT) {
-		ret = normal_gpio_write(index, value);
-		return ret == 0 ? 0 : NORMAL_GPIO_WRITE_FAIL;
-	}
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Contexts
+plc_context_t* plcDefaultContext(void) {
+	return &default_context;
+}
 
-	else if (I2C_BUS == PERIPHERALS_NO_I2C_BUS) {
-		return I2C_PIN_WITHOUT_I2C_BUS;
+plc_context_t* plcContextCreate(const plc_context_config_t* config) {
+	if (config == NULL || config->peripherals == NULL || !valid_peripherals(config->peripherals)) {
+		errno = EINVAL;
+		return NULL;
 	}
 
-	switch (peri) {
-		case PLC_PCA9685:
-			ret = pca9685_write(i2c, addr, index, value);
-			if (ret != 0)
-				return ARRAY_PCA9685_WRITE_FAIL;
-			break;
-		case PLC_MCP23008:
-			ret = mcp23008_write(i2c, addr, index, value);
-			if (ret != 0)
-				return ARRAY_MCP23008_WRITE_FAIL;
-			break;
-		case PLC_MCP23017:
-			ret = mcp23017_write(i2c, addr, index, value);
-			if (ret != 0)
-				return ARRAY_MCP23017_WRITE_FAIL;
-			break;
-		default:
-			return -1;
+	plc_context_t* ctx = calloc(1, sizeof(plc_context_t));
+	if (ctx == NULL) {
+		return NULL;
 	}
-	return 0;
-}
 
-int digitalRead(uint32_t pin) {
-	uint16_t value = 0;
-	int ret = -1;
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		struct expanded_bus_t* b = &ctx->buses[i];
+		b->ctx = ctx;
+		b->bus = PERIPHERALS_NO_I2C_BUS;
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+		pthread_mutex_init(&b->lock, NULL);
+		pthread_mutex_init(&b->worker.lock, NULL);
+		pthread_cond_init(&b->worker.cond, NULL);
+#endif
+	}
+	ctx->buses[0].bus = config->bus;
+	ctx->buses[0].peripherals = config->peripherals;
 
-	uint8_t peri = pinToPlcTypeEnum(pin);
-	uint8_t addr = pinToI2CAddress(pin);
-	uint8_t index = pinToDeviceIndex(pin);
+	return ctx;
+}
 
-	if (peri == PLC_DIRECT) {
-		ret = normal_gpio_read(index, (uint8_t*) &value);
-		assert(ret == 0);
-		return ret == 0 ? (int) value : 0;
+int plcContextDestroy(plc_context_t** ctx) {
+	if (ctx == NULL || *ctx == NULL || *ctx == &default_context) {
+		errno = EINVAL;
+		return -1;
 	}
 
-	else if (I2C_BUS == PERIPHERALS_NO_I2C_BUS) {
-		return I2C_PIN_WITHOUT_I2C_BUS;
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		if ((*ctx)->buses[i].i2c != NULL) {
+			errno = EBUSY;
+			return -1;
+		}
 	}
 
-	assert(i2c);
-	switch (peri) {
-		case PLC_MCP23008:
-			ret = mcp23008_read(i2c, addr, index, (uint8_t*) &value);
-			assert(ret == 0);
-			if (ret != 0)
-				return 0;
-			break;
-		case PLC_LTC2309:
-			ret = ltc2309_read(i2c, addr, index, &value);
-			assert(ret == 0);
-			if (ret != 0)
-				return 0;
-			value = value > 1636 ? 1 : 0;
-			break;
-		case PLC_ADS1015:
-			ret = ads1015_unsigned_read(i2c, addr, index, &value);
-			assert(ret == 0);
-			if (ret != 0)
-				return 0;
-			value = value > 818 ? 1 : 0;
-			break;
-		case PLC_MCP23017:
-			ret = mcp23017_read(i2c, addr, index, (uint8_t*) &value);
-			assert(ret == 0);
-			if (ret != 0)
-				return 0;
-			break;
-		default:
-			return value;
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		struct expanded_bus_t* b = &(*ctx)->buses[i];
+		pthread_mutex_destroy(&b->lock);
+		pthread_mutex_destroy(&b->worker.lock);
+		pthread_cond_destroy(&b->worker.cond);
 	}
-	return value;
+#endif
+
+	free(*ctx);
+	*ctx = NULL;
+	return 0;
 }
 
-int analogWrite(uint32_t pin, uint16_t value) {
-	int ret = -1;
 
-	uint8_t peri = pinToPlcTypeEnum(pin);
-	uint8_t addr = pinToI2CAddress(pin);
-	uint8_t index = pinToDeviceIndex(pin);
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Public entry points, serialized with the bus locks
+int plcInitExpandedGPIO(plc_context_t* ctx, bool restart_peripherals) {
+	PLC_TRACE_API_ENTRY(ctx, restart_peripherals, 0);
+	lock_all_buses(ctx);
+	int ret = init_expanded_gpio(ctx, restart_peripherals);
+	unlock_all_buses(ctx);
+	PLC_TRACE_API_RETURN(ctx, restart_peripherals, ret);
+	return ret;
+}
 
-	if (peri == PLC_DIRECT) {
-	        ret = normal_gpio_pwm_write(index, value);
-	        return ret == 0 ? 0 : NORMAL_GPIO_PWM_WRITE_FAIL;
-        }
+int plcInitExpandedGPIOLazy(plc_context_t* ctx, bool restart_peripherals) {
+	PLC_TRACE_API_ENTRY(ctx, restart_peripherals, 0);
+	lock_all_buses(ctx);
+	int ret = init_expanded_gpio_lazy(ctx, restart_peripherals);
+	unlock_all_buses(ctx);
+	PLC_TRACE_API_RETURN(ctx, restart_peripherals, ret);
+	return ret;
+}
 
-	else if (I2C_BUS == PERIPHERALS_NO_I2C_BUS) {
-		return I2C_PIN_WITHOUT_I2C_BUS;
+int plcPrewarmExpandedGPIO(plc_context_t* ctx, const uint32_t* pins, size_t num_pins) {
+	PLC_TRACE_API_ENTRY(ctx, num_pins, 0);
+	lock_all_buses(ctx);
+	int ret = prewarm_expanded_gpio(ctx, pins, num_pins);
+	unlock_all_buses(ctx);
+	PLC_TRACE_API_RETURN(ctx, num_pins, ret);
+	return ret;
+}
+
+int plcDeinitExpandedGPIO(plc_context_t* ctx) {
+	PLC_TRACE_API_ENTRY(ctx, 0, 0);
+	if (ctx == &default_context) {
+		stop_input_monitor();
 	}
 
+	lock_all_buses(ctx);
+	int ret = deinit_expanded_gpio(ctx);
+	unlock_all_buses(ctx);
+	PLC_TRACE_API_RETURN(ctx, 0, ret);
+	return ret;
+}
 
-	if (peri == PLC_PCA9685) {
-		ret = pca9685_pwm_write(i2c, addr, index, value);
-			if (ret != 0)
-				return ARRAY_PCA9685_PWM_WRITE_FAIL;
+int plcDeinitExpandedGPIONoReset(plc_context_t* ctx) {
+	PLC_TRACE_API_ENTRY(ctx, 0, 0);
+	if (ctx == &default_context) {
+		stop_input_monitor();
 	}
 
+	lock_all_buses(ctx);
+	int ret = deinit_expanded_gpio_no_reset(ctx);
+	unlock_all_buses(ctx);
+	PLC_TRACE_API_RETURN(ctx, 0, ret);
 	return ret;
 }
 
-int analogWriteSetFrequency(uint32_t pin, uint32_t desired_freq) {
-	int ret = -1;
+int plcSetExpandedGPIOBus(plc_context_t* ctx, uint8_t slot, int bus, const struct peripherals_t* peripherals) {
+	PLC_TRACE_API_ENTRY(ctx, slot, bus);
+	lock_all_buses(ctx);
+	int ret = set_expanded_gpio_bus(ctx, slot, bus, peripherals);
+	unlock_all_buses(ctx);
+	PLC_TRACE_API_RETURN(ctx, slot, ret);
+	return ret;
+}
 
-	uint8_t peri = pinToPlcTypeEnum(pin);
-	uint8_t addr = pinToI2CAddress(pin);
-	uint8_t index = pinToDeviceIndex(pin);
+int plcPinMode(plc_context_t* ctx, uint32_t pin, uint8_t mode) {
+	PLC_TRACE_API_ENTRY(ctx, pin, mode);
+	struct expanded_bus_t* b = pin_lock_bus(ctx, pin);
+	lock_pin(b);
+	int ret = pin_mode(ctx, pin, mode);
+	unlock_pin(b);
+	PLC_TRACE_API_RETURN(ctx, pin, ret);
+	return ret;
+}
 
-	if (peri == PLC_DIRECT) {
-	        ret = normal_gpio_pwm_frequency(index, desired_freq);
-	        return ret == 0 ? 0 : NORMAL_GPIO_PWM_CHANGE_FREQ_FAIL;
-        }
+int plcDigitalWrite(plc_context_t* ctx, uint32_t pin, uint8_t value) {
+	PLC_TRACE_API_ENTRY(ctx, pin, value);
+	struct expanded_bus_t* b = pin_lock_bus(ctx, pin);
+	lock_pin(b);
+	int ret = digital_write(ctx, pin, value);
+	unlock_pin(b);
+	PLC_TRACE_API_RETURN(ctx, pin, ret);
+	return ret;
+}
 
-	else if (I2C_BUS == PERIPHERALS_NO_I2C_BUS) {
-		return I2C_PIN_WITHOUT_I2C_BUS;
-	}
+int plcDigitalRead(plc_context_t* ctx, uint32_t pin) {
+	PLC_TRACE_API_ENTRY(ctx, pin, 0);
+	struct expanded_bus_t* b = pin_lock_bus(ctx, pin);
+	lock_pin(b);
+	int ret = digital_read(ctx, pin);
+	unlock_pin(b);
+	PLC_TRACE_API_RETURN(ctx, pin, ret);
+	return ret;
+}
 
+int plcAnalogWrite(plc_context_t* ctx, uint32_t pin, uint16_t value) {
+	PLC_TRACE_API_ENTRY(ctx, pin, value);
+	struct expanded_bus_t* b = pin_lock_bus(ctx, pin);
+	lock_pin(b);
+	int ret = analog_write(ctx, pin, value);
+	unlock_pin(b);
+	PLC_TRACE_API_RETURN(ctx, pin, ret);
+	return ret;
+}
 
-	if (peri == PLC_PCA9685) {
-		assert(desired_freq >= 24 && desired_freq <= 1526);
-		if (desired_freq < 24 || desired_freq > 1526) {
-			errno = ERANGE;
-			return -1;
-		}
+int plcAnalogWriteSetFrequency(plc_context_t* ctx, uint32_t pin, uint32_t desired_freq) {
+	PLC_TRACE_API_ENTRY(ctx, pin, desired_freq);
+	struct expanded_bus_t* b = pin_lock_bus(ctx, pin);
+	lock_pin(b);
+	int ret = analog_write_set_frequency(ctx, pin, desired_freq);
+	unlock_pin(b);
+	PLC_TRACE_API_RETURN(ctx, pin, ret);
+	return ret;
+}
 
-		uint64_t prescaler_value = ((((PCA9685_INTERNAL_CLOCK << 4) / (4096 * desired_freq))) >> 4) - 1;
-		if (prescaler_value > 255) {
-			errno = EOVERFLOW;
-			return -1;
-		}
+uint16_t plcAnalogRead(plc_context_t* ctx, uint32_t pin) {
+	PLC_TRACE_API_ENTRY(ctx, pin, 0);
+	struct expanded_bus_t* b = pin_lock_bus(ctx, pin);
+	lock_pin(b);
+	uint16_t ret = analog_read(ctx, pin);
+	unlock_pin(b);
+	PLC_TRACE_API_RETURN(ctx, pin, ret);
+	return ret;
+}
 
-		ret = pca9685_pwm_frequency(i2c, addr, prescaler_value);
-		assert(ret == 0);
-		if (ret != 0) {
-			return NORMAL_GPIO_PWM_CHANGE_FREQ_FAIL;
-		}
-	}
+int plcDigitalWriteAll(plc_context_t* ctx, uint8_t addr, uint32_t values) {
+	PLC_TRACE_API_ENTRY(ctx, addr, values);
+	LOCK_BUS(&ctx->buses[0]);
+	int ret = digital_write_all(slot_bus(ctx, 0), addr, values);
+	UNLOCK_BUS(&ctx->buses[0]);
+	PLC_TRACE_API_RETURN(ctx, addr, ret);
+	return ret;
+}
 
+int plcDigitalReadAll(plc_context_t* ctx, uint8_t addr, void* values) {
+	PLC_TRACE_API_ENTRY(ctx, addr, 0);
+	LOCK_BUS(&ctx->buses[0]);
+	int ret = digital_read_all(slot_bus(ctx, 0), addr, values);
+	UNLOCK_BUS(&ctx->buses[0]);
+	PLC_TRACE_API_RETURN(ctx, addr, ret);
 	return ret;
 }
 
-uint16_t analogRead(uint32_t pin) {
-	uint16_t value = 0;
-	int ret = -1;
+int plcAnalogWriteAll(plc_context_t* ctx, uint8_t addr, const void* values) {
+	PLC_TRACE_API_ENTRY(ctx, addr, 0);
+	LOCK_BUS(&ctx->buses[0]);
+	int ret = analog_write_all(slot_bus(ctx, 0), addr, values);
+	UNLOCK_BUS(&ctx->buses[0]);
+	PLC_TRACE_API_RETURN(ctx, addr, ret);
+	return ret;
+}
 
-	uint8_t peri = pinToPlcTypeEnum(pin);
-	uint8_t addr = pinToI2CAddress(pin);
-	uint8_t index = pinToDeviceIndex(pin);
+int plcDigitalWriteAllBatch(plc_context_t* ctx, expanded_gpio_write_all_t* ops, size_t num_ops) {
+	PLC_TRACE_API_ENTRY(ctx, num_ops, 0);
+	const uint64_t start_ns = plc_stats_now();
+	lock_all_buses(ctx);
+	int ret = digital_write_all_batch(ctx, ops, num_ops);
+	unlock_all_buses(ctx);
+	plc_stats_scan(start_ns, ret == 0);
+	PLC_TRACE_API_RETURN(ctx, num_ops, ret);
+	return ret;
+}
 
-	if (peri == PLC_DIRECT) {
-		ret = normal_gpio_analog_read(index, &value);
-		assert(ret == 0);
-		return ret == 0 ? value : 0;
-	}
+int plcDigitalReadAllBatch(plc_context_t* ctx, expanded_gpio_read_all_t* ops, size_t num_ops) {
+	PLC_TRACE_API_ENTRY(ctx, num_ops, 0);
+	const uint64_t start_ns = plc_stats_now();
+	lock_all_buses(ctx);
+	int ret = digital_read_all_batch(ctx, ops, num_ops);
+	unlock_all_buses(ctx);
+	plc_stats_scan(start_ns, ret == 0);
+	PLC_TRACE_API_RETURN(ctx, num_ops, ret);
+	return ret;
+}
 
-	else if (I2C_BUS == PERIPHERALS_NO_I2C_BUS) {
-		return I2C_PIN_WITHOUT_I2C_BUS;
+int plcSetInputDebounce(plc_context_t* ctx, uint32_t pin, uint8_t mode, uint16_t param) {
+	PLC_TRACE_API_ENTRY(ctx, pin, mode);
+	struct expanded_bus_t* b = pin_lock_bus(ctx, pin);
+	lock_pin(b);
+	int ret = set_input_debounce(ctx, pin, mode, param);
+	unlock_pin(b);
+	PLC_TRACE_API_RETURN(ctx, pin, ret);
+	return ret;
+}
+
+int plcScanDebouncedInputs(plc_context_t* ctx) {
+	PLC_TRACE_API_ENTRY(ctx, 0, 0);
+	const uint64_t start_ns = plc_stats_now();
+	lock_all_buses(ctx);
+	int ret = scan_debounced_inputs(ctx);
+	unlock_all_buses(ctx);
+	plc_stats_scan(start_ns, ret == 0);
+	PLC_TRACE_API_RETURN(ctx, 0, ret);
+	return ret;
+}
+
+// Not with LOCK_BUS, so reading the statistics doesn't count in them
+int plcGetExpandedGPIOLockStats(plc_context_t* ctx, uint8_t slot, expanded_gpio_lock_stats_t* stats) {
+	if (slot >= EXPANDED_GPIO_MAX_BUSES || stats == NULL) {
+		errno = EINVAL;
+		return -1;
 	}
 
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+	struct expanded_bus_t* b = &ctx->buses[slot];
+	pthread_mutex_lock(&b->lock);
+	*stats = b->lock_stats;
+	pthread_mutex_unlock(&b->lock);
+#else
+	(void) ctx;
+	*stats = (expanded_gpio_lock_stats_t) {0};
+#endif
+	return 0;
+}
 
-	assert(i2c);
-	switch (peri){
-		case PLC_ADS1015:
-			ret = ads1015_unsigned_read(i2c, addr, index, &value);
-			assert(ret == 0);
-			if (ret != 0)
-				return 0;
-			break;
-		case PLC_LTC2309:
-			ret = ltc2309_read(i2c, addr, index, &value);
-			assert(ret == 0);
-			if (ret != 0)
-				return 0;
-			break;
-		default:
-			return value;
+void plcClearExpandedGPIOLockStats(plc_context_t* ctx) {
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+	for (size_t i = 0; i < EXPANDED_GPIO_MAX_BUSES; i++) {
+		struct expanded_bus_t* b = &ctx->buses[i];
+		pthread_mutex_lock(&b->lock);
+		b->lock_stats = (expanded_gpio_lock_stats_t) {0};
+		pthread_mutex_unlock(&b->lock);
 	}
-	return value;
+#else
+	(void) ctx;
+#endif
 }
 
-int digitalWriteAll(uint8_t addr, uint32_t values) {
-	int ret = -1;
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Exported functions on the default context
+int initExpandedGPIO(bool restart_peripherals) {
+	return plcInitExpandedGPIO(&default_context, restart_peripherals);
+}
 
-	if (I2C_BUS == PERIPHERALS_NO_I2C_BUS) {
-		errno = ENOTSUP;
-		return ret;
-	}
+int initExpandedGPIOLazy(bool restart_peripherals) {
+	return plcInitExpandedGPIOLazy(&default_context, restart_peripherals);
+}
 
+int prewarmExpandedGPIO(const uint32_t* pins, size_t num_pins) {
+	return plcPrewarmExpandedGPIO(&default_context, pins, num_pins);
+}
 
-	if (isAddressIntoArray(addr, ARRAY_MCP23008, NUM_ARRAY_MCP23008) == 0) {
-		ret = mcp23008_write_all(i2c, addr, values);
-		if (ret != 0) {
-			return ARRAY_MCP23008_WRITE_ALL_FAIL;
-		}
-	}
+int deinitExpandedGPIO(void) {
+	return plcDeinitExpandedGPIO(&default_context);
+}
 
-	else if (isAddressIntoArray(addr, ARRAY_PCA9685, NUM_ARRAY_PCA9685) == 0) {
-		ret = pca9685_write_all(i2c, addr, values);
-		if (ret != 0) {
-			return ARRAY_PCA9685_WRITE_ALL_FAIL;
-		}
-	}
+int deinitExpandedGPIONoReset(void) {
+	return plcDeinitExpandedGPIONoReset(&default_context);
+}
 
-	else if (isAddressIntoArray(addr, ARRAY_MCP23017, NUM_ARRAY_MCP23017) == 0) {
-		ret = mcp23017_write_all(i2c, addr, values);
-		if (ret != 0) {
-			return ARRAY_MCP23017_WRITE_ALL_FAIL;
-		}
-	}
+int setExpandedGPIOBus(uint8_t slot, int bus, const struct peripherals_t* peripherals) {
+	return plcSetExpandedGPIOBus(&default_context, slot, bus, peripherals);
+}
 
-	return ret;
+int pinMode(uint32_t pin, uint8_t mode) {
+	return plcPinMode(&default_context, pin, mode);
 }
 
-int digitalReadAll(uint8_t addr, void* values) {
-	int ret = -1;
+int digitalWrite(uint32_t pin, uint8_t value) {
+	return plcDigitalWrite(&default_context, pin, value);
+}
 
+int digitalRead(uint32_t pin) {
+	return plcDigitalRead(&default_context, pin);
+}
 
-	if (I2C_BUS == PERIPHERALS_NO_I2C_BUS) {
-		errno = ENOTSUP;
-		return ret;
-	}
+int analogWrite(uint32_t pin, uint16_t value) {
+	return plcAnalogWrite(&default_context, pin, value);
+}
 
+int analogWriteSetFrequency(uint32_t pin, uint32_t desired_freq) {
+	return plcAnalogWriteSetFrequency(&default_context, pin, desired_freq);
+}
 
-	if (isAddressIntoArray(addr, ARRAY_MCP23008, NUM_ARRAY_MCP23008) == 0) {
-		ret = mcp23008_read_all(i2c, addr, (uint8_t*) values);
-		if (ret != 0) {
-			return ARRAY_MCP23008_READ_ALL_FAIL;
-		}
-	}
+uint16_t analogRead(uint32_t pin) {
+	return plcAnalogRead(&default_context, pin);
+}
 
-	else if (isAddressIntoArray(addr, ARRAY_MCP23017, NUM_ARRAY_MCP23017) == 0) {
-		ret = mcp23017_read_all(i2c, addr, (uint16_t*) values);
-		if (ret != 0) {
-			return ARRAY_MCP23017_READ_ALL_FAIL;
-		}
-	}
+int digitalWriteAll(uint8_t addr, uint32_t values) {
+	return plcDigitalWriteAll(&default_context, addr, values);
+}
 
-	return ret;
+int digitalReadAll(uint8_t addr, void* values) {
+	return plcDigitalReadAll(&default_context, addr, values);
 }
 
 int analogWriteAll(uint8_t addr, const void* values) {
-	int ret = -1;
+	return plcAnalogWriteAll(&default_context, addr, values);
+}
 
+int digitalWriteAllBatch(expanded_gpio_write_all_t* ops, size_t num_ops) {
+	return plcDigitalWriteAllBatch(&default_context, ops, num_ops);
+}
 
-	if (I2C_BUS == PERIPHERALS_NO_I2C_BUS) {
-		errno = ENOTSUP;
-		return ret;
-	}
+int digitalReadAllBatch(expanded_gpio_read_all_t* ops, size_t num_ops) {
+	return plcDigitalReadAllBatch(&default_context, ops, num_ops);
+}
 
+int setInputDebounce(uint32_t pin, uint8_t mode, uint16_t param) {
+	return plcSetInputDebounce(&default_context, pin, mode, param);
+}
 
-	if (isAddressIntoArray(addr, ARRAY_PCA9685, NUM_ARRAY_PCA9685) == 0) {
-		ret = pca9685_pwm_write_all(i2c, addr, (uint16_t*) values);
-		if (ret != 0) {
-			return ARRAY_PCA9685_PWM_WRITE_ALL_FAIL;
-		}
-	}
+int scanDebouncedInputs(void) {
+	return plcScanDebouncedInputs(&default_context);
+}
+
+int getExpandedGPIOLockStats(uint8_t slot, expanded_gpio_lock_stats_t* stats) {
+	return plcGetExpandedGPIOLockStats(&default_context, slot, stats);
+}
+
+void clearExpandedGPIOLockStats(void) {
+	plcClearExpandedGPIOLockStats(&default_context);
+}
+
+// The direct pins are shared by all the contexts and use the direct lock
+int digitalWriteAllDirect(uint64_t mask, uint64_t values) {
+	LOCK_DIRECT();
+	int ret = digital_write_all_direct(mask, values);
+	UNLOCK_DIRECT();
+	return ret;
+}
 
+int digitalReadAllDirect(uint64_t mask, uint64_t* values) {
+	LOCK_DIRECT();
+	int ret = digital_read_all_direct(mask, values);
+	UNLOCK_DIRECT();
 	return ret;
 }
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gpio-chardev.h>
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+#define DEFAULT_CONSUMER "plc-peripherals"
+
+// Maximum number of edge events read with each "read"
+#define READ_EDGES_BATCH 64
+
+/**
+ * @brief Translates GPIO_CHARDEV_* flags to the flags of the uAPI.
+ */
+static uint64_t line_flags(uint8_t flags) {
+	uint64_t ret = 0;
+	if (flags & GPIO_CHARDEV_EDGE_RISING) {
+		ret |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+	}
+	if (flags & GPIO_CHARDEV_EDGE_FALLING) {
+		ret |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+	}
+	if (flags & GPIO_CHARDEV_BIAS_PULL_UP) {
+		ret |= GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+	}
+	if (flags & GPIO_CHARDEV_BIAS_PULL_DOWN) {
+		ret |= GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN;
+	}
+	if (flags & GPIO_CHARDEV_ACTIVE_LOW) {
+		ret |= GPIO_V2_LINE_FLAG_ACTIVE_LOW;
+	}
+	return ret;
+}
+
+/**
+ * @brief Fills the configuration of a request.
+ *
+ * The lines in "output_mask" are outputs, and the rest are inputs. Edges can
+ * only be detected when all the lines are inputs.
+ *
+ * @return 0 on success, -1 on failure (errno is set to EINVAL).
+ */
+static int fill_config(struct gpio_v2_line_config* config, uint64_t output_mask, uint64_t values, uint8_t flags) {
+	if ((flags & GPIO_CHARDEV_BIAS_PULL_UP) && (flags & GPIO_CHARDEV_BIAS_PULL_DOWN)) {
+		errno = EINVAL;
+		return -1;
+	}
+	if ((flags & GPIO_CHARDEV_EDGE_BOTH) && output_mask != 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	memset(config, 0, sizeof(*config));
+	config->flags = GPIO_V2_LINE_FLAG_INPUT | line_flags(flags);
+
+	if (output_mask != 0) {
+		const uint64_t output_flags = line_flags(flags & (GPIO_CHARDEV_BIAS_PULL_UP | GPIO_CHARDEV_BIAS_PULL_DOWN | GPIO_CHARDEV_ACTIVE_LOW));
+
+		config->attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+		config->attrs[0].attr.flags = GPIO_V2_LINE_FLAG_OUTPUT | output_flags;
+		config->attrs[0].mask = output_mask;
+
+		config->attrs[1].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+		config->attrs[1].attr.values = values & output_mask;
+		config->attrs[1].mask = output_mask;
+
+		config->num_attrs = 2;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Requests several lines of a GPIO chip.
+ *
+ * @return The file descriptor of the request on success, -1 on failure.
+ */
+static int request_lines(const char* chip, const uint32_t* offsets, size_t num_lines, uint64_t output_mask, uint64_t values, uint8_t flags, const char* consumer) {
+	if (chip == NULL || offsets == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (num_lines == 0 || num_lines > GPIO_CHARDEV_MAX_LINES) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	struct gpio_v2_line_request request;
+	memset(&request, 0, sizeof(request));
+	memcpy(request.offsets, offsets, num_lines * sizeof(offsets[0]));
+	request.num_lines = num_lines;
+	strncpy(request.consumer, consumer != NULL ? consumer : DEFAULT_CONSUMER, sizeof(request.consumer) - 1);
+
+	if (fill_config(&request.config, output_mask, values, flags) != 0) {
+		return -1;
+	}
+	if (flags & GPIO_CHARDEV_EDGE_BOTH) {
+		request.event_buffer_size = GPIO_CHARDEV_EVENT_BUFFER_SIZE;
+	}
+
+	int chip_fd = open(chip, O_RDWR | O_CLOEXEC);
+	if (chip_fd < 0) {
+		return -1;
+	}
+
+	int ret = ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &request);
+	int saved_errno = errno;
+	close(chip_fd);
+	if (ret < 0) {
+		errno = saved_errno;
+		return -1;
+	}
+
+	errno = 0;
+	return request.fd;
+}
+
+int gpio_chardev_request_inputs(const char* chip, const uint32_t* offsets, size_t num_lines, uint8_t flags, const char* consumer) {
+	return request_lines(chip, offsets, num_lines, 0, 0, flags, consumer);
+}
+
+int gpio_chardev_request_outputs(const char* chip, const uint32_t* offsets, size_t num_lines, uint64_t values, uint8_t flags, const char* consumer) {
+	if (flags & GPIO_CHARDEV_EDGE_BOTH) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	const uint64_t all_lines = num_lines >= 64 ? ~0ULL : (1ULL << num_lines) - 1;
+	return request_lines(chip, offsets, num_lines, all_lines, values, flags, consumer);
+}
+
+int gpio_chardev_set_directions(int fd, uint64_t output_mask, uint64_t values, uint8_t flags) {
+	struct gpio_v2_line_config config;
+	if (fill_config(&config, output_mask, values, flags) != 0) {
+		return -1;
+	}
+	if (ioctl(fd, GPIO_V2_LINE_SET_CONFIG_IOCTL, &config) < 0) {
+		return -1;
+	}
+
+	errno = 0;
+	return 0;
+}
+
+int gpio_chardev_get_values(int fd, uint64_t mask, uint64_t* values) {
+	if (values == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	struct gpio_v2_line_values line_values = {
+		.bits = 0,
+		.mask = mask
+	};
+	if (ioctl(fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &line_values) < 0) {
+		return -1;
+	}
+
+	*values = line_values.bits & mask;
+	errno = 0;
+	return 0;
+}
+
+int gpio_chardev_set_values(int fd, uint64_t mask, uint64_t values) {
+	struct gpio_v2_line_values line_values = {
+		.bits = values & mask,
+		.mask = mask
+	};
+	if (ioctl(fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &line_values) < 0) {
+		return -1;
+	}
+
+	errno = 0;
+	return 0;
+}
+
+int gpio_chardev_read_edges(int fd, int timeout_ms, gpio_chardev_edge_t* edges, size_t max_edges) {
+	if (edges == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (max_edges == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	struct pollfd pfd = {
+		.fd = fd,
+		.events = POLLIN
+	};
+	int ret;
+	do {
+		ret = poll(&pfd, 1, timeout_ms);
+	} while (ret < 0 && errno == EINTR);
+	if (ret < 0) {
+		return -1;
+	}
+	if (ret == 0) {
+		errno = ETIMEDOUT;
+		return -1;
+	}
+
+	// The kernel only returns whole events
+	struct gpio_v2_line_event events[READ_EDGES_BATCH];
+	if (max_edges > READ_EDGES_BATCH) {
+		max_edges = READ_EDGES_BATCH;
+	}
+	ssize_t read_ret = read(fd, events, max_edges * sizeof(events[0]));
+	if (read_ret < 0) {
+		return -1;
+	}
+	if (read_ret == 0 || read_ret % sizeof(events[0]) != 0) {
+		errno = EBADE;
+		return -1;
+	}
+
+	const size_t num_edges = read_ret / sizeof(events[0]);
+	for (size_t i = 0; i < num_edges; i++) {
+		edges[i].timestamp_ns = events[i].timestamp_ns;
+		edges[i].offset = events[i].offset;
+		edges[i].seqno = events[i].line_seqno;
+		edges[i].rising = events[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE;
+	}
+
+	errno = 0;
+	return num_edges;
+}
+
+int gpio_chardev_read_edge(int fd, int timeout_ms, gpio_chardev_edge_t* edge) {
+	return gpio_chardev_read_edges(fd, timeout_ms, edge, 1) < 0 ? -1 : 0;
+}
+
+int gpio_chardev_release(int fd) {
+	return close(fd);
+}
+
+#endif // PLC_ENVIRONMENT == Linux
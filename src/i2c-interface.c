@@ -18,6 +18,8 @@
  */
 
 #include <i2c-interface.h>
+#include <plc-stats.h>
+#include "plc-trace.h"
 
 #include <stdbool.h>
 #include <string.h>
@@ -34,6 +36,7 @@
 #include <sys/stat.h>
 struct _i2c_interface_t {
 	int fd;
+	uint8_t bus;
 };
 
 #elif defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Arduino_ESP32
@@ -77,6 +80,7 @@ static inline int _init_i2c_platform(i2c_interface_t* i2c, uint8_t bus) {
 	        }
 	        return -1;
         }
+        i2c->bus = bus;
 
         errno = 0;
 	return 0;
@@ -224,6 +228,24 @@ static inline bool is_i2c_correct_platform(i2c_interface_t* i2c) {
 	return is_correct;
 }
 
+/**
+ * @brief Gets the number of the I2C bus of an interface, for the statistics.
+ */
+static inline uint8_t i2c_bus_number(const i2c_interface_t* i2c) {
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+	return i2c->bus;
+#elif defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Arduino_ESP32
+	return i2c->bus_num;
+#endif
+}
+
+/**
+ * @brief Gets the register of a transaction for the probes, the first byte written.
+ */
+static inline int i2c_trace_reg(const i2c_write_t* order) {
+	return order->len > 0 ? order->buff[0] : -1;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 #if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
 /**
@@ -330,7 +352,12 @@ int i2c_write(i2c_interface_t* i2c, const uint8_t addr, const i2c_write_t* to_wr
 	        return 0;
 	}
 
-	return _i2c_write_platform(i2c, addr, to_write);
+	PLC_TRACE_I2C_SUBMIT(i2c_bus_number(i2c), addr, i2c_trace_reg(to_write), to_write->len);
+	const uint64_t start_ns = plc_stats_now();
+	const int ret = _i2c_write_platform(i2c, addr, to_write);
+	plc_stats_transaction(i2c_bus_number(i2c), addr, to_write->len, start_ns, ret == 0);
+	PLC_TRACE_I2C_COMPLETE(i2c_bus_number(i2c), addr, i2c_trace_reg(to_write), to_write->len, ret == 0 ? 0 : -errno);
+	return ret;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -444,7 +471,12 @@ int i2c_read(i2c_interface_t* i2c, const uint8_t addr, const i2c_read_t* to_read
 		return 0;
 	}
 
-	return _i2c_read_platform(i2c, addr, to_read);
+	PLC_TRACE_I2C_SUBMIT(i2c_bus_number(i2c), addr, -1, to_read->len);
+	const uint64_t start_ns = plc_stats_now();
+	const int ret = _i2c_read_platform(i2c, addr, to_read);
+	plc_stats_transaction(i2c_bus_number(i2c), addr, to_read->len, start_ns, ret == 0);
+	PLC_TRACE_I2C_COMPLETE(i2c_bus_number(i2c), addr, -1, to_read->len, ret == 0 ? 0 : -errno);
+	return ret;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -567,5 +599,141 @@ int i2c_write_then_read(i2c_interface_t* i2c, const uint8_t addr, const i2c_writ
 		return -1;
 	}
 
-	return _i2c_write_then_read_platform(i2c, addr, read_order, to_read);
+	PLC_TRACE_I2C_SUBMIT(i2c_bus_number(i2c), addr, i2c_trace_reg(read_order), read_order->len + to_read->len);
+	const uint64_t start_ns = plc_stats_now();
+	const int ret = _i2c_write_then_read_platform(i2c, addr, read_order, to_read);
+	plc_stats_transaction(i2c_bus_number(i2c), addr, read_order->len + to_read->len, start_ns, ret == 0);
+	PLC_TRACE_I2C_COMPLETE(i2c_bus_number(i2c), addr, i2c_trace_reg(read_order), read_order->len + to_read->len, ret == 0 ? 0 : -errno);
+	return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+/**
+ * @brief It performs several write-then-read operations as a single combined transaction.
+ *
+ * This function sends all the messages in a single I2C_RDWR ioctl on a Linux platform.
+ *
+ * @param i2c Pointer to the I2C interface structure.
+ * @param addr The address of the I2C device.
+ * @param read_orders Array of "num" read orders.
+ * @param to_reads Array of "num" buffers where the data will be read.
+ * @param num The number of reads to perform.
+ * @return 0 on success, -1 on failure.
+ *         On failure, errno is set as follows:
+ *             - EAGAIN: The operation is temporarily unavailable.
+ *             - EIO: The slave didn't ACK the request, or a more general error (may be set by "ioctl").
+ *             - EBADE: "ioctl" returned something unexpected. If this errno is set, the return
+ *                       value will be the same as the "ioctl" call.
+ *             - Other errnos returned by "ioctl" may be set, but they are not expected.
+ */
+static inline int _i2c_write_then_read_multiple_platform(i2c_interface_t* i2c, const uint8_t addr, const i2c_write_t* read_orders, const i2c_read_t* to_reads, size_t num) {
+	struct i2c_msg msgs[2 * I2C_MAX_COMBINED_READS];
+	for (size_t i = 0; i < num; i++) {
+		msgs[2*i] = (struct i2c_msg) {
+			.addr = addr,
+			.flags = 0,
+			.len = read_orders[i].len,
+			.buf = (uint8_t*) read_orders[i].buff
+		};
+		msgs[2*i + 1] = (struct i2c_msg) {
+			.addr = addr,
+			.flags = I2C_M_RD,
+			.len = to_reads[i].len,
+			.buf = to_reads[i].buff
+		};
+	}
+	const struct i2c_rdwr_ioctl_data ioctl_data[1] = {
+		{
+			.msgs = msgs,
+			.nmsgs = 2 * num
+		}
+	};
+
+	int ioctl_ret = ioctl(i2c->fd, I2C_RDWR, ioctl_data);
+	if (ioctl_ret == (int) (2 * num)) {
+		return 0;
+	}
+	switch (ioctl_ret) {
+	case 0:
+		errno = EAGAIN;
+		[[fallthrough]];
+	case -1:
+		return -1;
+	default:
+		errno = EBADE;
+		return ioctl_ret;
+	}
+}
+#elif defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Arduino_ESP32
+/**
+ * @brief It performs several write-then-read operations, one after the other.
+ *
+ * The esp32-hal-i2c library can't combine several reads, so this function performs
+ * them sequentially on an Arduino ESP32 platform.
+ *
+ * @param i2c Pointer to the I2C interface structure.
+ * @param addr The address of the I2C device.
+ * @param read_orders Array of "num" read orders.
+ * @param to_reads Array of "num" buffers where the data will be read.
+ * @param num The number of reads to perform.
+ * @return 0 on success, -1 on failure.
+ *         On failure, errno is set as described in _i2c_write_then_read_platform.
+ */
+static inline int _i2c_write_then_read_multiple_platform(i2c_interface_t* i2c, const uint8_t addr, const i2c_write_t* read_orders, const i2c_read_t* to_reads, size_t num) {
+	for (size_t i = 0; i < num; i++) {
+		int i2c_ret = _i2c_write_then_read_platform(i2c, addr, &read_orders[i], &to_reads[i]);
+		if (i2c_ret != 0) {
+			return i2c_ret;
+		}
+	}
+
+	errno = 0;
+	return 0;
+}
+#endif
+
+int i2c_write_then_read_multiple(i2c_interface_t* i2c, const uint8_t addr, const i2c_write_t* read_orders, const i2c_read_t* to_reads, size_t num) {
+	if (i2c == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (is_i2c_correct_platform(i2c)) {
+	        errno = EBADFD;
+	        return -1;
+        }
+	if (addr >= 128) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (read_orders == NULL || to_reads == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (num == 0 || num > I2C_MAX_COMBINED_READS) {
+		errno = EINVAL;
+		return -1;
+	}
+	for (size_t i = 0; i < num; i++) {
+		if (read_orders[i].buff == NULL || to_reads[i].buff == NULL) {
+			errno = EFAULT;
+			return -1;
+		}
+		if (read_orders[i].len == 0 || to_reads[i].len == 0) {
+			errno = EINVAL;
+			return -1;
+		}
+	}
+
+	size_t bytes = 0;
+	for (size_t i = 0; i < num; i++) {
+		bytes += read_orders[i].len + to_reads[i].len;
+	}
+
+	PLC_TRACE_I2C_SUBMIT(i2c_bus_number(i2c), addr, i2c_trace_reg(&read_orders[0]), bytes);
+	const uint64_t start_ns = plc_stats_now();
+	const int ret = _i2c_write_then_read_multiple_platform(i2c, addr, read_orders, to_reads, num);
+	plc_stats_transaction(i2c_bus_number(i2c), addr, bytes, start_ns, ret == 0);
+	PLC_TRACE_I2C_COMPLETE(i2c_bus_number(i2c), addr, i2c_trace_reg(&read_orders[0]), bytes, ret == 0 ? 0 : -errno);
+	return ret;
 }
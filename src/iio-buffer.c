@@ -0,0 +1,590 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <iio-buffer.h>
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <endian.h>
+#include <sys/eventfd.h>
+
+#define TIMESTAMP_ELEMENT "in_timestamp"
+#define MAX_ELEMENTS (IIO_BUFFER_MAX_CHANNELS + 1)
+
+// Samples read from the character device with each "read"
+#define READ_BLOCK_SAMPLES 64
+
+// Layout of a scan element inside a sample of the character device
+struct element_t {
+	uint32_t index; // Scan index, which sets the order
+	size_t offset; // In bytes, inside the sample
+	uint8_t bytes; // Storage size
+	uint8_t real_bits;
+	uint8_t shift;
+	bool is_signed;
+	bool big_endian;
+	int channel; // Index in the configuration, -1 for the timestamp
+};
+
+struct _iio_buffer_t {
+	char device_dir[PATH_MAX];
+	int fd;
+	int wake_fd;
+	pthread_t thread;
+
+	struct element_t elements[MAX_ELEMENTS];
+	size_t num_elements;
+	size_t num_channels;
+	size_t sample_size;
+
+	pthread_mutex_t lock;
+	iio_buffer_sample_t* ring;
+	size_t ring_length;
+	size_t ring_head; // Oldest sample not taken
+	size_t ring_count;
+	uint64_t dropped;
+	bool has_latest;
+	iio_buffer_sample_t latest;
+	int error; // errno that stopped the capture thread, 0 while it runs
+};
+
+
+/**
+ * @brief Writes a text to a sysfs attribute.
+ *
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+static int write_attribute(const char* dir, const char* name, const char* value) {
+	char path[PATH_MAX];
+	if (snprintf(path, sizeof(path), "%s/%s", dir, name) >= (int) sizeof(path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+
+	int fd = open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+	if (fd < 0) {
+		return -1;
+	}
+	const size_t len = strlen(value);
+	const ssize_t written = write(fd, value, len);
+	const int saved_errno = errno;
+	close(fd);
+	if (written != (ssize_t) len) {
+		errno = written < 0 ? saved_errno : EIO;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Reads a sysfs attribute, without the trailing new line.
+ *
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+static int read_attribute(const char* dir, const char* name, char* value, size_t size) {
+	char path[PATH_MAX];
+	if (snprintf(path, sizeof(path), "%s/%s", dir, name) >= (int) sizeof(path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return -1;
+	}
+	const ssize_t len = read(fd, value, size - 1);
+	const int saved_errno = errno;
+	close(fd);
+	if (len < 0) {
+		errno = saved_errno;
+		return -1;
+	}
+
+	value[len] = '\0';
+	value[strcspn(value, "\n")] = '\0';
+	return 0;
+}
+
+/**
+ * @brief Reads the index and the type of a scan element.
+ *
+ * The type has the format "[be|le]:[s|u]bits/storagebits[>>shift]".
+ *
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+static int read_element(const char* scan_dir, const char* name, struct element_t* element) {
+	char attribute[NAME_MAX + 1];
+	char value[64];
+
+	snprintf(attribute, sizeof(attribute), "%s_index", name);
+	if (read_attribute(scan_dir, attribute, value, sizeof(value)) != 0) {
+		return -1;
+	}
+	element->index = strtoul(value, NULL, 10);
+
+	snprintf(attribute, sizeof(attribute), "%s_type", name);
+	if (read_attribute(scan_dir, attribute, value, sizeof(value)) != 0) {
+		return -1;
+	}
+
+	char endian[3], sign;
+	unsigned real_bits, storage_bits, shift = 0;
+	if (sscanf(value, "%2s:%c%u/%u>>%u", endian, &sign, &real_bits, &storage_bits, &shift) < 4 ||
+	    (storage_bits != 8 && storage_bits != 16 && storage_bits != 32 && storage_bits != 64) ||
+	    real_bits == 0 || real_bits > storage_bits || shift >= storage_bits) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	element->bytes = storage_bits / 8;
+	element->real_bits = real_bits;
+	element->shift = shift;
+	element->is_signed = sign == 's';
+	element->big_endian = strcmp(endian, "be") == 0;
+	return 0;
+}
+
+/**
+ * @brief Enables the given scan elements and disables the rest.
+ *
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+static int enable_elements(const char* scan_dir, const iio_buffer_config_t* config, bool* has_timestamp) {
+	DIR* dir = opendir(scan_dir);
+	if (dir == NULL) {
+		return -1;
+	}
+
+	*has_timestamp = false;
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != NULL) {
+		const size_t len = strlen(entry->d_name);
+		if (len <= 3 || strcmp(entry->d_name + len - 3, "_en") != 0) {
+			continue;
+		}
+
+		bool enable = strncmp(entry->d_name, TIMESTAMP_ELEMENT, len - 3) == 0 && len - 3 == strlen(TIMESTAMP_ELEMENT);
+		*has_timestamp = *has_timestamp || enable;
+		for (size_t i = 0; i < config->num_channels && !enable; i++) {
+			enable = strlen(config->channels[i]) == len - 3 && strncmp(entry->d_name, config->channels[i], len - 3) == 0;
+		}
+
+		if (write_attribute(scan_dir, entry->d_name, enable ? "1" : "0") != 0) {
+			const int saved_errno = errno;
+			closedir(dir);
+			errno = saved_errno;
+			return -1;
+		}
+	}
+
+	closedir(dir);
+	return 0;
+}
+
+static int compare_elements(const void* a, const void* b) {
+	const struct element_t* element_a = a;
+	const struct element_t* element_b = b;
+	return (element_a->index > element_b->index) - (element_a->index < element_b->index);
+}
+
+/**
+ * @brief Computes where every scan element is inside a sample.
+ *
+ * The elements are ordered by scan index, each one aligned to its size, and
+ * the sample is padded to the size of the largest one.
+ */
+static void compute_layout(iio_buffer_t* buffer) {
+	qsort(buffer->elements, buffer->num_elements, sizeof(buffer->elements[0]), compare_elements);
+
+	size_t offset = 0, largest = 1;
+	for (size_t i = 0; i < buffer->num_elements; i++) {
+		struct element_t* element = &buffer->elements[i];
+		offset = (offset + element->bytes - 1) / element->bytes * element->bytes;
+		element->offset = offset;
+		offset += element->bytes;
+		if (element->bytes > largest) {
+			largest = element->bytes;
+		}
+	}
+
+	buffer->sample_size = (offset + largest - 1) / largest * largest;
+}
+
+/**
+ * @brief Extracts the value of a scan element from a sample.
+ */
+static int64_t element_value(const struct element_t* element, const uint8_t* sample) {
+	uint64_t raw = 0;
+	const uint8_t* data = sample + element->offset;
+	switch (element->bytes) {
+		case 1:
+			raw = data[0];
+			break;
+		case 2: {
+			uint16_t value;
+			memcpy(&value, data, sizeof(value));
+			raw = element->big_endian ? be16toh(value) : le16toh(value);
+			break;
+		}
+		case 4: {
+			uint32_t value;
+			memcpy(&value, data, sizeof(value));
+			raw = element->big_endian ? be32toh(value) : le32toh(value);
+			break;
+		}
+		default: {
+			uint64_t value;
+			memcpy(&value, data, sizeof(value));
+			raw = element->big_endian ? be64toh(value) : le64toh(value);
+			break;
+		}
+	}
+
+	raw >>= element->shift;
+	if (element->real_bits < 64) {
+		raw &= (1ULL << element->real_bits) - 1;
+		if (element->is_signed && (raw & (1ULL << (element->real_bits - 1)))) {
+			raw |= ~((1ULL << element->real_bits) - 1);
+		}
+	}
+	return (int64_t) raw;
+}
+
+/**
+ * @brief Stores the samples read from the character device in the ring.
+ */
+static void store_samples(iio_buffer_t* buffer, const uint8_t* data, size_t num_samples) {
+	pthread_mutex_lock(&buffer->lock);
+	for (size_t s = 0; s < num_samples; s++) {
+		const uint8_t* raw_sample = data + s * buffer->sample_size;
+		iio_buffer_sample_t sample = {.timestamp_ns = 0};
+
+		for (size_t i = 0; i < buffer->num_elements; i++) {
+			const struct element_t* element = &buffer->elements[i];
+			const int64_t value = element_value(element, raw_sample);
+			if (element->channel < 0) {
+				sample.timestamp_ns = value;
+			}
+			else {
+				sample.values[element->channel] = value < 0 ? 0 : value > UINT16_MAX ? UINT16_MAX : value;
+			}
+		}
+
+		if (buffer->ring_count == buffer->ring_length) {
+			buffer->ring_head = (buffer->ring_head + 1) % buffer->ring_length;
+			buffer->ring_count--;
+			buffer->dropped++;
+		}
+		buffer->ring[(buffer->ring_head + buffer->ring_count) % buffer->ring_length] = sample;
+		buffer->ring_count++;
+
+		buffer->latest = sample;
+		buffer->has_latest = true;
+	}
+	pthread_mutex_unlock(&buffer->lock);
+}
+
+/**
+ * @brief Records the error that stopped the capture thread.
+ */
+static void stop_capture(iio_buffer_t* buffer, int error) {
+	pthread_mutex_lock(&buffer->lock);
+	buffer->error = error;
+	pthread_mutex_unlock(&buffer->lock);
+}
+
+/**
+ * @brief Body of the capture thread.
+ */
+static void* capture(void* arg) {
+	iio_buffer_t* buffer = arg;
+
+	uint8_t* data = malloc(buffer->sample_size * READ_BLOCK_SAMPLES);
+	if (data == NULL) {
+		stop_capture(buffer, ENOMEM);
+		return NULL;
+	}
+
+	size_t pending = 0; // Bytes of an incomplete sample
+	while (true) {
+		struct pollfd fds[2] = {
+			{.fd = buffer->wake_fd, .events = POLLIN},
+			{.fd = buffer->fd, .events = POLLIN}
+		};
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			stop_capture(buffer, errno);
+			break;
+		}
+		if (fds[0].revents & POLLIN) {
+			// Closed by iio_buffer_close
+			break;
+		}
+		if (!(fds[1].revents & POLLIN)) {
+			if (fds[1].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+				// The device went away, or its buffer was disabled
+				stop_capture(buffer, EPIPE);
+				break;
+			}
+			continue;
+		}
+
+		const ssize_t len = read(buffer->fd, data + pending, buffer->sample_size * READ_BLOCK_SAMPLES - pending);
+		if (len < 0) {
+			if (errno == EAGAIN || errno == EINTR) {
+				continue;
+			}
+			stop_capture(buffer, errno);
+			break;
+		}
+		if (len == 0) {
+			stop_capture(buffer, EPIPE);
+			break;
+		}
+
+		const size_t available = pending + len;
+		const size_t num_samples = available / buffer->sample_size;
+		store_samples(buffer, data, num_samples);
+
+		pending = available - num_samples * buffer->sample_size;
+		memmove(data, data + num_samples * buffer->sample_size, pending);
+	}
+
+	free(data);
+	return NULL;
+}
+
+/**
+ * @brief Closes the file descriptors of a capture and frees it.
+ */
+static void free_buffer(iio_buffer_t* buffer) {
+	if (buffer->fd >= 0) {
+		close(buffer->fd);
+	}
+	if (buffer->wake_fd >= 0) {
+		close(buffer->wake_fd);
+	}
+	pthread_mutex_destroy(&buffer->lock);
+	free(buffer->ring);
+	free(buffer);
+}
+
+iio_buffer_t* iio_buffer_open(const iio_buffer_config_t* config) {
+	if (config == NULL || config->channels == NULL) {
+		errno = EFAULT;
+		return NULL;
+	}
+	if (config->num_channels == 0 || config->num_channels > IIO_BUFFER_MAX_CHANNELS || config->ring_length == 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+	for (size_t i = 0; i < config->num_channels; i++) {
+		if (config->channels[i] == NULL) {
+			errno = EFAULT;
+			return NULL;
+		}
+	}
+
+	iio_buffer_t* buffer = calloc(1, sizeof(iio_buffer_t));
+	if (buffer == NULL) {
+		return NULL;
+	}
+	buffer->fd = -1;
+	buffer->wake_fd = -1;
+	pthread_mutex_init(&buffer->lock, NULL);
+	buffer->num_channels = config->num_channels;
+	buffer->ring_length = config->ring_length;
+	buffer->ring = calloc(config->ring_length, sizeof(iio_buffer_sample_t));
+	if (buffer->ring == NULL) {
+		free_buffer(buffer);
+		return NULL;
+	}
+
+	const char* sysfs_root = config->sysfs_root != NULL ? config->sysfs_root : IIO_BUFFER_DEFAULT_SYSFS_ROOT;
+	const char* dev_root = config->dev_root != NULL ? config->dev_root : IIO_BUFFER_DEFAULT_DEV_ROOT;
+	char scan_dir[PATH_MAX], dev_path[PATH_MAX];
+	if (snprintf(buffer->device_dir, sizeof(buffer->device_dir), "%s/iio:device%u", sysfs_root, config->device) >= (int) sizeof(buffer->device_dir) ||
+	    snprintf(scan_dir, sizeof(scan_dir), "%s/scan_elements", buffer->device_dir) >= (int) sizeof(scan_dir) ||
+	    snprintf(dev_path, sizeof(dev_path), "%s/iio:device%u", dev_root, config->device) >= (int) sizeof(dev_path)) {
+		free_buffer(buffer);
+		errno = ENAMETOOLONG;
+		return NULL;
+	}
+
+	// The scan elements and the trigger can only be changed with the buffer disabled
+	bool has_timestamp;
+	char length[16];
+	if (write_attribute(buffer->device_dir, "buffer/enable", "0") != 0 ||
+	    enable_elements(scan_dir, config, &has_timestamp) != 0) {
+		goto error;
+	}
+
+	for (size_t i = 0; i < config->num_channels; i++) {
+		struct element_t* element = &buffer->elements[buffer->num_elements++];
+		if (read_element(scan_dir, config->channels[i], element) != 0) {
+			goto error;
+		}
+		element->channel = i;
+	}
+	if (has_timestamp) {
+		struct element_t* element = &buffer->elements[buffer->num_elements++];
+		if (read_element(scan_dir, TIMESTAMP_ELEMENT, element) != 0) {
+			goto error;
+		}
+		element->channel = -1;
+	}
+	compute_layout(buffer);
+
+	if (config->trigger != NULL && write_attribute(buffer->device_dir, "trigger/current_trigger", config->trigger) != 0) {
+		goto error;
+	}
+	snprintf(length, sizeof(length), "%u", config->kernel_length);
+	if (config->kernel_length != 0 && write_attribute(buffer->device_dir, "buffer/length", length) != 0) {
+		goto error;
+	}
+
+	buffer->fd = open(dev_path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	buffer->wake_fd = eventfd(0, EFD_CLOEXEC);
+	if (buffer->fd < 0 || buffer->wake_fd < 0 ||
+	    write_attribute(buffer->device_dir, "buffer/enable", "1") != 0) {
+		goto error;
+	}
+
+	int ret = pthread_create(&buffer->thread, NULL, capture, buffer);
+	if (ret != 0) {
+		write_attribute(buffer->device_dir, "buffer/enable", "0");
+		errno = ret;
+		goto error;
+	}
+
+	errno = 0;
+	return buffer;
+
+error:;
+	const int saved_errno = errno;
+	free_buffer(buffer);
+	errno = saved_errno;
+	return NULL;
+}
+
+int iio_buffer_close(iio_buffer_t** pointer_to_buffer) {
+	if (pointer_to_buffer == NULL || *pointer_to_buffer == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	iio_buffer_t* buffer = *pointer_to_buffer;
+
+	const uint64_t one = 1;
+	if (write(buffer->wake_fd, &one, sizeof(one)) < 0) {
+		// The counter can't overflow, so the thread is woken up anyway
+	}
+	pthread_join(buffer->thread, NULL);
+
+	int ret = write_attribute(buffer->device_dir, "buffer/enable", "0");
+	const int saved_errno = errno;
+	free_buffer(buffer);
+	*pointer_to_buffer = NULL;
+
+	errno = ret == 0 ? 0 : saved_errno;
+	return ret;
+}
+
+int iio_buffer_latest(iio_buffer_t* buffer, size_t channel, uint16_t* value) {
+	if (buffer == NULL || value == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (channel >= buffer->num_channels) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&buffer->lock);
+	const bool has_latest = buffer->has_latest;
+	const int error = buffer->error;
+	*value = buffer->latest.values[channel];
+	pthread_mutex_unlock(&buffer->lock);
+
+	// The latest value would never change again
+	if (error != 0) {
+		errno = EPIPE;
+		return -1;
+	}
+	if (!has_latest) {
+		errno = EAGAIN;
+		return -1;
+	}
+	return 0;
+}
+
+size_t iio_buffer_read_block(iio_buffer_t* buffer, iio_buffer_sample_t* samples, size_t max_samples) {
+	if (buffer == NULL || samples == NULL) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&buffer->lock);
+	size_t num = 0;
+	while (num < max_samples && buffer->ring_count > 0) {
+		samples[num++] = buffer->ring[buffer->ring_head];
+		buffer->ring_head = (buffer->ring_head + 1) % buffer->ring_length;
+		buffer->ring_count--;
+	}
+	pthread_mutex_unlock(&buffer->lock);
+
+	return num;
+}
+
+uint64_t iio_buffer_dropped(iio_buffer_t* buffer) {
+	if (buffer == NULL) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&buffer->lock);
+	const uint64_t dropped = buffer->dropped;
+	pthread_mutex_unlock(&buffer->lock);
+	return dropped;
+}
+
+int iio_buffer_error(iio_buffer_t* buffer) {
+	if (buffer == NULL) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&buffer->lock);
+	const int error = buffer->error;
+	pthread_mutex_unlock(&buffer->lock);
+	return error;
+}
+
+#endif // PLC_ENVIRONMENT == Linux
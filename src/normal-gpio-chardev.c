@@ -0,0 +1,653 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <normal-gpio-chardev.h>
+
+#if defined(PLC_PERIPHERALS_NORMAL_GPIO_CHARDEV) && defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <expanded-gpio.h>
+#include <gpio-chardev.h>
+#include <iio-buffer.h>
+#include <pulse-counter.h>
+#include <pwm-sysfs.h>
+
+#define CONSUMER "plc-peripherals"
+#define CHIP_PATH_SIZE 64
+#define PWM_MAX_VALUE 4095
+
+const uint8_t NORMAL_GPIO_INPUT = 0;
+const uint8_t NORMAL_GPIO_OUTPUT = 1;
+
+// All the lines of a chip, behind a single request (and the counters, behind another one)
+struct chip_request_t {
+	char chip[CHIP_PATH_SIZE];
+	int fd;
+	size_t num_lines;
+	uint32_t offsets[GPIO_CHARDEV_MAX_LINES];
+	uint64_t outputs; // Lines configured as outputs
+	uint64_t values; // Last values written to the outputs
+
+	pulse_counter_t* counter;
+	size_t num_counter_lines;
+	uint32_t counter_offsets[GPIO_CHARDEV_MAX_LINES];
+};
+
+// Where every direct pin is
+struct pin_line_t {
+	uint32_t offset;
+	uint8_t request;
+	uint8_t bit; // In the request of the chip, or in its counter
+	bool counter;
+};
+
+static struct chip_request_t requests[NORMAL_GPIO_CHARDEV_MAX_CHIPS];
+static size_t num_requests = 0;
+static struct pin_line_t pins[NORMAL_GPIO_CHARDEV_MAX_PINS];
+static size_t num_pins = 0;
+static bool requested = false;
+
+// Direct pins counting pulses
+static uint64_t counter_pins = 0;
+static uint8_t counter_flags = GPIO_CHARDEV_EDGE_RISING;
+static uint32_t counter_gate_ms = 0;
+
+// Direct pins with a hardware PWM channel
+struct pin_pwm_t {
+	normal_gpio_chardev_pwm_t config;
+	pwm_sysfs_t* pwm;
+	uint16_t value; // Last duty cycle written (0-4095)
+};
+
+static char pwm_root[PATH_MAX] = PWM_SYSFS_DEFAULT_ROOT;
+static struct pin_pwm_t pwms[NORMAL_GPIO_CHARDEV_MAX_PWMS];
+static size_t num_pwms = 0;
+
+// Direct pins captured by an IIO device
+static iio_buffer_config_t analog_config;
+static uint32_t analog_pins[IIO_BUFFER_MAX_CHANNELS];
+static bool analog_configured = false;
+static iio_buffer_t* analog_buffer = NULL;
+
+
+int normal_gpio_chardev_set_lines(const normal_gpio_chardev_line_t* lines, size_t num_lines) {
+	if (lines == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (num_lines == 0 || num_lines > NORMAL_GPIO_CHARDEV_MAX_PINS) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (requested) {
+		errno = EBUSY;
+		return -1;
+	}
+
+	size_t new_num_requests = 0;
+	for (size_t i = 0; i < num_lines; i++) {
+		if (lines[i].chip == NULL) {
+			errno = EFAULT;
+			return -1;
+		}
+		if (strlen(lines[i].chip) >= CHIP_PATH_SIZE) {
+			errno = ENAMETOOLONG;
+			return -1;
+		}
+
+		size_t r = 0;
+		while (r < new_num_requests && strcmp(requests[r].chip, lines[i].chip) != 0) {
+			r++;
+		}
+		if (r == new_num_requests) {
+			if (new_num_requests == NORMAL_GPIO_CHARDEV_MAX_CHIPS) {
+				errno = ENOSPC;
+				return -1;
+			}
+			memset(&requests[r], 0, sizeof(requests[r]));
+			strcpy(requests[r].chip, lines[i].chip);
+			requests[r].fd = -1;
+			new_num_requests++;
+		}
+
+		pins[i].request = r;
+		pins[i].offset = lines[i].offset;
+		pins[i].counter = false;
+	}
+
+	num_requests = new_num_requests;
+	num_pins = num_lines;
+	counter_pins = 0;
+	return 0;
+}
+
+int normal_gpio_chardev_set_counters(const uint32_t* counter_list, size_t num_counters, uint8_t flags, uint32_t gate_ms) {
+	if (counter_list == NULL && num_counters > 0) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (!(flags & GPIO_CHARDEV_EDGE_BOTH)) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (requested) {
+		errno = EBUSY;
+		return -1;
+	}
+
+	uint64_t new_counter_pins = 0;
+	for (size_t i = 0; i < num_counters; i++) {
+		if (counter_list[i] >= num_pins) {
+			errno = EINVAL;
+			return -1;
+		}
+		new_counter_pins |= 1ULL << counter_list[i];
+	}
+
+	for (size_t pin = 0; pin < num_pins; pin++) {
+		pins[pin].counter = (new_counter_pins >> pin) & 1;
+	}
+	counter_pins = new_counter_pins;
+	counter_flags = flags;
+	counter_gate_ms = gate_ms;
+	return 0;
+}
+
+int normal_gpio_chardev_set_pwms(const char* root, const normal_gpio_chardev_pwm_t* channels, size_t num_channels) {
+	if (channels == NULL && num_channels > 0) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (num_channels > NORMAL_GPIO_CHARDEV_MAX_PWMS) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (requested) {
+		errno = EBUSY;
+		return -1;
+	}
+	if (root == NULL) {
+		root = PWM_SYSFS_DEFAULT_ROOT;
+	}
+	if (strlen(root) >= sizeof(pwm_root)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+
+	strcpy(pwm_root, root);
+	for (size_t i = 0; i < num_channels; i++) {
+		pwms[i] = (struct pin_pwm_t) {
+			.config = channels[i],
+			.pwm = NULL,
+			.value = 0
+		};
+	}
+	num_pwms = num_channels;
+	return 0;
+}
+
+int normal_gpio_chardev_set_analog(const iio_buffer_config_t* config, const uint32_t* pins) {
+	if (requested) {
+		errno = EBUSY;
+		return -1;
+	}
+	if (config == NULL) {
+		analog_configured = false;
+		return 0;
+	}
+	if (pins == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (config->num_channels == 0 || config->num_channels > IIO_BUFFER_MAX_CHANNELS) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	analog_config = *config;
+	memcpy(analog_pins, pins, config->num_channels * sizeof(pins[0]));
+	analog_configured = true;
+	return 0;
+}
+
+iio_buffer_t* normal_gpio_chardev_analog_buffer(void) {
+	return analog_buffer;
+}
+
+/**
+ * @brief Gets the counter of a direct pin.
+ *
+ * @return Pointer to the counter, or NULL on failure (errno is set).
+ */
+static pulse_counter_t* pin_counter(uint32_t pin) {
+	if (pin >= num_pins || !pins[pin].counter) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	pulse_counter_t* counter = requests[pins[pin].request].counter;
+	if (counter == NULL) {
+		errno = EBADFD;
+	}
+	return counter;
+}
+
+int normal_gpio_chardev_read_counter(uint32_t pin, pulse_counter_reading_t* reading) {
+	pulse_counter_t* counter = pin_counter(pin);
+	if (counter == NULL) {
+		return -1;
+	}
+	return pulse_counter_read(counter, pins[pin].bit, reading);
+}
+
+int normal_gpio_chardev_reset_counter(uint32_t pin) {
+	pulse_counter_t* counter = pin_counter(pin);
+	if (counter == NULL) {
+		return -1;
+	}
+	return pulse_counter_reset(counter, pins[pin].bit);
+}
+
+uint64_t normal_gpio_chardev_missed_pulses(void) {
+	uint64_t missed = 0;
+	for (size_t r = 0; r < num_requests; r++) {
+		missed += pulse_counter_missed(requests[r].counter);
+	}
+	return missed;
+}
+
+/**
+ * @brief Closes all the PWM channels.
+ *
+ * @return 0 on success, -1 on failure (errno is set by pwm_sysfs_close).
+ */
+static int close_pwms(void) {
+	int ret = 0;
+	for (size_t i = 0; i < num_pwms; i++) {
+		if (pwms[i].pwm != NULL && pwm_sysfs_close(&pwms[i].pwm) != 0) {
+			ret = -1;
+		}
+	}
+	return ret;
+}
+
+/**
+ * @brief Opens all the PWM channels.
+ *
+ * The channels without period (just exported) get the default frequency.
+ *
+ * @return 0 on success, -1 on failure (errno is set by the pwm_sysfs functions).
+ */
+static int open_pwms(void) {
+	for (size_t i = 0; i < num_pwms; i++) {
+		pwms[i].pwm = pwm_sysfs_open(pwm_root, pwms[i].config.chip, pwms[i].config.channel);
+		if (pwms[i].pwm == NULL) {
+			return -1;
+		}
+		if (pwm_sysfs_get_period(pwms[i].pwm) == 0 &&
+		    pwm_sysfs_set_period(pwms[i].pwm, 1000000000ULL / NORMAL_GPIO_CHARDEV_PWM_DEFAULT_FREQ) != 0) {
+			return -1;
+		}
+		pwms[i].value = 0;
+	}
+	return 0;
+}
+
+/**
+ * @brief Places every direct pin in the request of its chip or in its counter.
+ */
+static void layout_lines(void) {
+	for (size_t r = 0; r < num_requests; r++) {
+		requests[r].num_lines = 0;
+		requests[r].num_counter_lines = 0;
+	}
+
+	for (size_t pin = 0; pin < num_pins; pin++) {
+		struct chip_request_t* request = &requests[pins[pin].request];
+		if (pins[pin].counter) {
+			pins[pin].bit = request->num_counter_lines;
+			request->counter_offsets[request->num_counter_lines++] = pins[pin].offset;
+		} else {
+			pins[pin].bit = request->num_lines;
+			request->offsets[request->num_lines++] = pins[pin].offset;
+		}
+	}
+}
+
+/**
+ * @brief Requests the lines and starts the counters of every chip.
+ *
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+static int request_chips(void) {
+	for (size_t r = 0; r < num_requests; r++) {
+		struct chip_request_t* request = &requests[r];
+		request->outputs = 0;
+		request->values = 0;
+
+		if (request->num_lines > 0) {
+			request->fd = gpio_chardev_request_inputs(request->chip, request->offsets, request->num_lines, 0, CONSUMER);
+			if (request->fd < 0) {
+				return -1;
+			}
+		}
+		if (request->num_counter_lines > 0) {
+			request->counter = pulse_counter_open(request->chip, request->counter_offsets, request->num_counter_lines, counter_flags, counter_gate_ms);
+			if (request->counter == NULL) {
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+int normal_gpio_init(void) {
+	if (requested) {
+		return 0;
+	}
+
+	layout_lines();
+	requested = true;
+
+	if (request_chips() != 0 ||
+	    open_pwms() != 0 ||
+	    (analog_configured && (analog_buffer = iio_buffer_open(&analog_config)) == NULL)) {
+		const int saved_errno = errno;
+		normal_gpio_deinit();
+		errno = saved_errno;
+		return -1;
+	}
+
+	return 0;
+}
+
+int normal_gpio_deinit(void) {
+	int ret = 0;
+	for (size_t r = 0; r < num_requests; r++) {
+		if (requests[r].fd >= 0 && gpio_chardev_release(requests[r].fd) != 0) {
+			ret = -1;
+		}
+		requests[r].fd = -1;
+		if (requests[r].counter != NULL && pulse_counter_close(&requests[r].counter) != 0) {
+			ret = -1;
+		}
+	}
+	if (close_pwms() != 0) {
+		ret = -1;
+	}
+	if (analog_buffer != NULL && iio_buffer_close(&analog_buffer) != 0) {
+		ret = -1;
+	}
+
+	requested = false;
+	return ret;
+}
+
+/**
+ * @brief Gets the request and the bit of a direct pin.
+ *
+ * @return Pointer to the request, or NULL on failure (errno is set).
+ */
+static struct chip_request_t* pin_request(uint32_t pin, uint64_t* bit) {
+	if (pin >= num_pins) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (pins[pin].counter) {
+		errno = EBUSY;
+		return NULL;
+	}
+
+	struct chip_request_t* request = &requests[pins[pin].request];
+	if (request->fd < 0) {
+		errno = EBADFD;
+		return NULL;
+	}
+
+	*bit = 1ULL << pins[pin].bit;
+	return request;
+}
+
+int normal_gpio_set_pin_mode(uint32_t pin, uint8_t mode) {
+	uint64_t bit;
+	struct chip_request_t* request = pin_request(pin, &bit);
+	if (request == NULL) {
+		return -1;
+	}
+
+	const uint64_t outputs = mode == NORMAL_GPIO_OUTPUT ? request->outputs | bit : request->outputs & ~bit;
+	if (outputs == request->outputs) {
+		return 0;
+	}
+
+	// The whole request is reconfigured, the other outputs keep their values
+	if (gpio_chardev_set_directions(request->fd, outputs, request->values, 0) != 0) {
+		return -1;
+	}
+	request->outputs = outputs;
+	return 0;
+}
+
+int normal_gpio_write(uint32_t pin, uint8_t value) {
+	if (pin >= num_pins) {
+		errno = EINVAL;
+		return -1;
+	}
+	return normal_gpio_write_all(1ULL << pin, value ? ~0ULL : 0);
+}
+
+int normal_gpio_read(uint32_t pin, uint8_t* read) {
+	if (pin >= num_pins) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	uint64_t values;
+	if (normal_gpio_read_all(1ULL << pin, &values) != 0) {
+		return -1;
+	}
+
+	*read = values ? 1 : 0;
+	return 0;
+}
+
+/**
+ * @brief Gets the PWM channel of a direct pin.
+ *
+ * @return Pointer to the channel, or NULL on failure (errno is set).
+ */
+static struct pin_pwm_t* pin_pwm(uint32_t pin) {
+	for (size_t i = 0; i < num_pwms; i++) {
+		if (pwms[i].config.pin == pin) {
+			if (pwms[i].pwm == NULL) {
+				errno = EBADFD;
+				return NULL;
+			}
+			return &pwms[i];
+		}
+	}
+
+	errno = ENOTSUP;
+	return NULL;
+}
+
+static inline uint64_t duty_from_value(uint64_t period_ns, uint16_t value) {
+	return period_ns * value / PWM_MAX_VALUE;
+}
+
+int normal_gpio_pwm_frequency(uint32_t pin, uint32_t freq) {
+	if (freq == 0 || freq > 1000000000UL) {
+		errno = EINVAL;
+		return -1;
+	}
+	struct pin_pwm_t* channel = pin_pwm(pin);
+	if (channel == NULL) {
+		return -1;
+	}
+
+	// The duty cycle must fit in the period before and after the change
+	const uint64_t period_ns = 1000000000ULL / freq;
+	const uint64_t duty_ns = duty_from_value(period_ns, channel->value);
+	if (period_ns <= pwm_sysfs_get_period(channel->pwm)) {
+		if (pwm_sysfs_set_duty_cycle(channel->pwm, duty_ns) != 0) {
+			return -1;
+		}
+		return pwm_sysfs_set_period(channel->pwm, period_ns);
+	}
+
+	if (pwm_sysfs_set_period(channel->pwm, period_ns) != 0) {
+		return -1;
+	}
+	return pwm_sysfs_set_duty_cycle(channel->pwm, duty_ns);
+}
+
+int normal_gpio_pwm_write(uint32_t pin, uint16_t value) {
+	if (value > PWM_MAX_VALUE) {
+		value = PWM_MAX_VALUE;
+	}
+	struct pin_pwm_t* channel = pin_pwm(pin);
+	if (channel == NULL) {
+		return -1;
+	}
+
+	const uint64_t duty_ns = duty_from_value(pwm_sysfs_get_period(channel->pwm), value);
+	if (pwm_sysfs_set_duty_cycle(channel->pwm, duty_ns) != 0) {
+		return -1;
+	}
+	channel->value = value;
+
+	// Only the first write enables the output, the next ones are a single pwrite (or none)
+	return pwm_sysfs_enable(channel->pwm, true);
+}
+
+int normal_gpio_analog_read(uint32_t pin, uint16_t* read) {
+	if (analog_buffer == NULL) {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	// Served from the latest sample, without any system call
+	for (size_t i = 0; i < analog_config.num_channels; i++) {
+		if (analog_pins[i] == pin) {
+			return iio_buffer_latest(analog_buffer, i, read);
+		}
+	}
+
+	errno = ENOTSUP;
+	return -1;
+}
+
+/**
+ * @brief Splits a bitmask of pins in a bitmask of lines per request.
+ *
+ * @return 0 on success, -1 if a pin doesn't exist (errno is set).
+ */
+static int split_mask(uint64_t mask, uint64_t values, uint64_t* line_masks, uint64_t* line_values) {
+	if (num_pins < 64 && (mask >> num_pins) != 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (!requested) {
+		errno = EBADFD;
+		return -1;
+	}
+
+	memset(line_masks, 0, num_requests * sizeof(line_masks[0]));
+	memset(line_values, 0, num_requests * sizeof(line_values[0]));
+	mask &= ~counter_pins;
+	while (mask) {
+		const int pin = __builtin_ctzll(mask);
+		mask &= mask - 1;
+
+		const uint64_t bit = 1ULL << pins[pin].bit;
+		line_masks[pins[pin].request] |= bit;
+		if (values & (1ULL << pin)) {
+			line_values[pins[pin].request] |= bit;
+		}
+	}
+	return 0;
+}
+
+// Optional bulk functions of expanded-gpio, one ioctl per chip
+int normal_gpio_write_all(uint64_t mask, uint64_t values) {
+	if (mask & counter_pins) {
+		errno = EBUSY;
+		return -1;
+	}
+
+	uint64_t line_masks[NORMAL_GPIO_CHARDEV_MAX_CHIPS];
+	uint64_t line_values[NORMAL_GPIO_CHARDEV_MAX_CHIPS];
+	if (split_mask(mask, values, line_masks, line_values) != 0) {
+		return -1;
+	}
+
+	for (size_t r = 0; r < num_requests; r++) {
+		if (line_masks[r] == 0) {
+			continue;
+		}
+		if (gpio_chardev_set_values(requests[r].fd, line_masks[r], line_values[r]) != 0) {
+			return -1;
+		}
+		requests[r].values = (requests[r].values & ~line_masks[r]) | line_values[r];
+	}
+
+	return 0;
+}
+
+int normal_gpio_read_all(uint64_t mask, uint64_t* values) {
+	if (values == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	uint64_t line_masks[NORMAL_GPIO_CHARDEV_MAX_CHIPS];
+	uint64_t line_values[NORMAL_GPIO_CHARDEV_MAX_CHIPS];
+	if (split_mask(mask, 0, line_masks, line_values) != 0) {
+		return -1;
+	}
+
+	uint64_t counter_levels[NORMAL_GPIO_CHARDEV_MAX_CHIPS] = {0};
+	for (size_t r = 0; r < num_requests; r++) {
+		if (line_masks[r] != 0 && gpio_chardev_get_values(requests[r].fd, line_masks[r], &line_values[r]) != 0) {
+			return -1;
+		}
+		if ((mask & counter_pins) && requests[r].counter != NULL &&
+		    pulse_counter_levels(requests[r].counter, &counter_levels[r]) != 0) {
+			return -1;
+		}
+	}
+
+	// Back from lines to pins
+	uint64_t result = 0;
+	for (size_t pin = 0; pin < num_pins; pin++) {
+		const uint64_t* levels = pins[pin].counter ? counter_levels : line_values;
+		if ((mask & (1ULL << pin)) && (levels[pins[pin].request] & (1ULL << pins[pin].bit))) {
+			result |= 1ULL << pin;
+		}
+	}
+
+	*values = result;
+	return 0;
+}
+
+#endif // PLC_PERIPHERALS_NORMAL_GPIO_CHARDEV && PLC_ENVIRONMENT == Linux
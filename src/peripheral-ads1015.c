@@ -86,11 +86,7 @@ int ads1015_deinit(i2c_interface_t* i2c, uint8_t addr) {
 	return 0;
 }
 
-int ads1015_read(i2c_interface_t* i2c, uint8_t addr, uint8_t index, int16_t* read_value) {
-	if (read_value == NULL) {
-		errno = EFAULT;
-		return -1;
-	}
+int ads1015_start_conversion(i2c_interface_t* i2c, uint8_t addr, uint8_t index) {
 	uint8_t mux;
 	switch (index) {
 	case 0:
@@ -120,18 +116,22 @@ int ads1015_read(i2c_interface_t* i2c, uint8_t addr, uint8_t index, int16_t* rea
 	buffer[2] = CONFIG_L_CQUE_NONE | CONFIG_L_CLAT_NONE | CONFIG_L_CPOL_LOW | CONFIG_L_CMODE_HYST | CONFIG_L_DR_1600;
 	const i2c_write_t start_conversion = {.buff=buffer, .len=sizeof(buffer)};
 
-	int i2c_ret = i2c_write(i2c, addr, &start_conversion);
-	if (i2c_ret != 0) {
-		return i2c_ret;
+	return i2c_write(i2c, addr, &start_conversion);
+}
+
+int ads1015_read_conversion(i2c_interface_t* i2c, uint8_t addr, int16_t* read_value) {
+	if (read_value == NULL) {
+		errno = EFAULT;
+		return -1;
 	}
 
-	usleep(650);
+	uint8_t buffer[2];
 
 	buffer[0] = CONVERSION_REGISTER;
 	const i2c_write_t read_conversion_reg = {.buff=buffer, .len=1};
 	const i2c_read_t read_conversion = {.buff=buffer, .len=2}; // It must return two bytes
 
-	i2c_ret = i2c_write_then_read(i2c, addr, &read_conversion_reg, &read_conversion);
+	const int i2c_ret = i2c_write_then_read(i2c, addr, &read_conversion_reg, &read_conversion);
 	if (i2c_ret != 0) {
 		return i2c_ret;
 	}
@@ -146,15 +146,11 @@ int ads1015_read(i2c_interface_t* i2c, uint8_t addr, uint8_t index, int16_t* rea
 	return 0;
 }
 
-int ads1015_unsigned_read(i2c_interface_t* i2c, uint8_t addr, uint8_t index, uint16_t* read_value) {
-	int16_t signed_value;
-	int i2c_ret = ads1015_read(i2c, addr, index, &signed_value);
-
-	if (i2c_ret < 0) {
-		return i2c_ret;
-	}
-
-	else if (signed_value < 0) {
+/**
+ * @brief Converts a signed result to the unsigned one of a single-ended measurement.
+ */
+static int to_unsigned(int16_t signed_value, uint16_t* read_value) {
+	if (signed_value < 0) {
 		/* Quote from the ADS1015 datasheet, page 22:
 		 * Single-ended signal measurements, where VAINN = 0 V and VAINP = 0 V to +FS, only use
 		 * the positive code range from 0000h to 7FF0h. However, because of device offset, the
@@ -174,3 +170,51 @@ int ads1015_unsigned_read(i2c_interface_t* i2c, uint8_t addr, uint8_t index, uin
 
 	return 0;
 }
+
+int ads1015_read(i2c_interface_t* i2c, uint8_t addr, uint8_t index, int16_t* read_value) {
+	if (read_value == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	int i2c_ret = ads1015_start_conversion(i2c, addr, index);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	usleep(ADS1015_CONVERSION_US);
+
+	return ads1015_read_conversion(i2c, addr, read_value);
+}
+
+int ads1015_unsigned_read(i2c_interface_t* i2c, uint8_t addr, uint8_t index, uint16_t* read_value) {
+	if (read_value == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	int16_t signed_value;
+	int i2c_ret = ads1015_read(i2c, addr, index, &signed_value);
+
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	return to_unsigned(signed_value, read_value);
+}
+
+int ads1015_unsigned_read_conversion(i2c_interface_t* i2c, uint8_t addr, uint16_t* read_value) {
+	if (read_value == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	int16_t signed_value;
+	int i2c_ret = ads1015_read_conversion(i2c, addr, &signed_value);
+
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	return to_unsigned(signed_value, read_value);
+}
@@ -20,8 +20,15 @@
 #include <peripheral-mcp23008.h>
 
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+#include <stdbool.h>
+#include <time.h>
+#include <gpio-chardev.h>
+#endif
+
 // Registers
 #define IODIR_REGISTER		0x00
 #define IPOL_REGISTER		0x01
@@ -68,89 +75,111 @@ static inline int write_reg(i2c_interface_t* i2c, uint8_t addr, uint8_t reg, uin
 }
 
 /**
- * @brief Resets the MCP23008 GPIO expander.
+ * @brief Reads the IOCON and GPPU registers of the MCP23008 in a single transaction.
  *
- * This function resets the MCP23008 GPIO expander to its default configuration.
+ * Both registers are read with a combined transaction, so it works regardless of the
+ * sequential operation mode of the device.
  *
  * @param i2c Pointer to the I2C interface structure.
  * @param addr The I2C address of the MCP23008.
+ * @param iocon Pointer where the IOCON register will be stored.
+ * @param gppu Pointer where the GPPU register will be stored.
  * @return 0 on success, -1 on failure.
- *         On failure, errno is set as described in the write_regs function documentation.
+ *         On failure, errno is set as described in the i2c_write_then_read_multiple function documentation.
  */
-static int mcp23008_reset(i2c_interface_t* i2c, uint8_t addr) {
-	int i2c_ret;
-
-	i2c_ret = write_reg(i2c, addr, IODIR_REGISTER, 0xFF);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-
-	i2c_ret = write_reg(i2c, addr, IPOL_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-
-	i2c_ret = write_reg(i2c, addr, GPINTEN_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-
-	i2c_ret = write_reg(i2c, addr, DEFVAL_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-
-	i2c_ret = write_reg(i2c, addr, INTCON_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-
-	i2c_ret = write_reg(i2c, addr, IOCON_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
+static inline int read_config(i2c_interface_t* i2c, uint8_t addr, uint8_t* iocon, uint8_t* gppu) {
+	const i2c_write_t read_orders[] = {
+		{.buff = (const uint8_t[]) {IOCON_REGISTER}, .len = 1},
+		{.buff = (const uint8_t[]) {GPPU_REGISTER}, .len = 1}
+	};
+	const i2c_read_t to_reads[] = {
+		{.buff = iocon, .len = 1},
+		{.buff = gppu, .len = 1}
+	};
+
+	return i2c_write_then_read_multiple(i2c, addr, read_orders, to_reads, 2);
+}
 
-	i2c_ret = write_reg(i2c, addr, GPPU_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
+/**
+ * @brief Enables the sequential operation mode, needed to program the registers in a burst.
+ *
+ * The address pointer of the MCP23008 only increments after each byte when IOCON.SEQOP is
+ * cleared, so it is cleared (along with the rest of IOCON) if it is set.
+ *
+ * @param i2c Pointer to the I2C interface structure.
+ * @param addr The I2C address of the MCP23008.
+ * @param iocon The current value of the IOCON register.
+ * @return 0 on success, -1 on failure.
+ *         On failure, errno is set as described in the write_reg function documentation.
+ */
+static inline int enable_sequential_mode(i2c_interface_t* i2c, uint8_t addr, uint8_t iocon) {
+	if (iocon & IOCON_SEQOP) {
+		return write_reg(i2c, addr, IOCON_REGISTER, 0x00);
 	}
+	return 0;
+}
 
-	i2c_ret = write_reg(i2c, addr, INTF_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
+/**
+ * @brief Resets the MCP23008 GPIO expander.
+ *
+ * This function resets the MCP23008 GPIO expander to its default configuration, writing the
+ * whole register file with a single burst. Sequential operation must be enabled.
+ *
+ * @param i2c Pointer to the I2C interface structure.
+ * @param addr The I2C address of the MCP23008.
+ * @return 0 on success, -1 on failure.
+ *         On failure, errno is set as described in the write_reg function documentation.
+ */
+static int mcp23008_reset(i2c_interface_t* i2c, uint8_t addr) {
+	FAST_CREATE_I2C_WRITE(reset_regs, IODIR_REGISTER,
+		0xFF,	// IODIR
+		0x00,	// IPOL
+		0x00,	// GPINTEN
+		0x00,	// DEFVAL
+		0x00,	// INTCON
+		0x00,	// IOCON
+		0x00,	// GPPU
+		0x00,	// INTF (read-only)
+		0x00,	// INTCAP (read-only)
+		0x00,	// GPIO
+		0x00	// OLAT
+	);
+	return i2c_write(i2c, addr, &reset_regs);
+}
 
-	i2c_ret = write_reg(i2c, addr, INTCAP_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
+/**
+ * @brief Checks the configuration registers of the MCP23008 with a single burst read.
+ *
+ * The registers from IODIR to GPPU are read in a single transaction, so sequential
+ * operation must be enabled.
+ *
+ * @param i2c Pointer to the I2C interface structure.
+ * @param addr The I2C address of the MCP23008.
+ * @param expected The expected values of the registers from IODIR to GPPU.
+ * @return 0 if they match, -1 on failure.
+ *         On failure, errno is set as described in the i2c_write_then_read function
+ *         documentation, or to EIO if the registers don't match.
+ */
+static int verify_config(i2c_interface_t* i2c, uint8_t addr, const uint8_t expected[GPPU_REGISTER + 1]) {
+	FAST_CREATE_I2C_WRITE(read_order_config_regs, IODIR_REGISTER);
+	uint8_t config[GPPU_REGISTER + 1];
+	i2c_read_t read_config_regs = {.buff = config, .len = sizeof(config)};
 
-	i2c_ret = write_reg(i2c, addr, GPIO_REGISTER, 0x00);
+	int i2c_ret = i2c_write_then_read(i2c, addr, &read_order_config_regs, &read_config_regs);
 	if (i2c_ret != 0) {
 		return i2c_ret;
 	}
 
-	i2c_ret = write_reg(i2c, addr, OLAT_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
+	if (memcmp(config, expected, sizeof(config)) != 0) {
+		errno = EIO;
+		return -1;
 	}
-
 	return 0;
 }
 
 int mcp23008_init(i2c_interface_t* i2c, uint8_t addr) {
-	FAST_CREATE_I2C_WRITE(read_order_iocon_reg, IOCON_REGISTER);
-	FAST_CREATE_I2C_WRITE(read_order_gppu_reg, GPPU_REGISTER);
-
 	uint8_t iocon, gppu;
-	i2c_read_t read_iocon_reg = {.buff=&iocon, .len=1};
-	i2c_read_t read_gppu_reg = {.buff=&gppu, .len=1};
-
-	int i2c_ret = i2c_write_then_read(i2c, addr, &read_order_iocon_reg, &read_iocon_reg);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = i2c_write_then_read(i2c, addr, &read_order_gppu_reg, &read_gppu_reg);
+	int i2c_ret = read_config(i2c, addr, &iocon, &gppu);
 	if (i2c_ret != 0) {
 		return i2c_ret;
 	}
@@ -161,12 +190,44 @@ int mcp23008_init(i2c_interface_t* i2c, uint8_t addr) {
 		return 1;
 	}
 
-	i2c_ret = mcp23008_reset(i2c, addr);
+	i2c_ret = enable_sequential_mode(i2c, addr, iocon);
 	if (i2c_ret != 0) {
 		return i2c_ret;
 	}
 
-	// Sequential operation disabled, and INT as open-drain
+	/*
+	 * Reset the whole register file in a single burst. It starts at IODIR, so all
+	 * the pins are inputs before GPIO and OLAT are cleared: an output that was high
+	 * is never driven low. IOCON keeps sequential operation enabled for the burst
+	 * read that verifies the configuration.
+	 */
+	const uint8_t config[] = {
+		0xFF,	// IODIR
+		0x00,	// IPOL
+		0x00,	// GPINTEN
+		0x00,	// DEFVAL
+		0x00,	// INTCON
+		IOCON_ODR,	// IOCON
+		0x00	// GPPU
+	};
+	FAST_CREATE_I2C_WRITE(init_regs, IODIR_REGISTER,
+		config[0], config[1], config[2], config[3], config[4], config[5], config[6],
+		0x00,	// INTF (read-only)
+		0x00,	// INTCAP (read-only)
+		0x00,	// GPIO
+		0x00	// OLAT
+	);
+	i2c_ret = i2c_write(i2c, addr, &init_regs);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	i2c_ret = verify_config(i2c, addr, config);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	// Sequential operation is disabled last, which also marks the device as initialized
 	i2c_ret = write_reg(i2c, addr, IOCON_REGISTER, IOCON_SEQOP | IOCON_ODR);
 	if (i2c_ret != 0) {
 		return i2c_ret;
@@ -177,18 +238,8 @@ int mcp23008_init(i2c_interface_t* i2c, uint8_t addr) {
 }
 
 int mcp23008_deinit(i2c_interface_t* i2c, uint8_t addr) {
-        FAST_CREATE_I2C_WRITE(read_order_iocon_reg, IOCON_REGISTER);
-	FAST_CREATE_I2C_WRITE(read_order_gppu_reg, GPPU_REGISTER);
-
 	uint8_t iocon, gppu;
-	i2c_read_t read_iocon_reg = {.buff=&iocon, .len=1};
-	i2c_read_t read_gppu_reg = {.buff=&gppu, .len=1};
-
-	int i2c_ret = i2c_write_then_read(i2c, addr, &read_order_iocon_reg, &read_iocon_reg);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = i2c_write_then_read(i2c, addr, &read_order_gppu_reg, &read_gppu_reg);
+	int i2c_ret = read_config(i2c, addr, &iocon, &gppu);
 	if (i2c_ret != 0) {
 		return i2c_ret;
 	}
@@ -199,6 +250,11 @@ int mcp23008_deinit(i2c_interface_t* i2c, uint8_t addr) {
 		return 1;
 	}
 
+	i2c_ret = enable_sequential_mode(i2c, addr, iocon);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
         i2c_ret = mcp23008_reset(i2c, addr);
 	if (i2c_ret != 0) {
 		return i2c_ret;
@@ -209,6 +265,36 @@ int mcp23008_deinit(i2c_interface_t* i2c, uint8_t addr) {
 }
 
 
+/**
+ * @brief Writes the interrupt configuration registers that have changed.
+ *
+ * DEFVAL and INTCON are written before GPINTEN, so a pin is never enabled with
+ * its old comparison settings.
+ *
+ * @param i2c Pointer to the I2C interface structure.
+ * @param addr The I2C address of the MCP23008.
+ * @param old_regs Current values of GPINTEN, DEFVAL and INTCON.
+ * @param new_regs New values of GPINTEN, DEFVAL and INTCON.
+ * @return 0 on success, -1 on failure.
+ *         On failure, errno is set as described in the write_reg function documentation.
+ */
+static int write_interrupt_regs(i2c_interface_t* i2c, uint8_t addr, const uint8_t old_regs[3], const uint8_t new_regs[3]) {
+	static const uint8_t registers[3] = {GPINTEN_REGISTER, DEFVAL_REGISTER, INTCON_REGISTER};
+	static const uint8_t order[3] = {1, 2, 0};
+
+	for (size_t i = 0; i < 3; i++) {
+		const uint8_t reg = order[i];
+		if (old_regs[reg] != new_regs[reg]) {
+			int i2c_ret = write_reg(i2c, addr, registers[reg], new_regs[reg]);
+			if (i2c_ret != 0) {
+				return i2c_ret;
+			}
+		}
+	}
+
+	return 0;
+}
+
 int mcp23008_set_pin_mode(i2c_interface_t* i2c, uint8_t addr, uint8_t index, uint8_t mode) {
 	if (index >= 8 || mode >= 2) {
 	        errno = EINVAL;
@@ -341,3 +427,173 @@ int mcp23008_write_all(i2c_interface_t* i2c, uint8_t addr, uint8_t value) {
 	errno = 0;
 	return 0;
 }
+
+int mcp23008_read_state(i2c_interface_t* i2c, uint8_t addr, uint8_t state[MCP23008_STATE_SIZE]) {
+	if (state == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	// Sequential operation is disabled once initialized, so each register is read on its own
+	static const uint8_t registers[MCP23008_STATE_SIZE] = {
+		IODIR_REGISTER, IPOL_REGISTER, GPINTEN_REGISTER, DEFVAL_REGISTER,
+		INTCON_REGISTER, IOCON_REGISTER, GPPU_REGISTER, OLAT_REGISTER
+	};
+	i2c_write_t read_orders[MCP23008_STATE_SIZE];
+	i2c_read_t to_reads[MCP23008_STATE_SIZE];
+	for (size_t i = 0; i < MCP23008_STATE_SIZE; i++) {
+		read_orders[i] = (i2c_write_t) {.buff = &registers[i], .len = 1};
+		to_reads[i] = (i2c_read_t) {.buff = &state[i], .len = 1};
+	}
+
+	int i2c_ret = i2c_write_then_read_multiple(i2c, addr, read_orders, to_reads, MCP23008_STATE_SIZE);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	errno = 0;
+	return 0;
+}
+
+int mcp23008_set_interrupt(i2c_interface_t* i2c, uint8_t addr, uint8_t index, uint8_t mode) {
+	if (index >= 8 || mode > MCP23008_INT_ON_HIGH) {
+	        errno = EINVAL;
+	        return -1;
+        }
+
+	uint8_t gpinten, defval, intcon;
+	const i2c_write_t read_orders[] = {
+		{.buff = (const uint8_t[]) {GPINTEN_REGISTER}, .len = 1},
+		{.buff = (const uint8_t[]) {DEFVAL_REGISTER}, .len = 1},
+		{.buff = (const uint8_t[]) {INTCON_REGISTER}, .len = 1}
+	};
+	const i2c_read_t to_reads[] = {
+		{.buff = &gpinten, .len = 1},
+		{.buff = &defval, .len = 1},
+		{.buff = &intcon, .len = 1}
+	};
+
+	int i2c_ret = i2c_write_then_read_multiple(i2c, addr, read_orders, to_reads, 3);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	const uint8_t old_regs[3] = {gpinten, defval, intcon};
+	const uint8_t bit = 1 << index;
+	switch (mode) {
+		case MCP23008_INT_DISABLED:
+			gpinten &= ~bit;
+			break;
+		case MCP23008_INT_ON_CHANGE:
+			gpinten |= bit;
+			intcon &= ~bit;
+			break;
+		case MCP23008_INT_ON_LOW:
+			gpinten |= bit;
+			intcon |= bit;
+			defval |= bit;
+			break;
+		case MCP23008_INT_ON_HIGH:
+			gpinten |= bit;
+			intcon |= bit;
+			defval &= ~bit;
+			break;
+	}
+	const uint8_t new_regs[3] = {gpinten, defval, intcon};
+
+	i2c_ret = write_interrupt_regs(i2c, addr, old_regs, new_regs);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	errno = 0;
+	return 0;
+}
+
+int mcp23008_set_interrupt_all(i2c_interface_t* i2c, uint8_t addr, uint8_t enable, uint8_t compare, uint8_t defval) {
+	int i2c_ret = write_reg(i2c, addr, DEFVAL_REGISTER, defval);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	i2c_ret = write_reg(i2c, addr, INTCON_REGISTER, compare);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	i2c_ret = write_reg(i2c, addr, GPINTEN_REGISTER, enable);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	errno = 0;
+	return 0;
+}
+
+int mcp23008_read_interrupt(i2c_interface_t* i2c, uint8_t addr, uint8_t* flags, uint8_t* captured) {
+	if (flags == NULL || captured == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	// INTF must be read before INTCAP, which clears it
+	const i2c_write_t read_orders[] = {
+		{.buff = (const uint8_t[]) {INTF_REGISTER}, .len = 1},
+		{.buff = (const uint8_t[]) {INTCAP_REGISTER}, .len = 1}
+	};
+	const i2c_read_t to_reads[] = {
+		{.buff = flags, .len = 1},
+		{.buff = captured, .len = 1}
+	};
+
+	int i2c_ret = i2c_write_then_read_multiple(i2c, addr, read_orders, to_reads, 2);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	errno = 0;
+	return 0;
+}
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+int mcp23008_wait_interrupt(i2c_interface_t* i2c, uint8_t addr, int line_fd, int timeout_ms, uint8_t* flags, uint8_t* captured) {
+	if (flags == NULL || captured == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	struct timespec start, now;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (true) {
+		// The INT line may have been asserted before waiting, without an edge to wake up
+		uint64_t asserted;
+		if (gpio_chardev_get_values(line_fd, 1, &asserted) != 0) {
+			return -1;
+		}
+		if (asserted) {
+			int i2c_ret = mcp23008_read_interrupt(i2c, addr, flags, captured);
+			if (i2c_ret != 0) {
+				return i2c_ret;
+			}
+			if (*flags != 0) {
+				errno = 0;
+				return 0;
+			}
+			// The line is shared with another device
+		}
+
+		int remaining_ms = timeout_ms;
+		if (timeout_ms >= 0) {
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			const int64_t elapsed_ms = (now.tv_sec - start.tv_sec) * 1000LL + (now.tv_nsec - start.tv_nsec) / 1000000;
+			remaining_ms = elapsed_ms >= timeout_ms ? 0 : timeout_ms - elapsed_ms;
+		}
+
+		gpio_chardev_edge_t edge;
+		if (gpio_chardev_read_edge(line_fd, remaining_ms, &edge) != 0) {
+			return -1;
+		}
+	}
+}
+#endif
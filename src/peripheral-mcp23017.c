@@ -19,8 +19,15 @@
 
 #include <peripheral-mcp23017.h>
 
+#include <string.h>
 #include <errno.h>
 
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+#include <stdbool.h>
+#include <time.h>
+#include <gpio-chardev.h>
+#endif
+
 // Registers
 #define IODIR_A_REGISTER      0x00    
 #define IODIR_B_REGISTER      0x01
@@ -81,174 +88,215 @@ static inline int write_reg(i2c_interface_t* i2c, uint8_t addr, uint8_t reg, uin
 }
 
 /**
- * @brief Resets the MCP23017 GPIO expander.
+ * @brief Writes the A and B registers of a pair on the MCP23017.
  *
- * This function resets the MCP23017 GPIO expander to its default configuration.
+ * The address pointer goes from the A register to the B one both in sequential
+ * and byte mode, so both are written with a single transaction.
  *
  * @param i2c Pointer to the I2C interface structure.
  * @param addr The I2C address of the MCP23017.
+ * @param reg_a The address of the A register of the pair.
+ * @param value The value to write (the low byte to A, the high byte to B).
  * @return 0 on success, -1 on failure.
- *         On failure, errno is set as described in the write_regs function documentation.
+ *         On failure, errno is set as described in the write_reg function documentation.
  */
-static int mcp23017_reset(i2c_interface_t* i2c, uint8_t addr) {
-	int i2c_ret;
-
-
-	i2c_ret = write_reg(i2c, addr, IODIR_A_REGISTER, 0xFF);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = write_reg(i2c, addr, IODIR_B_REGISTER, 0xFF);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-
-	i2c_ret = write_reg(i2c, addr, IPOL_A_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = write_reg(i2c, addr, IPOL_B_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-
-	i2c_ret = write_reg(i2c, addr, GPINTEN_A_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = write_reg(i2c, addr, GPINTEN_B_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
+static inline int write_reg_pair(i2c_interface_t* i2c, uint8_t addr, uint8_t reg_a, uint16_t value) {
+	FAST_CREATE_I2C_WRITE(write_order_regs, reg_a, value & 0xFF, value >> 8);
+	return i2c_write(i2c, addr, &write_order_regs);
+}
 
-	i2c_ret = write_reg(i2c, addr, DEFVAL_A_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = write_reg(i2c, addr, DEFVAL_B_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
+/**
+ * @brief Writes the interrupt configuration registers that have changed.
+ *
+ * DEFVAL and INTCON are written before GPINTEN, so a pin is never enabled with
+ * its old comparison settings.
+ *
+ * @param i2c Pointer to the I2C interface structure.
+ * @param addr The I2C address of the MCP23017.
+ * @param registers Addresses of the GPINTEN, DEFVAL and INTCON registers of the port.
+ * @param old_regs Current values of GPINTEN, DEFVAL and INTCON.
+ * @param new_regs New values of GPINTEN, DEFVAL and INTCON.
+ * @return 0 on success, -1 on failure.
+ *         On failure, errno is set as described in the write_reg function documentation.
+ */
+static int write_interrupt_regs(i2c_interface_t* i2c, uint8_t addr, const uint8_t registers[3], const uint8_t old_regs[3], const uint8_t new_regs[3]) {
+	static const uint8_t order[3] = {1, 2, 0};
+
+	for (size_t i = 0; i < 3; i++) {
+		const uint8_t reg = order[i];
+		if (old_regs[reg] != new_regs[reg]) {
+			int i2c_ret = write_reg(i2c, addr, registers[reg], new_regs[reg]);
+			if (i2c_ret != 0) {
+				return i2c_ret;
+			}
+		}
 	}
 
+	return 0;
+}
 
-	i2c_ret = write_reg(i2c, addr, INTCON_A_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = write_reg(i2c, addr, INTCON_B_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-
-	i2c_ret = write_reg(i2c, addr, IOCON_A_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = write_reg(i2c, addr, IOCON_B_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
+/**
+ * @brief Reads the IOCON and GPPU registers of both ports of the MCP23017 in a single transaction.
+ *
+ * The registers are read with a combined transaction, so it works regardless of the
+ * sequential operation mode of the device.
+ *
+ * @param i2c Pointer to the I2C interface structure.
+ * @param addr The I2C address of the MCP23017.
+ * @param iocon Array of 2 bytes where the IOCON A and B registers will be stored.
+ * @param gppu Array of 2 bytes where the GPPU A and B registers will be stored.
+ * @return 0 on success, -1 on failure.
+ *         On failure, errno is set as described in the i2c_write_then_read_multiple function documentation.
+ */
+static inline int read_config(i2c_interface_t* i2c, uint8_t addr, uint8_t iocon[2], uint8_t gppu[2]) {
+	const i2c_write_t read_orders[] = {
+		{.buff = (const uint8_t[]) {IOCON_A_REGISTER}, .len = 1},
+		{.buff = (const uint8_t[]) {IOCON_B_REGISTER}, .len = 1},
+		{.buff = (const uint8_t[]) {GPPU_A_REGISTER}, .len = 1},
+		{.buff = (const uint8_t[]) {GPPU_B_REGISTER}, .len = 1}
+	};
+	const i2c_read_t to_reads[] = {
+		{.buff = &iocon[0], .len = 1},
+		{.buff = &iocon[1], .len = 1},
+		{.buff = &gppu[0], .len = 1},
+		{.buff = &gppu[1], .len = 1}
+	};
+
+	return i2c_write_then_read_multiple(i2c, addr, read_orders, to_reads, 4);
+}
 
-	i2c_ret = write_reg(i2c, addr, GPPU_A_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = write_reg(i2c, addr, GPPU_B_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
+/**
+ * @brief Enables the sequential operation mode, needed to program the registers in a burst.
+ *
+ * With IOCON.SEQOP set, the address pointer of the MCP23017 toggles between the A and B
+ * registers of a pair, so it is cleared (along with the rest of IOCON) if it is set.
+ *
+ * @param i2c Pointer to the I2C interface structure.
+ * @param addr The I2C address of the MCP23017.
+ * @param iocon The current value of the IOCON register.
+ * @return 0 on success, -1 on failure.
+ *         On failure, errno is set as described in the write_reg function documentation.
+ */
+static inline int enable_sequential_mode(i2c_interface_t* i2c, uint8_t addr, uint8_t iocon) {
+	if (iocon & IOCON_A_SEQOP) {
+		return write_reg(i2c, addr, IOCON_A_REGISTER, 0x00);
 	}
+	return 0;
+}
 
-	i2c_ret = write_reg(i2c, addr, INTF_A_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = write_reg(i2c, addr, INTF_B_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
+/**
+ * @brief Resets the MCP23017 GPIO expander.
+ *
+ * This function resets the MCP23017 GPIO expander to its default configuration, writing the
+ * whole register file with a single burst. Sequential operation must be enabled.
+ *
+ * @param i2c Pointer to the I2C interface structure.
+ * @param addr The I2C address of the MCP23017.
+ * @return 0 on success, -1 on failure.
+ *         On failure, errno is set as described in the write_reg function documentation.
+ */
+static int mcp23017_reset(i2c_interface_t* i2c, uint8_t addr) {
+	FAST_CREATE_I2C_WRITE(reset_regs, IODIR_A_REGISTER,
+		0xFF, 0xFF,	// IODIR
+		0x00, 0x00,	// IPOL
+		0x00, 0x00,	// GPINTEN
+		0x00, 0x00,	// DEFVAL
+		0x00, 0x00,	// INTCON
+		0x00, 0x00,	// IOCON
+		0x00, 0x00,	// GPPU
+		0x00, 0x00,	// INTF (read-only)
+		0x00, 0x00,	// INTCAP (read-only)
+		0x00, 0x00,	// GPIO
+		0x00, 0x00	// OLAT
+	);
+	return i2c_write(i2c, addr, &reset_regs);
+}
 
-	i2c_ret = write_reg(i2c, addr, INTCAP_A_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = write_reg(i2c, addr, INTCAP_B_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
+/**
+ * @brief Checks the configuration registers of the MCP23017 with a single burst read.
+ *
+ * The registers from IODIR_A to GPPU_B are read in a single transaction, so sequential
+ * operation must be enabled.
+ *
+ * @param i2c Pointer to the I2C interface structure.
+ * @param addr The I2C address of the MCP23017.
+ * @param expected The expected values of the registers from IODIR_A to GPPU_B.
+ * @return 0 if they match, -1 on failure.
+ *         On failure, errno is set as described in the i2c_write_then_read function
+ *         documentation, or to EIO if the registers don't match.
+ */
+static int verify_config(i2c_interface_t* i2c, uint8_t addr, const uint8_t expected[GPPU_B_REGISTER + 1]) {
+	FAST_CREATE_I2C_WRITE(read_order_config_regs, IODIR_A_REGISTER);
+	uint8_t config[GPPU_B_REGISTER + 1];
+	i2c_read_t read_config_regs = {.buff = config, .len = sizeof(config)};
 
-	i2c_ret = write_reg(i2c, addr, GPIO_A_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = write_reg(i2c, addr, GPIO_B_REGISTER, 0x00);
+	int i2c_ret = i2c_write_then_read(i2c, addr, &read_order_config_regs, &read_config_regs);
 	if (i2c_ret != 0) {
 		return i2c_ret;
 	}
 
-	i2c_ret = write_reg(i2c, addr, OLAT_A_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = write_reg(i2c, addr, OLAT_B_REGISTER, 0x00);
-	if (i2c_ret != 0) {
-		return i2c_ret;
+	if (memcmp(config, expected, sizeof(config)) != 0) {
+		errno = EIO;
+		return -1;
 	}
-
 	return 0;
 }
 
 int mcp23017_init(i2c_interface_t* i2c, uint8_t addr) {
-	int i2c_ret;
-
-	
-	FAST_CREATE_I2C_WRITE(read_order_iocon_a_reg, IOCON_A_REGISTER);
-	FAST_CREATE_I2C_WRITE(read_order_iocon_b_reg, IOCON_B_REGISTER);
-	FAST_CREATE_I2C_WRITE(read_order_gppu_a_reg, GPPU_A_REGISTER);
-	FAST_CREATE_I2C_WRITE(read_order_gppu_b_reg, GPPU_B_REGISTER);
-
-	uint8_t iocon_a, iocon_b, gppu_a, gppu_b;
-	i2c_read_t read_iocon_a_reg = {.buff=&iocon_a, .len=1};
-	i2c_read_t read_iocon_b_reg = {.buff=&iocon_b, .len=1};
-	i2c_read_t read_gppu_a_reg = {.buff=&gppu_a, .len=1};
-	i2c_read_t read_gppu_b_reg = {.buff=&gppu_b, .len=1};
-
-	i2c_ret = i2c_write_then_read(i2c, addr, &read_order_iocon_a_reg, &read_iocon_a_reg);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-        i2c_ret = i2c_write_then_read(i2c, addr, &read_order_iocon_b_reg, &read_iocon_b_reg);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = i2c_write_then_read(i2c, addr, &read_order_gppu_a_reg, &read_gppu_a_reg);
+	uint8_t iocon[2], gppu[2];
+	int i2c_ret = read_config(i2c, addr, iocon, gppu);
 	if (i2c_ret != 0) {
 		return i2c_ret;
 	}
-	i2c_ret = i2c_write_then_read(i2c, addr, &read_order_gppu_b_reg, &read_gppu_b_reg);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-
 
-	if ((iocon_a == (IOCON_A_SEQOP | IOCON_A_ODR)) &&
-	    (iocon_b == (IOCON_B_SEQOP | IOCON_B_ODR)) &&
-	    (gppu_a == 0x00) && (gppu_b == 0x00)) {
+	if ((iocon[0] == (IOCON_A_SEQOP | IOCON_A_ODR)) &&
+	    (iocon[1] == (IOCON_B_SEQOP | IOCON_B_ODR)) &&
+	    (gppu[0] == 0x00) && (gppu[1] == 0x00)) {
 		// Already initialized
 		errno = EALREADY;
 		return 1;
 	}
 
-	i2c_ret = mcp23017_reset(i2c, addr);
+	i2c_ret = enable_sequential_mode(i2c, addr, iocon[0]);
 	if (i2c_ret != 0) {
 		return i2c_ret;
 	}
 
-	// Sequential operation disabled, and INT as open-drain in both channels
-	i2c_ret = write_reg(i2c, addr, IOCON_A_REGISTER, IOCON_A_SEQOP | IOCON_A_ODR);
+	/*
+	 * Reset the whole register file in a single burst. It starts at IODIR_A, so all
+	 * the pins are inputs before GPIO and OLAT are cleared: an output that was high
+	 * is never driven low. IOCON (shared by both ports) keeps sequential operation
+	 * enabled for the burst read that verifies the configuration.
+	 */
+	const uint8_t config[] = {
+		0xFF, 0xFF,	// IODIR
+		0x00, 0x00,	// IPOL
+		0x00, 0x00,	// GPINTEN
+		0x00, 0x00,	// DEFVAL
+		0x00, 0x00,	// INTCON
+		IOCON_A_ODR, IOCON_B_ODR,	// IOCON
+		0x00, 0x00	// GPPU
+	};
+	FAST_CREATE_I2C_WRITE(init_regs, IODIR_A_REGISTER,
+		config[0], config[1], config[2], config[3], config[4], config[5], config[6],
+		config[7], config[8], config[9], config[10], config[11], config[12], config[13],
+		0x00, 0x00,	// INTF (read-only)
+		0x00, 0x00,	// INTCAP (read-only)
+		0x00, 0x00,	// GPIO
+		0x00, 0x00	// OLAT
+	);
+	i2c_ret = i2c_write(i2c, addr, &init_regs);
 	if (i2c_ret != 0) {
 		return i2c_ret;
 	}
-	i2c_ret = write_reg(i2c, addr, IOCON_B_REGISTER, IOCON_B_SEQOP | IOCON_B_ODR);
+
+	i2c_ret = verify_config(i2c, addr, config);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	// Sequential operation is disabled last, which also marks the device as initialized
+	i2c_ret = write_reg(i2c, addr, IOCON_A_REGISTER, IOCON_A_SEQOP | IOCON_A_ODR);
 	if (i2c_ret != 0) {
 		return i2c_ret;
 	}
@@ -258,45 +306,24 @@ int mcp23017_init(i2c_interface_t* i2c, uint8_t addr) {
 }
 
 int mcp23017_deinit(i2c_interface_t* i2c, uint8_t addr) {
-	int i2c_ret;
-
-	
-	FAST_CREATE_I2C_WRITE(read_order_iocon_a_reg, IOCON_A_REGISTER);
-	FAST_CREATE_I2C_WRITE(read_order_iocon_b_reg, IOCON_B_REGISTER);
-	FAST_CREATE_I2C_WRITE(read_order_gppu_a_reg, GPPU_A_REGISTER);
-	FAST_CREATE_I2C_WRITE(read_order_gppu_b_reg, GPPU_B_REGISTER);
-
-	uint8_t iocon_a, iocon_b, gppu_a, gppu_b;
-	i2c_read_t read_iocon_a_reg = {.buff=&iocon_a, .len=1};
-	i2c_read_t read_iocon_b_reg = {.buff=&iocon_b, .len=1};
-	i2c_read_t read_gppu_a_reg = {.buff=&gppu_a, .len=1};
-	i2c_read_t read_gppu_b_reg = {.buff=&gppu_b, .len=1};
-
-	i2c_ret = i2c_write_then_read(i2c, addr, &read_order_iocon_a_reg, &read_iocon_a_reg);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-        i2c_ret = i2c_write_then_read(i2c, addr, &read_order_iocon_b_reg, &read_iocon_b_reg);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = i2c_write_then_read(i2c, addr, &read_order_gppu_a_reg, &read_gppu_a_reg);
-	if (i2c_ret != 0) {
-		return i2c_ret;
-	}
-	i2c_ret = i2c_write_then_read(i2c, addr, &read_order_gppu_b_reg, &read_gppu_b_reg);
+	uint8_t iocon[2], gppu[2];
+	int i2c_ret = read_config(i2c, addr, iocon, gppu);
 	if (i2c_ret != 0) {
 		return i2c_ret;
 	}
 
-
-	if ((iocon_a == 0x00) && (iocon_b == 0x00) &&
-	    (gppu_a == 0x00) && (gppu_b == 0x00)) {
+	if ((iocon[0] == 0x00) && (iocon[1] == 0x00) &&
+	    (gppu[0] == 0x00) && (gppu[1] == 0x00)) {
 		// Already de-initialized
 		errno = EALREADY;
 		return 1;
 	}
 
+	i2c_ret = enable_sequential_mode(i2c, addr, iocon[0]);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
 	return mcp23017_reset(i2c, addr);
 }
 
@@ -446,7 +473,7 @@ int mcp23017_write_all(i2c_interface_t* i2c, uint8_t addr, uint16_t value) {
 		return i2c_ret;
 	}
 
-	i2c_ret = write_reg(i2c, addr, GPIO_B_REGISTER, (uint8_t) (value & 0xFF00));
+	i2c_ret = write_reg(i2c, addr, GPIO_B_REGISTER, value >> 8);
 	if (i2c_ret != 0) {
 		return i2c_ret;
 	}
@@ -454,3 +481,189 @@ int mcp23017_write_all(i2c_interface_t* i2c, uint8_t addr, uint16_t value) {
 	errno = 0;
 	return 0;
 }
+
+int mcp23017_read_state(i2c_interface_t* i2c, uint8_t addr, uint8_t state[MCP23017_STATE_SIZE]) {
+	if (state == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	/*
+	 * Each register is read on its own, as the address pointer behaves differently
+	 * depending on the sequential operation mode.
+	 */
+	static const uint8_t registers[MCP23017_STATE_SIZE] = {
+		IODIR_A_REGISTER, IODIR_B_REGISTER, IPOL_A_REGISTER, IPOL_B_REGISTER,
+		GPINTEN_A_REGISTER, GPINTEN_B_REGISTER, DEFVAL_A_REGISTER, DEFVAL_B_REGISTER,
+		INTCON_A_REGISTER, INTCON_B_REGISTER, IOCON_A_REGISTER, IOCON_B_REGISTER,
+		GPPU_A_REGISTER, GPPU_B_REGISTER, OLAT_A_REGISTER, OLAT_B_REGISTER
+	};
+	i2c_write_t read_orders[MCP23017_STATE_SIZE];
+	i2c_read_t to_reads[MCP23017_STATE_SIZE];
+	for (size_t i = 0; i < MCP23017_STATE_SIZE; i++) {
+		read_orders[i] = (i2c_write_t) {.buff = &registers[i], .len = 1};
+		to_reads[i] = (i2c_read_t) {.buff = &state[i], .len = 1};
+	}
+
+	int i2c_ret = i2c_write_then_read_multiple(i2c, addr, read_orders, to_reads, MCP23017_STATE_SIZE);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	errno = 0;
+	return 0;
+}
+
+int mcp23017_set_interrupt(i2c_interface_t* i2c, uint8_t addr, uint8_t index, uint8_t mode) {
+	if (index >= 16 || mode > MCP23017_INT_ON_HIGH) {
+	        errno = EINVAL;
+	        return -1;
+        }
+
+	const uint8_t gpinten_register = GET_REGISTER(index, GPINTEN_A_REGISTER, GPINTEN_B_REGISTER);
+	const uint8_t defval_register = GET_REGISTER(index, DEFVAL_A_REGISTER, DEFVAL_B_REGISTER);
+	const uint8_t intcon_register = GET_REGISTER(index, INTCON_A_REGISTER, INTCON_B_REGISTER);
+	index = index % 8;
+
+	uint8_t gpinten, defval, intcon;
+	const i2c_write_t read_orders[] = {
+		{.buff = &gpinten_register, .len = 1},
+		{.buff = &defval_register, .len = 1},
+		{.buff = &intcon_register, .len = 1}
+	};
+	const i2c_read_t to_reads[] = {
+		{.buff = &gpinten, .len = 1},
+		{.buff = &defval, .len = 1},
+		{.buff = &intcon, .len = 1}
+	};
+
+	int i2c_ret = i2c_write_then_read_multiple(i2c, addr, read_orders, to_reads, 3);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	const uint8_t old_regs[3] = {gpinten, defval, intcon};
+	const uint8_t bit = 1 << index;
+	switch (mode) {
+		case MCP23017_INT_DISABLED:
+			gpinten &= ~bit;
+			break;
+		case MCP23017_INT_ON_CHANGE:
+			gpinten |= bit;
+			intcon &= ~bit;
+			break;
+		case MCP23017_INT_ON_LOW:
+			gpinten |= bit;
+			intcon |= bit;
+			defval |= bit;
+			break;
+		case MCP23017_INT_ON_HIGH:
+			gpinten |= bit;
+			intcon |= bit;
+			defval &= ~bit;
+			break;
+	}
+	const uint8_t new_regs[3] = {gpinten, defval, intcon};
+
+	const uint8_t registers[3] = {gpinten_register, defval_register, intcon_register};
+	i2c_ret = write_interrupt_regs(i2c, addr, registers, old_regs, new_regs);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	errno = 0;
+	return 0;
+}
+
+int mcp23017_set_interrupt_all(i2c_interface_t* i2c, uint8_t addr, uint16_t enable, uint16_t compare, uint16_t defval) {
+	// The address pointer goes from A to B in both sequential and byte mode
+	int i2c_ret = write_reg_pair(i2c, addr, DEFVAL_A_REGISTER, defval);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	i2c_ret = write_reg_pair(i2c, addr, INTCON_A_REGISTER, compare);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	i2c_ret = write_reg_pair(i2c, addr, GPINTEN_A_REGISTER, enable);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	errno = 0;
+	return 0;
+}
+
+int mcp23017_read_interrupt(i2c_interface_t* i2c, uint8_t addr, uint16_t* flags, uint16_t* captured) {
+	if (flags == NULL || captured == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	// INTF must be read before INTCAP, which clears it
+	uint8_t intf[2], intcap[2];
+	const i2c_write_t read_orders[] = {
+		{.buff = (const uint8_t[]) {INTF_A_REGISTER}, .len = 1},
+		{.buff = (const uint8_t[]) {INTCAP_A_REGISTER}, .len = 1}
+	};
+	const i2c_read_t to_reads[] = {
+		{.buff = intf, .len = 2},
+		{.buff = intcap, .len = 2}
+	};
+
+	int i2c_ret = i2c_write_then_read_multiple(i2c, addr, read_orders, to_reads, 2);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	*flags = intf[0] | (intf[1] << 8);
+	*captured = intcap[0] | (intcap[1] << 8);
+
+	errno = 0;
+	return 0;
+}
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+int mcp23017_wait_interrupt(i2c_interface_t* i2c, uint8_t addr, int line_fd, int timeout_ms, uint16_t* flags, uint16_t* captured) {
+	if (flags == NULL || captured == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	struct timespec start, now;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (true) {
+		// The INT line may have been asserted before waiting, without an edge to wake up
+		uint64_t asserted;
+		if (gpio_chardev_get_values(line_fd, 1, &asserted) != 0) {
+			return -1;
+		}
+		if (asserted) {
+			int i2c_ret = mcp23017_read_interrupt(i2c, addr, flags, captured);
+			if (i2c_ret != 0) {
+				return i2c_ret;
+			}
+			if (*flags != 0) {
+				errno = 0;
+				return 0;
+			}
+			// The line is shared with another device
+		}
+
+		int remaining_ms = timeout_ms;
+		if (timeout_ms >= 0) {
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			const int64_t elapsed_ms = (now.tv_sec - start.tv_sec) * 1000LL + (now.tv_nsec - start.tv_nsec) / 1000000;
+			remaining_ms = elapsed_ms >= timeout_ms ? 0 : timeout_ms - elapsed_ms;
+		}
+
+		gpio_chardev_edge_t edge;
+		if (gpio_chardev_read_edge(line_fd, remaining_ms, &edge) != 0) {
+			return -1;
+		}
+	}
+}
+#endif
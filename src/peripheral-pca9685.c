@@ -429,3 +429,28 @@ int pca9685_pwm_write_all(i2c_interface_t* i2c, uint8_t addr, const uint16_t val
 
 	return write_regs(i2c, addr, buffer, sizeof(buffer));
 }
+
+int pca9685_read_state(i2c_interface_t* i2c, uint8_t addr, uint8_t state[PCA9685_STATE_SIZE]) {
+	if (state == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	// Auto-Increment is enabled once initialized, so MODE1 to LED15_OFF_H is a single read
+	const i2c_write_t read_orders[] = {
+		{.buff = (const uint8_t[]) {MODE1_REGISTER}, .len = 1},
+		{.buff = (const uint8_t[]) {PRE_SCALE_REGISTER}, .len = 1}
+	};
+	const i2c_read_t to_reads[] = {
+		{.buff = state, .len = LED_REGISTERS(PCA9685_NUM_OUTPUTS)},
+		{.buff = &state[LED_REGISTERS(PCA9685_NUM_OUTPUTS)], .len = 1}
+	};
+
+	int i2c_ret = i2c_write_then_read_multiple(i2c, addr, read_orders, to_reads, 2);
+	if (i2c_ret != 0) {
+		return i2c_ret;
+	}
+
+	errno = 0;
+	return 0;
+}
@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <plc-stats.h>
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#include "detect-platform.h"
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define STATS_ENV "PLC_PERIPHERALS_STATS_SHM"
+
+// Used when there is no shared-memory segment
+static plc_stats_t private_stats = {
+	.magic = PLC_STATS_MAGIC,
+	.version = PLC_STATS_VERSION,
+	.size = sizeof(plc_stats_t),
+};
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux && !defined(PLC_PERIPHERALS_NO_STATS)
+static plc_stats_t* stats = NULL; // Set once, when the counters are first used
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+static char shm_name[NAME_MAX];
+#endif
+
+
+static inline uint64_t monotonic_ns(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+#define LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define ADD(x, n) __atomic_fetch_add(&(x), (n), __ATOMIC_RELAXED)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux && !defined(PLC_PERIPHERALS_NO_STATS)
+/**
+ * @brief Creates the shared-memory segment of the process, if STATS_ENV asks for it.
+ *
+ * @return Pointer to the mapped segment, or NULL if the counters must stay private.
+ */
+static plc_stats_t* create_segment(void) {
+	const char* env = getenv(STATS_ENV);
+	if (env == NULL || env[0] == '\0') {
+		return NULL;
+	}
+
+	// A name is given with its leading '/', any other value asks for the default one
+	const bool default_name = env[0] != '/';
+	if (default_name) {
+		snprintf(shm_name, sizeof(shm_name), PLC_STATS_SHM_PREFIX "%d", (int) getpid());
+	}
+	else if (snprintf(shm_name, sizeof(shm_name), "%s", env) >= (int) sizeof(shm_name)) {
+		return NULL;
+	}
+
+	int fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+	if (fd < 0 && errno == EEXIST && default_name) {
+		// Left by a process with the same PID that didn't exit normally
+		shm_unlink(shm_name);
+		fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+	}
+	if (fd < 0) {
+		return NULL;
+	}
+
+	void* segment = MAP_FAILED;
+	if (ftruncate(fd, sizeof(plc_stats_t)) == 0) {
+		segment = mmap(NULL, sizeof(plc_stats_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+
+	if (segment == MAP_FAILED) {
+		shm_unlink(shm_name);
+		return NULL;
+	}
+	return segment;
+}
+
+static void init_stats(void) {
+	plc_stats_t* s = create_segment();
+	if (s == NULL) {
+		shm_name[0] = '\0';
+		s = &private_stats;
+	}
+
+	s->version = PLC_STATS_VERSION;
+	s->size = sizeof(plc_stats_t);
+	s->pid = getpid();
+	s->start_ns = monotonic_ns();
+	// The readers wait for the magic number, so it goes last
+	__atomic_store_n(&s->magic, PLC_STATS_MAGIC, __ATOMIC_RELEASE);
+
+	__atomic_store_n(&stats, s, __ATOMIC_RELEASE);
+}
+
+__attribute__((destructor))
+static void remove_segment(void) {
+	// Not unmapped, since other threads may still be recording
+	if (__atomic_load_n(&stats, __ATOMIC_ACQUIRE) != NULL && shm_name[0] != '\0') {
+		shm_unlink(shm_name);
+	}
+}
+
+/**
+ * @brief Gets the counters of the process, creating them the first time.
+ */
+static inline plc_stats_t* get_stats(void) {
+	plc_stats_t* s = __atomic_load_n(&stats, __ATOMIC_ACQUIRE);
+	if (s == NULL) {
+		pthread_once(&stats_once, init_stats);
+		s = stats;
+	}
+	return s;
+}
+#else
+static inline plc_stats_t* get_stats(void) {
+	return &private_stats;
+}
+#endif
+
+const plc_stats_t* plc_stats_self(void) {
+	return get_stats();
+}
+
+const char* plc_stats_shm_name(void) {
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux && !defined(PLC_PERIPHERALS_NO_STATS)
+	get_stats();
+	return shm_name[0] != '\0' ? shm_name : NULL;
+#else
+	return NULL;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+const plc_stats_t* plc_stats_attach(const char* name) {
+	if (name == NULL) {
+		errno = EFAULT;
+		return NULL;
+	}
+
+	int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return NULL;
+	}
+	if ((size_t) st.st_size != sizeof(plc_stats_t)) {
+		close(fd);
+		errno = EPROTO;
+		return NULL;
+	}
+
+	const plc_stats_t* s = mmap(NULL, sizeof(plc_stats_t), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (s == MAP_FAILED) {
+		return NULL;
+	}
+
+	if (__atomic_load_n(&s->magic, __ATOMIC_ACQUIRE) != PLC_STATS_MAGIC ||
+	    s->version != PLC_STATS_VERSION || s->size != sizeof(plc_stats_t)) {
+		munmap((void*) s, sizeof(plc_stats_t));
+		errno = EPROTO;
+		return NULL;
+	}
+
+	return s;
+}
+
+int plc_stats_detach(const plc_stats_t** pointer_to_stats) {
+	if (pointer_to_stats == NULL || *pointer_to_stats == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	if (munmap((void*) *pointer_to_stats, sizeof(plc_stats_t)) != 0) {
+		return -1;
+	}
+	*pointer_to_stats = NULL;
+	return 0;
+}
+#else
+const plc_stats_t* plc_stats_attach(const char* name) {
+	(void) name;
+	errno = ENOTSUP;
+	return NULL;
+}
+
+int plc_stats_detach(const plc_stats_t** pointer_to_stats) {
+	(void) pointer_to_stats;
+	errno = ENOTSUP;
+	return -1;
+}
+#endif
+
+static void copy_latency(const plc_stats_latency_t* latency, plc_stats_latency_t* copy) {
+	copy->count = LOAD(latency->count);
+	copy->total_ns = LOAD(latency->total_ns);
+	copy->max_ns = LOAD(latency->max_ns);
+	for (size_t i = 0; i < PLC_STATS_LATENCY_BUCKETS; i++) {
+		copy->buckets[i] = LOAD(latency->buckets[i]);
+	}
+}
+
+void plc_stats_snapshot(const plc_stats_t* stats, plc_stats_t* copy) {
+	memset(copy, 0, sizeof(plc_stats_t));
+
+	copy->magic = LOAD(stats->magic);
+	copy->version = stats->version;
+	copy->size = stats->size;
+	copy->pid = stats->pid;
+	copy->start_ns = stats->start_ns;
+	copy->num_devices = __atomic_load_n(&stats->num_devices, __ATOMIC_ACQUIRE);
+	copy->dropped_transactions = LOAD(stats->dropped_transactions);
+
+	copy_latency(&stats->scans, &copy->scans);
+	copy->scan_errors = LOAD(stats->scan_errors);
+
+	for (size_t i = 0; i < PLC_STATS_NUM_CACHES; i++) {
+		copy->caches[i].hits = LOAD(stats->caches[i].hits);
+		copy->caches[i].misses = LOAD(stats->caches[i].misses);
+	}
+
+	for (size_t i = 0; i < copy->num_devices && i < PLC_STATS_MAX_DEVICES; i++) {
+		const plc_stats_device_t* device = &stats->devices[i];
+		plc_stats_device_t* device_copy = &copy->devices[i];
+
+		device_copy->key = LOAD(device->key);
+		device_copy->last_errno = LOAD(device->last_errno);
+		device_copy->transactions = LOAD(device->transactions);
+		device_copy->errors = LOAD(device->errors);
+		device_copy->bytes = LOAD(device->bytes);
+		copy_latency(&device->latency, &device_copy->latency);
+	}
+}
+
+uint64_t plc_stats_percentile(const plc_stats_latency_t* latency, double fraction) {
+	// Not the count, which may not match the buckets in a snapshot
+	uint64_t total = 0;
+	for (size_t i = 0; i < PLC_STATS_LATENCY_BUCKETS; i++) {
+		total += latency->buckets[i];
+	}
+	if (total == 0) {
+		return 0;
+	}
+
+	if (fraction < 0) {
+		fraction = 0;
+	}
+	else if (fraction > 1) {
+		fraction = 1;
+	}
+	const double target = fraction * total;
+
+	uint64_t seen = 0;
+	for (size_t i = 0; i < PLC_STATS_LATENCY_BUCKETS - 1; i++) {
+		if (latency->buckets[i] != 0 && seen + latency->buckets[i] >= target) {
+			const uint64_t lower = i == 0 ? 0 : 1000ULL << (i - 1);
+			const uint64_t upper = 1000ULL << i;
+			const uint64_t ns = lower + (uint64_t) ((upper - lower) * (target - seen) / latency->buckets[i]);
+			return (latency->max_ns != 0 && ns > latency->max_ns) ? latency->max_ns : ns;
+		}
+		seen += latency->buckets[i];
+	}
+
+	// In the last bucket, which has no upper limit
+	return latency->max_ns;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef PLC_PERIPHERALS_NO_STATS
+static void record_latency(plc_stats_latency_t* latency, uint64_t ns) {
+	const uint64_t us = ns / 1000;
+	size_t bucket = us == 0 ? 0 : 64 - __builtin_clzll(us);
+	if (bucket >= PLC_STATS_LATENCY_BUCKETS) {
+		bucket = PLC_STATS_LATENCY_BUCKETS - 1;
+	}
+
+	ADD(latency->count, 1);
+	ADD(latency->total_ns, ns);
+	ADD(latency->buckets[bucket], 1);
+
+	uint64_t max = LOAD(latency->max_ns);
+	while (ns > max && !__atomic_compare_exchange_n(&latency->max_ns, &max, ns, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+	}
+}
+
+/**
+ * @brief Finds the entry of a device, adding it the first time.
+ *
+ * The entries are never removed and their key doesn't change once set, so
+ * the search needs no lock.
+ *
+ * @return Pointer to the entry, or NULL if the table is full.
+ */
+static plc_stats_device_t* find_device(plc_stats_t* s, uint8_t bus, uint8_t addr) {
+	const uint32_t key = ((uint32_t) bus << 8 | addr) + 1;
+
+	for (;;) {
+		const uint64_t num_devices = __atomic_load_n(&s->num_devices, __ATOMIC_ACQUIRE);
+		for (size_t i = 0; i < num_devices; i++) {
+			if (LOAD(s->devices[i].key) == key) {
+				return &s->devices[i];
+			}
+		}
+		if (num_devices >= PLC_STATS_MAX_DEVICES) {
+			return NULL;
+		}
+
+		// Whoever claims the next entry, it is published and searched again
+		uint32_t free_key = 0;
+		__atomic_compare_exchange_n(&s->devices[num_devices].key, &free_key, key, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+		uint64_t expected = num_devices;
+		__atomic_compare_exchange_n(&s->num_devices, &expected, num_devices + 1, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+	}
+}
+#endif
+
+uint64_t plc_stats_now(void) {
+#ifndef PLC_PERIPHERALS_NO_STATS
+	return monotonic_ns();
+#else
+	return 0;
+#endif
+}
+
+void plc_stats_transaction(uint8_t bus, uint8_t addr, size_t bytes, uint64_t start_ns, bool ok) {
+#ifndef PLC_PERIPHERALS_NO_STATS
+	const int err = errno;
+	const uint64_t ns = monotonic_ns() - start_ns;
+
+	plc_stats_t* s = get_stats();
+	plc_stats_device_t* device = find_device(s, bus, addr);
+	if (device == NULL) {
+		ADD(s->dropped_transactions, 1);
+		errno = err;
+		return;
+	}
+
+	ADD(device->transactions, 1);
+	ADD(device->bytes, bytes);
+	if (!ok) {
+		ADD(device->errors, 1);
+		__atomic_store_n(&device->last_errno, err, __ATOMIC_RELAXED);
+	}
+	record_latency(&device->latency, ns);
+
+	errno = err;
+#else
+	(void) bus;
+	(void) addr;
+	(void) bytes;
+	(void) start_ns;
+	(void) ok;
+#endif
+}
+
+void plc_stats_scan(uint64_t start_ns, bool ok) {
+#ifndef PLC_PERIPHERALS_NO_STATS
+	const int err = errno;
+	const uint64_t ns = monotonic_ns() - start_ns;
+
+	plc_stats_t* s = get_stats();
+	if (!ok) {
+		ADD(s->scan_errors, 1);
+	}
+	record_latency(&s->scans, ns);
+
+	errno = err;
+#else
+	(void) start_ns;
+	(void) ok;
+#endif
+}
+
+void plc_stats_cache(plc_stats_cache_id_t cache, bool hit) {
+#ifndef PLC_PERIPHERALS_NO_STATS
+	if (cache >= PLC_STATS_NUM_CACHES) {
+		return;
+	}
+
+	const int err = errno;
+	plc_stats_t* s = get_stats();
+	if (hit) {
+		ADD(s->caches[cache].hits, 1);
+	}
+	else {
+		ADD(s->caches[cache].misses, 1);
+	}
+	errno = err;
+#else
+	(void) cache;
+	(void) hit;
+#endif
+}
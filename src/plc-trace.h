@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PLC_TRACE_H__
+#define __PLC_TRACE_H__
+
+/*
+ * USDT probes of the library, for perf, bpftrace or SystemTap. They are
+ * compiled in with PLC_PERIPHERALS_USDT, which needs the sys/sdt.h header of
+ * SystemTap; each probe is then a single nop until a tracer attaches to it.
+ * Without it, the macros are empty and their arguments aren't evaluated.
+ *
+ * Provider "plc_peripherals":
+ *   - i2c_submit(bus, addr, reg, len): an I2C transaction is about to be
+ *     issued. reg is the first byte written (the register of the drivers),
+ *     or -1 for a plain read, and len the bytes written and read.
+ *   - i2c_complete(bus, addr, reg, len, result): it has finished. result is
+ *     0, or -errno if it failed.
+ *   - api_entry(name, ctx, arg, value): a public function of expanded-gpio
+ *     is called. name is the function, arg its first argument after the
+ *     context (the pin, or the address of the *All functions; the length
+ *     for the arrays), and value the second one, like the value written
+ *     (0 when there is none).
+ *   - api_return(name, ctx, arg, result): it returns result, after
+ *     releasing the bus locks.
+ */
+
+#include "detect-platform.h"
+
+#if defined(PLC_PERIPHERALS_USDT) && defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#include <sys/sdt.h>
+
+#define PLC_TRACE_I2C_SUBMIT(bus, addr, reg, len) \
+	STAP_PROBE4(plc_peripherals, i2c_submit, bus, addr, reg, len)
+#define PLC_TRACE_I2C_COMPLETE(bus, addr, reg, len, result) \
+	STAP_PROBE5(plc_peripherals, i2c_complete, bus, addr, reg, len, result)
+
+#define PLC_TRACE_API_ENTRY(ctx, arg, value) \
+	STAP_PROBE4(plc_peripherals, api_entry, (const char*) __func__, ctx, arg, value)
+#define PLC_TRACE_API_RETURN(ctx, arg, result) \
+	STAP_PROBE4(plc_peripherals, api_return, (const char*) __func__, ctx, arg, result)
+
+#else
+
+#define PLC_TRACE_I2C_SUBMIT(bus, addr, reg, len) do {} while (0)
+#define PLC_TRACE_I2C_COMPLETE(bus, addr, reg, len, result) do {} while (0)
+
+#define PLC_TRACE_API_ENTRY(ctx, arg, value) do {} while (0)
+#define PLC_TRACE_API_RETURN(ctx, arg, result) do {} while (0)
+
+#endif
+
+#endif // __PLC_TRACE_H__
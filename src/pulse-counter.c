@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pulse-counter.h>
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#define CONSUMER "plc-peripherals-counter"
+
+// Edge events taken from the kernel with each "read"
+#define READ_BLOCK_EDGES 64
+
+struct line_counter_t {
+	uint32_t offset;
+	uint32_t last_seqno;
+	uint64_t count;
+	uint64_t total; // Like count, but never reset
+	uint64_t last_edge_ns;
+	uint64_t period_ns;
+	uint64_t gate_start_ns; // First edge of the current gate
+	uint64_t gate_start_total;
+	double frequency_hz;
+};
+
+struct _pulse_counter_t {
+	int fd;
+	int wake_fd;
+	pthread_t thread;
+	uint64_t gate_ns;
+
+	pthread_mutex_t lock;
+	uint64_t missed;
+	int error; // errno that stopped the counting thread, 0 while it runs
+	size_t num_lines;
+	struct line_counter_t lines[GPIO_CHARDEV_MAX_LINES];
+};
+
+
+static inline uint64_t monotonic_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Updates the counter of a line with an edge.
+ *
+ * It must be called with the lock held.
+ */
+static void count_edge(pulse_counter_t* counter, struct line_counter_t* line, const gpio_chardev_edge_t* edge) {
+	// The sequence number also advances for the events the kernel had to discard
+	uint32_t edges = edge->seqno - line->last_seqno;
+	if (edges == 0) {
+		return;
+	}
+	counter->missed += edges - 1;
+	line->last_seqno = edge->seqno;
+	line->count += edges;
+	line->total += edges;
+
+	if (line->last_edge_ns != 0 && edges == 1) {
+		line->period_ns = edge->timestamp_ns - line->last_edge_ns;
+	}
+	line->last_edge_ns = edge->timestamp_ns;
+
+	if (line->gate_start_ns == 0) {
+		line->gate_start_ns = edge->timestamp_ns;
+		line->gate_start_total = line->total;
+		return;
+	}
+	const uint64_t elapsed_ns = edge->timestamp_ns - line->gate_start_ns;
+	if (elapsed_ns >= counter->gate_ns) {
+		line->frequency_hz = (double) (line->total - line->gate_start_total) * 1e9 / elapsed_ns;
+		line->gate_start_ns = edge->timestamp_ns;
+		line->gate_start_total = line->total;
+	}
+}
+
+/**
+ * @brief Records the error that stopped the counting thread.
+ */
+static void stop_counting(pulse_counter_t* counter, int error) {
+	pthread_mutex_lock(&counter->lock);
+	counter->error = error;
+	pthread_mutex_unlock(&counter->lock);
+}
+
+/**
+ * @brief Body of the counting thread.
+ */
+static void* count_edges(void* arg) {
+	pulse_counter_t* counter = arg;
+	gpio_chardev_edge_t edges[READ_BLOCK_EDGES];
+
+	while (true) {
+		struct pollfd fds[2] = {
+			{.fd = counter->wake_fd, .events = POLLIN},
+			{.fd = counter->fd, .events = POLLIN}
+		};
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			stop_counting(counter, errno);
+			break;
+		}
+		if (fds[0].revents & POLLIN) {
+			// Closed by pulse_counter_close
+			break;
+		}
+		if (!(fds[1].revents & POLLIN)) {
+			if (fds[1].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+				// The chip went away
+				stop_counting(counter, EPIPE);
+				break;
+			}
+			continue;
+		}
+
+		const int num_edges = gpio_chardev_read_edges(counter->fd, 0, edges, READ_BLOCK_EDGES);
+		if (num_edges < 0) {
+			if (errno == ETIMEDOUT || errno == EINTR) {
+				continue;
+			}
+			stop_counting(counter, errno);
+			break;
+		}
+
+		pthread_mutex_lock(&counter->lock);
+		for (int i = 0; i < num_edges; i++) {
+			for (size_t l = 0; l < counter->num_lines; l++) {
+				if (counter->lines[l].offset == edges[i].offset) {
+					count_edge(counter, &counter->lines[l], &edges[i]);
+					break;
+				}
+			}
+		}
+		pthread_mutex_unlock(&counter->lock);
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Releases the lines of a counter and frees it.
+ */
+static int free_counter(pulse_counter_t* counter) {
+	int ret = 0;
+	if (counter->fd >= 0 && gpio_chardev_release(counter->fd) != 0) {
+		ret = -1;
+	}
+	if (counter->wake_fd >= 0) {
+		close(counter->wake_fd);
+	}
+	pthread_mutex_destroy(&counter->lock);
+	free(counter);
+	return ret;
+}
+
+pulse_counter_t* pulse_counter_open(const char* chip, const uint32_t* offsets, size_t num_lines, uint8_t flags, uint32_t gate_ms) {
+	if (chip == NULL || offsets == NULL) {
+		errno = EFAULT;
+		return NULL;
+	}
+	if (num_lines == 0 || num_lines > GPIO_CHARDEV_MAX_LINES || !(flags & GPIO_CHARDEV_EDGE_BOTH)) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	pulse_counter_t* counter = calloc(1, sizeof(pulse_counter_t));
+	if (counter == NULL) {
+		return NULL;
+	}
+	counter->fd = -1;
+	counter->wake_fd = -1;
+	counter->gate_ns = (uint64_t) (gate_ms != 0 ? gate_ms : PULSE_COUNTER_DEFAULT_GATE_MS) * 1000000ULL;
+	pthread_mutex_init(&counter->lock, NULL);
+	counter->num_lines = num_lines;
+	for (size_t i = 0; i < num_lines; i++) {
+		counter->lines[i].offset = offsets[i];
+	}
+
+	counter->fd = gpio_chardev_request_inputs(chip, offsets, num_lines, flags, CONSUMER);
+	counter->wake_fd = eventfd(0, EFD_CLOEXEC);
+	if (counter->fd < 0 || counter->wake_fd < 0) {
+		goto error;
+	}
+
+	int ret = pthread_create(&counter->thread, NULL, count_edges, counter);
+	if (ret != 0) {
+		errno = ret;
+		goto error;
+	}
+
+	errno = 0;
+	return counter;
+
+error:;
+	const int saved_errno = errno;
+	free_counter(counter);
+	errno = saved_errno;
+	return NULL;
+}
+
+int pulse_counter_close(pulse_counter_t** pointer_to_counter) {
+	if (pointer_to_counter == NULL || *pointer_to_counter == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	pulse_counter_t* counter = *pointer_to_counter;
+
+	const uint64_t one = 1;
+	if (write(counter->wake_fd, &one, sizeof(one)) < 0) {
+		// The counter can't overflow, so the thread is woken up anyway
+	}
+	pthread_join(counter->thread, NULL);
+
+	int ret = free_counter(counter);
+	*pointer_to_counter = NULL;
+	if (ret == 0) {
+		errno = 0;
+	}
+	return ret;
+}
+
+int pulse_counter_read(pulse_counter_t* counter, size_t line, pulse_counter_reading_t* reading) {
+	if (counter == NULL || reading == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (line >= counter->num_lines) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&counter->lock);
+	const struct line_counter_t* state = &counter->lines[line];
+	reading->count = state->count;
+	reading->last_edge_ns = state->last_edge_ns;
+	reading->period_ns = state->period_ns;
+	reading->frequency_hz = state->frequency_hz;
+	const int error = counter->error;
+	pthread_mutex_unlock(&counter->lock);
+
+	// The count would never change again
+	if (error != 0) {
+		errno = EPIPE;
+		return -1;
+	}
+
+	// Without new edges, the frequency can't be higher than one edge since the last one
+	if (reading->last_edge_ns != 0) {
+		const uint64_t silence_ns = monotonic_ns() - reading->last_edge_ns;
+		if (silence_ns > counter->gate_ns && silence_ns > reading->period_ns) {
+			const double bound_hz = 1e9 / silence_ns;
+			if (reading->frequency_hz > bound_hz) {
+				reading->frequency_hz = bound_hz;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int pulse_counter_levels(pulse_counter_t* counter, uint64_t* levels) {
+	if (counter == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	const uint64_t mask = counter->num_lines == 64 ? ~0ULL : (1ULL << counter->num_lines) - 1;
+	return gpio_chardev_get_values(counter->fd, mask, levels);
+}
+
+int pulse_counter_reset(pulse_counter_t* counter, size_t line) {
+	if (counter == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (line >= counter->num_lines) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&counter->lock);
+	counter->lines[line].count = 0;
+	pthread_mutex_unlock(&counter->lock);
+	return 0;
+}
+
+uint64_t pulse_counter_missed(pulse_counter_t* counter) {
+	if (counter == NULL) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&counter->lock);
+	const uint64_t missed = counter->missed;
+	pthread_mutex_unlock(&counter->lock);
+	return missed;
+}
+
+int pulse_counter_error(pulse_counter_t* counter) {
+	if (counter == NULL) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&counter->lock);
+	const int error = counter->error;
+	pthread_mutex_unlock(&counter->lock);
+	return error;
+}
+
+#endif // PLC_ENVIRONMENT == Linux
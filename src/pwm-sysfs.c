@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This file is part of plc-peripherals.
+ *
+ * plc-peripherals is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * plc-peripherals is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pwm-sysfs.h>
+#include <plc-stats.h>
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/vfs.h>
+
+#ifndef SYSFS_MAGIC
+#define SYSFS_MAGIC 0x62656572
+#endif
+
+// udev may need some time to give access to a channel that has just been exported
+#define EXPORT_TIMEOUT_MS 1000
+#define EXPORT_POLL_US (10 * 1000)
+
+// A 64-bit number in decimal, plus the new line
+#define VALUE_BUFFER_SIZE 21
+
+struct _pwm_sysfs_t {
+	int period_fd;
+	int duty_cycle_fd;
+	int enable_fd;
+	bool truncate; // Not in sysfs (a fake tree), so the files must be truncated
+	uint64_t period_ns;
+	uint64_t duty_ns;
+	int enabled; // -1 if unknown
+};
+
+
+/**
+ * @brief Formats a number in decimal, followed by a new line.
+ *
+ * @param buff Buffer of at least VALUE_BUFFER_SIZE bytes.
+ * @param value The number.
+ * @return The length of the text.
+ */
+static size_t format_value(char* buff, uint64_t value) {
+	char digits[VALUE_BUFFER_SIZE];
+	size_t len = 0;
+	do {
+		digits[len++] = '0' + value % 10;
+		value /= 10;
+	} while (value);
+
+	for (size_t i = 0; i < len; i++) {
+		buff[i] = digits[len - 1 - i];
+	}
+	buff[len] = '\n';
+	return len + 1;
+}
+
+/**
+ * @brief Writes a number to an attribute file.
+ *
+ * @return 0 on success, -1 on failure (errno is set by "pwrite").
+ */
+static int write_value(const pwm_sysfs_t* pwm, int fd, uint64_t value) {
+	char buff[VALUE_BUFFER_SIZE];
+	const size_t len = format_value(buff, value);
+
+	if (pwrite(fd, buff, len, 0) != (ssize_t) len) {
+		return -1;
+	}
+	if (pwm->truncate && ftruncate(fd, len) != 0) {
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Reads a number from an attribute file.
+ *
+ * @return 0 on success, -1 on failure (errno is set by "pread" or to EINVAL).
+ */
+static int read_value(int fd, uint64_t* value) {
+	char buff[VALUE_BUFFER_SIZE];
+	const ssize_t len = pread(fd, buff, sizeof(buff) - 1, 0);
+	if (len < 0) {
+		return -1;
+	}
+	buff[len] = '\0';
+
+	char* end;
+	errno = 0;
+	*value = strtoull(buff, &end, 10);
+	if (errno != 0 || end == buff) {
+		errno = EINVAL;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Exports a channel, unless it already is, and waits for its attributes.
+ *
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+static int export_channel(const char* root, uint32_t chip, uint32_t channel) {
+	char path[PATH_MAX];
+	if (snprintf(path, sizeof(path), "%s/pwmchip%u/pwm%u/enable", root, chip, channel) >= (int) sizeof(path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	if (access(path, W_OK) == 0) {
+		return 0;
+	}
+
+	char export_path[PATH_MAX];
+	if (snprintf(export_path, sizeof(export_path), "%s/pwmchip%u/export", root, chip) >= (int) sizeof(export_path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	int fd = open(export_path, O_WRONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return -1;
+	}
+	char buff[VALUE_BUFFER_SIZE];
+	const size_t len = format_value(buff, channel);
+	const ssize_t written = write(fd, buff, len);
+	const int saved_errno = errno;
+	close(fd);
+	// EBUSY: exported by someone else in the meantime
+	if (written != (ssize_t) len && saved_errno != EBUSY) {
+		errno = saved_errno;
+		return -1;
+	}
+
+	for (int waited_ms = 0; waited_ms < EXPORT_TIMEOUT_MS; waited_ms += EXPORT_POLL_US / 1000) {
+		if (access(path, W_OK) == 0) {
+			return 0;
+		}
+		usleep(EXPORT_POLL_US);
+	}
+
+	errno = ETIMEDOUT;
+	return -1;
+}
+
+/**
+ * @brief Opens an attribute file of a channel.
+ *
+ * @return The file descriptor, -1 on failure (errno is set).
+ */
+static int open_attribute(const char* root, uint32_t chip, uint32_t channel, const char* attribute) {
+	char path[PATH_MAX];
+	if (snprintf(path, sizeof(path), "%s/pwmchip%u/pwm%u/%s", root, chip, channel, attribute) >= (int) sizeof(path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	return open(path, O_RDWR | O_CLOEXEC);
+}
+
+pwm_sysfs_t* pwm_sysfs_open(const char* root, uint32_t chip, uint32_t channel) {
+	if (root == NULL) {
+		root = PWM_SYSFS_DEFAULT_ROOT;
+	}
+
+	if (export_channel(root, chip, channel) != 0) {
+		return NULL;
+	}
+
+	pwm_sysfs_t* pwm = malloc(sizeof(pwm_sysfs_t));
+	if (pwm == NULL) {
+		return NULL;
+	}
+	pwm->period_fd = open_attribute(root, chip, channel, "period");
+	pwm->duty_cycle_fd = open_attribute(root, chip, channel, "duty_cycle");
+	pwm->enable_fd = open_attribute(root, chip, channel, "enable");
+	pwm->enabled = -1;
+
+	struct statfs fs;
+	if (pwm->period_fd < 0 || pwm->duty_cycle_fd < 0 || pwm->enable_fd < 0 ||
+	    fstatfs(pwm->period_fd, &fs) != 0 ||
+	    read_value(pwm->period_fd, &pwm->period_ns) != 0 ||
+	    read_value(pwm->duty_cycle_fd, &pwm->duty_ns) != 0) {
+		const int saved_errno = errno;
+		pwm_sysfs_close(&pwm);
+		errno = saved_errno;
+		return NULL;
+	}
+	pwm->truncate = fs.f_type != SYSFS_MAGIC;
+
+	errno = 0;
+	return pwm;
+}
+
+int pwm_sysfs_close(pwm_sysfs_t** pointer_to_pwm) {
+	if (pointer_to_pwm == NULL || *pointer_to_pwm == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	pwm_sysfs_t* pwm = *pointer_to_pwm;
+
+	int ret = 0;
+	const int fds[] = {pwm->period_fd, pwm->duty_cycle_fd, pwm->enable_fd};
+	for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+		if (fds[i] >= 0 && close(fds[i]) != 0) {
+			ret = -1;
+		}
+	}
+
+	free(pwm);
+	*pointer_to_pwm = NULL;
+	return ret;
+}
+
+int pwm_sysfs_set_period(pwm_sysfs_t* pwm, uint64_t period_ns) {
+	if (pwm == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	const bool unchanged = period_ns == pwm->period_ns;
+	plc_stats_cache(PLC_STATS_CACHE_PWM_SYSFS, unchanged);
+	if (unchanged) {
+		return 0;
+	}
+
+	// The kernel rejects a period shorter than the duty cycle
+	if (pwm->duty_ns > period_ns) {
+		if (write_value(pwm, pwm->duty_cycle_fd, period_ns) != 0) {
+			return -1;
+		}
+		pwm->duty_ns = period_ns;
+	}
+
+	if (write_value(pwm, pwm->period_fd, period_ns) != 0) {
+		return -1;
+	}
+	pwm->period_ns = period_ns;
+
+	errno = 0;
+	return 0;
+}
+
+int pwm_sysfs_set_duty_cycle(pwm_sysfs_t* pwm, uint64_t duty_ns) {
+	if (pwm == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (duty_ns > pwm->period_ns) {
+		errno = EINVAL;
+		return -1;
+	}
+	const bool unchanged = duty_ns == pwm->duty_ns;
+	plc_stats_cache(PLC_STATS_CACHE_PWM_SYSFS, unchanged);
+	if (unchanged) {
+		return 0;
+	}
+
+	if (write_value(pwm, pwm->duty_cycle_fd, duty_ns) != 0) {
+		return -1;
+	}
+	pwm->duty_ns = duty_ns;
+
+	errno = 0;
+	return 0;
+}
+
+int pwm_sysfs_enable(pwm_sysfs_t* pwm, bool enable) {
+	if (pwm == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	const bool unchanged = pwm->enabled == (int) enable;
+	plc_stats_cache(PLC_STATS_CACHE_PWM_SYSFS, unchanged);
+	if (unchanged) {
+		return 0;
+	}
+
+	if (write_value(pwm, pwm->enable_fd, enable) != 0) {
+		return -1;
+	}
+	pwm->enabled = enable;
+
+	errno = 0;
+	return 0;
+}
+
+uint64_t pwm_sysfs_get_period(const pwm_sysfs_t* pwm) {
+	return pwm != NULL ? pwm->period_ns : 0;
+}
+
+#endif // PLC_ENVIRONMENT == Linux
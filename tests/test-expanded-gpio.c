@@ -0,0 +1,713 @@
+/**
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Checks the debounce filters, the lazy initialization, the warm restart
+ * snapshot, the input events, the expander interrupts, the bus slots and the
+ * contexts of expanded-gpio against the simulated buses of bench/i2c-sim
+ * (with the INT lines on the simulated chip of bench/gpio-sim), and the pulse
+ * counters and the normal_gpio backend of the GPIO character device (when it
+ * is built) against the same simulated chip.
+ */
+
+#include <plc-peripherals.h>
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include <unity.h>
+#include <peripheral-mcp23017.h>
+
+#ifdef PLC_PERIPHERALS_NORMAL_GPIO_CHARDEV
+#include <normal-gpio-chardev.h>
+#endif
+
+#include "i2c-sim.h"
+#include "gpio-sim.h"
+
+#define MCP23008_ADDRESS 0x20
+#define MISSING_ADDRESS 0x21
+#define MCP23017_ADDRESS 0x24
+#define OTHER_BUS (I2C_BUS + 1)
+#define CONTEXT_BUS_A (I2C_BUS + 2)
+#define CONTEXT_BUS_B (I2C_BUS + 3)
+
+// MCP23008 registers, and MCP23017 registers of port A (BANK=0, port B is the next one)
+#define MCP23008_GPINTEN 0x02
+#define MCP23008_DEFVAL 0x03
+#define MCP23008_INTCON 0x04
+#define MCP23008_INTF 0x07
+#define MCP23008_OLAT 0x0A
+#define MCP23017_GPINTENA 0x04
+#define MCP23017_DEFVALA 0x06
+#define MCP23017_INTCONA 0x08
+#define MCP23017_INTFA 0x0E
+
+#define INTEGRATOR_PIN 1
+#define INTEGRATOR_SAMPLES 3
+#define WINDOW_PIN 2
+#define WINDOW_MS 20
+#define EVENT_PIN 3
+#define EVENT_TIMEOUT_MS 1000
+#define OUTPUT_PIN 7
+
+#define GPIO_CHIP 0
+#define GPIO_CHIP_PATH "/dev/gpiochip0"
+#define GPIO_CHIP_LINES 8
+#define INT_LINE 0
+#define COUNTER_LINE 6
+#define IDLE_COUNTER_LINE 7
+#define COUNTER_PULSES 3
+
+static const uint8_t present_addrs[] = {MCP23008_ADDRESS};
+static const uint8_t lazy_addrs[] = {MCP23008_ADDRESS, MISSING_ADDRESS};
+static const uint8_t no_addrs[] = {0};
+
+static char snapshot_dir[] = "/tmp/test-expanded-gpio-XXXXXX";
+static char snapshot_file[128];
+
+
+static struct peripherals_t mcp23008_devices(const uint8_t* addrs, size_t num_addrs) {
+	return (struct peripherals_t) {
+		.arrayMCP23008 = addrs, .numArrayMCP23008 = num_addrs,
+		.arrayADS1015 = no_addrs, .numArrayADS1015 = 0,
+		.arrayPCA9685 = no_addrs, .numArrayPCA9685 = 0,
+		.arrayLTC2309 = no_addrs, .numArrayLTC2309 = 0,
+		.arrayMCP23017 = no_addrs, .numArrayMCP23017 = 0,
+	};
+}
+
+static void use_mcp23008(const uint8_t* addrs, size_t num_addrs) {
+	_peripherals_struct = mcp23008_devices(addrs, num_addrs);
+}
+
+static uint8_t sample(uint8_t bit) {
+	uint8_t values;
+	TEST_ASSERT_EQUAL(0, digitalReadAll(MCP23008_ADDRESS, &values));
+	return (values >> bit) & 1;
+}
+
+static uint64_t ioctls_since_clear(void) {
+	struct i2c_sim_stats stats;
+	i2c_sim_get_stats(&stats);
+	return stats.ioctls;
+}
+
+static uint64_t wait_count(pulse_counter_t* counter, size_t line, uint64_t count) {
+	// The edges are taken by the counting thread, on its own time
+	pulse_counter_reading_t reading = {0};
+	for (int i = 0; i < EVENT_TIMEOUT_MS; i++) {
+		TEST_ASSERT_EQUAL(0, pulse_counter_read(counter, line, &reading));
+		if (reading.count >= count) {
+			break;
+		}
+		usleep(1000);
+	}
+	return reading.count;
+}
+
+static bool event_fd_readable(int fd, int timeout_ms) {
+	struct pollfd pfd = {.fd = fd, .events = POLLIN};
+	return poll(&pfd, 1, timeout_ms) == 1 && (pfd.revents & POLLIN);
+}
+
+static input_event_t wait_event(int fd) {
+	input_event_t event = {0};
+	TEST_ASSERT_TRUE_MESSAGE(event_fd_readable(fd, EVENT_TIMEOUT_MS), "No event was queued");
+	TEST_ASSERT_EQUAL(1, readInputEvents(&event, 1));
+	return event;
+}
+
+void setUp(void) {
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 0);
+}
+
+void tearDown(void) {
+}
+
+void debounce_integrator_test() {
+	use_mcp23008(present_addrs, 1);
+	TEST_ASSERT_EQUAL(0, initExpandedGPIO(false));
+	TEST_ASSERT_EQUAL(0, setInputDebounce(MAKE_PIN_MCP23008(MCP23008_ADDRESS, INTEGRATOR_PIN), DEBOUNCE_INTEGRATOR, INTEGRATOR_SAMPLES));
+
+	// The first sample gives the level at once
+	TEST_ASSERT_EQUAL(0, sample(INTEGRATOR_PIN));
+
+	// The new level is taken after INTEGRATOR_SAMPLES samples in a row
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 1 << INTEGRATOR_PIN);
+	for (int i = 1; i < INTEGRATOR_SAMPLES; i++) {
+		TEST_ASSERT_EQUAL_MESSAGE(0, sample(INTEGRATOR_PIN), "Taken before the last sample");
+	}
+	TEST_ASSERT_EQUAL(1, sample(INTEGRATOR_PIN));
+
+	// A bounce back to the debounced level starts the count over
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 0);
+	TEST_ASSERT_EQUAL(1, sample(INTEGRATOR_PIN));
+	TEST_ASSERT_EQUAL(1, sample(INTEGRATOR_PIN));
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 1 << INTEGRATOR_PIN);
+	TEST_ASSERT_EQUAL(1, sample(INTEGRATOR_PIN));
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 0);
+	for (int i = 1; i < INTEGRATOR_SAMPLES; i++) {
+		TEST_ASSERT_EQUAL_MESSAGE(1, sample(INTEGRATOR_PIN), "The bounce didn't reset the count");
+	}
+	TEST_ASSERT_EQUAL(0, sample(INTEGRATOR_PIN));
+
+	// Without debounce, the level read is the raw one
+	TEST_ASSERT_EQUAL(0, setInputDebounce(MAKE_PIN_MCP23008(MCP23008_ADDRESS, INTEGRATOR_PIN), DEBOUNCE_NONE, 0));
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 1 << INTEGRATOR_PIN);
+	TEST_ASSERT_EQUAL(1, sample(INTEGRATOR_PIN));
+
+	TEST_ASSERT_EQUAL(0, deinitExpandedGPIO());
+}
+
+void debounce_time_window_test() {
+	use_mcp23008(present_addrs, 1);
+	TEST_ASSERT_EQUAL(0, initExpandedGPIO(false));
+	TEST_ASSERT_EQUAL(0, setInputDebounce(MAKE_PIN_MCP23008(MCP23008_ADDRESS, WINDOW_PIN), DEBOUNCE_TIME_WINDOW, WINDOW_MS));
+
+	TEST_ASSERT_EQUAL(0, sample(WINDOW_PIN));
+
+	// The new level is taken on the first sample after holding it for WINDOW_MS
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 1 << WINDOW_PIN);
+	for (int i = 0; i < 4; i++) {
+		TEST_ASSERT_EQUAL_MESSAGE(0, sample(WINDOW_PIN), "Taken before the window");
+	}
+	usleep((WINDOW_MS + 5) * 1000);
+	TEST_ASSERT_EQUAL(1, sample(WINDOW_PIN));
+
+	// A bounce back to the debounced level starts the window over
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 0);
+	TEST_ASSERT_EQUAL(1, sample(WINDOW_PIN));
+	usleep(WINDOW_MS / 2 * 1000);
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 1 << WINDOW_PIN);
+	TEST_ASSERT_EQUAL(1, sample(WINDOW_PIN));
+	usleep((WINDOW_MS / 2 + 5) * 1000);
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 0);
+	TEST_ASSERT_EQUAL_MESSAGE(1, sample(WINDOW_PIN), "The bounce didn't reset the window");
+	usleep((WINDOW_MS + 5) * 1000);
+	TEST_ASSERT_EQUAL(0, sample(WINDOW_PIN));
+
+	// The filter outlives deinitExpandedGPIO, and would make the next tests poll
+	TEST_ASSERT_EQUAL(0, setInputDebounce(MAKE_PIN_MCP23008(MCP23008_ADDRESS, WINDOW_PIN), DEBOUNCE_NONE, 0));
+	TEST_ASSERT_EQUAL(0, deinitExpandedGPIO());
+}
+
+void snapshot_test() {
+	struct stat st;
+	const uint32_t pin = MAKE_PIN_MCP23008(MCP23008_ADDRESS, 0);
+	use_mcp23008(present_addrs, 1);
+
+	i2c_sim_clear_stats();
+	TEST_ASSERT_EQUAL(0, initExpandedGPIO(false));
+	const uint64_t cold_ioctls = ioctls_since_clear();
+	TEST_ASSERT_EQUAL(0, pinMode(pin, OUTPUT));
+	TEST_ASSERT_EQUAL(0, digitalWrite(pin, 1));
+
+	// The state is saved in PLC_PERIPHERALS_SNAPSHOT_DIR and the outputs kept
+	TEST_ASSERT_EQUAL(0, deinitExpandedGPIONoReset());
+	TEST_ASSERT_EQUAL_MESSAGE(0, stat(snapshot_file, &st), strerror(errno));
+	TEST_ASSERT_EQUAL(0600, st.st_mode & 0777);
+	TEST_ASSERT_EQUAL_HEX8(0x01, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+
+	// The device is verified instead of initialized, and the snapshot consumed
+	i2c_sim_clear_stats();
+	TEST_ASSERT_EQUAL(0, initExpandedGPIO(false));
+	TEST_ASSERT_TRUE(ioctls_since_clear() < cold_ioctls);
+	TEST_ASSERT_EQUAL(-1, stat(snapshot_file, &st));
+	TEST_ASSERT_EQUAL(ENOENT, errno);
+	TEST_ASSERT_EQUAL_HEX8(0x01, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+
+	TEST_ASSERT_EQUAL(0, deinitExpandedGPIO());
+	TEST_ASSERT_EQUAL_HEX8(0x00, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+	TEST_ASSERT_EQUAL(-1, stat(snapshot_file, &st));
+}
+
+void lazy_missing_device_test() {
+	const uint32_t missing_pin = MAKE_PIN_MCP23008(MISSING_ADDRESS, 0);
+	const uint32_t present_pin = MAKE_PIN_MCP23008(MCP23008_ADDRESS, 0);
+	use_mcp23008(lazy_addrs, 2);
+
+	i2c_sim_clear_stats();
+	TEST_ASSERT_EQUAL(0, initExpandedGPIOLazy(false));
+	TEST_ASSERT_EQUAL_MESSAGE(0, ioctls_since_clear(), "The devices were touched by the initialization");
+
+	// The first access waits for the device, the following ones fail at once
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(pinMode(missing_pin, INPUT) != 0);
+	TEST_ASSERT_TRUE(ioctls_since_clear() > 1);
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(pinMode(missing_pin, INPUT) != 0);
+	TEST_ASSERT_EQUAL(LOW, digitalRead(missing_pin));
+	TEST_ASSERT_EQUAL(0, ioctls_since_clear());
+
+	// The other devices are not affected
+	TEST_ASSERT_EQUAL(0, pinMode(present_pin, INPUT));
+
+	// prewarmExpandedGPIO tries the device again
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(prewarmExpandedGPIO(&missing_pin, 1) != 0);
+	TEST_ASSERT_TRUE(ioctls_since_clear() > 0);
+
+	TEST_ASSERT_EQUAL(0, i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23008, MISSING_ADDRESS));
+	TEST_ASSERT_EQUAL(0, prewarmExpandedGPIO(&missing_pin, 1));
+	i2c_sim_clear_stats();
+	TEST_ASSERT_EQUAL(0, pinMode(present_pin, OUTPUT));
+	const uint64_t ready_ioctls = ioctls_since_clear();
+	i2c_sim_clear_stats();
+	TEST_ASSERT_EQUAL(0, pinMode(missing_pin, OUTPUT));
+	TEST_ASSERT_EQUAL_MESSAGE(ready_ioctls, ioctls_since_clear(), "The device was initialized again");
+
+	TEST_ASSERT_EQUAL(0, deinitExpandedGPIO());
+}
+
+void input_events_test() {
+	const uint32_t pin = MAKE_PIN_MCP23008(MCP23008_ADDRESS, EVENT_PIN);
+	input_event_t events[4];
+	use_mcp23008(present_addrs, 1);
+	TEST_ASSERT_EQUAL(0, initExpandedGPIO(false));
+
+	const int fd = inputEventFd();
+	TEST_ASSERT_TRUE_MESSAGE(fd >= 0, strerror(errno));
+	TEST_ASSERT_EQUAL(0, setInputEventPeriod(1));
+	TEST_ASSERT_EQUAL(0, subscribeInput(pin, 0, 0));
+	TEST_ASSERT_FALSE(event_fd_readable(fd, 20));
+
+	// A change is queued with its new level, and the queue drained clears the descriptor
+	const uint64_t before_ns = plc_stats_now();
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 1 << EVENT_PIN);
+	input_event_t event = wait_event(fd);
+	TEST_ASSERT_EQUAL(pin, event.pin);
+	TEST_ASSERT_EQUAL(HIGH, event.value);
+	TEST_ASSERT_TRUE(event.timestamp_ns >= before_ns);
+	TEST_ASSERT_EQUAL(0, readInputEvents(events, 4));
+	TEST_ASSERT_FALSE(event_fd_readable(fd, 0));
+
+	// The other pins of the expander don't fire
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 1 << EVENT_PIN | 1 << (EVENT_PIN + 1));
+	TEST_ASSERT_FALSE(event_fd_readable(fd, 20));
+
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 0);
+	event = wait_event(fd);
+	TEST_ASSERT_EQUAL(LOW, event.value);
+
+	TEST_ASSERT_EQUAL(0, unsubscribeInput(pin));
+	TEST_ASSERT_EQUAL(-1, unsubscribeInput(pin));
+	TEST_ASSERT_EQUAL(ENOENT, errno);
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 1 << EVENT_PIN);
+	TEST_ASSERT_FALSE(event_fd_readable(fd, 20));
+
+	TEST_ASSERT_EQUAL(0, deinitExpandedGPIO());
+}
+
+void input_monitor_error_test() {
+	const uint32_t pin = MAKE_PIN_MCP23008(MCP23008_ADDRESS, EVENT_PIN);
+	input_event_t event;
+	use_mcp23008(present_addrs, 1);
+	TEST_ASSERT_EQUAL(0, initExpandedGPIO(false));
+
+	const int fd = inputEventFd();
+	TEST_ASSERT_TRUE_MESSAGE(fd >= 0, strerror(errno));
+	TEST_ASSERT_EQUAL(0, setInputEventPeriod(1));
+	TEST_ASSERT_EQUAL(0, subscribeInput(pin, 0, 0));
+	TEST_ASSERT_EQUAL(0, inputEventsError());
+
+	// Without descriptors allowed, the poll of the monitor fails with EINVAL
+	struct rlimit limit;
+	TEST_ASSERT_EQUAL(0, getrlimit(RLIMIT_NOFILE, &limit));
+	const struct rlimit no_files = {.rlim_cur = 0, .rlim_max = limit.rlim_max};
+	TEST_ASSERT_EQUAL(0, setrlimit(RLIMIT_NOFILE, &no_files));
+	for (int i = 0; i < EVENT_TIMEOUT_MS && inputEventsError() == 0; i++) {
+		usleep(1000);
+	}
+	TEST_ASSERT_EQUAL(0, setrlimit(RLIMIT_NOFILE, &limit));
+	TEST_ASSERT_EQUAL(EINVAL, inputEventsError());
+
+	// The application is woken up and told, and the descriptor stays readable
+	TEST_ASSERT_TRUE(event_fd_readable(fd, 0));
+	errno = 0;
+	TEST_ASSERT_EQUAL(0, readInputEvents(&event, 1));
+	TEST_ASSERT_EQUAL(EPIPE, errno);
+	TEST_ASSERT_TRUE(event_fd_readable(fd, 0));
+
+	// Subscribing again starts the monitor over
+	TEST_ASSERT_EQUAL(0, subscribeInput(pin, 0, 0));
+	TEST_ASSERT_EQUAL(0, inputEventsError());
+	TEST_ASSERT_EQUAL(0, readInputEvents(&event, 1));
+	TEST_ASSERT_FALSE(event_fd_readable(fd, 0));
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 1 << EVENT_PIN);
+	event = wait_event(fd);
+	TEST_ASSERT_EQUAL(HIGH, event.value);
+
+	TEST_ASSERT_EQUAL(0, deinitExpandedGPIO());
+}
+
+void interrupt_registers_test() {
+	i2c_interface_t* i2c = i2c_init(I2C_BUS);
+	TEST_ASSERT_NOT_NULL(i2c);
+
+	// Every mode sets its bits of GPINTEN, INTCON and DEFVAL, and leaves the other pins
+	TEST_ASSERT_EQUAL(0, mcp23008_set_interrupt_all(i2c, MCP23008_ADDRESS, 0, 0, 0));
+	TEST_ASSERT_EQUAL(0, mcp23008_set_interrupt(i2c, MCP23008_ADDRESS, 1, MCP23008_INT_ON_CHANGE));
+	TEST_ASSERT_EQUAL(0, mcp23008_set_interrupt(i2c, MCP23008_ADDRESS, 2, MCP23008_INT_ON_LOW));
+	TEST_ASSERT_EQUAL(0, mcp23008_set_interrupt(i2c, MCP23008_ADDRESS, 3, MCP23008_INT_ON_HIGH));
+	TEST_ASSERT_EQUAL_HEX8(0x0E, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_GPINTEN));
+	TEST_ASSERT_EQUAL_HEX8(0x0C, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_INTCON));
+	TEST_ASSERT_EQUAL_HEX8(0x04, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_DEFVAL));
+	TEST_ASSERT_EQUAL(0, mcp23008_set_interrupt(i2c, MCP23008_ADDRESS, 2, MCP23008_INT_DISABLED));
+	TEST_ASSERT_EQUAL_HEX8(0x0A, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_GPINTEN));
+	TEST_ASSERT_EQUAL(-1, mcp23008_set_interrupt(i2c, MCP23008_ADDRESS, 8, MCP23008_INT_ON_CHANGE));
+	TEST_ASSERT_EQUAL(EINVAL, errno);
+
+	TEST_ASSERT_EQUAL(0, mcp23008_set_interrupt_all(i2c, MCP23008_ADDRESS, 0xF0, 0x30, 0x10));
+	TEST_ASSERT_EQUAL_HEX8(0xF0, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_GPINTEN));
+	TEST_ASSERT_EQUAL_HEX8(0x30, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_INTCON));
+	TEST_ASSERT_EQUAL_HEX8(0x10, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_DEFVAL));
+
+	// INTCAP keeps the levels of the first change until it is read, which clears INTF
+	uint8_t flags, captured;
+	TEST_ASSERT_EQUAL(0, mcp23008_set_interrupt_all(i2c, MCP23008_ADDRESS, 1 << 1, 0, 0));
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 1 << 1);
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 0);
+	TEST_ASSERT_EQUAL_HEX8(1 << 1, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_INTF));
+	TEST_ASSERT_EQUAL(0, mcp23008_read_interrupt(i2c, MCP23008_ADDRESS, &flags, &captured));
+	TEST_ASSERT_EQUAL_HEX8(1 << 1, flags);
+	TEST_ASSERT_EQUAL_HEX8(1 << 1, captured);
+	TEST_ASSERT_EQUAL(0, mcp23008_read_interrupt(i2c, MCP23008_ADDRESS, &flags, &captured));
+	TEST_ASSERT_EQUAL_HEX8(0, flags);
+
+	// The disabled pins don't fire
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 1 << 2);
+	TEST_ASSERT_EQUAL(0, mcp23008_read_interrupt(i2c, MCP23008_ADDRESS, &flags, &captured));
+	TEST_ASSERT_EQUAL_HEX8(0, flags);
+	TEST_ASSERT_EQUAL(0, mcp23008_set_interrupt_all(i2c, MCP23008_ADDRESS, 0, 0, 0));
+
+	// The pins 8-15 of the MCP23017 are port B
+	TEST_ASSERT_EQUAL(0, mcp23017_set_interrupt(i2c, MCP23017_ADDRESS, 9, MCP23017_INT_ON_LOW));
+	TEST_ASSERT_EQUAL_HEX8(0, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_GPINTENA));
+	TEST_ASSERT_EQUAL_HEX8(1 << 1, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_GPINTENA + 1));
+	TEST_ASSERT_EQUAL_HEX8(1 << 1, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_INTCONA + 1));
+	TEST_ASSERT_EQUAL_HEX8(1 << 1, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_DEFVALA + 1));
+	TEST_ASSERT_EQUAL(0, mcp23017_set_interrupt(i2c, MCP23017_ADDRESS, 2, MCP23017_INT_ON_CHANGE));
+	TEST_ASSERT_EQUAL_HEX8(1 << 2, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_GPINTENA));
+	TEST_ASSERT_EQUAL_HEX8(0, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_INTCONA));
+
+	// A low level fires while it differs from DEFVAL, and both ports are read at once
+	uint16_t flags16, captured16;
+	i2c_sim_set_inputs(I2C_BUS, MCP23017_ADDRESS, 1 << 9);
+	i2c_sim_set_inputs(I2C_BUS, MCP23017_ADDRESS, 1 << 2);
+	TEST_ASSERT_EQUAL_HEX8(1 << 2, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_INTFA));
+	TEST_ASSERT_EQUAL_HEX8(1 << 1, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_INTFA + 1));
+	TEST_ASSERT_EQUAL(0, mcp23017_read_interrupt(i2c, MCP23017_ADDRESS, &flags16, &captured16));
+	TEST_ASSERT_EQUAL_HEX16(1 << 9 | 1 << 2, flags16);
+	TEST_ASSERT_EQUAL_HEX16(1 << 2, captured16);
+	TEST_ASSERT_EQUAL(0, mcp23017_read_interrupt(i2c, MCP23017_ADDRESS, &flags16, &captured16));
+	TEST_ASSERT_EQUAL_HEX16(0, flags16);
+	TEST_ASSERT_EQUAL(0, mcp23017_set_interrupt_all(i2c, MCP23017_ADDRESS, 0, 0, 0));
+	i2c_sim_set_inputs(I2C_BUS, MCP23017_ADDRESS, 0);
+
+	TEST_ASSERT_EQUAL(0, i2c_deinit(&i2c));
+}
+
+void interrupt_line_events_test() {
+	const uint32_t pin = MAKE_PIN_MCP23008(MCP23008_ADDRESS, EVENT_PIN);
+	use_mcp23008(present_addrs, 1);
+	TEST_ASSERT_EQUAL(0, initExpandedGPIO(false));
+
+	// INT is idle high, and the monitor only reads the expander when it goes low
+	gpio_sim_set_input(GPIO_CHIP, INT_LINE, true);
+	const int fd = inputEventFd();
+	TEST_ASSERT_TRUE_MESSAGE(fd >= 0, strerror(errno));
+	TEST_ASSERT_EQUAL(0, attachInputInterruptLine(MCP23008_ADDRESS, GPIO_CHIP_PATH, INT_LINE));
+	TEST_ASSERT_TRUE(gpio_sim_is_requested(GPIO_CHIP, INT_LINE));
+	TEST_ASSERT_EQUAL(0, subscribeInput(pin, 0, 0));
+	TEST_ASSERT_EQUAL_HEX8(1 << EVENT_PIN, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_GPINTEN));
+	TEST_ASSERT_EQUAL_HEX8(0, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_INTCON));
+
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 1 << EVENT_PIN);
+	TEST_ASSERT_FALSE_MESSAGE(event_fd_readable(fd, 20), "The expander was polled");
+
+	// The event takes the time of the edge, and the interrupt is cleared
+	const uint64_t before_ns = plc_stats_now();
+	gpio_sim_set_input(GPIO_CHIP, INT_LINE, false);
+	input_event_t event = wait_event(fd);
+	TEST_ASSERT_EQUAL(pin, event.pin);
+	TEST_ASSERT_EQUAL(HIGH, event.value);
+	TEST_ASSERT_TRUE(event.timestamp_ns >= before_ns && event.timestamp_ns <= plc_stats_now());
+	TEST_ASSERT_EQUAL_HEX8(0, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_INTF));
+	gpio_sim_set_input(GPIO_CHIP, INT_LINE, true);
+
+	// A pulse shorter than the read is still reported from INTCAP
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 0);
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 1 << EVENT_PIN);
+	gpio_sim_set_input(GPIO_CHIP, INT_LINE, false);
+	event = wait_event(fd);
+	TEST_ASSERT_EQUAL(LOW, event.value);
+	event = wait_event(fd);
+	TEST_ASSERT_EQUAL(HIGH, event.value);
+	gpio_sim_set_input(GPIO_CHIP, INT_LINE, true);
+
+	TEST_ASSERT_EQUAL(0, unsubscribeInput(pin));
+	TEST_ASSERT_EQUAL_HEX8(0, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_GPINTEN));
+
+	TEST_ASSERT_EQUAL(0, deinitExpandedGPIO());
+	TEST_ASSERT_FALSE(gpio_sim_is_requested(GPIO_CHIP, INT_LINE));
+}
+
+void multi_bus_test() {
+	const struct peripherals_t other_devices = mcp23008_devices(present_addrs, 1);
+	const uint32_t device = MAKE_PIN_MCP23008(MCP23008_ADDRESS, 0);
+	const uint32_t pin = MAKE_PIN_MCP23008(MCP23008_ADDRESS, OUTPUT_PIN);
+	const uint32_t other_pin = PIN_ON_BUS(1, pin);
+	use_mcp23008(present_addrs, 1);
+	TEST_ASSERT_EQUAL(0, setExpandedGPIOBus(1, OTHER_BUS, &other_devices));
+	TEST_ASSERT_EQUAL(0, initExpandedGPIO(false));
+
+	// The same address on every bus is a different device
+	TEST_ASSERT_EQUAL(0, pinMode(pin, OUTPUT));
+	TEST_ASSERT_EQUAL(0, pinMode(other_pin, OUTPUT));
+	TEST_ASSERT_EQUAL(0, digitalWrite(other_pin, HIGH));
+	TEST_ASSERT_EQUAL_HEX8(1 << OUTPUT_PIN, i2c_sim_peek(OTHER_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+	TEST_ASSERT_EQUAL_HEX8(0, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+	TEST_ASSERT_EQUAL(0, digitalWrite(pin, HIGH));
+	TEST_ASSERT_EQUAL(0, digitalWrite(other_pin, LOW));
+	TEST_ASSERT_EQUAL_HEX8(0, i2c_sim_peek(OTHER_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+	TEST_ASSERT_EQUAL_HEX8(1 << OUTPUT_PIN, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+	i2c_sim_set_inputs(OTHER_BUS, MCP23008_ADDRESS, 1 << 1);
+	TEST_ASSERT_EQUAL(HIGH, digitalRead(PIN_ON_BUS(1, MAKE_PIN_MCP23008(MCP23008_ADDRESS, 1))));
+	TEST_ASSERT_EQUAL(LOW, digitalRead(MAKE_PIN_MCP23008(MCP23008_ADDRESS, 1)));
+
+	// Every operation of a batch goes to its own bus, and one without bus fails alone
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 0x05);
+	i2c_sim_set_inputs(OTHER_BUS, MCP23008_ADDRESS, 0x0A);
+	expanded_gpio_read_all_t reads[] = {
+		{.device = PIN_ON_BUS(1, device)},
+		{.device = device},
+		{.device = PIN_ON_BUS(2, device)},
+	};
+	TEST_ASSERT_EQUAL(I2C_PIN_WITHOUT_I2C_BUS, digitalReadAllBatch(reads, 3));
+	TEST_ASSERT_EQUAL(0, reads[0].result);
+	TEST_ASSERT_EQUAL_HEX8(0x0A, reads[0].values & 0x7F);
+	TEST_ASSERT_EQUAL(0, reads[1].result);
+	TEST_ASSERT_EQUAL_HEX8(0x05, reads[1].values & 0x7F);
+	TEST_ASSERT_EQUAL(I2C_PIN_WITHOUT_I2C_BUS, reads[2].result);
+
+	expanded_gpio_write_all_t writes[] = {
+		{.device = PIN_ON_BUS(1, device), .values = 0x0F},
+		{.device = device, .values = 0xF0},
+	};
+	TEST_ASSERT_EQUAL(0, digitalWriteAllBatch(writes, 2));
+	TEST_ASSERT_EQUAL_HEX8(0x0F, i2c_sim_peek(OTHER_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+	TEST_ASSERT_EQUAL_HEX8(0xF0, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+
+	// Each slot counts the use of its own lock
+	expanded_gpio_lock_stats_t stats;
+	clearExpandedGPIOLockStats();
+	TEST_ASSERT_EQUAL(0, digitalWrite(other_pin, HIGH));
+	TEST_ASSERT_EQUAL(0, getExpandedGPIOLockStats(1, &stats));
+	TEST_ASSERT_EQUAL(1, stats.acquisitions);
+	TEST_ASSERT_EQUAL(0, getExpandedGPIOLockStats(0, &stats));
+	TEST_ASSERT_EQUAL(0, stats.acquisitions);
+
+	TEST_ASSERT_EQUAL(0, deinitExpandedGPIO());
+	TEST_ASSERT_EQUAL(0, setExpandedGPIOBus(1, OTHER_BUS, NULL));
+	i2c_sim_set_inputs(OTHER_BUS, MCP23008_ADDRESS, 0);
+}
+
+void contexts_test() {
+	const struct peripherals_t devices = mcp23008_devices(present_addrs, 1);
+	const plc_context_config_t config_a = {.bus = CONTEXT_BUS_A, .peripherals = &devices};
+	const plc_context_config_t config_b = {.bus = CONTEXT_BUS_B, .peripherals = &devices};
+	const uint32_t pin = MAKE_PIN_MCP23008(MCP23008_ADDRESS, OUTPUT_PIN);
+	const uint32_t input_pin = MAKE_PIN_MCP23008(MCP23008_ADDRESS, INTEGRATOR_PIN);
+	plc_context_t* a = plcContextCreate(&config_a);
+	plc_context_t* b = plcContextCreate(&config_b);
+	TEST_ASSERT_NOT_NULL(a);
+	TEST_ASSERT_NOT_NULL(b);
+	use_mcp23008(present_addrs, 1);
+	TEST_ASSERT_EQUAL(0, initExpandedGPIO(false));
+	TEST_ASSERT_EQUAL(0, plcInitExpandedGPIO(a, false));
+	TEST_ASSERT_EQUAL(0, plcInitExpandedGPIO(b, false));
+
+	// The writes of a context only reach its own bus
+	TEST_ASSERT_EQUAL(0, plcPinMode(a, pin, OUTPUT));
+	TEST_ASSERT_EQUAL(0, plcDigitalWrite(a, pin, HIGH));
+	TEST_ASSERT_EQUAL_HEX8(1 << OUTPUT_PIN, i2c_sim_peek(CONTEXT_BUS_A, MCP23008_ADDRESS, MCP23008_OLAT));
+	TEST_ASSERT_EQUAL_HEX8(0, i2c_sim_peek(CONTEXT_BUS_B, MCP23008_ADDRESS, MCP23008_OLAT));
+	TEST_ASSERT_EQUAL_HEX8(0, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+
+	// So do the debounce filters, for the same pin with the same inputs
+	TEST_ASSERT_EQUAL(0, plcSetInputDebounce(a, input_pin, DEBOUNCE_INTEGRATOR, INTEGRATOR_SAMPLES));
+	TEST_ASSERT_EQUAL(LOW, plcDigitalRead(a, input_pin));
+	i2c_sim_set_inputs(CONTEXT_BUS_A, MCP23008_ADDRESS, 1 << INTEGRATOR_PIN);
+	i2c_sim_set_inputs(CONTEXT_BUS_B, MCP23008_ADDRESS, 1 << INTEGRATOR_PIN);
+	TEST_ASSERT_EQUAL(HIGH, plcDigitalRead(b, input_pin));
+	TEST_ASSERT_EQUAL_MESSAGE(LOW, plcDigitalRead(a, input_pin), "The filter of the other context was used");
+	TEST_ASSERT_EQUAL(LOW, digitalRead(input_pin));
+	i2c_sim_set_inputs(CONTEXT_BUS_A, MCP23008_ADDRESS, 0);
+	i2c_sim_set_inputs(CONTEXT_BUS_B, MCP23008_ADDRESS, 0);
+
+	// Releasing a context leaves the others working
+	TEST_ASSERT_EQUAL(-1, plcContextDestroy(&a));
+	TEST_ASSERT_EQUAL(EBUSY, errno);
+	TEST_ASSERT_EQUAL(0, plcDeinitExpandedGPIO(a));
+	TEST_ASSERT_EQUAL(0, plcPinMode(b, pin, OUTPUT));
+	TEST_ASSERT_EQUAL(0, plcDigitalWrite(b, pin, HIGH));
+	TEST_ASSERT_EQUAL_HEX8(1 << OUTPUT_PIN, i2c_sim_peek(CONTEXT_BUS_B, MCP23008_ADDRESS, MCP23008_OLAT));
+	TEST_ASSERT_EQUAL(0, digitalWrite(pin, LOW));
+	TEST_ASSERT_EQUAL(0, plcContextDestroy(&a));
+	TEST_ASSERT_NULL(a);
+
+	TEST_ASSERT_EQUAL(0, plcDeinitExpandedGPIO(b));
+	TEST_ASSERT_EQUAL(0, plcContextDestroy(&b));
+	TEST_ASSERT_EQUAL(0, deinitExpandedGPIO());
+}
+
+void pulse_counter_test() {
+	static const uint32_t offsets[] = {COUNTER_LINE, IDLE_COUNTER_LINE};
+	pulse_counter_reading_t reading;
+	pulse_counter_t* counter = pulse_counter_open(GPIO_CHIP_PATH, offsets, 2, GPIO_CHARDEV_EDGE_RISING, 0);
+	TEST_ASSERT_NOT_NULL_MESSAGE(counter, strerror(errno));
+
+	// Only the rising edges of the line are counted
+	for (int i = 0; i < COUNTER_PULSES; i++) {
+		gpio_sim_set_input(GPIO_CHIP, COUNTER_LINE, true);
+		gpio_sim_set_input(GPIO_CHIP, COUNTER_LINE, false);
+	}
+	TEST_ASSERT_EQUAL(COUNTER_PULSES, wait_count(counter, 0, COUNTER_PULSES));
+	TEST_ASSERT_EQUAL(0, wait_count(counter, 1, 0));
+	TEST_ASSERT_EQUAL(0, pulse_counter_missed(counter));
+	TEST_ASSERT_EQUAL(0, pulse_counter_error(counter));
+
+	uint64_t levels;
+	gpio_sim_set_input(GPIO_CHIP, IDLE_COUNTER_LINE, true);
+	TEST_ASSERT_EQUAL(0, pulse_counter_levels(counter, &levels));
+	TEST_ASSERT_EQUAL_HEX64(0x2, levels);
+	gpio_sim_set_input(GPIO_CHIP, IDLE_COUNTER_LINE, false);
+	TEST_ASSERT_EQUAL(0, pulse_counter_reset(counter, 0));
+	TEST_ASSERT_EQUAL(0, wait_count(counter, 0, 0));
+
+	// The chip going away stops the counting, and the readings tell it
+	gpio_sim_set_input(GPIO_CHIP, COUNTER_LINE, true);
+	gpio_sim_set_input(GPIO_CHIP, COUNTER_LINE, false);
+	TEST_ASSERT_EQUAL(1, wait_count(counter, 0, 1));
+	TEST_ASSERT_EQUAL(0, gpio_sim_hangup(GPIO_CHIP));
+	for (int i = 0; i < EVENT_TIMEOUT_MS && pulse_counter_error(counter) == 0; i++) {
+		usleep(1000);
+	}
+	TEST_ASSERT_EQUAL(EPIPE, pulse_counter_error(counter));
+	TEST_ASSERT_EQUAL(-1, pulse_counter_read(counter, 0, &reading));
+	TEST_ASSERT_EQUAL(EPIPE, errno);
+	TEST_ASSERT_EQUAL(1, reading.count);
+
+	TEST_ASSERT_EQUAL(0, pulse_counter_close(&counter));
+	TEST_ASSERT_NULL(counter);
+	TEST_ASSERT_FALSE(gpio_sim_is_requested(GPIO_CHIP, COUNTER_LINE));
+}
+
+#ifdef PLC_PERIPHERALS_NORMAL_GPIO_CHARDEV
+void chardev_direct_pins_test() {
+	// The direct pins 0 and 1 are lines 4 and 5 of the simulated chip
+	static const normal_gpio_chardev_line_t lines[] = {
+		{GPIO_CHIP_PATH, 4},
+		{GPIO_CHIP_PATH, 5},
+	};
+	const uint32_t output_pin = MAKE_PIN_DIRECT(0);
+	const uint32_t input_pin = MAKE_PIN_DIRECT(1);
+	use_mcp23008(present_addrs, 1);
+	TEST_ASSERT_EQUAL(0, normal_gpio_chardev_set_lines(lines, 2));
+	TEST_ASSERT_EQUAL(0, initExpandedGPIO(false));
+	TEST_ASSERT_TRUE(gpio_sim_is_requested(GPIO_CHIP, 4));
+	TEST_ASSERT_TRUE(gpio_sim_is_requested(GPIO_CHIP, 5));
+	TEST_ASSERT_FALSE(gpio_sim_is_requested(GPIO_CHIP, 0));
+
+	// The writes reach the line, and changing the mode of a pin keeps the other one
+	TEST_ASSERT_EQUAL(0, pinMode(output_pin, OUTPUT));
+	TEST_ASSERT_EQUAL(0, digitalWrite(output_pin, HIGH));
+	TEST_ASSERT_EQUAL(1, gpio_sim_get_output(GPIO_CHIP, 4));
+	TEST_ASSERT_EQUAL(0, pinMode(input_pin, INPUT));
+	TEST_ASSERT_EQUAL(1, gpio_sim_get_output(GPIO_CHIP, 4));
+	TEST_ASSERT_EQUAL(0, digitalWrite(output_pin, LOW));
+	TEST_ASSERT_EQUAL(0, gpio_sim_get_output(GPIO_CHIP, 4));
+
+	// The reads come from the line
+	TEST_ASSERT_EQUAL(LOW, digitalRead(input_pin));
+	TEST_ASSERT_EQUAL(0, gpio_sim_set_input(GPIO_CHIP, 5, true));
+	TEST_ASSERT_EQUAL(HIGH, digitalRead(input_pin));
+	TEST_ASSERT_EQUAL(0, gpio_sim_set_input(GPIO_CHIP, 5, false));
+	TEST_ASSERT_EQUAL(LOW, digitalRead(input_pin));
+
+	// The lines are released, and taken again by the next initialization
+	TEST_ASSERT_EQUAL(0, deinitExpandedGPIO());
+	TEST_ASSERT_FALSE(gpio_sim_is_requested(GPIO_CHIP, 4));
+	TEST_ASSERT_FALSE(gpio_sim_is_requested(GPIO_CHIP, 5));
+	TEST_ASSERT_EQUAL(0, initExpandedGPIO(false));
+	TEST_ASSERT_TRUE(gpio_sim_is_requested(GPIO_CHIP, 4));
+	TEST_ASSERT_EQUAL(0, deinitExpandedGPIO());
+}
+#endif
+
+int main() {
+	// Keep the snapshots out of /run
+	if (mkdtemp(snapshot_dir) == NULL) {
+		perror("mkdtemp");
+		return 1;
+	}
+	setenv("PLC_PERIPHERALS_SNAPSHOT_DIR", snapshot_dir, 1);
+	snprintf(snapshot_file, sizeof(snapshot_file), "%s/plc-peripherals-i2c-%d.snapshot", snapshot_dir, I2C_BUS);
+
+	i2c_sim_enable(true);
+	i2c_sim_set_bus_speed(0);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23008, MCP23008_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23017, MCP23017_ADDRESS);
+	i2c_sim_add_device(OTHER_BUS, I2C_SIM_MCP23008, MCP23008_ADDRESS);
+	i2c_sim_add_device(CONTEXT_BUS_A, I2C_SIM_MCP23008, MCP23008_ADDRESS);
+	i2c_sim_add_device(CONTEXT_BUS_B, I2C_SIM_MCP23008, MCP23008_ADDRESS);
+	gpio_sim_add_chip(GPIO_CHIP, GPIO_CHIP_LINES);
+
+	UNITY_BEGIN();
+
+	RUN_TEST(debounce_integrator_test);
+	RUN_TEST(debounce_time_window_test);
+	RUN_TEST(snapshot_test);
+	RUN_TEST(lazy_missing_device_test);
+	RUN_TEST(input_events_test);
+	RUN_TEST(input_monitor_error_test);
+	RUN_TEST(interrupt_registers_test);
+	RUN_TEST(interrupt_line_events_test);
+	RUN_TEST(multi_bus_test);
+	RUN_TEST(contexts_test);
+	RUN_TEST(pulse_counter_test);
+#ifdef PLC_PERIPHERALS_NORMAL_GPIO_CHARDEV
+	// Last, since the direct pins stay set for the next initializations
+	RUN_TEST(chardev_direct_pins_test);
+#endif
+
+	const int failures = UNITY_END();
+	unlink(snapshot_file);
+	rmdir(snapshot_dir);
+	return failures;
+}
+
+#endif // PLC_ENVIRONMENT == Linux
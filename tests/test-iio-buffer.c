@@ -0,0 +1,322 @@
+/**
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Unlike the other tests, this one doesn't need any hardware: the IIO device
+ * is a fake sysfs tree created in /tmp, and its character device is a FIFO
+ * fed by the test.
+ */
+
+#define _GNU_SOURCE
+
+#include <plc-peripherals.h>
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <endian.h>
+#include <sys/stat.h>
+
+#define TRIGGER "trigger0"
+
+#include <unity.h>
+
+static char root[] = "/tmp/test-iio-buffer-XXXXXX";
+static char sysfs_root[64], dev_root[64];
+static int device_fd = -1;
+
+static const char* const channels[] = {"in_voltage0", "in_voltage1"};
+
+// Sample of the fake device: voltage0 (le:u12/16), voltage1 (be:u12/16>>4) and the timestamp
+struct __attribute__((packed)) raw_sample_t {
+	uint16_t voltage0;
+	uint16_t voltage1;
+	uint32_t padding;
+	int64_t timestamp;
+};
+
+static void write_file(const char* name, const char* content) {
+	char path[256];
+	snprintf(path, sizeof(path), "%s/%s", root, name);
+	FILE* file = fopen(path, "w");
+	TEST_ASSERT_NOT_NULL_MESSAGE(file, strerror(errno));
+	fputs(content, file);
+	fclose(file);
+}
+
+static const char* read_file(const char* name) {
+	static char content[64];
+	char path[256];
+	snprintf(path, sizeof(path), "%s/%s", root, name);
+	FILE* file = fopen(path, "r");
+	TEST_ASSERT_NOT_NULL_MESSAGE(file, strerror(errno));
+	size_t len = fread(content, 1, sizeof(content) - 1, file);
+	content[len] = '\0';
+	fclose(file);
+	return content;
+}
+
+static void make_dir(const char* name) {
+	char path[256];
+	snprintf(path, sizeof(path), "%s/%s", root, name);
+	TEST_ASSERT_EQUAL_MESSAGE(0, mkdir(path, 0755), strerror(errno));
+}
+
+static iio_buffer_config_t make_config(size_t ring_length) {
+	return (iio_buffer_config_t) {
+		.sysfs_root = sysfs_root,
+		.dev_root = dev_root,
+		.device = 0,
+		.channels = channels,
+		.num_channels = 2,
+		.trigger = TRIGGER,
+		.kernel_length = 128,
+		.ring_length = ring_length
+	};
+}
+
+static void feed(uint16_t voltage0, uint16_t voltage1, int64_t timestamp) {
+	const struct raw_sample_t sample = {
+		.voltage0 = htole16(voltage0),
+		.voltage1 = htobe16(voltage1 << 4),
+		.padding = 0,
+		.timestamp = htole64(timestamp)
+	};
+	TEST_ASSERT_EQUAL_MESSAGE(sizeof(sample), write(device_fd, &sample, sizeof(sample)), strerror(errno));
+}
+
+static size_t wait_samples(iio_buffer_t* buffer, iio_buffer_sample_t* samples, size_t expected) {
+	size_t num = 0;
+	for (int tries = 0; tries < 100 && num < expected; tries++) {
+		num += iio_buffer_read_block(buffer, samples + num, expected - num);
+		usleep(10 * 1000);
+	}
+	return num;
+}
+
+void setUp(void) {
+	strcpy(root, "/tmp/test-iio-buffer-XXXXXX");
+	TEST_ASSERT_NOT_NULL_MESSAGE(mkdtemp(root), strerror(errno));
+	snprintf(sysfs_root, sizeof(sysfs_root), "%s/sys", root);
+	snprintf(dev_root, sizeof(dev_root), "%s/dev", root);
+
+	make_dir("sys");
+	make_dir("sys/iio:device0");
+	make_dir("sys/iio:device0/buffer");
+	make_dir("sys/iio:device0/trigger");
+	make_dir("sys/iio:device0/scan_elements");
+	write_file("sys/iio:device0/buffer/enable", "0\n");
+	write_file("sys/iio:device0/buffer/length", "2\n");
+	write_file("sys/iio:device0/trigger/current_trigger", "\n");
+
+	write_file("sys/iio:device0/scan_elements/in_voltage0_en", "0\n");
+	write_file("sys/iio:device0/scan_elements/in_voltage0_index", "0\n");
+	write_file("sys/iio:device0/scan_elements/in_voltage0_type", "le:u12/16>>0\n");
+	write_file("sys/iio:device0/scan_elements/in_voltage1_en", "0\n");
+	write_file("sys/iio:device0/scan_elements/in_voltage1_index", "1\n");
+	write_file("sys/iio:device0/scan_elements/in_voltage1_type", "be:u12/16>>4\n");
+	write_file("sys/iio:device0/scan_elements/in_voltage2_en", "1\n");
+	write_file("sys/iio:device0/scan_elements/in_voltage2_index", "2\n");
+	write_file("sys/iio:device0/scan_elements/in_voltage2_type", "le:u12/16>>0\n");
+	write_file("sys/iio:device0/scan_elements/in_timestamp_en", "0\n");
+	write_file("sys/iio:device0/scan_elements/in_timestamp_index", "3\n");
+	write_file("sys/iio:device0/scan_elements/in_timestamp_type", "le:s64/64>>0\n");
+
+	make_dir("dev");
+	char path[256];
+	snprintf(path, sizeof(path), "%s/iio:device0", dev_root);
+	TEST_ASSERT_EQUAL_MESSAGE(0, mkfifo(path, 0600), strerror(errno));
+	// Opened for reading too, so it doesn't block and never reports a hang-up
+	device_fd = open(path, O_RDWR);
+	TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(0, device_fd, strerror(errno));
+}
+
+static int remove_entry(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+	(void) st;
+	(void) flag;
+	(void) ftw;
+	return remove(path);
+}
+
+void tearDown(void) {
+	if (device_fd >= 0) {
+		close(device_fd);
+		device_fd = -1;
+	}
+	nftw(root, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+}
+
+void iio_buffer_sanity_check() {
+	TEST_ASSERT_NULL(iio_buffer_open(NULL));
+	TEST_ASSERT_EQUAL_MESSAGE(EFAULT, errno, strerror(errno));
+
+	iio_buffer_config_t config = make_config(16);
+	config.num_channels = 0;
+	TEST_ASSERT_NULL(iio_buffer_open(&config));
+	TEST_ASSERT_EQUAL_MESSAGE(EINVAL, errno, strerror(errno));
+
+	config = make_config(0);
+	TEST_ASSERT_NULL(iio_buffer_open(&config));
+	TEST_ASSERT_EQUAL_MESSAGE(EINVAL, errno, strerror(errno));
+
+	// The device doesn't exist
+	config = make_config(16);
+	config.device = 5;
+	TEST_ASSERT_NULL(iio_buffer_open(&config));
+	TEST_ASSERT_EQUAL_MESSAGE(ENOENT, errno, strerror(errno));
+
+	TEST_ASSERT_EQUAL_MESSAGE(-1, iio_buffer_close(NULL), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(EFAULT, errno, strerror(errno));
+
+	uint16_t value;
+	TEST_ASSERT_EQUAL_MESSAGE(-1, iio_buffer_latest(NULL, 0, &value), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(EFAULT, errno, strerror(errno));
+}
+
+void iio_buffer_setup_test() {
+	iio_buffer_config_t config = make_config(16);
+	iio_buffer_t* buffer = iio_buffer_open(&config);
+	TEST_ASSERT_NOT_NULL_MESSAGE(buffer, strerror(errno));
+
+	TEST_ASSERT_EQUAL_STRING("1", read_file("sys/iio:device0/scan_elements/in_voltage0_en"));
+	TEST_ASSERT_EQUAL_STRING("1", read_file("sys/iio:device0/scan_elements/in_voltage1_en"));
+	TEST_ASSERT_EQUAL_STRING("0", read_file("sys/iio:device0/scan_elements/in_voltage2_en"));
+	TEST_ASSERT_EQUAL_STRING("1", read_file("sys/iio:device0/scan_elements/in_timestamp_en"));
+	TEST_ASSERT_EQUAL_STRING(TRIGGER, read_file("sys/iio:device0/trigger/current_trigger"));
+	TEST_ASSERT_EQUAL_STRING("128", read_file("sys/iio:device0/buffer/length"));
+	TEST_ASSERT_EQUAL_STRING("1", read_file("sys/iio:device0/buffer/enable"));
+
+	// Nothing captured yet
+	uint16_t value;
+	TEST_ASSERT_EQUAL_MESSAGE(-1, iio_buffer_latest(buffer, 0, &value), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(EAGAIN, errno, strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(-1, iio_buffer_latest(buffer, 2, &value), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(EINVAL, errno, strerror(errno));
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, iio_buffer_close(&buffer), strerror(errno));
+	TEST_ASSERT_NULL(buffer);
+	TEST_ASSERT_EQUAL_STRING("0", read_file("sys/iio:device0/buffer/enable"));
+}
+
+void iio_buffer_capture_test() {
+	iio_buffer_config_t config = make_config(16);
+	iio_buffer_t* buffer = iio_buffer_open(&config);
+	TEST_ASSERT_NOT_NULL_MESSAGE(buffer, strerror(errno));
+
+	feed(100, 4000, 1000);
+	feed(200, 3000, 2000);
+	feed(4095, 0, 3000);
+
+	iio_buffer_sample_t samples[3];
+	TEST_ASSERT_EQUAL(3, wait_samples(buffer, samples, 3));
+	TEST_ASSERT_EQUAL(100, samples[0].values[0]);
+	TEST_ASSERT_EQUAL(4000, samples[0].values[1]);
+	TEST_ASSERT_EQUAL(1000, samples[0].timestamp_ns);
+	TEST_ASSERT_EQUAL(200, samples[1].values[0]);
+	TEST_ASSERT_EQUAL(3000, samples[1].values[1]);
+	TEST_ASSERT_EQUAL(4095, samples[2].values[0]);
+	TEST_ASSERT_EQUAL(0, samples[2].values[1]);
+	TEST_ASSERT_EQUAL(3000, samples[2].timestamp_ns);
+
+	uint16_t value;
+	TEST_ASSERT_EQUAL_MESSAGE(0, iio_buffer_latest(buffer, 0, &value), strerror(errno));
+	TEST_ASSERT_EQUAL(4095, value);
+
+	// Already taken
+	TEST_ASSERT_EQUAL(0, iio_buffer_read_block(buffer, samples, 3));
+	TEST_ASSERT_EQUAL(0, iio_buffer_dropped(buffer));
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, iio_buffer_close(&buffer), strerror(errno));
+}
+
+void iio_buffer_overrun_test() {
+	iio_buffer_config_t config = make_config(4);
+	iio_buffer_t* buffer = iio_buffer_open(&config);
+	TEST_ASSERT_NOT_NULL_MESSAGE(buffer, strerror(errno));
+
+	for (int i = 0; i < 6; i++) {
+		feed(i, i, i);
+	}
+	uint16_t value = 0;
+	for (int tries = 0; tries < 100 && value != 5; tries++) {
+		iio_buffer_latest(buffer, 0, &value);
+		usleep(10 * 1000);
+	}
+	TEST_ASSERT_EQUAL(5, value);
+
+	// The two oldest samples were overwritten
+	iio_buffer_sample_t samples[6];
+	TEST_ASSERT_EQUAL(4, iio_buffer_read_block(buffer, samples, 6));
+	TEST_ASSERT_EQUAL(2, samples[0].values[0]);
+	TEST_ASSERT_EQUAL(5, samples[3].values[0]);
+	TEST_ASSERT_EQUAL(2, iio_buffer_dropped(buffer));
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, iio_buffer_close(&buffer), strerror(errno));
+}
+
+void iio_buffer_hangup_test() {
+	iio_buffer_config_t config = make_config(16);
+	iio_buffer_t* buffer = iio_buffer_open(&config);
+	TEST_ASSERT_NOT_NULL_MESSAGE(buffer, strerror(errno));
+
+	feed(100, 200, 1000);
+	iio_buffer_sample_t samples[1];
+	TEST_ASSERT_EQUAL(1, wait_samples(buffer, samples, 1));
+	TEST_ASSERT_EQUAL(0, iio_buffer_error(buffer));
+
+	// Without writers, the FIFO reports a hang-up, as a device that goes away
+	feed(300, 400, 2000);
+	close(device_fd);
+	device_fd = -1;
+
+	uint16_t value;
+	int ret = 0;
+	for (int tries = 0; tries < 100 && ret == 0; tries++) {
+		ret = iio_buffer_latest(buffer, 0, &value);
+		usleep(10 * 1000);
+	}
+	TEST_ASSERT_EQUAL(-1, ret);
+	TEST_ASSERT_EQUAL_MESSAGE(EPIPE, errno, strerror(errno));
+	TEST_ASSERT_EQUAL(EPIPE, iio_buffer_error(buffer));
+
+	// The samples captured before are kept
+	TEST_ASSERT_EQUAL(1, iio_buffer_read_block(buffer, samples, 1));
+	TEST_ASSERT_EQUAL(300, samples[0].values[0]);
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, iio_buffer_close(&buffer), strerror(errno));
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(iio_buffer_sanity_check);
+	RUN_TEST(iio_buffer_setup_test);
+
+	RUN_TEST(iio_buffer_capture_test);
+	RUN_TEST(iio_buffer_overrun_test);
+	RUN_TEST(iio_buffer_hangup_test);
+
+	return UNITY_END();
+}
+
+#endif // PLC_ENVIRONMENT == Linux
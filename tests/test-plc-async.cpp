@@ -0,0 +1,269 @@
+/**
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Checks the coroutines of plc-async.hpp on the simulated bus of
+ * bench/i2c-sim: the results reach the coroutines, the reads of an ADS1015
+ * don't mix their channels, and the bus serves the other devices while an
+ * ADS1015 converts.
+ */
+
+#include <plc-async.hpp>
+#include <expanded-gpio.h> // I2C_BUS, the bus of bench-board
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#include <stdexcept>
+#include <vector>
+
+#include <unity.h>
+
+#include "i2c-sim.h"
+
+#define MCP23008_ADDRESS 0x20
+#define MCP23017_ADDRESS 0x21
+#define PCA9685_ADDRESS 0x40
+#define ADS1015_ADDRESS 0x48
+#define LTC2309_ADDRESS 0x08
+#define MISSING_ADDRESS 0x30
+
+// Registers of the simulated MCP230XX (IOCON.BANK = 0)
+#define MCP23017_OLATA 0x14
+
+// The co_await are never in the condition of the assertions: GCC 12 skips the
+// body of a coroutine with a co_await in the condition of an if
+
+extern "C" void setUp(void) {
+	i2c_sim_clear_stats();
+}
+
+extern "C" void tearDown(void) {
+}
+
+static plc::Task<> init_task(plc::AsyncMcp23017& mcp, plc::AsyncAds1015& ads, plc::AsyncLtc2309& ltc) {
+	plc::Status status = co_await mcp.init();
+	TEST_ASSERT_TRUE(status.ok());
+	status = co_await ads.init();
+	TEST_ASSERT_TRUE(status.ok());
+	status = co_await ltc.init();
+	TEST_ASSERT_TRUE(status.ok());
+}
+
+static plc::Task<> read_task(plc::AsyncMcp23017& mcp, plc::AsyncAds1015& ads, plc::AsyncLtc2309& ltc) {
+	plc::Status status = co_await mcp.pin_mode_all(0xFF00);
+	TEST_ASSERT_TRUE(status.ok());
+	status = co_await mcp.write_all(0x0081);
+	TEST_ASSERT_TRUE(status.ok());
+	TEST_ASSERT_EQUAL_HEX8(0x81, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_OLATA));
+
+	i2c_sim_set_inputs(I2C_BUS, MCP23017_ADDRESS, 0x1200);
+	const plc::Result<uint16_t> levels = co_await mcp.read_all();
+	TEST_ASSERT_TRUE(levels.ok());
+	TEST_ASSERT_EQUAL_HEX16(0x1281, levels.value);
+
+	i2c_sim_set_analog(I2C_BUS, ADS1015_ADDRESS, 2, 1000);
+	const plc::Result<uint16_t> analog = co_await ads.unsigned_read(2);
+	TEST_ASSERT_TRUE(analog.ok());
+	TEST_ASSERT_EQUAL_UINT16(1000, analog.value);
+
+	i2c_sim_set_analog(I2C_BUS, LTC2309_ADDRESS, 7, 3000);
+	const plc::Result<uint16_t> other = co_await ltc.read(7);
+	TEST_ASSERT_TRUE(other.ok());
+	TEST_ASSERT_EQUAL_UINT16(3000, other.value);
+
+	const plc::Result<int16_t> invalid = co_await ads.read(4);
+	TEST_ASSERT_EQUAL(EINVAL, invalid.status.error());
+}
+
+void read_test() {
+	plc::AsyncBus bus(I2C_BUS);
+	TEST_ASSERT_MESSAGE(bus.status().ok(), bus.status().message());
+	plc::AsyncMcp23017 mcp(bus, MCP23017_ADDRESS);
+	plc::AsyncAds1015 ads(bus, ADS1015_ADDRESS);
+	plc::AsyncLtc2309 ltc(bus, LTC2309_ADDRESS);
+
+	plc::AsyncLoop loop;
+	loop.spawn(init_task(mcp, ads, ltc));
+	loop.run();
+	loop.spawn(read_task(mcp, ads, ltc));
+	loop.run();
+}
+
+static plc::Task<> same_ads_task(plc::AsyncAds1015& ads) {
+	i2c_sim_set_analog(I2C_BUS, ADS1015_ADDRESS, 0, 100);
+	i2c_sim_set_analog(I2C_BUS, ADS1015_ADDRESS, 1, 200);
+	i2c_sim_set_analog(I2C_BUS, ADS1015_ADDRESS, 3, 300);
+
+	auto [a, b, c] = co_await plc::when_all(ads.unsigned_read(0), ads.unsigned_read(1), ads.unsigned_read(3));
+	TEST_ASSERT_TRUE(a.ok() && b.ok() && c.ok());
+	TEST_ASSERT_EQUAL_UINT16(100, a.value);
+	TEST_ASSERT_EQUAL_UINT16(200, b.value);
+	TEST_ASSERT_EQUAL_UINT16(300, c.value);
+}
+
+void same_ads_test() {
+	plc::AsyncBus bus(I2C_BUS);
+	plc::AsyncAds1015 ads(bus, ADS1015_ADDRESS);
+
+	plc::AsyncLoop loop;
+	loop.spawn(same_ads_task(ads));
+	loop.run();
+}
+
+static plc::Task<> overlap_task(plc::AsyncAds1015& ads, plc::AsyncMcp23008& mcp, std::vector<int>& order) {
+	// Several devices at once
+	auto [analog, levels, written] = co_await plc::when_all(ads.read(0), mcp.read_all(), mcp.write(3, true));
+	TEST_ASSERT_TRUE(analog.ok() && levels.ok() && written.ok());
+	order.push_back(2);
+}
+
+static plc::Task<> ads_then_record(plc::AsyncAds1015& ads, std::vector<int>& order) {
+	const plc::Result<int16_t> value = co_await ads.read(0);
+	TEST_ASSERT_TRUE(value.ok());
+	order.push_back(0);
+}
+
+static plc::Task<> mcp_then_record(plc::AsyncMcp23008& mcp, std::vector<int>& order) {
+	const plc::Result<uint8_t> values = co_await mcp.read_all();
+	TEST_ASSERT_TRUE(values.ok());
+	order.push_back(1);
+}
+
+void overlap_test() {
+	plc::AsyncBus bus(I2C_BUS);
+	plc::AsyncAds1015 ads(bus, ADS1015_ADDRESS);
+	plc::AsyncMcp23008 mcp(bus, MCP23008_ADDRESS);
+	std::vector<int> order;
+
+	plc::AsyncLoop loop;
+	loop.spawn(overlap_task(ads, mcp, order));
+	loop.run();
+	TEST_ASSERT_EQUAL(1, (int) order.size());
+
+	// Two coroutines: the one of the expander ends first, during the conversion
+	order.clear();
+	loop.spawn(ads_then_record(ads, order));
+	loop.spawn(mcp_then_record(mcp, order));
+	const auto start = std::chrono::steady_clock::now();
+	loop.run();
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+	TEST_ASSERT_EQUAL(2, (int) order.size());
+	TEST_ASSERT_EQUAL(1, order[0]);
+	TEST_ASSERT_EQUAL(0, order[1]);
+	TEST_ASSERT_TRUE(elapsed >= std::chrono::microseconds(ADS1015_CONVERSION_US));
+}
+
+static plc::Task<int> nested_task(plc::AsyncBus& bus, bool fail) {
+	plc::Pca9685 pca(bus.bus(), PCA9685_ADDRESS);
+	plc::Status status = co_await bus.run([&] { return pca.init(); });
+	TEST_ASSERT_TRUE(status.ok());
+	status = co_await bus.run([&] { return pca.pwm_write(3, 2048); });
+	TEST_ASSERT_TRUE(status.ok());
+
+	const plc::Result<uint16_t> duty = co_await bus.run<uint16_t>([&](uint16_t& value) {
+		return pca.duty(3, value) ? plc::Status() : plc::Status(ENODATA);
+	});
+	TEST_ASSERT_TRUE(duty.ok());
+	if (fail) {
+		throw std::runtime_error("nested");
+	}
+	co_return duty.value;
+}
+
+static plc::Task<> error_task(plc::AsyncBus& bus) {
+	const int duty = co_await nested_task(bus, false);
+	TEST_ASSERT_EQUAL(2048, duty);
+
+	bool thrown = false;
+	try {
+		co_await nested_task(bus, true);
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	TEST_ASSERT_TRUE(thrown);
+
+	plc::AsyncMcp23008 missing(bus, MISSING_ADDRESS);
+	const plc::Status status = co_await missing.init();
+	TEST_ASSERT_FALSE(status.ok());
+	const plc::Result<uint8_t> values = co_await missing.read_all();
+	TEST_ASSERT_FALSE(values.ok());
+}
+
+void error_test() {
+	plc::AsyncBus bus(I2C_BUS);
+	plc::AsyncLoop loop;
+	loop.spawn(error_task(bus));
+	loop.run();
+}
+
+/**
+ * @brief A coroutine of another framework, which starts at once and isn't awaited.
+ */
+struct Fire {
+	struct promise_type {
+		Fire get_return_object() noexcept { return {}; }
+		std::suspend_never initial_suspend() const noexcept { return {}; }
+		std::suspend_never final_suspend() const noexcept { return {}; }
+		void return_void() noexcept {}
+		void unhandled_exception() noexcept { std::terminate(); }
+	};
+};
+
+static Fire read_on_worker(plc::AsyncMcp23008& mcp, std::thread::id& resumed_on, std::atomic<int>& result) {
+	const plc::Result<uint8_t> values = co_await mcp.read_all();
+	resumed_on = std::this_thread::get_id();
+	result.store(values.ok() ? 1 : 0, std::memory_order_release);
+}
+
+void without_loop_test() {
+	plc::AsyncBus bus(I2C_BUS);
+	plc::AsyncMcp23008 mcp(bus, MCP23008_ADDRESS);
+
+	// Outside a loop, the coroutine goes on in the worker
+	std::thread::id resumed_on;
+	std::atomic<int> result{-1};
+	read_on_worker(mcp, resumed_on, result);
+	while (result.load(std::memory_order_acquire) < 0) {
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+	TEST_ASSERT_EQUAL(1, result.load());
+	TEST_ASSERT_TRUE(resumed_on != std::this_thread::get_id());
+}
+
+int main() {
+	i2c_sim_enable(true);
+	i2c_sim_set_bus_speed(0);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23008, MCP23008_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23017, MCP23017_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_PCA9685, PCA9685_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_ADS1015, ADS1015_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_LTC2309, LTC2309_ADDRESS);
+
+	UNITY_BEGIN();
+
+	RUN_TEST(read_test);
+	RUN_TEST(same_ads_test);
+	RUN_TEST(overlap_test);
+	RUN_TEST(error_test);
+	RUN_TEST(without_loop_test);
+
+	return UNITY_END();
+}
+
+#endif // PLC_ENVIRONMENT == Linux
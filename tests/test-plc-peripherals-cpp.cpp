@@ -0,0 +1,252 @@
+/**
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Checks the C++ layer of plc-peripherals.hpp on the simulated bus of
+ * bench/i2c-sim: the values written reach the registers, and the cached
+ * state saves the transactions it should (no read before a write, nothing
+ * sent when nothing changes).
+ */
+
+#include <plc-peripherals.hpp>
+#include <expanded-gpio.h> // I2C_BUS, the bus of bench-board
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#include <array>
+#include <vector>
+
+#include <unity.h>
+
+#include "i2c-sim.h"
+
+#define MCP23008_ADDRESS 0x20
+#define MCP23017_ADDRESS 0x21
+#define PCA9685_ADDRESS 0x40
+#define ADS1015_ADDRESS 0x48
+#define LTC2309_ADDRESS 0x08
+#define MISSING_ADDRESS 0x30
+
+// Registers of the simulated MCP230XX (IOCON.BANK = 0)
+#define MCP23008_OLAT 0x0A
+#define MCP23017_IODIRA 0x00
+#define MCP23017_IODIRB 0x01
+#define MCP23017_OLATA 0x14
+#define MCP23017_OLATB 0x15
+
+
+static uint64_t ioctls_since_clear() {
+	struct i2c_sim_stats stats;
+	i2c_sim_get_stats(&stats);
+	return stats.ioctls;
+}
+
+extern "C" void setUp(void) {
+	i2c_sim_clear_stats();
+}
+
+extern "C" void tearDown(void) {
+}
+
+void bus_test() {
+	plc::I2cBus bus(I2C_BUS);
+	TEST_ASSERT_MESSAGE(bus.is_open(), bus.status().message());
+	TEST_ASSERT_TRUE(bus.status().ok());
+
+	plc::I2cBus moved(std::move(bus));
+	TEST_ASSERT_FALSE(bus.is_open());
+	TEST_ASSERT_TRUE(moved.is_open());
+
+	TEST_ASSERT_TRUE(moved.close().ok());
+	TEST_ASSERT_FALSE(moved.is_open());
+	TEST_ASSERT_TRUE(moved.close().ok());
+
+	// Raw transactions, and the errno of a failure in the status
+	plc::I2cBus other(I2C_BUS);
+	const uint8_t data[] = {0x00, 0xFF};
+	const plc::Status status = other.write(MISSING_ADDRESS, data);
+	TEST_ASSERT_FALSE(status.ok());
+	TEST_ASSERT_TRUE(status.error() != 0);
+}
+
+void mcp23008_test() {
+	plc::I2cBus bus(I2C_BUS);
+	plc::Mcp23008 mcp(bus, MCP23008_ADDRESS);
+	TEST_ASSERT_TRUE(mcp.init().ok());
+	TEST_ASSERT_TRUE(mcp.pin_mode_all(0xF0).ok());
+	TEST_ASSERT_EQUAL_HEX8(0xF0, mcp.modes());
+
+	// A single write, without reading the port
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(mcp.write(2, true).ok());
+	TEST_ASSERT_EQUAL_UINT64(1, ioctls_since_clear());
+	TEST_ASSERT_EQUAL_HEX8(0x04, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+
+	// Nothing when nothing changes
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(mcp.write(2, true).ok());
+	TEST_ASSERT_TRUE(mcp.pin_mode(7, MCP23008_INPUT).ok());
+	TEST_ASSERT_EQUAL_UINT64(0, ioctls_since_clear());
+
+	// Several pins with a single write
+	i2c_sim_clear_stats();
+	const plc::PinValue pins[] = {{0, true}, {1, true}, {2, false}, {3, true}};
+	TEST_ASSERT_TRUE(mcp.write(pins).ok());
+	TEST_ASSERT_EQUAL_UINT64(1, ioctls_since_clear());
+	TEST_ASSERT_EQUAL_HEX8(0x0B, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+
+	// Several pins with a single read
+	const std::array<uint8_t, 3> indexes = {{0, 2, 3}};
+	std::array<bool, 3> values;
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(mcp.read(indexes, values).ok());
+	TEST_ASSERT_EQUAL_UINT64(1, ioctls_since_clear());
+	TEST_ASSERT_TRUE(values[0]);
+	TEST_ASSERT_FALSE(values[1]);
+	TEST_ASSERT_TRUE(values[2]);
+
+	TEST_ASSERT_EQUAL(EINVAL, mcp.write(8, true).error());
+
+	// Another object of an initialized device reads its state
+	plc::Mcp23008 other(bus, MCP23008_ADDRESS);
+	TEST_ASSERT_TRUE(other.init().ok());
+	TEST_ASSERT_EQUAL_HEX8(mcp.modes(), other.modes());
+	TEST_ASSERT_EQUAL_HEX8(mcp.outputs(), other.outputs());
+
+	TEST_ASSERT_TRUE(mcp.deinit().ok());
+}
+
+void mcp23017_test() {
+	plc::I2cBus bus(I2C_BUS);
+	plc::Mcp23017 mcp(bus, MCP23017_ADDRESS);
+	TEST_ASSERT_TRUE(mcp.init().ok());
+
+	// Port A is the low byte
+	TEST_ASSERT_TRUE(mcp.pin_mode_all(0xFF00).ok());
+	TEST_ASSERT_EQUAL_HEX8(0x00, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_IODIRA));
+	TEST_ASSERT_EQUAL_HEX8(0xFF, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_IODIRB));
+	TEST_ASSERT_TRUE(mcp.pin_mode(12, MCP23017_OUTPUT).ok());
+	TEST_ASSERT_EQUAL_HEX8(0xEF, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_IODIRB));
+
+	// A write of a pin writes both ports, without reading them
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(mcp.write(12, true).ok());
+	TEST_ASSERT_EQUAL_UINT64(2, ioctls_since_clear());
+	TEST_ASSERT_EQUAL_HEX8(0x00, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_OLATA));
+	TEST_ASSERT_EQUAL_HEX8(0x10, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_OLATB));
+
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(mcp.write_all(0x1081).ok());
+	TEST_ASSERT_EQUAL_UINT64(2, ioctls_since_clear());
+	TEST_ASSERT_EQUAL_HEX8(0x81, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_OLATA));
+	TEST_ASSERT_EQUAL_HEX8(0x10, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_OLATB));
+
+	// Nothing is sent if nothing changes
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(mcp.write(0, true).ok());
+	TEST_ASSERT_EQUAL_UINT64(0, ioctls_since_clear());
+
+	uint16_t values;
+	TEST_ASSERT_TRUE(mcp.read_all(values).ok());
+	TEST_ASSERT_EQUAL_HEX16(0x1081, values & ~mcp.modes());
+	bool value;
+	TEST_ASSERT_TRUE(mcp.read(12, value).ok());
+	TEST_ASSERT_TRUE(value);
+
+	plc::Mcp23017 other(bus, MCP23017_ADDRESS);
+	TEST_ASSERT_TRUE(other.init().ok());
+	TEST_ASSERT_EQUAL_HEX16(mcp.modes(), other.modes());
+	TEST_ASSERT_EQUAL_HEX16(mcp.outputs(), other.outputs());
+
+	TEST_ASSERT_TRUE(mcp.deinit().ok());
+}
+
+void pca9685_test() {
+	plc::I2cBus bus(I2C_BUS);
+	plc::Pca9685 pca(bus, PCA9685_ADDRESS);
+	TEST_ASSERT_TRUE(pca.init().ok());
+	TEST_ASSERT_TRUE(pca.set_prescaler(30).ok());
+
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(pca.set_prescaler(30).ok());
+	TEST_ASSERT_TRUE(pca.pwm_write(5, 0).ok());
+	TEST_ASSERT_EQUAL_UINT64(0, ioctls_since_clear());
+
+	TEST_ASSERT_TRUE(pca.pwm_write(5, 2048).ok());
+	TEST_ASSERT_TRUE(pca.pwm_write(5, 2048).ok());
+	TEST_ASSERT_EQUAL_UINT64(1, ioctls_since_clear());
+	uint16_t duty;
+	TEST_ASSERT_TRUE(pca.duty(5, duty));
+	TEST_ASSERT_EQUAL_UINT16(2048, duty);
+
+	// Several changes with a single transaction
+	i2c_sim_clear_stats();
+	std::vector<plc::ChannelValue> channels = {{0, 100}, {1, 200}, {5, 2048}, {15, 4095}};
+	TEST_ASSERT_TRUE(pca.pwm_write(channels).ok());
+	TEST_ASSERT_EQUAL_UINT64(1, ioctls_since_clear());
+
+	// An output written as digital is unknown, and written again
+	TEST_ASSERT_TRUE(pca.write(5, true).ok());
+	TEST_ASSERT_FALSE(pca.duty(5, duty));
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(pca.pwm_write(5, 2048).ok());
+	TEST_ASSERT_EQUAL_UINT64(1, ioctls_since_clear());
+
+	TEST_ASSERT_TRUE(pca.deinit().ok());
+}
+
+void adc_test() {
+	plc::I2cBus bus(I2C_BUS);
+	plc::Ads1015 ads(bus, ADS1015_ADDRESS);
+	plc::Ltc2309 ltc(bus, LTC2309_ADDRESS);
+	TEST_ASSERT_TRUE(ads.init().ok());
+	TEST_ASSERT_TRUE(ltc.init().ok());
+
+	const uint8_t channels[] = {0, 1, 2, 3};
+	int16_t ads_values[4];
+	uint16_t ltc_values[4];
+	TEST_ASSERT_TRUE(ads.read(channels, ads_values).ok());
+	TEST_ASSERT_TRUE(ltc.read(channels, ltc_values).ok());
+
+	TEST_ASSERT_EQUAL(EINVAL, ltc.read(channels, plc::Span<uint16_t>(ltc_values, 2)).error());
+
+	plc::Ltc2309 missing(bus, MISSING_ADDRESS);
+	uint16_t value;
+	TEST_ASSERT_FALSE(missing.read(0, value).ok());
+}
+
+int main() {
+	i2c_sim_enable(true);
+	i2c_sim_set_bus_speed(0);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23008, MCP23008_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23017, MCP23017_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_PCA9685, PCA9685_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_ADS1015, ADS1015_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_LTC2309, LTC2309_ADDRESS);
+
+	UNITY_BEGIN();
+
+	RUN_TEST(bus_test);
+	RUN_TEST(mcp23008_test);
+	RUN_TEST(mcp23017_test);
+	RUN_TEST(pca9685_test);
+	RUN_TEST(adc_test);
+
+	return UNITY_END();
+}
+
+#endif // PLC_ENVIRONMENT == Linux
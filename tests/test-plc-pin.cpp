@@ -0,0 +1,211 @@
+/**
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Checks the compile-time pins of plc-pin.hpp on the simulated bus of
+ * bench/i2c-sim: the masks and ids folded when compiling, and that a group
+ * of pins is written and read with a single transaction.
+ */
+
+#include <plc-pin.hpp>
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#include <unity.h>
+
+#include "i2c-sim.h"
+
+#define MCP23008_ADDRESS 0x20
+#define MCP23017_ADDRESS 0x21
+#define PCA9685_ADDRESS 0x40
+#define ADS1015_ADDRESS 0x48
+#define LTC2309_ADDRESS 0x08
+
+// Registers of the simulated MCP230XX (IOCON.BANK = 0)
+#define MCP23008_IODIR 0x00
+#define MCP23008_OLAT 0x0A
+#define MCP23017_IODIRB 0x01
+#define MCP23017_OLATA 0x14
+#define MCP23017_OLATB 0x15
+
+typedef plc::Pin<PLC_MCP23008, MCP23008_ADDRESS, 1> Q0_1;
+typedef plc::Pin<PLC_MCP23008, MCP23008_ADDRESS, 5> Q0_5;
+typedef plc::Pin<PLC_MCP23008, MCP23008_ADDRESS, 7> Q0_7;
+typedef plc::Pin<PLC_MCP23017, MCP23017_ADDRESS, 3> R0_3;
+typedef plc::Pin<PLC_MCP23017, MCP23017_ADDRESS, 12> R0_12;
+typedef plc::Pin<PLC_PCA9685, PCA9685_ADDRESS, 6> A0_6;
+typedef plc::Pin<PLC_ADS1015, ADS1015_ADDRESS, 2> I0_2;
+typedef plc::Pin<PLC_LTC2309, LTC2309_ADDRESS, 7> I1_7;
+
+static_assert(Q0_5::mask == 0x20, "Mask of a MCP23008 pin");
+static_assert(R0_12::mask == 0x1000, "Mask of a MCP23017 pin");
+static_assert(plc::PinGroup<Q0_1, Q0_5, Q0_7>::mask == 0xA2, "Mask of a group");
+static_assert(plc::PinGroup<R0_3, R0_12>::mask == 0x1008, "Mask of a group over both ports");
+static_assert(R0_12::id == (uint32_t) _MAKE_PIN_PLC(PLC_MCP23017, MCP23017_ADDRESS, 0, 12), "Same pin as expanded-gpio");
+static_assert(plc::Pin<PLC_MCP23008, MCP23008_ADDRESS, 5, 2>::id == PIN_ON_BUS(2, Q0_5::id), "Same pin on another bus");
+
+
+static uint64_t ioctls_since_clear() {
+	struct i2c_sim_stats stats;
+	i2c_sim_get_stats(&stats);
+	return stats.ioctls;
+}
+
+extern "C" void setUp(void) {
+	i2c_sim_clear_stats();
+}
+
+extern "C" void tearDown(void) {
+}
+
+void mcp23008_pin_test() {
+	plc::I2cBus bus(I2C_BUS);
+	plc::Mcp23008 mcp(bus, MCP23008_ADDRESS);
+	TEST_ASSERT_TRUE(mcp.init().ok());
+
+	const Q0_1 q0_1(mcp);
+	const Q0_5 q0_5(mcp);
+	const Q0_7 q0_7(mcp);
+
+	TEST_ASSERT_TRUE(plc::pinMode(q0_5, OUTPUT).ok());
+	TEST_ASSERT_TRUE(plc::pinMode(q0_7, OUTPUT).ok());
+	TEST_ASSERT_EQUAL_HEX8(0x5F, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_IODIR));
+
+	// A single write, and nothing when nothing changes
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(plc::digitalWrite(q0_5, true).ok());
+	TEST_ASSERT_TRUE(plc::digitalWrite(q0_5, true).ok());
+	TEST_ASSERT_EQUAL_UINT64(1, ioctls_since_clear());
+	TEST_ASSERT_EQUAL_HEX8(0x20, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+
+	// A group with a single write, the other pins untouched
+	const plc::PinGroup<Q0_1, Q0_5, Q0_7> group = plc::group(q0_1, q0_5, q0_7);
+	TEST_ASSERT_TRUE(group.pinMode(OUTPUT).ok());
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(group.write(true, false, true).ok());
+	TEST_ASSERT_EQUAL_UINT64(1, ioctls_since_clear());
+	TEST_ASSERT_EQUAL_HEX8(0x82, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+
+	TEST_ASSERT_TRUE(mcp.write(0, true).ok());
+	TEST_ASSERT_TRUE(group.write(false, true, true).ok());
+	TEST_ASSERT_EQUAL_HEX8(0xA1, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, MCP23008_OLAT));
+
+	// A group with a single read
+	TEST_ASSERT_TRUE(group.pinMode(INPUT).ok());
+	i2c_sim_set_inputs(I2C_BUS, MCP23008_ADDRESS, 0x82);
+	bool a, b, c;
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(group.read(a, b, c).ok());
+	TEST_ASSERT_EQUAL_UINT64(1, ioctls_since_clear());
+	TEST_ASSERT_TRUE(a);
+	TEST_ASSERT_FALSE(b);
+	TEST_ASSERT_TRUE(c);
+
+	bool value;
+	TEST_ASSERT_TRUE(plc::digitalRead(q0_7, value).ok());
+	TEST_ASSERT_TRUE(value);
+
+	TEST_ASSERT_TRUE(mcp.deinit().ok());
+}
+
+void mcp23017_pin_test() {
+	plc::I2cBus bus(I2C_BUS);
+	plc::Mcp23017 mcp(bus, MCP23017_ADDRESS);
+	TEST_ASSERT_TRUE(mcp.init().ok());
+
+	const R0_3 r0_3(mcp);
+	const R0_12 r0_12(mcp);
+
+	TEST_ASSERT_TRUE(plc::pinMode(r0_12, OUTPUT).ok());
+	TEST_ASSERT_EQUAL_HEX8(0xEF, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_IODIRB));
+
+	// A write of a pin writes both ports, without reading them
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(plc::digitalWrite(r0_12, true).ok());
+	TEST_ASSERT_EQUAL_UINT64(2, ioctls_since_clear());
+	TEST_ASSERT_EQUAL_HEX8(0x00, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_OLATA));
+	TEST_ASSERT_EQUAL_HEX8(0x10, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_OLATB));
+
+	// A group over both ports writes each of them once
+	const plc::PinGroup<R0_3, R0_12> group = plc::group(r0_3, r0_12);
+	TEST_ASSERT_TRUE(group.pinMode(OUTPUT).ok());
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(group.write(true, false).ok());
+	TEST_ASSERT_EQUAL_UINT64(2, ioctls_since_clear());
+	TEST_ASSERT_EQUAL_HEX8(0x08, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_OLATA));
+	TEST_ASSERT_EQUAL_HEX8(0x00, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, MCP23017_OLATB));
+
+	bool a, b;
+	TEST_ASSERT_TRUE(group.read(a, b).ok());
+	TEST_ASSERT_TRUE(a);
+	TEST_ASSERT_FALSE(b);
+
+	TEST_ASSERT_TRUE(mcp.deinit().ok());
+}
+
+void analog_pin_test() {
+	plc::I2cBus bus(I2C_BUS);
+	plc::Pca9685 pca(bus, PCA9685_ADDRESS);
+	plc::Ads1015 ads(bus, ADS1015_ADDRESS);
+	plc::Ltc2309 ltc(bus, LTC2309_ADDRESS);
+	TEST_ASSERT_TRUE(pca.init().ok());
+	TEST_ASSERT_TRUE(ads.init().ok());
+	TEST_ASSERT_TRUE(ltc.init().ok());
+
+	const A0_6 a0_6(pca);
+	i2c_sim_clear_stats();
+	TEST_ASSERT_TRUE(plc::analogWrite(a0_6, 2048).ok());
+	TEST_ASSERT_TRUE(plc::analogWrite(a0_6, 2048).ok());
+	TEST_ASSERT_EQUAL_UINT64(1, ioctls_since_clear());
+	uint16_t duty;
+	TEST_ASSERT_TRUE(pca.duty(6, duty));
+	TEST_ASSERT_EQUAL_UINT16(2048, duty);
+	TEST_ASSERT_TRUE(plc::digitalWrite(a0_6, false).ok());
+
+	const I0_2 i0_2(ads);
+	const I1_7 i1_7(ltc);
+	i2c_sim_set_analog(I2C_BUS, ADS1015_ADDRESS, 2, 1000);
+	i2c_sim_set_analog(I2C_BUS, LTC2309_ADDRESS, 7, 3000);
+	uint16_t value;
+	TEST_ASSERT_TRUE(plc::analogRead(i0_2, value).ok());
+	TEST_ASSERT_EQUAL_UINT16(1000, value);
+	TEST_ASSERT_TRUE(plc::analogRead(i1_7, value).ok());
+	TEST_ASSERT_EQUAL_UINT16(3000, value);
+
+	TEST_ASSERT_TRUE(pca.deinit().ok());
+}
+
+int main() {
+	i2c_sim_enable(true);
+	i2c_sim_set_bus_speed(0);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23008, MCP23008_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23017, MCP23017_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_PCA9685, PCA9685_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_ADS1015, ADS1015_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_LTC2309, LTC2309_ADDRESS);
+
+	UNITY_BEGIN();
+
+	RUN_TEST(mcp23008_pin_test);
+	RUN_TEST(mcp23017_pin_test);
+	RUN_TEST(analog_pin_test);
+
+	return UNITY_END();
+}
+
+#endif // PLC_ENVIRONMENT == Linux
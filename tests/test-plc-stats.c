@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Checks the counters of plc-stats against the traffic counted by the
+ * simulated bus of bench/i2c-sim, and that another mapping of the
+ * shared-memory segment sees the same values.
+ */
+
+#include <plc-peripherals.h>
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <unity.h>
+
+#include "i2c-sim.h"
+
+#define MCP23008_ADDRESS 0x20
+#define MISSING_ADDRESS 0x30
+
+#define CALLS 32
+
+static i2c_interface_t* i2c;
+
+
+static plc_stats_device_t device_stats(uint8_t addr) {
+	plc_stats_t stats;
+	plc_stats_snapshot(plc_stats_self(), &stats);
+
+	const uint32_t key = ((uint32_t) I2C_BUS << 8 | addr) + 1;
+	for (size_t i = 0; i < stats.num_devices; i++) {
+		if (stats.devices[i].key == key) {
+			return stats.devices[i];
+		}
+	}
+	return (plc_stats_device_t) {0};
+}
+
+void setUp(void) {
+	i2c = i2c_init(I2C_BUS);
+	TEST_ASSERT_NOT_NULL_MESSAGE(i2c, strerror(errno));
+}
+
+void tearDown(void) {
+	i2c_deinit(&i2c);
+}
+
+void device_counters_test() {
+	TEST_ASSERT_EQUAL_MESSAGE(0, mcp23008_init(i2c, MCP23008_ADDRESS), strerror(errno));
+
+	const plc_stats_device_t before = device_stats(MCP23008_ADDRESS);
+	struct i2c_sim_stats sim;
+	i2c_sim_clear_stats();
+	for (long call = 0; call < CALLS; call++) {
+		uint8_t value;
+		TEST_ASSERT_EQUAL(0, mcp23008_write(i2c, MCP23008_ADDRESS, call % MCP23008_NUM_IO, call & 1));
+		TEST_ASSERT_EQUAL(0, mcp23008_read_all(i2c, MCP23008_ADDRESS, &value));
+	}
+	i2c_sim_get_stats(&sim);
+	const plc_stats_device_t after = device_stats(MCP23008_ADDRESS);
+
+	// One transaction per ioctl, and the bytes on the wire without the address of each message
+	TEST_ASSERT_EQUAL_UINT64(sim.ioctls, after.transactions - before.transactions);
+	TEST_ASSERT_EQUAL_UINT64(sim.wire_bytes - sim.messages, after.bytes - before.bytes);
+	TEST_ASSERT_EQUAL_UINT64(0, after.errors - before.errors);
+	TEST_ASSERT_EQUAL_UINT64(after.transactions - before.transactions, after.latency.count - before.latency.count);
+	TEST_ASSERT_EQUAL(0, after.last_errno);
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, mcp23008_deinit(i2c, MCP23008_ADDRESS), strerror(errno));
+}
+
+void device_errors_test() {
+	const plc_stats_device_t before = device_stats(MISSING_ADDRESS);
+
+	FAST_CREATE_I2C_WRITE(to_write, 0x00, 0xFF);
+	TEST_ASSERT_EQUAL(-1, i2c_write(i2c, MISSING_ADDRESS, &to_write));
+	const int error = errno;
+	TEST_ASSERT_TRUE(error != 0);
+
+	const plc_stats_device_t after = device_stats(MISSING_ADDRESS);
+	TEST_ASSERT_EQUAL_UINT64(1, after.transactions - before.transactions);
+	TEST_ASSERT_EQUAL_UINT64(1, after.errors - before.errors);
+	TEST_ASSERT_EQUAL(error, after.last_errno);
+}
+
+void scans_and_caches_test() {
+	plc_stats_t before, after;
+	plc_stats_snapshot(plc_stats_self(), &before);
+
+	plc_stats_scan(plc_stats_now(), true);
+	plc_stats_scan(plc_stats_now(), false);
+	plc_stats_cache(PLC_STATS_CACHE_DEBOUNCE, true);
+	plc_stats_cache(PLC_STATS_CACHE_DEBOUNCE, false);
+	plc_stats_cache(PLC_STATS_CACHE_DEBOUNCE, true);
+
+	plc_stats_snapshot(plc_stats_self(), &after);
+	TEST_ASSERT_EQUAL_UINT64(2, after.scans.count - before.scans.count);
+	TEST_ASSERT_EQUAL_UINT64(1, after.scan_errors - before.scan_errors);
+	TEST_ASSERT_EQUAL_UINT64(2, after.caches[PLC_STATS_CACHE_DEBOUNCE].hits - before.caches[PLC_STATS_CACHE_DEBOUNCE].hits);
+	TEST_ASSERT_EQUAL_UINT64(1, after.caches[PLC_STATS_CACHE_DEBOUNCE].misses - before.caches[PLC_STATS_CACHE_DEBOUNCE].misses);
+}
+
+void percentile_test() {
+	plc_stats_latency_t latency = {0};
+	TEST_ASSERT_EQUAL_UINT64(0, plc_stats_percentile(&latency, 0.5));
+
+	// 90 durations from 1 to 2 us and 10 from 64 to 128 us
+	latency.count = 100;
+	latency.buckets[1] = 90;
+	latency.buckets[7] = 10;
+	latency.max_ns = 100000;
+
+	const uint64_t p50 = plc_stats_percentile(&latency, 0.5);
+	TEST_ASSERT_TRUE(p50 >= 1000 && p50 <= 2000);
+	const uint64_t p95 = plc_stats_percentile(&latency, 0.95);
+	TEST_ASSERT_TRUE(p95 >= 64000 && p95 <= 100000);
+	TEST_ASSERT_EQUAL_UINT64(latency.max_ns, plc_stats_percentile(&latency, 1));
+}
+
+void segment_test() {
+	const char* name = plc_stats_shm_name();
+	TEST_ASSERT_NOT_NULL(name);
+
+	const plc_stats_t* stats = plc_stats_attach(name);
+	TEST_ASSERT_NOT_NULL_MESSAGE(stats, strerror(errno));
+	TEST_ASSERT_EQUAL(getpid(), stats->pid);
+	TEST_ASSERT_TRUE(stats != plc_stats_self());
+
+	// Created with the umask of main
+	char path[64];
+	struct stat st;
+	snprintf(path, sizeof(path), "/dev/shm%s", name);
+	TEST_ASSERT_EQUAL_MESSAGE(0, stat(path, &st), strerror(errno));
+	TEST_ASSERT_EQUAL(0600, st.st_mode & 0777);
+
+	uint8_t value;
+	TEST_ASSERT_EQUAL(0, mcp23008_read_all(i2c, MCP23008_ADDRESS, &value));
+	plc_stats_t mine, theirs;
+	plc_stats_snapshot(plc_stats_self(), &mine);
+	plc_stats_snapshot(stats, &theirs);
+	TEST_ASSERT_EQUAL_UINT64(mine.num_devices, theirs.num_devices);
+	TEST_ASSERT_EQUAL_UINT64(mine.devices[0].transactions, theirs.devices[0].transactions);
+
+	TEST_ASSERT_EQUAL(0, plc_stats_detach(&stats));
+	TEST_ASSERT_NULL(stats);
+
+	TEST_ASSERT_NULL(plc_stats_attach(PLC_STATS_SHM_PREFIX "0"));
+	TEST_ASSERT_EQUAL(ENOENT, errno);
+}
+
+int main() {
+	// Publish the counters, before the first transaction creates them
+	setenv("PLC_PERIPHERALS_STATS_SHM", "1", 1);
+	umask(077);
+
+	i2c_sim_enable(true);
+	i2c_sim_set_bus_speed(0);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23008, MCP23008_ADDRESS);
+
+	UNITY_BEGIN();
+
+	RUN_TEST(device_counters_test);
+	RUN_TEST(device_errors_test);
+	RUN_TEST(scans_and_caches_test);
+	RUN_TEST(percentile_test);
+	RUN_TEST(segment_test);
+
+	return UNITY_END();
+}
+
+#endif // PLC_ENVIRONMENT == Linux
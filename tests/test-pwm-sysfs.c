@@ -0,0 +1,214 @@
+/**
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Unlike the other tests, this one doesn't need any hardware: the PWM
+ * channels are files of a fake sysfs tree created in /tmp.
+ */
+
+#define _GNU_SOURCE
+
+#include <plc-peripherals.h>
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <ftw.h>
+#include <sys/stat.h>
+
+#define PWM_CHIP 0
+#define PWM_CHANNEL 1
+#define UNEXPORTED_CHANNEL 2
+
+#include <unity.h>
+
+static char root[] = "/tmp/test-pwm-sysfs-XXXXXX";
+
+static void write_file(const char* name, const char* content) {
+	char path[256];
+	snprintf(path, sizeof(path), "%s/%s", root, name);
+	FILE* file = fopen(path, "w");
+	TEST_ASSERT_NOT_NULL_MESSAGE(file, strerror(errno));
+	fputs(content, file);
+	fclose(file);
+}
+
+static const char* read_file(const char* name) {
+	static char content[64];
+	char path[256];
+	snprintf(path, sizeof(path), "%s/%s", root, name);
+	FILE* file = fopen(path, "r");
+	TEST_ASSERT_NOT_NULL_MESSAGE(file, strerror(errno));
+	size_t len = fread(content, 1, sizeof(content) - 1, file);
+	content[len] = '\0';
+	fclose(file);
+	return content;
+}
+
+void setUp(void) {
+	strcpy(root, "/tmp/test-pwm-sysfs-XXXXXX");
+	TEST_ASSERT_NOT_NULL_MESSAGE(mkdtemp(root), strerror(errno));
+
+	char path[256];
+	snprintf(path, sizeof(path), "%s/pwmchip0", root);
+	TEST_ASSERT_EQUAL_MESSAGE(0, mkdir(path, 0755), strerror(errno));
+	snprintf(path, sizeof(path), "%s/pwmchip0/pwm1", root);
+	TEST_ASSERT_EQUAL_MESSAGE(0, mkdir(path, 0755), strerror(errno));
+
+	write_file("pwmchip0/export", "");
+	write_file("pwmchip0/pwm1/period", "0\n");
+	write_file("pwmchip0/pwm1/duty_cycle", "0\n");
+	write_file("pwmchip0/pwm1/enable", "0\n");
+}
+
+static int remove_entry(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+	(void) st;
+	(void) flag;
+	(void) ftw;
+	return remove(path);
+}
+
+void tearDown(void) {
+	nftw(root, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+}
+
+void pwm_sysfs_sanity_check() {
+	TEST_ASSERT_EQUAL_MESSAGE(-1, pwm_sysfs_close(NULL), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(EFAULT, errno, strerror(errno));
+
+	pwm_sysfs_t* pwm = NULL;
+	TEST_ASSERT_EQUAL_MESSAGE(-1, pwm_sysfs_close(&pwm), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(EFAULT, errno, strerror(errno));
+
+	TEST_ASSERT_EQUAL_MESSAGE(-1, pwm_sysfs_set_period(NULL, 1000), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(EFAULT, errno, strerror(errno));
+
+	TEST_ASSERT_EQUAL_MESSAGE(-1, pwm_sysfs_set_duty_cycle(NULL, 1000), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(EFAULT, errno, strerror(errno));
+
+	TEST_ASSERT_EQUAL_MESSAGE(-1, pwm_sysfs_enable(NULL, true), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(EFAULT, errno, strerror(errno));
+
+	// The chip doesn't exist
+	TEST_ASSERT_NULL(pwm_sysfs_open(root, 5, 0));
+	TEST_ASSERT_EQUAL_MESSAGE(ENOENT, errno, strerror(errno));
+}
+
+void pwm_sysfs_open_exported() {
+	pwm_sysfs_t* pwm = pwm_sysfs_open(root, PWM_CHIP, PWM_CHANNEL);
+	TEST_ASSERT_NOT_NULL_MESSAGE(pwm, strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(0, errno, strerror(errno));
+
+	// Already exported, so it isn't exported again
+	TEST_ASSERT_EQUAL_STRING("", read_file("pwmchip0/export"));
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_close(&pwm), strerror(errno));
+	TEST_ASSERT_NULL(pwm);
+}
+
+void pwm_sysfs_open_unexported() {
+	// The fake tree doesn't create the channel, so it times out after exporting it
+	TEST_ASSERT_NULL(pwm_sysfs_open(root, PWM_CHIP, UNEXPORTED_CHANNEL));
+	TEST_ASSERT_EQUAL_MESSAGE(ETIMEDOUT, errno, strerror(errno));
+	TEST_ASSERT_EQUAL_STRING("2\n", read_file("pwmchip0/export"));
+}
+
+void pwm_sysfs_write_test() {
+	pwm_sysfs_t* pwm = pwm_sysfs_open(root, PWM_CHIP, PWM_CHANNEL);
+	TEST_ASSERT_NOT_NULL_MESSAGE(pwm, strerror(errno));
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_set_period(pwm, 1000000), strerror(errno));
+	TEST_ASSERT_EQUAL_UINT64(1000000, pwm_sysfs_get_period(pwm));
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_set_duty_cycle(pwm, 250000), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_enable(pwm, true), strerror(errno));
+
+	TEST_ASSERT_EQUAL_STRING("1000000\n", read_file("pwmchip0/pwm1/period"));
+	TEST_ASSERT_EQUAL_STRING("250000\n", read_file("pwmchip0/pwm1/duty_cycle"));
+	TEST_ASSERT_EQUAL_STRING("1\n", read_file("pwmchip0/pwm1/enable"));
+
+	// A shorter value replaces the whole file, as in sysfs
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_set_duty_cycle(pwm, 5), strerror(errno));
+	TEST_ASSERT_EQUAL_STRING("5\n", read_file("pwmchip0/pwm1/duty_cycle"));
+
+	// The duty cycle can't be longer than the period
+	TEST_ASSERT_EQUAL_MESSAGE(-1, pwm_sysfs_set_duty_cycle(pwm, 2000000), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(EINVAL, errno, strerror(errno));
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_close(&pwm), strerror(errno));
+}
+
+void pwm_sysfs_unchanged_values_test() {
+	pwm_sysfs_t* pwm = pwm_sysfs_open(root, PWM_CHIP, PWM_CHANNEL);
+	TEST_ASSERT_NOT_NULL_MESSAGE(pwm, strerror(errno));
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_set_period(pwm, 1000000), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_set_duty_cycle(pwm, 500000), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_enable(pwm, true), strerror(errno));
+
+	// Mark the files: they must not be written for the same values
+	write_file("pwmchip0/pwm1/period", "untouched\n");
+	write_file("pwmchip0/pwm1/duty_cycle", "untouched\n");
+	write_file("pwmchip0/pwm1/enable", "untouched\n");
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_set_period(pwm, 1000000), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_set_duty_cycle(pwm, 500000), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_enable(pwm, true), strerror(errno));
+
+	TEST_ASSERT_EQUAL_STRING("untouched\n", read_file("pwmchip0/pwm1/period"));
+	TEST_ASSERT_EQUAL_STRING("untouched\n", read_file("pwmchip0/pwm1/duty_cycle"));
+	TEST_ASSERT_EQUAL_STRING("untouched\n", read_file("pwmchip0/pwm1/enable"));
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_set_duty_cycle(pwm, 400000), strerror(errno));
+	TEST_ASSERT_EQUAL_STRING("400000\n", read_file("pwmchip0/pwm1/duty_cycle"));
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_close(&pwm), strerror(errno));
+}
+
+void pwm_sysfs_shorter_period_test() {
+	pwm_sysfs_t* pwm = pwm_sysfs_open(root, PWM_CHIP, PWM_CHANNEL);
+	TEST_ASSERT_NOT_NULL_MESSAGE(pwm, strerror(errno));
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_set_period(pwm, 1000000), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_set_duty_cycle(pwm, 800000), strerror(errno));
+
+	// The duty cycle is shortened to the new period
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_set_period(pwm, 500000), strerror(errno));
+	TEST_ASSERT_EQUAL_STRING("500000\n", read_file("pwmchip0/pwm1/period"));
+	TEST_ASSERT_EQUAL_STRING("500000\n", read_file("pwmchip0/pwm1/duty_cycle"));
+
+	TEST_ASSERT_EQUAL_MESSAGE(0, pwm_sysfs_close(&pwm), strerror(errno));
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(pwm_sysfs_sanity_check);
+	RUN_TEST(pwm_sysfs_open_exported);
+	RUN_TEST(pwm_sysfs_open_unexported);
+
+	RUN_TEST(pwm_sysfs_write_test);
+	RUN_TEST(pwm_sysfs_unchanged_values_test);
+	RUN_TEST(pwm_sysfs_shorter_period_test);
+
+	return UNITY_END();
+}
+
+#endif // PLC_ENVIRONMENT == Linux
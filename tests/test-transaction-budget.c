@@ -0,0 +1,399 @@
+/**
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Checks that every driver and expanded-gpio operation stays within its
+ * budget of I2C transactions. The calls run against the simulated bus of
+ * bench/i2c-sim, which counts the ioctls, messages and bytes on the wire
+ * of each one, so no hardware is needed. A change that adds a transfer to
+ * an operation (a read before a write, for example) must update the table.
+ */
+
+#include <plc-peripherals.h>
+#include <peripheral-mcp23017.h>
+
+#if defined(PLC_ENVIRONMENT) && PLC_ENVIRONMENT == Linux
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <unity.h>
+
+#include "i2c-sim.h"
+
+#define MCP23008_ADDRESS 0x20
+#define MCP23017_ADDRESS 0x21
+#define PCA9685_ADDRESS 0x40
+#define ADS1015_ADDRESS 0x48
+#define LTC2309_ADDRESS 0x08
+
+// Calls of every operation, with different arguments
+#define BUDGET_CALLS 16
+
+struct budget {
+	const char* name;
+	int (*run)(long call);
+	uint64_t ioctls;
+	uint64_t messages;
+	uint64_t wire_bytes; // Payload plus one address byte per message
+};
+
+static const uint8_t mcp23008_addrs[] = {MCP23008_ADDRESS};
+static const uint8_t mcp23017_addrs[] = {MCP23017_ADDRESS};
+static const uint8_t pca9685_addrs[] = {PCA9685_ADDRESS};
+static const uint8_t ads1015_addrs[] = {ADS1015_ADDRESS};
+static const uint8_t ltc2309_addrs[] = {LTC2309_ADDRESS};
+
+static i2c_interface_t* i2c;
+
+
+static int mcp23008_set_pin_mode_op(long call) {
+	return mcp23008_set_pin_mode(i2c, MCP23008_ADDRESS, call % MCP23008_NUM_IO, call & 1 ? MCP23008_INPUT : MCP23008_OUTPUT);
+}
+
+static int mcp23008_set_pin_mode_all_op(long call) {
+	return mcp23008_set_pin_mode_all(i2c, MCP23008_ADDRESS, call * 0x11);
+}
+
+static int mcp23008_write_op(long call) {
+	return mcp23008_write(i2c, MCP23008_ADDRESS, call % MCP23008_NUM_IO, call & 1);
+}
+
+static int mcp23008_read_op(long call) {
+	uint8_t value;
+	return mcp23008_read(i2c, MCP23008_ADDRESS, call % MCP23008_NUM_IO, &value);
+}
+
+static int mcp23008_write_all_op(long call) {
+	return mcp23008_write_all(i2c, MCP23008_ADDRESS, call * 0x11);
+}
+
+static int mcp23008_read_all_op(long call) {
+	(void) call;
+	uint8_t value;
+	return mcp23008_read_all(i2c, MCP23008_ADDRESS, &value);
+}
+
+static int mcp23008_read_interrupt_op(long call) {
+	(void) call;
+	uint8_t flags, captured;
+	return mcp23008_read_interrupt(i2c, MCP23008_ADDRESS, &flags, &captured);
+}
+
+static int mcp23017_set_pin_mode_op(long call) {
+	return mcp23017_set_pin_mode(i2c, MCP23017_ADDRESS, call % MCP23017_NUM_IO, call & 1 ? MCP23017_INPUT : MCP23017_OUTPUT);
+}
+
+static int mcp23017_set_pin_mode_all_op(long call) {
+	return mcp23017_set_pin_mode_all(i2c, MCP23017_ADDRESS, call * 0x1111);
+}
+
+static int mcp23017_write_op(long call) {
+	return mcp23017_write(i2c, MCP23017_ADDRESS, call % MCP23017_NUM_IO, call & 1);
+}
+
+static int mcp23017_read_op(long call) {
+	uint8_t value;
+	return mcp23017_read(i2c, MCP23017_ADDRESS, call % MCP23017_NUM_IO, &value);
+}
+
+static int mcp23017_write_all_op(long call) {
+	return mcp23017_write_all(i2c, MCP23017_ADDRESS, call * 0x1111);
+}
+
+static int mcp23017_read_all_op(long call) {
+	(void) call;
+	uint16_t value;
+	return mcp23017_read_all(i2c, MCP23017_ADDRESS, &value);
+}
+
+static int mcp23017_read_interrupt_op(long call) {
+	(void) call;
+	uint16_t flags, captured;
+	return mcp23017_read_interrupt(i2c, MCP23017_ADDRESS, &flags, &captured);
+}
+
+static int pca9685_write_op(long call) {
+	return pca9685_write(i2c, PCA9685_ADDRESS, call % PCA9685_NUM_OUTPUTS, call & 1);
+}
+
+static int pca9685_write_all_op(long call) {
+	return pca9685_write_all(i2c, PCA9685_ADDRESS, call * 0x1111);
+}
+
+static int pca9685_pwm_write_op(long call) {
+	return pca9685_pwm_write(i2c, PCA9685_ADDRESS, call % PCA9685_NUM_OUTPUTS, (call * 257) & 0x0FFF);
+}
+
+static int pca9685_pwm_write_all_op(long call) {
+	uint16_t values[PCA9685_NUM_OUTPUTS];
+	for (size_t i = 0; i < PCA9685_NUM_OUTPUTS; i++) {
+		values[i] = (call * 257 + i) & 0x0FFF;
+	}
+	return pca9685_pwm_write_all(i2c, PCA9685_ADDRESS, values);
+}
+
+static int pca9685_pwm_frequency_op(long call) {
+	return pca9685_pwm_frequency(i2c, PCA9685_ADDRESS, call & 1 ? 0x1E : 0x79);
+}
+
+static int ads1015_read_op(long call) {
+	int16_t value;
+	return ads1015_read(i2c, ADS1015_ADDRESS, call % ADS1015_NUM_INPUTS, &value);
+}
+
+static int ads1015_start_conversion_op(long call) {
+	return ads1015_start_conversion(i2c, ADS1015_ADDRESS, call % ADS1015_NUM_INPUTS);
+}
+
+static int ads1015_read_conversion_op(long call) {
+	(void) call;
+	int16_t value;
+	return ads1015_read_conversion(i2c, ADS1015_ADDRESS, &value);
+}
+
+static int ltc2309_read_op(long call) {
+	uint16_t value;
+	return ltc2309_read(i2c, LTC2309_ADDRESS, call % LTC2309_NUM_INPUTS, &value);
+}
+
+static int digitalWrite_op(long call) {
+	return digitalWrite(MAKE_PIN_MCP23008(MCP23008_ADDRESS, call % MCP23008_NUM_IO), call & 1);
+}
+
+static int digitalRead_op(long call) {
+	const uint8_t index = call % MCP23017_NUM_IO;
+	(void) digitalRead(MAKE_PIN_MCP23017(MCP23017_ADDRESS, index));
+	return 0;
+}
+
+static int analogWrite_op(long call) {
+	return analogWrite(MAKE_PIN_PCA9685(PCA9685_ADDRESS, call % PCA9685_NUM_OUTPUTS), (call * 257) & 0x0FFF);
+}
+
+static int analogRead_op(long call) {
+	(void) analogRead(MAKE_PIN_LTC2309(LTC2309_ADDRESS, call % LTC2309_NUM_INPUTS));
+	return 0;
+}
+
+static int digitalWriteAll_op(long call) {
+	return digitalWriteAll(MCP23017_ADDRESS, call * 0x1111);
+}
+
+static int digitalReadAll_op(long call) {
+	(void) call;
+	uint16_t values;
+	return digitalReadAll(MCP23017_ADDRESS, &values);
+}
+
+static int analogWriteAll_op(long call) {
+	uint16_t values[PCA9685_NUM_OUTPUTS];
+	for (size_t i = 0; i < PCA9685_NUM_OUTPUTS; i++) {
+		values[i] = (call * 257 + i) & 0x0FFF;
+	}
+	return analogWriteAll(PCA9685_ADDRESS, values);
+}
+
+static const struct budget MCP23008_BUDGETS[] = {
+	{"mcp23008_set_pin_mode", mcp23008_set_pin_mode_op, 2, 3, 7},
+	{"mcp23008_set_pin_mode_all", mcp23008_set_pin_mode_all_op, 1, 1, 3},
+	{"mcp23008_write", mcp23008_write_op, 2, 3, 7},
+	{"mcp23008_read", mcp23008_read_op, 1, 2, 4},
+	{"mcp23008_write_all", mcp23008_write_all_op, 1, 1, 3},
+	{"mcp23008_read_all", mcp23008_read_all_op, 1, 2, 4},
+	{"mcp23008_read_interrupt", mcp23008_read_interrupt_op, 1, 4, 8},
+};
+
+static const struct budget MCP23017_BUDGETS[] = {
+	{"mcp23017_set_pin_mode", mcp23017_set_pin_mode_op, 2, 3, 7},
+	{"mcp23017_set_pin_mode_all", mcp23017_set_pin_mode_all_op, 2, 2, 6},
+	{"mcp23017_write", mcp23017_write_op, 2, 3, 7},
+	{"mcp23017_read", mcp23017_read_op, 1, 2, 4},
+	{"mcp23017_write_all", mcp23017_write_all_op, 2, 2, 6},
+	{"mcp23017_read_all", mcp23017_read_all_op, 2, 4, 8},
+	{"mcp23017_read_interrupt", mcp23017_read_interrupt_op, 1, 4, 10},
+};
+
+static const struct budget PCA9685_BUDGETS[] = {
+	{"pca9685_write", pca9685_write_op, 1, 1, 6},
+	{"pca9685_write_all", pca9685_write_all_op, 1, 1, 66},
+	{"pca9685_pwm_write", pca9685_pwm_write_op, 1, 1, 6},
+	{"pca9685_pwm_write_all", pca9685_pwm_write_all_op, 1, 1, 66},
+	{"pca9685_pwm_frequency", pca9685_pwm_frequency_op, 5, 7, 17},
+};
+
+static const struct budget ADC_BUDGETS[] = {
+	{"ads1015_read", ads1015_read_op, 2, 3, 9},
+	{"ads1015_start_conversion", ads1015_start_conversion_op, 1, 1, 4},
+	{"ads1015_read_conversion", ads1015_read_conversion_op, 1, 2, 5},
+	{"ltc2309_read", ltc2309_read_op, 2, 2, 5},
+};
+
+static const struct budget EXPANDED_GPIO_BUDGETS[] = {
+	{"digitalWrite(MCP23008)", digitalWrite_op, 2, 3, 7},
+	{"digitalRead(MCP23017)", digitalRead_op, 1, 2, 4},
+	{"analogWrite(PCA9685)", analogWrite_op, 1, 1, 6},
+	{"analogRead(LTC2309)", analogRead_op, 2, 2, 5},
+	{"digitalWriteAll(MCP23017)", digitalWriteAll_op, 2, 2, 6},
+	{"digitalReadAll(MCP23017)", digitalReadAll_op, 2, 4, 8},
+	{"analogWriteAll(PCA9685)", analogWriteAll_op, 1, 1, 66},
+};
+
+
+/**
+ * @brief Runs every operation of a table and checks the traffic of each call against its budget.
+ */
+static void check_budgets(const struct budget* budgets, size_t num_budgets) {
+	char message[128];
+
+	for (size_t i = 0; i < num_budgets; i++) {
+		const struct budget* b = &budgets[i];
+
+		for (long call = 0; call < BUDGET_CALLS; call++) {
+			struct i2c_sim_stats stats;
+			i2c_sim_clear_stats();
+			int ret = b->run(call);
+			i2c_sim_get_stats(&stats);
+
+			snprintf(message, sizeof(message), "%s (call %ld): %s", b->name, call, strerror(errno));
+			TEST_ASSERT_EQUAL_MESSAGE(0, ret, message);
+
+			snprintf(message, sizeof(message), "%s (call %ld): %lu ioctls, %lu messages, %lu bytes",
+			         b->name, call, (unsigned long) stats.ioctls, (unsigned long) stats.messages,
+			         (unsigned long) stats.wire_bytes);
+			TEST_ASSERT_MESSAGE(stats.ioctls <= b->ioctls, message);
+			TEST_ASSERT_MESSAGE(stats.messages <= b->messages, message);
+			TEST_ASSERT_MESSAGE(stats.wire_bytes <= b->wire_bytes, message);
+		}
+	}
+}
+
+void setUp(void) {
+	i2c = i2c_init(I2C_BUS);
+	TEST_ASSERT_NOT_NULL_MESSAGE(i2c, strerror(errno));
+}
+
+void tearDown(void) {
+	i2c_deinit(&i2c);
+}
+
+void mcp23008_init_test() {
+	struct i2c_sim_stats stats;
+	i2c_sim_clear_stats();
+	TEST_ASSERT_EQUAL_MESSAGE(0, mcp23008_init(i2c, MCP23008_ADDRESS), strerror(errno));
+	i2c_sim_get_stats(&stats);
+
+	// Fingerprint, register file burst, verification burst and IOCON
+	TEST_ASSERT_EQUAL(4, stats.ioctls);
+	TEST_ASSERT_EQUAL_HEX8(0xFF, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, 0x00)); // IODIR
+	TEST_ASSERT_EQUAL_HEX8(0x24, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, 0x05)); // IOCON
+	TEST_ASSERT_EQUAL_HEX8(0x00, i2c_sim_peek(I2C_BUS, MCP23008_ADDRESS, 0x0A)); // OLAT
+	TEST_ASSERT_EQUAL(1, mcp23008_init(i2c, MCP23008_ADDRESS));
+	TEST_ASSERT_EQUAL_MESSAGE(0, mcp23008_deinit(i2c, MCP23008_ADDRESS), strerror(errno));
+}
+
+void mcp23017_init_test() {
+	struct i2c_sim_stats stats;
+	i2c_sim_clear_stats();
+	TEST_ASSERT_EQUAL_MESSAGE(0, mcp23017_init(i2c, MCP23017_ADDRESS), strerror(errno));
+	i2c_sim_get_stats(&stats);
+
+	// Fingerprint, register file burst, verification burst and IOCON
+	TEST_ASSERT_EQUAL(4, stats.ioctls);
+	TEST_ASSERT_EQUAL_HEX8(0xFF, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, 0x00)); // IODIRA
+	TEST_ASSERT_EQUAL_HEX8(0xFF, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, 0x01)); // IODIRB
+	TEST_ASSERT_EQUAL_HEX8(0x24, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, 0x0A)); // IOCON
+	TEST_ASSERT_EQUAL_HEX8(0x00, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, 0x14)); // OLATA
+	TEST_ASSERT_EQUAL_HEX8(0x00, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, 0x15)); // OLATB
+	TEST_ASSERT_EQUAL(1, mcp23017_init(i2c, MCP23017_ADDRESS));
+
+	// Port A is the low byte
+	TEST_ASSERT_EQUAL_MESSAGE(0, mcp23017_write_all(i2c, MCP23017_ADDRESS, 0xA55A), strerror(errno));
+	TEST_ASSERT_EQUAL_HEX8(0x5A, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, 0x14)); // OLATA
+	TEST_ASSERT_EQUAL_HEX8(0xA5, i2c_sim_peek(I2C_BUS, MCP23017_ADDRESS, 0x15)); // OLATB
+	TEST_ASSERT_EQUAL_MESSAGE(0, mcp23017_deinit(i2c, MCP23017_ADDRESS), strerror(errno));
+}
+
+void mcp23008_budget_test() {
+	TEST_ASSERT_EQUAL_MESSAGE(0, mcp23008_init(i2c, MCP23008_ADDRESS), strerror(errno));
+	check_budgets(MCP23008_BUDGETS, sizeof(MCP23008_BUDGETS) / sizeof(MCP23008_BUDGETS[0]));
+	TEST_ASSERT_EQUAL_MESSAGE(0, mcp23008_deinit(i2c, MCP23008_ADDRESS), strerror(errno));
+}
+
+void mcp23017_budget_test() {
+	TEST_ASSERT_EQUAL_MESSAGE(0, mcp23017_init(i2c, MCP23017_ADDRESS), strerror(errno));
+	check_budgets(MCP23017_BUDGETS, sizeof(MCP23017_BUDGETS) / sizeof(MCP23017_BUDGETS[0]));
+	TEST_ASSERT_EQUAL_MESSAGE(0, mcp23017_deinit(i2c, MCP23017_ADDRESS), strerror(errno));
+}
+
+void pca9685_budget_test() {
+	TEST_ASSERT_EQUAL_MESSAGE(0, pca9685_init(i2c, PCA9685_ADDRESS), strerror(errno));
+	check_budgets(PCA9685_BUDGETS, sizeof(PCA9685_BUDGETS) / sizeof(PCA9685_BUDGETS[0]));
+	TEST_ASSERT_EQUAL_MESSAGE(0, pca9685_deinit(i2c, PCA9685_ADDRESS), strerror(errno));
+}
+
+void adc_budget_test() {
+	TEST_ASSERT_EQUAL_MESSAGE(0, ads1015_init(i2c, ADS1015_ADDRESS), strerror(errno));
+	TEST_ASSERT_EQUAL_MESSAGE(0, ltc2309_init(i2c, LTC2309_ADDRESS), strerror(errno));
+	check_budgets(ADC_BUDGETS, sizeof(ADC_BUDGETS) / sizeof(ADC_BUDGETS[0]));
+}
+
+void expanded_gpio_budget_test() {
+	TEST_ASSERT_EQUAL(0, initExpandedGPIO(false));
+	for (uint8_t i = 0; i < MCP23008_NUM_IO; i++) {
+		TEST_ASSERT_EQUAL(0, pinMode(MAKE_PIN_MCP23008(MCP23008_ADDRESS, i), OUTPUT));
+	}
+	TEST_ASSERT_EQUAL(0, analogWriteSetFrequency(MAKE_PIN_PCA9685(PCA9685_ADDRESS, 0), 200));
+
+	check_budgets(EXPANDED_GPIO_BUDGETS, sizeof(EXPANDED_GPIO_BUDGETS) / sizeof(EXPANDED_GPIO_BUDGETS[0]));
+
+	TEST_ASSERT_EQUAL(0, deinitExpandedGPIO());
+}
+
+int main() {
+	_peripherals_struct = (struct peripherals_t) {
+		.arrayMCP23008 = mcp23008_addrs, .numArrayMCP23008 = 1,
+		.arrayADS1015 = ads1015_addrs, .numArrayADS1015 = 1,
+		.arrayPCA9685 = pca9685_addrs, .numArrayPCA9685 = 1,
+		.arrayLTC2309 = ltc2309_addrs, .numArrayLTC2309 = 1,
+		.arrayMCP23017 = mcp23017_addrs, .numArrayMCP23017 = 1,
+	};
+
+	// No bus time, the transfers are counted but not timed
+	i2c_sim_enable(true);
+	i2c_sim_set_bus_speed(0);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23008, MCP23008_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_MCP23017, MCP23017_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_PCA9685, PCA9685_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_ADS1015, ADS1015_ADDRESS);
+	i2c_sim_add_device(I2C_BUS, I2C_SIM_LTC2309, LTC2309_ADDRESS);
+
+	UNITY_BEGIN();
+
+	RUN_TEST(mcp23008_init_test);
+	RUN_TEST(mcp23017_init_test);
+	RUN_TEST(mcp23008_budget_test);
+	RUN_TEST(mcp23017_budget_test);
+	RUN_TEST(pca9685_budget_test);
+	RUN_TEST(adc_budget_test);
+	RUN_TEST(expanded_gpio_budget_test);
+
+	return UNITY_END();
+}
+
+#endif // PLC_ENVIRONMENT == Linux
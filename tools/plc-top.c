@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2026 Industrial Shields. All rights reserved
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * plc-top attaches read-only to the statistics segment of a program that
+ * uses the library (see plc-stats.h), and shows every few seconds the
+ * transaction and error rates of each I2C device, their latencies, the
+ * scans of expanded-gpio and the hit ratio of the caches. The rates and
+ * the percentiles are those of the last interval. It never writes to the
+ * segment, so it can be run at any time on a working PLC.
+ */
+
+#define _GNU_SOURCE
+
+#include <plc-stats.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <signal.h>
+#include <sys/mman.h>
+
+#define NSEC_PER_SEC 1000000000LL
+
+#define SHM_DIR "/dev/shm"
+
+static const char* const CACHE_NAMES[PLC_STATS_NUM_CACHES] = {
+	[PLC_STATS_CACHE_DEBOUNCE] = "debounce",
+	[PLC_STATS_CACHE_PWM_SYSFS] = "pwm-sysfs",
+};
+
+struct options {
+	const char* name;
+	pid_t pid;
+	double interval;
+	long count; // 0 = until interrupted
+	bool batch;
+};
+
+
+static void usage(const char* name) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -p PID      attach to the process PID\n"
+		"  -s NAME     attach to the segment NAME (default: the only process running)\n"
+		"  -d SECONDS  refresh interval (default 1)\n"
+		"  -c COUNT    exit after COUNT refreshes\n"
+		"  -b          batch mode: don't clear the screen, to log the output\n"
+		"  -l          list the processes with statistics and exit\n"
+		"  -r          remove the segments of the processes no longer running and exit\n",
+		name);
+}
+
+static inline int64_t clock_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static bool process_running(pid_t pid) {
+	return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+/**
+ * @brief Calls a function for every statistics segment in SHM_DIR.
+ *
+ * @return The number of segments found.
+ */
+static size_t for_each_segment(void (*fun)(const char* name, pid_t pid, void* arg), void* arg) {
+	DIR* dir = opendir(SHM_DIR);
+	if (dir == NULL) {
+		return 0;
+	}
+
+	// The segment names start with '/', which isn't part of the file name
+	const char* prefix = PLC_STATS_SHM_PREFIX + 1;
+	const size_t prefix_len = strlen(prefix);
+
+	size_t found = 0;
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != NULL) {
+		if (strncmp(entry->d_name, prefix, prefix_len) != 0) {
+			continue;
+		}
+
+		char name[sizeof(entry->d_name) + 1];
+		snprintf(name, sizeof(name), "/%s", entry->d_name);
+		fun(name, atoi(entry->d_name + prefix_len), arg);
+		found++;
+	}
+
+	closedir(dir);
+	return found;
+}
+
+static void print_segment(const char* name, pid_t pid, void* arg) {
+	(void) arg;
+	printf("%-32s %8d %s\n", name, (int) pid, process_running(pid) ? "running" : "not running");
+}
+
+static void remove_stale(const char* name, pid_t pid, void* arg) {
+	(void) arg;
+	if (!process_running(pid)) {
+		if (shm_unlink(name) == 0) {
+			printf("Removed %s\n", name);
+		}
+		else {
+			fprintf(stderr, "%s: %s\n", name, strerror(errno));
+		}
+	}
+}
+
+static void find_running(const char* name, pid_t pid, void* arg) {
+	pid_t* running = arg;
+	if (process_running(pid)) {
+		// -1 if there is more than one
+		*running = *running == 0 ? pid : -1;
+	}
+	(void) name;
+}
+
+static int parse_options(int argc, char* argv[], struct options* opts) {
+	*opts = (struct options) {
+		.name = NULL,
+		.pid = 0,
+		.interval = 1,
+		.count = 0,
+		.batch = false,
+	};
+
+	int opt;
+	while ((opt = getopt(argc, argv, "p:s:d:c:blr")) != -1) {
+		switch (opt) {
+		case 'p':
+			opts->pid = strtol(optarg, NULL, 0);
+			break;
+		case 's':
+			opts->name = optarg;
+			break;
+		case 'd':
+			opts->interval = strtod(optarg, NULL);
+			break;
+		case 'c':
+			opts->count = strtol(optarg, NULL, 0);
+			break;
+		case 'b':
+			opts->batch = true;
+			break;
+		case 'l':
+			printf("%-32s %8s\n", "SEGMENT", "PID");
+			for_each_segment(print_segment, NULL);
+			exit(EXIT_SUCCESS);
+		case 'r':
+			// Left by the processes killed by a signal, which can't remove them
+			for_each_segment(remove_stale, NULL);
+			exit(EXIT_SUCCESS);
+		default:
+			return -1;
+		}
+	}
+
+	return opts->interval > 0 && opts->count >= 0 ? 0 : -1;
+}
+
+/**
+ * @brief Subtracts two distributions, for the durations of an interval.
+ *
+ * The maximum can't be subtracted, so it is the one since the start.
+ */
+static void latency_delta(const plc_stats_latency_t* now, const plc_stats_latency_t* before, plc_stats_latency_t* delta) {
+	delta->count = now->count - before->count;
+	delta->total_ns = now->total_ns - before->total_ns;
+	delta->max_ns = now->max_ns;
+	for (size_t i = 0; i < PLC_STATS_LATENCY_BUCKETS; i++) {
+		delta->buckets[i] = now->buckets[i] - before->buckets[i];
+	}
+}
+
+static const plc_stats_device_t* find_device(const plc_stats_t* stats, uint32_t key) {
+	for (size_t i = 0; i < stats->num_devices && i < PLC_STATS_MAX_DEVICES; i++) {
+		if (stats->devices[i].key == key) {
+			return &stats->devices[i];
+		}
+	}
+	return NULL;
+}
+
+static int compare_devices(const void* a, const void* b) {
+	const uint32_t x = ((const plc_stats_device_t*) a)->key;
+	const uint32_t y = ((const plc_stats_device_t*) b)->key;
+	return (x > y) - (x < y);
+}
+
+static void print_frame(const struct options* opts, const char* name, const plc_stats_t* now, const plc_stats_t* before, double seconds) {
+	if (!opts->batch) {
+		// Home and clear the screen
+		printf("\033[H\033[2J");
+	}
+
+	const uint64_t uptime = (clock_ns() - (int64_t) now->start_ns) / NSEC_PER_SEC;
+	printf("plc-top - PID %d (%s), up %lu:%02lu:%02lu, last %.1f s\n\n", (int) now->pid, name,
+	       (unsigned long) (uptime / 3600), (unsigned long) (uptime / 60 % 60), (unsigned long) (uptime % 60), seconds);
+
+	plc_stats_latency_t scans;
+	latency_delta(&now->scans, &before->scans, &scans);
+	printf("Scans: %lu, %.1f/s, %lu errors", (unsigned long) now->scans.count, scans.count / seconds,
+	       (unsigned long) (now->scan_errors - before->scan_errors));
+	if (scans.count > 0) {
+		printf(", avg %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us",
+		       scans.total_ns / 1000.0 / scans.count, plc_stats_percentile(&scans, 0.5) / 1000.0,
+		       plc_stats_percentile(&scans, 0.99) / 1000.0, scans.max_ns / 1000.0);
+	}
+	printf("\n");
+
+	printf("Caches:");
+	for (size_t i = 0; i < PLC_STATS_NUM_CACHES; i++) {
+		const uint64_t hits = now->caches[i].hits - before->caches[i].hits;
+		const uint64_t accesses = hits + now->caches[i].misses - before->caches[i].misses;
+		if (accesses > 0) {
+			printf(" %s %.1f%% of %lu", CACHE_NAMES[i], 100.0 * hits / accesses, (unsigned long) accesses);
+		}
+		else {
+			printf(" %s -", CACHE_NAMES[i]);
+		}
+	}
+	printf("\n");
+
+	if (now->dropped_transactions > 0) {
+		printf("Transactions of devices that don't fit in the table: %lu\n", (unsigned long) now->dropped_transactions);
+	}
+
+	printf("\n%3s %4s %9s %8s %6s %8s %9s %9s %9s %9s %10s  %s\n",
+	       "BUS", "ADDR", "TX/s", "ERR/s", "ERR%", "KB/s", "AVG_us", "P50_us", "P99_us", "MAX_us", "TX", "LAST_ERROR");
+
+	plc_stats_device_t devices[PLC_STATS_MAX_DEVICES];
+	const size_t num_devices = now->num_devices < PLC_STATS_MAX_DEVICES ? now->num_devices : PLC_STATS_MAX_DEVICES;
+	memcpy(devices, now->devices, num_devices * sizeof(plc_stats_device_t));
+	qsort(devices, num_devices, sizeof(plc_stats_device_t), compare_devices);
+
+	for (size_t i = 0; i < num_devices; i++) {
+		const plc_stats_device_t* device = &devices[i];
+		const plc_stats_device_t* previous = find_device(before, device->key);
+		static const plc_stats_device_t NONE = {0};
+		if (previous == NULL) {
+			previous = &NONE;
+		}
+
+		const uint64_t transactions = device->transactions - previous->transactions;
+		const uint64_t errors = device->errors - previous->errors;
+		plc_stats_latency_t latency;
+		latency_delta(&device->latency, &previous->latency, &latency);
+
+		printf("%3u 0x%02x %9.1f %8.1f %6.2f %8.2f", (device->key - 1) >> 8, (device->key - 1) & 0xFF,
+		       transactions / seconds, errors / seconds, transactions > 0 ? 100.0 * errors / transactions : 0,
+		       (device->bytes - previous->bytes) / 1024.0 / seconds);
+		if (latency.count > 0) {
+			printf(" %9.1f %9.1f %9.1f", latency.total_ns / 1000.0 / latency.count,
+			       plc_stats_percentile(&latency, 0.5) / 1000.0, plc_stats_percentile(&latency, 0.99) / 1000.0);
+		}
+		else {
+			printf(" %9s %9s %9s", "-", "-", "-");
+		}
+		printf(" %9.1f %10lu  %s\n", device->latency.max_ns / 1000.0, (unsigned long) device->transactions,
+		       device->last_errno != 0 ? strerror(device->last_errno) : "-");
+	}
+
+	fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+	struct options opts;
+	if (parse_options(argc, argv, &opts) != 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	char name[NAME_MAX + 2];
+	if (opts.name != NULL) {
+		snprintf(name, sizeof(name), "%s", opts.name);
+	}
+	else {
+		pid_t pid = opts.pid;
+		if (pid == 0) {
+			for_each_segment(find_running, &pid);
+			if (pid <= 0) {
+				fprintf(stderr, "%s running process with statistics (see PLC_PERIPHERALS_STATS_SHM), choose one with -p (see -l)\n",
+				        pid == 0 ? "There is no" : "There is more than one");
+				return EXIT_FAILURE;
+			}
+		}
+		snprintf(name, sizeof(name), PLC_STATS_SHM_PREFIX "%d", (int) pid);
+	}
+
+	const plc_stats_t* stats = plc_stats_attach(name);
+	if (stats == NULL) {
+		fprintf(stderr, "%s: %s\n", name, errno == EPROTO ? "not from a compatible version of the library" : strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	// The first interval starts with the process
+	static plc_stats_t now, before;
+	memset(&before, 0, sizeof(before));
+	int64_t before_ns = stats->start_ns;
+
+	for (long frame = 0; opts.count == 0 || frame < opts.count; frame++) {
+		if (frame > 0) {
+			const struct timespec delay = {
+				.tv_sec = (time_t) opts.interval,
+				.tv_nsec = (long) ((opts.interval - (time_t) opts.interval) * NSEC_PER_SEC),
+			};
+			nanosleep(&delay, NULL);
+		}
+
+		plc_stats_snapshot(stats, &now);
+		const int64_t now_ns = clock_ns();
+		const double seconds = now_ns > before_ns ? (now_ns - before_ns) / (double) NSEC_PER_SEC : 1;
+
+		print_frame(&opts, name, &now, &before, seconds);
+
+		if (!process_running(now.pid)) {
+			printf("\nThe process has exited\n");
+			break;
+		}
+
+		before = now;
+		before_ns = now_ns;
+	}
+
+	plc_stats_detach(&stats);
+	return EXIT_SUCCESS;
+}